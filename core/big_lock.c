@@ -28,6 +28,8 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <pthread.h>
+
 #include "mosys/big_lock.h"
 #include "mosys/ipc_lock.h"
 #include "mosys/locks.h"
@@ -38,6 +40,84 @@ static struct ipc_lock mosys_big_lock = SYSV_IPC_LOCK_INIT(MOSYS_LOCK_BIGLOCK);
 static struct ipc_lock mosys_big_lock = LOCKFILE_INIT(MOSYS_LOCKFILE_NAME);
 #endif
 
+/*
+ * The big lock is held by the process, so threads which entered it share
+ * it. A thread changes it, i.e. converts or hands it to a child process,
+ * only once no other thread is inside, and others wait to enter until
+ * the change is done.
+ */
+static pthread_mutex_t big_lock_threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t big_lock_threads_cond = PTHREAD_COND_INITIALIZER;
+static int big_lock_threads;		/* threads inside */
+static int big_lock_changers;		/* threads changing or waiting to */
+static int big_lock_changing;		/* a thread is changing the lock */
+static __thread int big_lock_entered;
+static enum ipc_lock_mode big_lock_suspended_mode;
+
+void mosys_big_lock_enter(void)
+{
+	pthread_mutex_lock(&big_lock_threads_lock);
+	while (big_lock_changers)
+		pthread_cond_wait(&big_lock_threads_cond,
+		                  &big_lock_threads_lock);
+	big_lock_threads++;
+	big_lock_entered = 1;
+	pthread_mutex_unlock(&big_lock_threads_lock);
+}
+
+void mosys_big_lock_leave(void)
+{
+	pthread_mutex_lock(&big_lock_threads_lock);
+	big_lock_threads--;
+	big_lock_entered = 0;
+	pthread_cond_broadcast(&big_lock_threads_cond);
+	pthread_mutex_unlock(&big_lock_threads_lock);
+}
+
+/*
+ * big_lock_change_begin  -  wait until this thread may change the lock
+ *
+ * @mode:	mode the change is to, NULL if it is not a conversion
+ *
+ * returns 0 once this is the only thread inside and no other is changing,
+ * big_lock_change_end() must follow
+ * returns 1 if another thread converted the lock to @mode meanwhile
+ */
+static int big_lock_change_begin(const enum ipc_lock_mode *mode)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&big_lock_threads_lock);
+	big_lock_changers++;
+	big_lock_threads -= big_lock_entered;
+	while (big_lock_changing || big_lock_threads) {
+		if (!big_lock_changing && mode && mosys_big_lock.is_held &&
+		    mosys_big_lock.mode == *mode) {
+			big_lock_changers--;
+			pthread_cond_broadcast(&big_lock_threads_cond);
+			ret = 1;
+			break;
+		}
+		pthread_cond_wait(&big_lock_threads_cond,
+		                  &big_lock_threads_lock);
+	}
+	if (ret == 0)
+		big_lock_changing = 1;
+	big_lock_threads += big_lock_entered;
+	pthread_mutex_unlock(&big_lock_threads_lock);
+
+	return ret;
+}
+
+static void big_lock_change_end(void)
+{
+	pthread_mutex_lock(&big_lock_threads_lock);
+	big_lock_changing = 0;
+	big_lock_changers--;
+	pthread_cond_broadcast(&big_lock_threads_cond);
+	pthread_mutex_unlock(&big_lock_threads_lock);
+}
+
 /*
  * mosys_acquire_big_lock  -  acquire global lock
  *
@@ -50,6 +130,44 @@ int mosys_acquire_big_lock(int timeout_secs)
 	return mosys_lock(&mosys_big_lock, timeout_secs*1000);
 }
 
+/*
+ * mosys_acquire_big_lock_mode  -  acquire global lock in given mode
+ *
+ * @mode:	IPC_LOCK_SHARED or IPC_LOCK_EXCLUSIVE
+ * @timeout_secs:	seconds to wait for lock
+ *
+ * A held lock is converted to the given mode.
+ *
+ * returns 0 to indicate lock acquired or converted
+ * returns >0 to indicate lock was already held in this mode
+ * returns <0 to indicate failed to acquire lock
+ */
+int mosys_acquire_big_lock_mode(enum ipc_lock_mode mode, int timeout_secs)
+{
+	int ret;
+
+	/* nothing to change, inside threads keep the mode while inside */
+	if (mosys_big_lock.is_held && mosys_big_lock.mode == mode)
+		return 1;
+
+	if (big_lock_change_begin(&mode) > 0)
+		return 1;
+	ret = mosys_lock_mode(&mosys_big_lock, mode, timeout_secs*1000);
+	big_lock_change_end();
+	return ret;
+}
+
+/*
+ * mosys_big_lock_is_held  -  check if this process holds the global lock
+ *
+ * returns 1 if lock is held
+ * returns 0 if lock is not held
+ */
+int mosys_big_lock_is_held(void)
+{
+	return mosys_big_lock.is_held;
+}
+
 /*
  * mosys_release_big_lock  -  release global lock
  *
@@ -61,6 +179,47 @@ int mosys_release_big_lock(void)
 	return mosys_unlock(&mosys_big_lock);
 }
 
+/*
+ * mosys_big_lock_suspend  -  release global lock for a child process
+ *
+ * Waits until no other thread is inside. They stay out until the lock is
+ * taken back with mosys_big_lock_resume().
+ *
+ * returns 0 if lock was released, mosys_big_lock_resume() must follow
+ * returns -1 if lock had not been held before the call
+ */
+int mosys_big_lock_suspend(void)
+{
+	big_lock_change_begin(NULL);
+	big_lock_suspended_mode = mosys_big_lock.mode;
+	if (mosys_unlock(&mosys_big_lock) < 0) {
+		big_lock_change_end();
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * mosys_big_lock_resume  -  take back lock released by mosys_big_lock_suspend
+ *
+ * @timeout_secs:	seconds to wait for lock
+ *
+ * The lock is taken in the mode it was held in before.
+ *
+ * returns 0 to indicate lock acquired
+ * returns <0 to indicate failed to acquire lock
+ */
+int mosys_big_lock_resume(int timeout_secs)
+{
+	int ret;
+
+	ret = mosys_lock_mode(&mosys_big_lock, big_lock_suspended_mode,
+	                      timeout_secs*1000);
+	big_lock_change_end();
+	return ret;
+}
+
 /*
  * mosys_big_lock_prepare_test - setup the big lock for testing.
  *
@@ -35,6 +35,7 @@
 #include "mosys/kv_pair.h"
 #include "mosys/log.h"
 #include "mosys/platform.h"
+#include "mosys/resource_lock.h"
 
 static int ec_info(struct platform_intf *intf,
                    struct platform_cmd *cmd, int argc, char **argv)
@@ -85,12 +86,18 @@ ec_info_done:
 	return rc;
 }
 
+static const struct resource_claim ec_resources[] = {
+	{ RESOURCE_EC, "ec", IPC_LOCK_SHARED },
+	{ RESOURCE_NONE },
+};
+
 struct platform_cmd ec_cmds[] = {
 	{
 		.name	= "info",
 		.desc	= "Print basic EC information",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = ec_info}
+		.arg	= { .func = ec_info},
+		.resources	= ec_resources
 	},
 	/* TODO: add a sub-menu for EC commands */
 	{ NULL }
@@ -46,6 +46,7 @@
 #include "mosys/log.h"
 #include "mosys/output.h"
 #include "mosys/kv_pair.h"
+#include "mosys/resource_lock.h"
 
 #include "lib/crypto.h"
 #include "lib/eeprom.h"
@@ -611,6 +612,19 @@ eeprom_write_done:
 	return rc;
 }
 
+/* EEPROMs on I2C are locked by the I2C interface */
+static const struct resource_claim eeprom_read_resources[] = {
+	{ RESOURCE_HOST_FLASH, NULL, IPC_LOCK_SHARED },
+	{ RESOURCE_EC_FLASH, NULL, IPC_LOCK_SHARED },
+	{ RESOURCE_NONE },
+};
+
+static const struct resource_claim eeprom_write_resources[] = {
+	{ RESOURCE_HOST_FLASH, NULL, IPC_LOCK_EXCLUSIVE },
+	{ RESOURCE_EC_FLASH, NULL, IPC_LOCK_EXCLUSIVE },
+	{ RESOURCE_NONE },
+};
+
 struct platform_cmd eeprom_enet_cmds[] = {
 	{
 		.name	= "info",
@@ -636,35 +650,40 @@ struct platform_cmd eeprom_cmds[] = {
 		.desc	= "List EEPROMs present in system and some basic info",
 		.usage	= "mosys eeprom list",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = eeprom_list_cmd }
+		.arg	= { .func = eeprom_list_cmd },
+		.resources	= eeprom_read_resources
 	},
 	{
 		.name	= "map",
 		.desc	= "Print EEPROM maps if present",
 		.usage	= "mosys eeprom map <eeprom/filename>",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = eeprom_map_cmd }
+		.arg	= { .func = eeprom_map_cmd },
+		.resources	= eeprom_read_resources
 	},
 	{
 		.name	= "csum",
 		.desc	= "Print sha1 checksum",
 		.usage	= "mosys eeprom csum <eeprom/filename>",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = eeprom_csum_cmd }
+		.arg	= { .func = eeprom_csum_cmd },
+		.resources	= eeprom_read_resources
 	},
 	{
 		.name	= "dump",
 		.desc	= "Dump entire contents of EEPROM to file",
 		.usage	= "mosys eeprom dump <device> <file>",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = eeprom_dump_cmd }
+		.arg	= { .func = eeprom_dump_cmd },
+		.resources	= eeprom_read_resources
 	},
 	{
 		.name	= "write",
 		.desc	= "Write contents of file to EEPROM",
 		.usage	= "mosys eeprom write <device> <file>",
 		.type	= ARG_TYPE_SETTER,
-		.arg	= { .func = eeprom_write_cmd }
+		.arg	= { .func = eeprom_write_cmd },
+		.resources	= eeprom_write_resources
 	},
 	{
 		.name	= "enet",
@@ -33,13 +33,20 @@
 #include <string.h>
 #include <inttypes.h>
 #include <errno.h>
+#include <limits.h>
+#include <time.h>
 
+#include "lib/elog.h"
+#include "lib/elog_cursor.h"
+#include "lib/elog_export.h"
+#include "lib/elog_query.h"
 #include "lib/elog_smbios.h"
 
 #include "mosys/alloc.h"
 #include "mosys/log.h"
 #include "mosys/kv_pair.h"
 #include "mosys/platform.h"
+#include "mosys/resource_lock.h"
 
 static int eventlog_smbios_list_callback(struct platform_intf *intf,
                                          struct smbios_log_entry *entry,
@@ -105,12 +112,80 @@ static int eventlog_smbios_list_callback(struct platform_intf *intf,
 	return rc;
 }
 
+/*
+ * eventlog_smbios_list_since_cursor  -  list entries added since last call
+ *
+ * @intf:	platform interface
+ *
+ * Only entries after the one recorded in the saved cursor are decoded.
+ * The cursor is advanced if all of them were listed successfully.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int eventlog_smbios_list_since_cursor(struct platform_intf *intf)
+{
+	uint8_t *data;
+	size_t length;
+	off_t header_offset, data_offset, last_offset = 0;
+	struct smbios_eventlog_iterator *elog_iter;
+	struct smbios_log_entry *entry, *last = NULL;
+	struct elog_cursor cursor;
+	int entry_count, complete = 0, rc = 0;
+
+	if (intf->cb->eventlog->fetch(intf, &data, &length, &header_offset,
+				      &data_offset))
+		return -1;
+
+	elog_iter = smbios_new_eventlog_iterator(intf, data, length,
+						 header_offset, data_offset);
+
+	if (intf->cb->eventlog->verify_header &&
+	    intf->cb->eventlog->verify_header(
+			smbios_eventlog_get_header(elog_iter)) < 0) {
+		rc = -1;
+		goto eventlog_smbios_list_since_cursor_exit;
+	}
+
+	elog_cursor_load(&cursor);
+	elog_cursor_resume(&cursor, elog_iter);
+
+	entry_count = cursor.next_entry;
+	while (!complete &&
+	       (entry = smbios_eventlog_get_next_entry(elog_iter)) != NULL) {
+		rc |= eventlog_smbios_list_callback(intf, entry, &entry_count,
+		                                    &complete);
+		last = entry;
+		last_offset = smbios_eventlog_get_offset(elog_iter);
+	}
+
+	if (rc)
+		goto eventlog_smbios_list_since_cursor_exit;
+
+	if (last)
+		elog_cursor_advance(&cursor, last_offset, last, entry_count);
+	rc = elog_cursor_save(&cursor);
+
+eventlog_smbios_list_since_cursor_exit:
+	smbios_free_eventlog_iterator(elog_iter);
+	return rc;
+}
+
 static int eventlog_smbios_list_cmd(struct platform_intf *intf,
                                     struct platform_cmd *cmd,
                                     int argc, char **argv)
 {
 	int entry_count = 0;
 
+	if (argc == 1 && !strcmp(argv[0], "--since-cursor"))
+		return eventlog_smbios_list_since_cursor(intf);
+
+	if (argc > 0) {
+		platform_cmd_usage(cmd);
+		errno = EINVAL;
+		return -1;
+	}
+
 	return smbios_eventlog_foreach_event(
 		intf, intf->cb->eventlog->verify_header,
 		eventlog_smbios_list_callback, &entry_count);
@@ -120,55 +195,282 @@ static int eventlog_smbios_add_cmd(struct platform_intf *intf,
 				   struct platform_cmd *cmd,
 				   int argc, char **argv)
 {
-	enum smbios_log_entry_type type;
-	size_t data_size = 0;
-	uint8_t *data = NULL;
-	int res;
+	struct elog_new_event *events = NULL;
+	int num = 0, i, res = 0;
 
 	if (!intf->cb->eventlog || !intf->cb->eventlog->add) {
 		errno = ENOSYS;
 		return -1;
 	}
 
-	if (argc < 1 || argc > 2) {
+	if (argc == 2 && !strcmp(argv[0], "-f")) {
+		num = elog_parse_event_file(argv[1], &events);
+		if (num < 0) {
+			errno = EINVAL;
+			return -1;
+		}
+	} else if (argc == 1 || (argc > 0 && argc % 2 == 0)) {
+		/* a lone type, or any number of type/data pairs */
+		num = (argc + 1) / 2;
+		events = mosys_zalloc(num * sizeof(*events));
+		for (i = 0; i < num; i++) {
+			const char *hex = NULL;
+
+			if (2 * i + 1 < argc && argv[2 * i + 1][0])
+				hex = argv[2 * i + 1];
+			if (elog_parse_event(argv[2 * i], hex, &events[i]) < 0) {
+				res = -1;
+				break;
+			}
+		}
+		if (res < 0) {
+			while (i--)
+				free(events[i].data);
+			free(events);
+			platform_cmd_usage(cmd);
+			errno = EINVAL;
+			return -1;
+		}
+	} else {
 		platform_cmd_usage(cmd);
 		errno = EINVAL;
 		return -1;
 	}
 
-	type = strtol(argv[0], NULL, 0);
+	/* commit a batch with a single write when the platform supports it */
+	if (num > 1 && intf->cb->eventlog->add_many) {
+		res = intf->cb->eventlog->add_many(intf, events, num);
+	} else {
+		for (i = 0; i < num && res == 0; i++)
+			res = intf->cb->eventlog->add(intf, events[i].type,
+						      events[i].data_size,
+						      events[i].data);
+	}
 
-	if (argc == 2) {
-		size_t len = strlen(argv[1]);
-		char byte[3] = { 0, 0, 0 };
-		char *endptr;
-		int i;
+	for (i = 0; i < num; i++)
+		free(events[i].data);
+	free(events);
+	return res;
+}
 
-		if (len % 2) {
-			platform_cmd_usage(cmd);
-			errno = EINVAL;
-			return -1;
+/*
+ * eventlog_parse_time  -  parse a time given to the query command
+ *
+ * @arg:	seconds since the epoch, or a number followed by s, m, h or d
+ *		for that long before now
+ * @time:	pointer to store the time in
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int eventlog_parse_time(const char *arg, time_t *time_p)
+{
+	char *endptr;
+	long long value;
+
+	value = strtoll(arg, &endptr, 10);
+	if (endptr == arg || value < 0)
+		return -1;
+
+	switch (*endptr) {
+	case '\0':
+		*time_p = value;
+		return 0;
+	case 'd':
+		value *= 24;
+		/* fall through */
+	case 'h':
+		value *= 60;
+		/* fall through */
+	case 'm':
+		value *= 60;
+		/* fall through */
+	case 's':
+		break;
+	default:
+		return -1;
+	}
+
+	if (endptr[1])
+		return -1;
+
+	*time_p = time(NULL) - value;
+	return 0;
+}
+
+/*
+ * eventlog_parse_query  -  parse arguments of the query command
+ *
+ * @argc:	number of arguments
+ * @argv:	arguments
+ * @query:	query to fill in
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int eventlog_parse_query(int argc, char **argv,
+				struct elog_query *query)
+{
+	char *endptr, *tok, *saveptr;
+	long value;
+	int i;
+
+	elog_query_init(query);
+
+	for (i = 0; i < argc; i++) {
+		if (!strcmp(argv[i], "--hourly")) {
+			query->aggregate = ELOG_QUERY_HOURLY;
+			continue;
+		}
+		if (!strcmp(argv[i], "--first-last")) {
+			query->aggregate = ELOG_QUERY_FIRST_LAST;
+			continue;
 		}
 
-		data_size = len / 2;
-		data = mosys_malloc(data_size);
-		for (i = 0; i < data_size; i++) {
-			byte[0] = *argv[1]++;
-			byte[1] = *argv[1]++;
-			data[i] = strtol(byte, &endptr, 0);
-			if (endptr != &byte[2]) {
-				free(data);
-				platform_cmd_usage(cmd);
-				errno = EINVAL;
+		/* the remaining options take a value */
+		if (i + 1 == argc)
+			return -1;
+
+		if (!strcmp(argv[i], "--type")) {
+			query->type_filter = 1;
+			for (tok = strtok_r(argv[++i], ",", &saveptr); tok;
+			     tok = strtok_r(NULL, ",", &saveptr)) {
+				value = strtol(tok, &endptr, 0);
+				if (endptr == tok || *endptr ||
+				    value < 0 || value >= ELOG_QUERY_NUM_TYPES)
+					return -1;
+				query->types[value] = 1;
+			}
+		} else if (!strcmp(argv[i], "--since")) {
+			if (eventlog_parse_time(argv[++i], &query->since) < 0)
+				return -1;
+		} else if (!strcmp(argv[i], "--until")) {
+			if (eventlog_parse_time(argv[++i], &query->until) < 0)
+				return -1;
+		} else if (!strcmp(argv[i], "--entries")) {
+			tok = argv[++i];
+			value = strtol(tok, &endptr, 10);
+			if (endptr == tok || value < 0)
+				return -1;
+			query->first_entry = value;
+			if (*endptr == '\0') {
+				query->last_entry = value;
+			} else if (*endptr == '-') {
+				tok = endptr + 1;
+				if (*tok == '\0')
+					continue;
+				value = strtol(tok, &endptr, 10);
+				if (endptr == tok || *endptr ||
+				    value < query->first_entry)
+					return -1;
+				query->last_entry = value;
+			} else {
 				return -1;
 			}
+		} else {
+			return -1;
 		}
 	}
 
-	res = intf->cb->eventlog->add(intf, type, data_size, data);
+	return 0;
+}
 
-	free(data);
-	return res;
+static void eventlog_query_add_time(struct kv_pair *kv, const char *key,
+				    time_t time)
+{
+	char tm_string[40];
+	struct tm tm;
+
+	if (time == ELOG_QUERY_NO_TIME) {
+		kv_pair_add(kv, key, "Unknown");
+		return;
+	}
+
+	strftime(tm_string, sizeof(tm_string),
+		 "%Y-%m-%d %H:%M:%S", localtime_r(&time, &tm));
+	kv_pair_add(kv, key, tm_string);
+}
+
+/*
+ * eventlog_query_print  -  run query on decoded log and print the result
+ *
+ * @intf:	platform interface
+ * @cols:	decoded event log
+ * @query:	query to run
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int eventlog_query_print(struct platform_intf *intf,
+				const struct elog_columns *cols,
+				const struct elog_query *query)
+{
+	struct elog_query_row *rows;
+	struct smbios_log_entry *entry;
+	struct kv_pair *kv;
+	int i, num_rows, rc = 0;
+
+	num_rows = elog_query_run(cols, query, &rows);
+	for (i = 0; i < num_rows && rc == 0; i++) {
+		kv = kv_pair_new();
+
+		if (query->aggregate == ELOG_QUERY_HOURLY)
+			eventlog_query_add_time(kv, "hour", rows[i].hour);
+
+		/* name the type the way listing the first entry would */
+		entry = (void *)&cols->log[cols->offset[rows[i].first]];
+		if (intf->cb->eventlog->print_type == NULL ||
+		    intf->cb->eventlog->print_type(intf, entry, kv) == 0) {
+			const char *type = smbios_get_event_type_string(entry);
+			kv_pair_add(kv, "type", type ? type : "Unknown");
+		}
+		kv_pair_fmt(kv, "type_id", "0x%02x", rows[i].type);
+		kv_pair_fmt(kv, "count", "%d", rows[i].count);
+
+		if (query->aggregate == ELOG_QUERY_FIRST_LAST) {
+			kv_pair_fmt(kv, "first_entry", "%d",
+				    cols->entry[rows[i].first]);
+			eventlog_query_add_time(kv, "first",
+						cols->time[rows[i].first]);
+			kv_pair_fmt(kv, "last_entry", "%d",
+				    cols->entry[rows[i].last]);
+			eventlog_query_add_time(kv, "last",
+						cols->time[rows[i].last]);
+		}
+
+		rc = kv_pair_print(kv);
+		kv_pair_free(kv);
+	}
+
+	free(rows);
+	return rc;
+}
+
+static int eventlog_smbios_query_cmd(struct platform_intf *intf,
+				     struct platform_cmd *cmd,
+				     int argc, char **argv)
+{
+	struct elog_columns cols;
+	struct elog_query query;
+	int rc;
+
+	if (!intf->cb->eventlog || !intf->cb->eventlog->fetch) {
+		errno = ENOSYS;
+		return -1;
+	}
+
+	if (eventlog_parse_query(argc, argv, &query) < 0) {
+		platform_cmd_usage(cmd);
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (elog_columns_decode(intf, &cols, &query) < 0)
+		return -1;
+
+	rc = eventlog_query_print(intf, &cols, &query);
+	elog_columns_free(&cols);
+	return rc;
 }
 
 static int eventlog_smbios_clear_cmd(struct platform_intf *intf,
@@ -183,27 +485,170 @@ static int eventlog_smbios_clear_cmd(struct platform_intf *intf,
 	return intf->cb->eventlog->clear(intf);
 }
 
+static int eventlog_smbios_export_cmd(struct platform_intf *intf,
+				      struct platform_cmd *cmd,
+				      int argc, char **argv)
+{
+	if (!intf->cb->eventlog || !intf->cb->eventlog->fetch) {
+		errno = ENOSYS;
+		return -1;
+	}
+
+	if (argc != 1) {
+		platform_cmd_usage(cmd);
+		errno = EINVAL;
+		return -1;
+	}
+
+	return elog_export(intf, argv[0]);
+}
+
+/*
+ * eventlog_smbios_decode_cmd  -  list or query an exported log
+ *
+ * The platform's decoders are used, but the log is read from the file
+ * and handed to them in place. Hardware is not accessed.
+ */
+static int eventlog_smbios_decode_cmd(struct platform_intf *intf,
+				      struct platform_cmd *cmd,
+				      int argc, char **argv)
+{
+	struct elog_export_log log;
+	struct elog_columns cols;
+	struct elog_query query;
+	int entry_count = 0, rc;
+
+	if (!intf->cb->eventlog) {
+		errno = ENOSYS;
+		return -1;
+	}
+
+	if ((argc != 1 && (argc < 2 || strcmp(argv[1], "query"))) ||
+	    (argc > 1 && eventlog_parse_query(argc - 2, &argv[2],
+					      &query) < 0)) {
+		platform_cmd_usage(cmd);
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (elog_import(argv[0], &log) < 0)
+		return -1;
+
+	if (strcasecmp(log.platform, intf->name))
+		lprintf(LOG_WARNING, "%s was exported on %s, decoding as %s\n",
+		        argv[0], log.platform, intf->name);
+
+	if (argc == 1) {
+		rc = smbios_eventlog_foreach_event_in(
+			intf, log.data, log.length, log.header_offset,
+			log.data_offset, intf->cb->eventlog->verify_header,
+			eventlog_smbios_list_callback, &entry_count);
+	} else {
+		rc = elog_columns_decode_log(intf, &cols, &query, log.data,
+					     log.length, log.header_offset,
+					     log.data_offset);
+		if (rc == 0) {
+			rc = eventlog_query_print(intf, &cols, &query);
+			elog_columns_free(&cols);
+		}
+	}
+
+	elog_import_free(&log);
+	return rc;
+}
+
+static const struct resource_claim eventlog_read_resources[] = {
+	{ RESOURCE_HOST_FLASH, NULL, IPC_LOCK_SHARED },
+	{ RESOURCE_NONE },
+};
+
+static const struct resource_claim eventlog_write_resources[] = {
+	{ RESOURCE_HOST_FLASH, NULL, IPC_LOCK_EXCLUSIVE },
+	{ RESOURCE_NONE },
+};
+
+/* decoding a saved log touches no hardware */
+static const struct resource_claim eventlog_offline_resources[] = {
+	{ RESOURCE_NONE },
+};
+
 struct platform_cmd eventlog_smbios_cmds[] = {
 	{
 		.name	= "list",
 		.desc	= "List Event Log",
+		.usage	= "[--since-cursor]\n\n"
+			  "--since-cursor lists only entries added since "
+			  "the last\nlisting with --since-cursor",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = eventlog_smbios_list_cmd }
+		.arg	= { .func = eventlog_smbios_list_cmd },
+		.resources	= eventlog_read_resources
 	},
 	{
 		.name	= "add",
 		.desc	= "Add entry to Event Log",
-		.usage	= "<event type> [event data]\n\n"
+		.usage	= "<event type> [event data] "
+			  "[<event type> <event data> ...]\n"
+			  "       eventlog add -f <file>\n\n"
 			  "event type is number, event data is a "
-			  "series of bytes",
+			  "series of bytes\n"
+			  "when adding several events, each type must be "
+			  "followed by\nits data, which may be \"\" for "
+			  "none\n"
+			  "a file lists one \"<event type> [event data]\" "
+			  "per line\n"
+			  "all events are added with a single write",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = eventlog_smbios_add_cmd }
+		.arg	= { .func = eventlog_smbios_add_cmd },
+		.resources	= eventlog_write_resources
+	},
+	{
+		.name	= "query",
+		.desc	= "Count Event Log entries",
+		.usage	= "[--type <type>[,<type>...]] [--since <time>] "
+			  "[--until <time>]\n"
+			  "       [--entries <first>[-[<last>]]] "
+			  "[--hourly | --first-last]\n\n"
+			  "counts matching entries per type, per type and "
+			  "hour with --hourly\n"
+			  "or with their first and last occurrence with "
+			  "--first-last\n"
+			  "time is seconds since the epoch, or a number "
+			  "followed by s, m, h or d\n"
+			  "for that long ago\n"
+			  "entries are numbered from 0 in the order they "
+			  "are logged",
+		.type	= ARG_TYPE_GETTER,
+		.arg	= { .func = eventlog_smbios_query_cmd },
+		.resources	= eventlog_read_resources
 	},
 	{
 		.name	= "clear",
 		.desc	= "Clear Event Log",
 		.type	= ARG_TYPE_SETTER,
-		.arg	= { .func = eventlog_smbios_clear_cmd }
+		.arg	= { .func = eventlog_smbios_clear_cmd },
+		.resources	= eventlog_write_resources
+	},
+	{
+		.name	= "export",
+		.desc	= "Save Event Log to a file",
+		.usage	= "<file>\n\n"
+			  "the raw log is saved with what is needed to "
+			  "decode it offline\n"
+			  "using \"mosys -p <platform> eventlog decode\"",
+		.type	= ARG_TYPE_GETTER,
+		.arg	= { .func = eventlog_smbios_export_cmd },
+		.resources	= eventlog_read_resources
+	},
+	{
+		.name	= "decode",
+		.desc	= "List Event Log saved to a file",
+		.usage	= "<file> [query [query options]]\n\n"
+			  "lists the entries of a log saved by \"eventlog "
+			  "export\", or\n"
+			  "runs \"eventlog query\" on it",
+		.type	= ARG_TYPE_GETTER,
+		.arg	= { .func = eventlog_smbios_decode_cmd },
+		.resources	= eventlog_offline_resources
 	},
 	{ NULL }
 };
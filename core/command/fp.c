@@ -35,6 +35,7 @@
 #include "mosys/kv_pair.h"
 #include "mosys/log.h"
 #include "mosys/platform.h"
+#include "mosys/resource_lock.h"
 
 static int fp_info(struct platform_intf *intf,
                    struct platform_cmd *cmd, int argc, char **argv)
@@ -63,12 +64,18 @@ static int fp_info(struct platform_intf *intf,
 	return rc;
 }
 
+static const struct resource_claim fp_resources[] = {
+	{ RESOURCE_EC, "fp", IPC_LOCK_SHARED },
+	{ RESOURCE_NONE },
+};
+
 struct platform_cmd fp_cmds[] = {
 	{
 		.name	= "info",
 		.desc	= "Print basic FP MCU information",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = fp_info}
+		.arg	= { .func = fp_info},
+		.resources	= fp_resources
 	},
 	/* TODO: add a sub-menu for FP commands */
 	{ NULL }
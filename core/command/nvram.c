@@ -37,6 +37,7 @@
 
 #include "mosys/log.h"
 #include "mosys/platform.h"
+#include "mosys/resource_lock.h"
 
 static int nvram_clear_cmd(struct platform_intf *intf,
                            struct platform_cmd *cmd, int argc, char **argv)
@@ -99,18 +100,26 @@ static int nvram_vboot_write(struct platform_intf *intf,
 	return intf->cb->nvram->vboot_write(intf, argv[0]);
 }
 
+/* CMOS is accessed through index/data registers, even for reads */
+static const struct resource_claim nvram_resources[] = {
+	{ RESOURCE_CMOS, NULL, IPC_LOCK_EXCLUSIVE },
+	{ RESOURCE_NONE },
+};
+
 struct platform_cmd nvram_vboot_cmds[] = {
 	{
 		.name	= "read",
 		.desc	= "Read VbNvContext from NVRAM",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = nvram_vboot_read }
+		.arg	= { .func = nvram_vboot_read },
+		.resources	= nvram_resources
 	},
 	{
 		.name	= "write",
 		.desc	= "Write VbNvContext from NVRAM",
 		.type	= ARG_TYPE_SETTER,
-		.arg	= { .func = nvram_vboot_write }
+		.arg	= { .func = nvram_vboot_write },
+		.resources	= nvram_resources
 	},
 	{ NULL }
 };
@@ -120,19 +129,22 @@ struct platform_cmd nvram_cmds[] = {
 		.name	= "clear",
 		.desc	= "Clear Configuration",
 		.type	= ARG_TYPE_SETTER,
-		.arg	= { .func = nvram_clear_cmd }
+		.arg	= { .func = nvram_clear_cmd },
+		.resources	= nvram_resources
 	},
 	{
 		.name	= "dump",
 		.desc	= "Dump NVRAM",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = nvram_dump_cmd }
+		.arg	= { .func = nvram_dump_cmd },
+		.resources	= nvram_resources
 	},
 	{
 		.name	= "list",
 		.desc	= "List NVRAM Variables",
 		.type	= ARG_TYPE_SETTER,
-		.arg	= { .func = nvram_list_cmd }
+		.arg	= { .func = nvram_list_cmd },
+		.resources	= nvram_resources
 	},
 	{
 		.name	= "vboot",
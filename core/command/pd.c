@@ -35,6 +35,7 @@
 #include "mosys/kv_pair.h"
 #include "mosys/log.h"
 #include "mosys/platform.h"
+#include "mosys/resource_lock.h"
 
 static int pd_info(struct platform_intf *intf,
 		   struct platform_cmd *cmd, int argc, char **argv)
@@ -81,19 +82,26 @@ static int pd_chip_info(struct platform_intf *intf,
 	return intf->cb->ec->pd_chip_info(intf, intf->cb->ec, port);
 }
 
+static const struct resource_claim pd_resources[] = {
+	{ RESOURCE_EC, "pd", IPC_LOCK_SHARED },
+	{ RESOURCE_NONE },
+};
+
 struct platform_cmd pd_cmds[] = {
 	{
 		.name	= "info",
 		.desc	= "Print basic PD information",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = pd_info }
+		.arg	= { .func = pd_info },
+		.resources	= pd_resources
 	},
 	{
 		.name	= "chip",
 		.desc	= "Print basic PD information",
 		.usage = "<port>",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = pd_chip_info }
+		.arg	= { .func = pd_chip_info },
+		.resources	= pd_resources
 	},
 	/* TODO: add a sub-menu for PD commands */
 	{ NULL }
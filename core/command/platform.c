@@ -42,6 +42,7 @@
 #include "lib/sku.h"
 #include "mosys/log.h"
 #include "mosys/kv_pair.h"
+#include "mosys/resource_lock.h"
 
 /* Identifiers for platform_generic_identifier_cmd. */
 enum {
@@ -222,60 +223,82 @@ static int platform_reset_cmd(struct platform_intf *intf,
 	return intf->cb->sys->reset(intf);
 }
 
+/* board version and SKU may come from the EC */
+static const struct resource_claim platform_resources[] = {
+	{ RESOURCE_EC, "ec", IPC_LOCK_SHARED },
+	{ RESOURCE_NONE },
+};
+
+/* model, chassis, brand and customization may fall back to VPD in flash */
+static const struct resource_claim platform_vpd_resources[] = {
+	{ RESOURCE_HOST_FLASH, NULL, IPC_LOCK_SHARED },
+	{ RESOURCE_EC, "ec", IPC_LOCK_SHARED },
+	{ RESOURCE_NONE },
+};
+
 struct platform_cmd platform_cmds[] = {
 	{
 		.name	= "vendor",
 		.desc	= "Display Platform Vendor",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = platform_vendor_cmd }
+		.arg	= { .func = platform_vendor_cmd },
+		.resources	= platform_resources
 	},
 	{
 		.name	= "name",
 		.desc	= "Display Platform Product Name",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = platform_name_cmd }
+		.arg	= { .func = platform_name_cmd },
+		.resources	= platform_resources
 	},
 	{
 		.name	= "model",
 		.desc	= "Display Model",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = platform_model_cmd }
+		.arg	= { .func = platform_model_cmd },
+		.resources	= platform_vpd_resources
 	},
 	{
 		.name	= "chassis",
 		.desc	= "Display Chassis ID",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = platform_chassis_cmd }
+		.arg	= { .func = platform_chassis_cmd },
+		.resources	= platform_vpd_resources
 	},
 	{
 		.name	= "sku",
 		.desc	= "Display SKU Number",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = platform_sku_cmd }
+		.arg	= { .func = platform_sku_cmd },
+		.resources	= platform_resources
 	},
 	{
 		.name	= "brand",
 		.desc	= "Display Brand Code",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = platform_brand_cmd }
+		.arg	= { .func = platform_brand_cmd },
+		.resources	= platform_vpd_resources
 	},
 	{
 		.name	= "customization",
 		.desc	= "Display Customization ID",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = platform_customization_cmd }
+		.arg	= { .func = platform_customization_cmd },
+		.resources	= platform_vpd_resources
 	},
 	{
 		.name	= "version",
 		.desc	= "Display Platform Version",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = platform_version_cmd }
+		.arg	= { .func = platform_version_cmd },
+		.resources	= platform_resources
 	},
 	{
 		.name	= "family",
 		.desc	= "Display Platform Family",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = platform_family_cmd }
+		.arg	= { .func = platform_family_cmd },
+		.resources	= platform_resources
 	},
 	{
 		.name	= "reset",
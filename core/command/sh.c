@@ -35,6 +35,7 @@
 #include "mosys/kv_pair.h"
 #include "mosys/log.h"
 #include "mosys/platform.h"
+#include "mosys/resource_lock.h"
 
 static int sh_info(struct platform_intf *intf,
                    struct platform_cmd *cmd, int argc, char **argv)
@@ -62,12 +63,18 @@ static int sh_info(struct platform_intf *intf,
 	return rc;
 }
 
+static const struct resource_claim sh_resources[] = {
+	{ RESOURCE_EC, "sh", IPC_LOCK_SHARED },
+	{ RESOURCE_NONE },
+};
+
 struct platform_cmd sh_cmds[] = {
 	{
 		.name	= "info",
 		.desc	= "Print basic sh information",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = sh_info}
+		.arg	= { .func = sh_info},
+		.resources	= sh_resources
 	},
 	/* TODO: add a sub-menu for sh commands */
 	{ NULL }
@@ -39,6 +39,7 @@
 #include "mosys/log.h"
 #include "mosys/kv_pair.h"
 #include "mosys/platform.h"
+#include "mosys/resource_lock.h"
 
 #include "lib/smbios.h"
 #include "lib/smbios_tables.h"
@@ -193,24 +194,32 @@ static int smbios_info_log_cmd(struct platform_intf *intf,
 	return rc;
 }
 
+/* tables are read from sysfs or memory, which need no lock */
+static const struct resource_claim smbios_resources[] = {
+	{ RESOURCE_NONE },
+};
+
 struct platform_cmd smbios_info_cmds[] = {
 	{
 		.name	= "bios",
 		.desc	= "BIOS Information Table",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = smbios_info_bios_cmd }
+		.arg	= { .func = smbios_info_bios_cmd },
+		.resources	= smbios_resources
 	},
 	{
 		.name	= "system",
 		.desc	= "System Information Table",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = smbios_info_system_cmd }
+		.arg	= { .func = smbios_info_system_cmd },
+		.resources	= smbios_resources
 	},
 	{
 		.name	= "log",
 		.desc	= "Event Log Table",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = smbios_info_log_cmd }
+		.arg	= { .func = smbios_info_log_cmd },
+		.resources	= smbios_resources
 	},
 	{ NULL }
 };
@@ -221,7 +230,8 @@ struct platform_cmd smbios_cmds[] = {
 		.desc	= "Legacy String Retrieval",
 		.usage	= "<table type> <string number>",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = smbios_get_cmd }
+		.arg	= { .func = smbios_get_cmd },
+		.resources	= smbios_resources
 	},
 	{
 		.name	= "info",
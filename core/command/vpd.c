@@ -40,6 +40,7 @@
 #include "mosys/log.h"
 #include "mosys/kv_pair.h"
 #include "mosys/platform.h"
+#include "mosys/resource_lock.h"
 
 #include "lib/string.h"
 #include "lib/vpd.h"
@@ -152,9 +153,11 @@ static int vpd_print_blobs_cmd(struct platform_intf *intf,
 {
 	struct vpd_table table;
 	struct kv_pair *kv, *blob_kv;
-	int i, rc;
+	int i, count, rc = 0;
 
-	for (i = 0; i < 0xffff; i++) {
+	count = vpd_count_tables(intf, VPD_TYPE_BINARY_BLOB_POINTER,
+	                         vpd_rom_base, vpd_rom_size);
+	for (i = 0; i < count; i++) {
 		if (vpd_find_table(intf, VPD_TYPE_BINARY_BLOB_POINTER,
 		                   i, &table, vpd_rom_base, vpd_rom_size) < 0) {
 			lprintf(LOG_DEBUG, "cannot find binary blob pointer\n");
@@ -230,7 +233,7 @@ static int vpd_dump_blobs_cmd(struct platform_intf *intf,
 		end = start + 1;
 	} else {
 		start = 0;
-		end = 0xffff;
+		end = vpd_count_tables(intf, type, vpd_rom_base, vpd_rom_size);
 	}
 
 	/* find the VPD structure table entry */
@@ -278,20 +281,27 @@ static int vpd_dump_blobs_cmd(struct platform_intf *intf,
 	return 0;
 }
 
+static const struct resource_claim vpd_resources[] = {
+	{ RESOURCE_HOST_FLASH, NULL, IPC_LOCK_SHARED },
+	{ RESOURCE_NONE },
+};
+
 struct platform_cmd vpd_find_cmds[] = {
 	{
 		.name	= "string",
 		.desc	= "Retrieve a Specified String",
 		.usage	= "<table type> <string number>",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = vpd_find_string_cmd }
+		.arg	= { .func = vpd_find_string_cmd },
+		.resources	= vpd_resources
 	},
 	{
 		.name	= "blob",
 		.desc	= "Decode Specified Binary Blob",
 		.usage	= "<vendor> <description>",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = vpd_find_blob_cmd }
+		.arg	= { .func = vpd_find_blob_cmd },
+		.resources	= vpd_resources
 	},
 	{ NULL },
 };
@@ -301,25 +311,29 @@ struct platform_cmd vpd_print_cmds[] = {
 		.name	= "all",
 		.desc	= "Print All Tables",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = vpd_print_all_cmd }
+		.arg	= { .func = vpd_print_all_cmd },
+		.resources	= vpd_resources
 	},
 	{
 		.name	= "firmware",
 		.desc	= "Firmware Information Table",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = vpd_print_firmware_cmd }
+		.arg	= { .func = vpd_print_firmware_cmd },
+		.resources	= vpd_resources
 	},
 	{
 		.name	= "system",
 		.desc	= "System Information Table",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = vpd_print_system_cmd }
+		.arg	= { .func = vpd_print_system_cmd },
+		.resources	= vpd_resources
 	},
 	{
 		.name	= "blobs",
 		.desc	= "Binary Blobs Pointer Tables",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = vpd_print_blobs_cmd }
+		.arg	= { .func = vpd_print_blobs_cmd },
+		.resources	= vpd_resources
 	},
 	{ NULL }
 };
@@ -349,7 +363,8 @@ struct platform_cmd vpd_dump_cmds[] = {
 		.name	= "blobs",
 		.desc	= "Binary Blobs",
 		.type	= ARG_TYPE_GETTER,
-		.arg	= { .func = vpd_dump_blobs_cmd }
+		.arg	= { .func = vpd_dump_blobs_cmd },
+		.resources	= vpd_resources
 	},
 	{ NULL }
 };
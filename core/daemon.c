@@ -0,0 +1,269 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * daemon.c: mosysd protocol helpers and client
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "mosys/alloc.h"
+#include "mosys/daemon.h"
+#include "mosys/log.h"
+
+int mosysd_read_full(int fd, void *buf, size_t len)
+{
+	uint8_t *p = buf;
+	ssize_t n;
+
+	while (len) {
+		n = read(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		p += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+int mosysd_write_full(int fd, const void *buf, size_t len)
+{
+	const uint8_t *p = buf;
+	ssize_t n;
+
+	while (len) {
+		n = write(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		p += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+int mosysd_set_timeout(int fd, int timeout_secs)
+{
+	struct timeval tv;
+
+	tv.tv_sec = timeout_secs;
+	tv.tv_usec = 0;
+	if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0 ||
+	    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0) {
+		lperror(LOG_DEBUG, "%s: Unable to set timeout", __func__);
+		return -1;
+	}
+
+	return 0;
+}
+
+int mosysd_send_request(int fd, enum kv_pair_style style,
+                        const char *single_key, int argc, char **argv)
+{
+	struct mosysd_request req;
+	char *data, *p;
+	size_t len;
+	int i, ret = 0;
+
+	if (!single_key)
+		single_key = "";
+	len = strlen(single_key) + 1;
+	for (i = 0; i < argc; i++)
+		len += strlen(argv[i]) + 1;
+
+	req.magic = MOSYSD_REQUEST_MAGIC;
+	req.style = style;
+	req.argc = argc;
+	req.len = len;
+
+	p = data = mosys_malloc(len);
+	strcpy(p, single_key);
+	p += strlen(p) + 1;
+	for (i = 0; i < argc; i++) {
+		strcpy(p, argv[i]);
+		p += strlen(p) + 1;
+	}
+
+	if (mosysd_write_full(fd, &req, sizeof(req)) < 0 ||
+	    mosysd_write_full(fd, data, len) < 0)
+		ret = -1;
+
+	free(data);
+	return ret;
+}
+
+int mosysd_recv_request(int fd, struct mosysd_request *req,
+                        char **single_key, char ***argv)
+{
+	char *data, *p, *end;
+	char **args;
+	uint32_t i;
+
+	if (mosysd_read_full(fd, req, sizeof(*req)) < 0)
+		return -1;
+
+	if (req->magic != MOSYSD_REQUEST_MAGIC ||
+	    req->len > MOSYSD_MAX_LEN || req->argc > req->len) {
+		lprintf(LOG_DEBUG, "%s: invalid request\n", __func__);
+		return -1;
+	}
+
+	/* argument pointers and strings share one allocation */
+	args = mosys_malloc((req->argc + 1) * sizeof(*args) + req->len + 1);
+	data = (char *)&args[req->argc + 1];
+	if (mosysd_read_full(fd, data, req->len) < 0) {
+		free(args);
+		return -1;
+	}
+	data[req->len] = '\0';
+
+	p = data;
+	end = data + req->len;
+	*single_key = *p ? p : NULL;
+	p += strlen(p) + 1;
+	for (i = 0; i < req->argc; i++) {
+		if (p >= end) {
+			lprintf(LOG_DEBUG, "%s: truncated request\n",
+			        __func__);
+			free(args);
+			return -1;
+		}
+		args[i] = p;
+		p += strlen(p) + 1;
+	}
+	args[req->argc] = NULL;
+
+	*argv = args;
+	return 0;
+}
+
+int mosysd_send_response(int fd, int status, const void *data, size_t len)
+{
+	struct mosysd_response rsp;
+
+	rsp.magic = MOSYSD_RESPONSE_MAGIC;
+	rsp.status = status;
+	rsp.len = len;
+
+	if (mosysd_write_full(fd, &rsp, sizeof(rsp)) < 0)
+		return -1;
+	if (len && mosysd_write_full(fd, data, len) < 0)
+		return -1;
+
+	return 0;
+}
+
+/*
+ * mosysd_connect  -  connect to mosysd socket
+ *
+ * @path:	path of socket
+ *
+ * returns connected socket
+ * returns <0 to indicate failure
+ */
+static int mosysd_connect(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		lprintf(LOG_ERR, "Socket path %s is too long\n", path);
+		return -1;
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		lperror(LOG_ERR, "Unable to create socket");
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		lperror(LOG_ERR, "Unable to connect to %s", path);
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+int mosysd_client(const char *path, enum kv_pair_style style,
+                  const char *single_key, int argc, char **argv)
+{
+	struct mosysd_response rsp;
+	char buf[4096];
+	size_t len, n;
+	int fd, ret = -1;
+
+	fd = mosysd_connect(path);
+	if (fd < 0)
+		return -1;
+
+	if (mosysd_send_request(fd, style, single_key, argc, argv) < 0) {
+		lperror(LOG_ERR, "Unable to send request to %s", path);
+		goto mosysd_client_exit;
+	}
+
+	if (mosysd_read_full(fd, &rsp, sizeof(rsp)) < 0 ||
+	    rsp.magic != MOSYSD_RESPONSE_MAGIC) {
+		lprintf(LOG_ERR, "Invalid response from %s\n", path);
+		goto mosysd_client_exit;
+	}
+
+	/* copy output through as it arrives */
+	for (len = rsp.len; len; len -= n) {
+		n = len < sizeof(buf) ? len : sizeof(buf);
+		if (mosysd_read_full(fd, buf, n) < 0) {
+			lprintf(LOG_ERR, "Truncated response from %s\n", path);
+			goto mosysd_client_exit;
+		}
+		fwrite(buf, 1, n, stdout);
+	}
+	fflush(stdout);
+
+	ret = rsp.status;
+
+mosysd_client_exit:
+	close(fd);
+	return ret;
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * daemon_unittest.c: unit tests for the mosysd protocol
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "cmockery.h"
+
+#include "mosys/daemon.h"
+
+static void request_test(void **state)
+{
+	char *args[] = { "platform", "name", "" };
+	struct mosysd_request req;
+	char *single_key, **argv;
+	int sv[2];
+
+	assert_int_equal(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+
+	assert_int_equal(0, mosysd_send_request(sv[0], KV_STYLE_SINGLE,
+	                                        "name", 3, args));
+	assert_int_equal(0, mosysd_recv_request(sv[1], &req,
+	                                        &single_key, &argv));
+	assert_int_equal(KV_STYLE_SINGLE, req.style);
+	assert_int_equal(3, req.argc);
+	assert_string_equal("name", single_key);
+	assert_string_equal("platform", argv[0]);
+	assert_string_equal("name", argv[1]);
+	assert_string_equal("", argv[2]);
+	assert_true(argv[3] == NULL);
+	free(argv);
+
+	/* no single key */
+	assert_int_equal(0, mosysd_send_request(sv[0], KV_STYLE_PAIR,
+	                                        NULL, 1, args));
+	assert_int_equal(0, mosysd_recv_request(sv[1], &req,
+	                                        &single_key, &argv));
+	assert_true(single_key == NULL);
+	assert_int_equal(1, req.argc);
+	assert_string_equal("platform", argv[0]);
+	free(argv);
+
+	close(sv[0]);
+	close(sv[1]);
+}
+
+static void bad_request_test(void **state)
+{
+	struct mosysd_request req;
+	char *single_key, **argv;
+	int sv[2];
+
+	/* wrong magic */
+	assert_int_equal(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+	req.magic = MOSYSD_RESPONSE_MAGIC;
+	req.style = KV_STYLE_PAIR;
+	req.argc = 0;
+	req.len = 1;
+	assert_int_equal(0, mosysd_write_full(sv[0], &req, sizeof(req)));
+	assert_int_equal(0, mosysd_write_full(sv[0], "", 1));
+	assert_int_equal(-1, mosysd_recv_request(sv[1], &req,
+	                                         &single_key, &argv));
+	close(sv[0]);
+	close(sv[1]);
+
+	/* more arguments than the data holds */
+	assert_int_equal(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+	req.magic = MOSYSD_REQUEST_MAGIC;
+	req.argc = 2;
+	req.len = 3;
+	assert_int_equal(0, mosysd_write_full(sv[0], &req, sizeof(req)));
+	assert_int_equal(0, mosysd_write_full(sv[0], "\0a", 3));
+	assert_int_equal(-1, mosysd_recv_request(sv[1], &req,
+	                                         &single_key, &argv));
+	close(sv[0]);
+	close(sv[1]);
+
+	/* client hangs up half way through */
+	assert_int_equal(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+	req.argc = 1;
+	req.len = 16;
+	assert_int_equal(0, mosysd_write_full(sv[0], &req, sizeof(req)));
+	close(sv[0]);
+	assert_int_equal(-1, mosysd_recv_request(sv[1], &req,
+	                                         &single_key, &argv));
+	close(sv[1]);
+}
+
+static void timeout_test(void **state)
+{
+	struct mosysd_request req;
+	char *single_key, **argv;
+	time_t start;
+	int sv[2];
+
+	/* a client which connects and sends nothing is dropped */
+	assert_int_equal(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+	assert_int_equal(0, mosysd_set_timeout(sv[1], 1));
+	start = time(NULL);
+	assert_int_equal(-1, mosysd_recv_request(sv[1], &req,
+	                                         &single_key, &argv));
+	assert_true(time(NULL) - start <= 3);
+	close(sv[0]);
+	close(sv[1]);
+}
+
+static void response_test(void **state)
+{
+	struct mosysd_response rsp;
+	char buf[4];
+	int sv[2];
+
+	assert_int_equal(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+	assert_int_equal(0, mosysd_send_response(sv[0], 3, "out", 3));
+	assert_int_equal(0, mosysd_read_full(sv[1], &rsp, sizeof(rsp)));
+	assert_int_equal(MOSYSD_RESPONSE_MAGIC, rsp.magic);
+	assert_int_equal(3, rsp.status);
+	assert_int_equal(3, rsp.len);
+	assert_int_equal(0, mosysd_read_full(sv[1], buf, rsp.len));
+	assert_memory_equal("out", buf, 3);
+
+	/* nothing more is sent */
+	close(sv[0]);
+	assert_int_equal(-1, mosysd_read_full(sv[1], buf, 1));
+	close(sv[1]);
+}
+
+int daemon_unittest(void)
+{
+	UnitTest tests[] = {
+		unit_test(request_test),
+		unit_test(bad_request_test),
+		unit_test(timeout_test),
+		unit_test(response_test),
+	};
+
+	return run_tests(tests);
+}
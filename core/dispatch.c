@@ -0,0 +1,309 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * dispatch.c: command dispatch
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mosys/big_lock.h"
+#include "mosys/kv_pair.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+#include "mosys/resource_lock.h"
+#include "mosys/result_cache.h"
+
+#define LOCK_TIMEOUT_SECS 180
+
+/*
+ * cmd_list_entry  -  list a command
+ *
+ * While output is captured, e.g. by the library, each command becomes a
+ * record instead of a line on stdout.
+ */
+static void cmd_list_entry(const char *name, const char *desc)
+{
+	struct kv_pair *kv;
+
+	if (!kv_pair_capturing()) {
+		printf("    %-12s  %s\n", name, desc);
+		return;
+	}
+
+	kv = kv_pair_new();
+	kv_pair_add(kv, "command", name);
+	kv_pair_add(kv, "description", desc);
+	kv_pair_print(kv);
+	kv_pair_free(kv);
+}
+
+static void sub_list(struct platform_cmd *sub)
+{
+	struct platform_cmd *_sub;
+
+	if (!sub)
+		return;
+
+	if (!kv_pair_capturing())
+		printf("  Commands:\n");
+	for (_sub = sub->arg.sub; _sub && _sub->name; _sub++) {
+		if (_sub->desc)
+			cmd_list_entry(_sub->name, _sub->desc);
+	}
+	if (!kv_pair_capturing())
+		printf("\n");
+}
+
+/*
+ * sub_run  -  run command handler with the locks it needs
+ *
+ * Commands which declare the resources they use take only those locks
+ * and share the big lock, so they run alongside other such commands.
+ * Undeclared commands keep the big lock exclusive, as before resource
+ * locks existed. The big lock is left alone if the caller does not hold
+ * it, e.g. when forced.
+ *
+ * returns return value of command handler
+ * returns <0 if a lock could not be acquired
+ */
+static int sub_run(struct platform_intf *intf,
+		   struct platform_cmd *sub, int argc, char **argv)
+{
+	int ret;
+
+#if defined(CONFIG_USE_IPC_LOCK)
+	enum ipc_lock_mode mode;
+
+	mode = sub->resources ? IPC_LOCK_SHARED : IPC_LOCK_EXCLUSIVE;
+	if (mosys_big_lock_is_held() &&
+	    mosys_acquire_big_lock_mode(mode, LOCK_TIMEOUT_SECS) < 0)
+		return -1;
+
+	if (sub->resources &&
+	    mosys_acquire_resources(sub->resources, LOCK_TIMEOUT_SECS) < 0)
+		return -1;
+#endif
+
+	ret = sub->arg.func(intf, sub, argc, argv);
+
+	/* even a failed write may have changed something */
+	if (sub->type == ARG_TYPE_SETTER)
+		result_cache_invalidate();
+
+#if defined(CONFIG_USE_IPC_LOCK)
+	if (sub->resources)
+		mosys_release_resources(sub->resources);
+#endif
+
+	return ret;
+}
+
+static int sub_main(struct platform_intf *intf,
+		    struct platform_cmd *sub, int argc, char **argv)
+{
+	struct platform_cmd *cmd;
+
+	if (!intf || !sub) {
+		errno = ENOSYS;
+		return -1;
+	}
+
+	switch (sub->type) {
+	case ARG_TYPE_GETTER:
+	case ARG_TYPE_SETTER:
+		if (!sub->arg.func) {
+			lprintf(LOG_ERR, "Undefined Function\n");
+			return -1;
+		}
+
+		/* this is a function, it might have more args */
+		if (argc > 0 && strcmp(argv[0], "help") == 0) {
+			platform_cmd_usage(sub);
+			return 0;
+		}
+
+		/* run command handler */
+		return sub_run(intf, sub, argc, argv);
+
+	case ARG_TYPE_SUB:
+		if (argc == 0) {
+			sub_list(sub);
+			return -1;	/* generic error */
+		}
+
+		/* this is a sub-command, we must have some more args */
+		if (argc == 0 || strcmp(argv[0], "help") == 0) {
+			sub_list(sub);
+			return 0;
+		}
+
+		/* search for matching sub-command */
+		for (cmd = sub->arg.sub; cmd && cmd->name; cmd++) {
+			if (strlen(cmd->name) != strlen(argv[0]))
+				continue;
+			if (strcmp(cmd->name, argv[0]) == 0) {
+				lprintf(LOG_DEBUG, "Subcommand %s (%s)\n",
+					cmd->name, cmd->desc);
+				return sub_main(intf, cmd, argc - 1,
+						&(argv[1]));
+			}
+		}
+		break;
+
+	default:
+		lprintf(LOG_ERR, "Unknown subcommand type\n");
+		return -1;
+	}
+
+	lprintf(LOG_WARNING, "Command not found\n\n");
+	sub_list(sub);
+
+	errno = EINVAL;	/* unknown or invalid subcommand argument */
+	return -1;
+}
+
+/*
+ * platform_cmd_find  -  find the command handler arguments lead to
+ *
+ * @intf:	platform interface
+ * @argc:	number of arguments
+ * @argv:	command and its arguments, e.g. { "platform", "name" }
+ *
+ * Commands are looked up the way platform_dispatch() does, without
+ * running anything.
+ *
+ * returns pointer to getter or setter
+ * returns NULL if arguments do not lead to one
+ */
+struct platform_cmd *platform_cmd_find(struct platform_intf *intf,
+                                       int argc, char **argv)
+{
+	struct platform_cmd **_sub, *cmd = NULL;
+
+	if (!intf || !intf->sub || argc == 0)
+		return NULL;
+
+	for (_sub = intf->sub; *_sub; _sub++) {
+		if (strcmp((*_sub)->name, argv[0]) == 0) {
+			cmd = *_sub;
+			break;
+		}
+	}
+
+	while (cmd && cmd->type == ARG_TYPE_SUB) {
+		argc--;
+		argv++;
+		if (argc == 0)
+			return NULL;
+
+		for (cmd = cmd->arg.sub; cmd && cmd->name; cmd++) {
+			if (strcmp(cmd->name, argv[0]) == 0)
+				break;
+		}
+		if (cmd && !cmd->name)
+			cmd = NULL;
+	}
+
+	if (!cmd || (cmd->type != ARG_TYPE_GETTER &&
+	             cmd->type != ARG_TYPE_SETTER))
+		return NULL;
+
+	return cmd;
+}
+
+/*
+ * platform_dispatch  -  run command given as arguments
+ *
+ * @intf:	platform interface
+ * @argc:	number of arguments
+ * @argv:	command and its arguments, e.g. { "platform", "name" }
+ * @usage:	prints program usage before command list, may be NULL
+ *
+ * returns return value of command handler
+ * returns <0 with errno set to ENOSYS if command is not found
+ */
+int platform_dispatch(struct platform_intf *intf, int argc, char **argv,
+                      void (*usage)(void))
+{
+	struct platform_cmd **_sub, *sub;
+	int do_list = 0;
+	int ret = 0;
+
+	if (!intf || !intf->sub) {
+		lprintf(LOG_ERR, "No commands defined for this platform\n");
+		errno = ENOSYS;
+		return -1;
+	}
+
+	if (argc == 0 || strcmp(argv[0], "help") == 0) {
+		do_list = 1;
+		if (usage)
+			usage();
+		if (!kv_pair_capturing())
+			printf("  Commands:\n");
+	}
+
+	/* go through subcommand list for this interface */
+	for (_sub = intf->sub; _sub && *_sub; _sub++) {
+
+		sub = *_sub;
+		if (do_list) {
+			/*FIXME: if the intf had a main sub, call sub_list */
+			cmd_list_entry(sub->name, sub->desc);
+			continue;
+		}
+
+		lprintf(LOG_DEBUG, "Command: %s (%s)\n", sub->name, argv[0]);
+
+		/* is this sub-command is the one they asked for? */
+		if (strlen(sub->name) != strlen(argv[0]))
+			continue;
+		if (strcmp(sub->name, argv[0]) == 0) {
+			lprintf(LOG_DEBUG, "Found command %s (%s)\n",
+				sub->name, sub->desc);
+			return sub_main(intf, sub, argc - 1, &(argv[1]));
+		}
+	}
+
+	if (do_list) {
+		if (!kv_pair_capturing())
+			printf("\n");
+		if (argc == 0)
+			ret = -1;
+		return ret;
+	}
+
+	lprintf(LOG_WARNING, "Command not found\n\n");
+	errno = ENOSYS;
+	/* trigger a help listing */
+	return platform_dispatch(intf, 0, NULL, usage);
+}
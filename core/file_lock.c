@@ -142,18 +142,20 @@ static int file_lock_open_or_create(struct ipc_lock *lock)
 	return 0;
 }
 
-static int file_lock_get(struct ipc_lock *lock, int timeout_msecs)
+static int file_lock_get(struct ipc_lock *lock, enum ipc_lock_mode mode,
+                         int timeout_msecs)
 {
 	int msecs_remaining = timeout_msecs;
 	struct timespec sleep_interval, rem;
+	int op = (mode == IPC_LOCK_SHARED) ? LOCK_SH : LOCK_EX;
 	int ret = -1;
 
 	if (timeout_msecs == 0)
-		return flock(lock->fd, LOCK_EX | LOCK_NB);
+		return flock(lock->fd, op | LOCK_NB);
 
 	msecs_to_timespec(SLEEP_INTERVAL_MS, &sleep_interval);
 
-	while ((ret = flock(lock->fd, LOCK_EX | LOCK_NB)) != 0) {
+	while ((ret = flock(lock->fd, op | LOCK_NB)) != 0) {
 		if (errno != EWOULDBLOCK) {
 			lperror(LOG_ERR, "Error obtaining lock");
 			return -1;
@@ -236,15 +238,45 @@ int mosys_lock(struct ipc_lock *lock, int timeout_msecs)
 	if (mosys_lock_is_held(lock))
 		return 1;
 
+	return mosys_lock_mode(lock, IPC_LOCK_EXCLUSIVE, timeout_msecs);
+}
+
+/*
+ * mosys_lock_mode - acquire a lock in the given mode
+ *
+ * timeout as for mosys_lock()
+ *
+ * returns 0 to indicate lock acquired or converted
+ * returns >0 to indicate lock was already held in this mode
+ * returns <0 to indicate failed to acquire lock
+ */
+int mosys_lock_mode(struct ipc_lock *lock, enum ipc_lock_mode mode,
+                    int timeout_msecs)
+{
+	if (mosys_lock_is_held(lock)) {
+		if (lock->mode == mode)
+			return 1;
+
+		/* flock() drops the old lock before taking the new one */
+		if (file_lock_get(lock, mode, timeout_msecs)) {
+			lock->is_held = 0;
+			close(lock->fd);
+			return -1;
+		}
+		lock->mode = mode;
+		return 0;
+	}
+
 	if (file_lock_open_or_create(lock))
 		return -1;
 
-	if (file_lock_get(lock, timeout_msecs)) {
+	if (file_lock_get(lock, mode, timeout_msecs)) {
 		lock->is_held = 0;
 		close(lock->fd);
 		return -1;
 	} else {
 		lock->is_held = 1;
+		lock->mode = mode;
 	}
 
 	/*
@@ -252,10 +284,12 @@ int mosys_lock(struct ipc_lock *lock, int timeout_msecs)
 	 * the file should not be considered fatal. There might be something
 	 * bad happening with the filesystem, but the lock has already been
 	 * obtained and we may need our tools for diagnostics and repairs
-	 * so we should continue anyway.
+	 * so we should continue anyway. Holders of a shared lock would
+	 * overwrite each other, so only an exclusive holder writes it.
 	 */
 
-	file_lock_write_pid(lock);
+	if (mode == IPC_LOCK_EXCLUSIVE)
+		file_lock_write_pid(lock);
 	return 0;
 }
 
@@ -87,3 +87,18 @@ void mosys_set_verbosity(int verbosity)
 {
 	mosys_verbosity = verbosity;
 }
+
+/*
+ * The global platform re-probe request
+ */
+static int mosys_force_probe;
+
+int mosys_get_force_probe(void)
+{
+	return mosys_force_probe;
+}
+
+void mosys_set_force_probe(int force)
+{
+	mosys_force_probe = force;
+}
@@ -30,7 +30,11 @@
  * intf_list.c: hardware component interfaces
  */
 
+#include <pthread.h>
+
+#include "mosys/callbacks.h"
 #include "mosys/intf_list.h"
+#include "mosys/log.h"
 #include "mosys/platform.h"
 
 #include "intf/i2c.h"
@@ -65,45 +69,124 @@ struct platform_op platform_common_op = {
 #endif
 };
 
+static pthread_mutex_t intf_op_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int intf_op_ready_mask;	/* bit per enum intf_op_type */
+static unsigned int intf_op_failed_mask;	/* setup failed, not retried */
+
 /*
- * intf_op_setup  -  prepare interface operations
+ * intf_op_setup_one  -  run setup function for one interface operation
  *
  * @intf:       platform interface
+ * @type:       interface operation type
  *
- * returns aggregate return code from setup functions
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
  */
-int intf_op_setup(struct platform_intf *intf)
+static int intf_op_setup_one(struct platform_intf *intf,
+                             enum intf_op_type type)
+{
+	int (*setup)(struct platform_intf *intf) = NULL;
+	int present = 0;
+
+	switch (type) {
+	case INTF_OP_PCI:
+		if ((present = intf->op->pci != NULL))
+			setup = intf->op->pci->setup;
+		break;
+	case INTF_OP_I2C:
+		if ((present = intf->op->i2c != NULL))
+			setup = intf->op->i2c->setup;
+		break;
+	case INTF_OP_IO:
+		if ((present = intf->op->io != NULL))
+			setup = intf->op->io->setup;
+		break;
+	case INTF_OP_MMIO:
+		if ((present = intf->op->mmio != NULL))
+			setup = intf->op->mmio->setup;
+		break;
+	default:
+		break;
+	}
+
+	if (!present)
+		return -1;
+	if (setup)
+		return setup(intf);
+	return 0;
+}
+
+/*
+ * intf_op_destroy_one  -  run destroy function for one interface operation
+ *
+ * @intf:       platform interface
+ * @type:       interface operation type
+ */
+static void intf_op_destroy_one(struct platform_intf *intf,
+                                enum intf_op_type type)
+{
+	switch (type) {
+	case INTF_OP_PCI:
+		if (intf->op->pci && intf->op->pci->destroy)
+			intf->op->pci->destroy(intf);
+		break;
+	case INTF_OP_I2C:
+		if (intf->op->i2c && intf->op->i2c->destroy)
+			intf->op->i2c->destroy(intf);
+		break;
+	case INTF_OP_IO:
+		if (intf->op->io && intf->op->io->destroy)
+			intf->op->io->destroy(intf);
+		break;
+	case INTF_OP_MMIO:
+		if (intf->op->mmio && intf->op->mmio->destroy)
+			intf->op->mmio->destroy(intf);
+		break;
+	default:
+		break;
+	}
+}
+
+static void intf_op_destroy_callback(void *arg)
+{
+	intf_op_destroy(arg);
+}
+
+int intf_op_ready(struct platform_intf *intf, enum intf_op_type type)
 {
 	int rc = 0;
 
-	if (intf->op->pci && intf->op->pci->setup)
-		rc |= intf->op->pci->setup(intf);
-	if (intf->op->i2c && intf->op->i2c->setup)
-		rc |= intf->op->i2c->setup(intf);
-	if (intf->op->io && intf->op->io->setup)
-		rc |= intf->op->io->setup(intf);
-	if (intf->op->mmio && intf->op->mmio->setup)
-		rc |= intf->op->mmio->setup(intf);
-#if 0
-	if (intf->op->amb && intf->op->amb->setup)
-		rc |= intf->op->amb->setup(intf);
-	if (intf->op->sp && intf->op->sp->setup)
-		rc |= intf->op->sp->setup(intf);
-	if (intf->op->msr && intf->op->msr->setup)
-		rc |= intf->op->msr->setup(intf);
-	if (intf->op->smi && intf->op->smi->setup)
-		rc |= intf->op->smi->setup(intf);
-	if (intf->op->cpuid && intf->op->cpuid->setup)
-		rc |= intf->op->cpuid->setup(intf);
-	/* interfaces to skip when mosys is being used as a library */
-	if (!MOSYS_AS_LIBRARY) {
-		if (intf->op->mce && intf->op->mce->setup)
-			rc |= intf->op->mce->setup(intf);
-		if (intf->op->edac && intf->op->edac->setup)
-			rc |= intf->op->edac->setup(intf);
+	/* this runs for every register access, so skip the lock when ready */
+	if (__atomic_load_n(&intf_op_ready_mask, __ATOMIC_ACQUIRE) &
+	    (1 << type))
+		return 0;
+
+	pthread_mutex_lock(&intf_op_lock);
+	if (intf_op_ready_mask & (1 << type))
+		goto intf_op_ready_exit;
+
+	/* a failed setup would only fail and be logged again */
+	if (intf_op_failed_mask & (1 << type)) {
+		rc = -1;
+		goto intf_op_ready_exit;
 	}
-#endif
 
+	rc = intf_op_setup_one(intf, type);
+	if (rc < 0) {
+		lprintf(LOG_DEBUG, "%s: setup of operation %d failed\n",
+		        __func__, type);
+		intf_op_failed_mask |= 1 << type;
+		goto intf_op_ready_exit;
+	}
+
+	/* make sure we get torn down at exit time. */
+	if (!intf_op_ready_mask)
+		add_destroy_callback(intf_op_destroy_callback, intf);
+	__atomic_store_n(&intf_op_ready_mask, intf_op_ready_mask | 1 << type,
+	                 __ATOMIC_RELEASE);
+
+intf_op_ready_exit:
+	pthread_mutex_unlock(&intf_op_lock);
 	return rc;
 }
 
@@ -114,31 +197,14 @@ int intf_op_setup(struct platform_intf *intf)
  */
 void intf_op_destroy(struct platform_intf *intf)
 {
-	if (intf->op->pci && intf->op->pci->destroy)
-		intf->op->pci->destroy(intf);
-	if (intf->op->i2c && intf->op->i2c->destroy)
-		intf->op->i2c->destroy(intf);
-	if (intf->op->io && intf->op->io->destroy)
-		intf->op->io->destroy(intf);
-	if (intf->op->mmio && intf->op->mmio->destroy)
-		intf->op->mmio->destroy(intf);
-#if 0
-	if (intf->op->amb && intf->op->amb->destroy)
-		intf->op->amb->destroy(intf);
-	if (intf->op->sp && intf->op->sp->destroy)
-		intf->op->sp->destroy(intf);
-	if (intf->op->msr && intf->op->msr->destroy)
-		intf->op->msr->destroy(intf);
-	if (intf->op->smi && intf->op->smi->destroy)
-		intf->op->smi->destroy(intf);
-	if (intf->op->cpuid && intf->op->cpuid->destroy)
-		intf->op->cpuid->destroy(intf);
-	/* interfaces to skip when mosys is being used as a library */
-	if (!MOSYS_AS_LIBRARY) {
-		if (intf->op->mce && intf->op->mce->destroy)
-			intf->op->mce->destroy(intf);
-		if (intf->op->edac && intf->op->edac->destroy)
-			intf->op->edac->destroy(intf);
+	enum intf_op_type type;
+
+	pthread_mutex_lock(&intf_op_lock);
+	for (type = 0; type < INTF_OP_MAX; type++) {
+		if (intf_op_ready_mask & (1 << type))
+			intf_op_destroy_one(intf, type);
 	}
-#endif
+	__atomic_store_n(&intf_op_ready_mask, 0, __ATOMIC_RELEASE);
+	intf_op_failed_mask = 0;
+	pthread_mutex_unlock(&intf_op_lock);
 }
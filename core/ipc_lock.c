@@ -138,3 +138,26 @@ mosys_unlock(struct ipc_lock *lock)
         /* did not hold the lock */
         return -1;
 }
+
+/*
+ * mosys_lock_mode - acquire a lock in the given mode
+ *
+ * Semaphores have no shared mode, so the lock is always held exclusively
+ * and changing the mode of a held lock does nothing.
+ *
+ * returns 0 to indicate lock acquired
+ * returns >0 to indicate lock was already held
+ * returns <0 to indicate failed to acquire lock
+ */
+int
+mosys_lock_mode(struct ipc_lock *lock, enum ipc_lock_mode mode,
+                int timeout_msecs)
+{
+	int ret;
+
+	ret = mosys_lock(lock, timeout_msecs);
+	if (ret == 0)
+		lock->mode = mode;
+
+	return ret;
+}
@@ -44,10 +44,15 @@
 #include "mosys/globals.h"
 #include "mosys/kv_pair.h"
 
+/*
+ * Output settings are per thread so that threads running different
+ * commands do not change each other's output.
+ */
+
 /*
  * globally used kv_pair_style
  */
-static enum kv_pair_style mosys_kv_pair_style;
+static __thread enum kv_pair_style mosys_kv_pair_style;
 
 void mosys_set_kv_pair_style(enum kv_pair_style style)
 {
@@ -60,6 +65,35 @@ enum kv_pair_style mosys_get_kv_pair_style()
 }
 
 
+/*
+ * records collected by kv_pair_print while capturing, see kv_pair_capture
+ */
+static __thread struct kv_record **capture_tail;
+
+/*
+ * kv_record_append  -  append copy of key=value pair list to captured records
+ *
+ * @kv_list:    key=value pair list
+ */
+static void kv_record_append(struct kv_pair *kv_list)
+{
+	struct kv_record *record = mosys_zalloc(sizeof(*record));
+	struct kv_pair *kv_ptr, *kv_tail = NULL;
+
+	for (kv_ptr = kv_list; kv_ptr != NULL; kv_ptr = kv_ptr->next) {
+		/* skip the empty list head from kv_pair_new() */
+		if (!kv_ptr->key || !kv_ptr->value)
+			continue;
+
+		kv_tail = kv_pair_add(kv_tail, kv_ptr->key, kv_ptr->value);
+		if (!record->pairs)
+			record->pairs = kv_tail;
+	}
+
+	*capture_tail = record;
+	capture_tail = &record->next;
+}
+
 /*
  * kv_pair_new  -  create new key=value pair
  *
@@ -261,10 +295,50 @@ int kv_pair_print(struct kv_pair *kv_list)
 {
 	FILE *fp = mosys_get_output_file();
 	enum kv_pair_style style = mosys_get_kv_pair_style();
+
+	if (capture_tail) {
+		kv_record_append(kv_list);
+		return 0;
+	}
+
 	return kv_pair_print_to_file(fp, kv_list, style);
 }
 
-static const char *single_key;
+/*
+ * kv_pair_capture  -  capture lists passed to kv_pair_print as records
+ *
+ * @records:	list to append records to, NULL to resume printing
+ */
+void kv_pair_capture(struct kv_record **records)
+{
+	capture_tail = records;
+	while (capture_tail && *capture_tail)
+		capture_tail = &(*capture_tail)->next;
+}
+
+int kv_pair_capturing(void)
+{
+	return capture_tail != NULL;
+}
+
+/*
+ * kv_record_free  -  free a record list
+ *
+ * @records:	record list
+ */
+void kv_record_free(struct kv_record *records)
+{
+	struct kv_record *next;
+
+	while (records) {
+		next = records->next;
+		kv_pair_free(records->pairs);
+		free(records);
+		records = next;
+	}
+}
+
+static __thread const char *single_key;
 
 const char *kv_get_single_key(void)
 {
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * library.c: mosys library interface
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mosys/alloc.h"
+#include "mosys/big_lock.h"
+#include "mosys/globals.h"
+#include "mosys/kv_pair.h"
+#include "mosys/library.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "lib/flashrom.h"
+
+#define LOCK_TIMEOUT_SECS 180
+#define QUERY_SEPARATORS "/ \t\n"
+
+struct mosys_handle {
+	struct platform_intf *intf;
+};
+
+static struct mosys_handle *open_handle;
+
+/* the big lock is held while any query is running */
+static pthread_mutex_t query_lock = PTHREAD_MUTEX_INITIALIZER;
+static int query_count;
+
+static int query_begin(void)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&query_lock);
+#if defined(CONFIG_USE_IPC_LOCK)
+	if (query_count == 0 &&
+	    mosys_acquire_big_lock(LOCK_TIMEOUT_SECS) < 0)
+		ret = -1;
+#endif
+	/*
+	 * Firmware and other processes change the event log, NVRAM and the
+	 * like while a handle is open, so cached flash contents are only
+	 * reused by queries running at the same time.
+	 */
+	if (ret == 0 && query_count++ == 0)
+		flashrom_cache_expire();
+	pthread_mutex_unlock(&query_lock);
+
+#if defined(CONFIG_USE_IPC_LOCK)
+	if (ret == 0)
+		mosys_big_lock_enter();
+#endif
+
+	return ret;
+}
+
+static void query_end(void)
+{
+#if defined(CONFIG_USE_IPC_LOCK)
+	mosys_big_lock_leave();
+#endif
+
+	pthread_mutex_lock(&query_lock);
+	query_count--;
+#if defined(CONFIG_USE_IPC_LOCK)
+	if (query_count == 0)
+		mosys_release_big_lock();
+#endif
+	pthread_mutex_unlock(&query_lock);
+}
+
+struct mosys_handle *mosys_open(const char *platform_id)
+{
+	struct mosys_handle *handle;
+	struct platform_intf *intf;
+
+	if (open_handle) {
+		lprintf(LOG_ERR, "mosys is already open\n");
+		errno = EBUSY;
+		return NULL;
+	}
+
+	mosys_globals_init();
+
+#if defined(CONFIG_USE_IPC_LOCK)
+	if (mosys_acquire_big_lock(LOCK_TIMEOUT_SECS) < 0)
+		return NULL;
+#endif
+	intf = mosys_platform_setup(platform_id);
+#if defined(CONFIG_USE_IPC_LOCK)
+	mosys_release_big_lock();
+#endif
+	if (!intf) {
+		lprintf(LOG_ERR, "Platform not supported\n");
+		errno = ENODEV;
+		return NULL;
+	}
+
+	handle = mosys_zalloc(sizeof(*handle));
+	handle->intf = intf;
+	open_handle = handle;
+	return handle;
+}
+
+int mosys_query_argv(struct mosys_handle *handle, int argc,
+                     char **argv, struct kv_record **records)
+{
+	int rc;
+
+	*records = NULL;
+
+	if (!handle || handle != open_handle || argc < 1) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (query_begin() < 0)
+		return -1;
+
+	/* values are wanted as-is, not the output of a single key */
+	mosys_set_kv_pair_style(KV_STYLE_LONG);
+	kv_set_single_key(NULL);
+
+	kv_pair_capture(records);
+	rc = platform_dispatch(handle->intf, argc, argv, NULL);
+	kv_pair_capture(NULL);
+
+	query_end();
+
+	return rc;
+}
+
+int mosys_query(struct mosys_handle *handle, const char *path,
+                struct kv_record **records)
+{
+	char *buf, *tok, *saveptr;
+	char **argv;
+	int argc = 0, rc;
+
+	*records = NULL;
+
+	if (!path) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* there are at most strlen / 2 + 1 components */
+	buf = mosys_strdup(path);
+	argv = mosys_calloc(strlen(path) / 2 + 2, sizeof(*argv));
+
+	for (tok = strtok_r(buf, QUERY_SEPARATORS, &saveptr); tok;
+	     tok = strtok_r(NULL, QUERY_SEPARATORS, &saveptr))
+		argv[argc++] = tok;
+
+	rc = mosys_query_argv(handle, argc, argv, records);
+
+	free(argv);
+	free(buf);
+	return rc;
+}
+
+void mosys_close(struct mosys_handle *handle)
+{
+	if (!handle || handle != open_handle)
+		return;
+
+	mosys_platform_destroy(handle->intf);
+	open_handle = NULL;
+	free(handle);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * library_unittest.c: unit tests for the mosys library interface
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+
+#include "cmockery.h"
+
+#include "mosys/big_lock.h"
+#include "mosys/kv_pair.h"
+#include "mosys/library.h"
+
+/* Link is used since its platform commands need no hardware */
+#define TEST_PLATFORM	"Link"
+
+static const char *record_value(struct kv_record *record, const char *key)
+{
+	struct kv_pair *kv;
+
+	for (kv = record->pairs; kv; kv = kv->next) {
+		if (!strcmp(kv->key, key))
+			return kv->value;
+	}
+
+	return NULL;
+}
+
+static void open_query_close_test(void **state)
+{
+	struct mosys_handle *handle;
+	struct kv_record *records;
+
+	handle = mosys_open(TEST_PLATFORM);
+	assert_true(handle != NULL);
+
+	/* only one handle at a time */
+	assert_true(mosys_open(TEST_PLATFORM) == NULL);
+	assert_int_equal(EBUSY, errno);
+
+	assert_int_equal(0, mosys_query(handle, "platform name", &records));
+	assert_true(records != NULL);
+	assert_string_equal(TEST_PLATFORM, record_value(records, "name"));
+	assert_true(records->next == NULL);
+	kv_record_free(records);
+
+	/* '/' separates components as well */
+	assert_int_equal(0, mosys_query(handle, "platform/name", &records));
+	assert_string_equal(TEST_PLATFORM, record_value(records, "name"));
+	kv_record_free(records);
+
+	mosys_close(handle);
+
+	/* the handle is gone */
+	assert_int_equal(-1, mosys_query(handle, "platform name", &records));
+	assert_int_equal(EINVAL, errno);
+	assert_true(records == NULL);
+}
+
+static void unknown_command_test(void **state)
+{
+	struct mosys_handle *handle;
+	struct kv_record *records, *record;
+	int found = 0;
+
+	handle = mosys_open(TEST_PLATFORM);
+	assert_true(handle != NULL);
+
+	/* the command list is captured rather than printed */
+	assert_int_equal(-1, mosys_query(handle, "bogus", &records));
+	assert_int_equal(ENOSYS, errno);
+	for (record = records; record; record = record->next) {
+		assert_true(record_value(record, "description") != NULL);
+		if (!strcmp(record_value(record, "command"), "platform"))
+			found = 1;
+	}
+	assert_true(found);
+	kv_record_free(records);
+
+	/* as is the list of subcommands */
+	assert_int_equal(-1, mosys_query(handle, "platform bogus", &records));
+	assert_int_equal(EINVAL, errno);
+	assert_true(records != NULL);
+	assert_string_equal("vendor", record_value(records, "command"));
+	kv_record_free(records);
+
+	/* and usage */
+	assert_int_equal(0, mosys_query(handle, "platform name help",
+	                                &records));
+	assert_true(records != NULL);
+	assert_string_equal("name", record_value(records, "command"));
+	assert_true(record_value(records, "usage") != NULL);
+	kv_record_free(records);
+
+	mosys_close(handle);
+}
+
+int library_unittest(void)
+{
+	UnitTest tests[] = {
+		unit_test(open_query_close_test),
+		unit_test(unknown_command_test),
+	};
+
+#if defined(CONFIG_USE_IPC_LOCK)
+	mosys_big_lock_prepare_test();
+#endif
+
+	return run_tests(tests);
+}
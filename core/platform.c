@@ -30,6 +30,7 @@
  * platform.c: platform interface routines
  */
 
+#include <ctype.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -44,13 +45,240 @@
 #include "mosys/log.h"
 #include "mosys/platform.h"
 #include "mosys/output.h"
+#include "mosys/result_cache.h"
 
+#include "lib/probe.h"
 #include "lib/string.h"
 
 #ifndef LINE_MAX
 #define LINE_MAX 64
 #endif
 
+/* Number of buckets in platform id hash table, must be a power of two */
+#define PLATFORM_ID_BUCKETS	256
+
+/* Platform id, linked into a hash bucket */
+struct platform_id_node {
+	const char *id;
+	size_t len;
+	int index;			/* index in platform_intf_list */
+	int probe_only;			/* from probe_ids, not id_list */
+	struct platform_id_node *next;
+};
+
+static struct platform_id_node *platform_id_table[PLATFORM_ID_BUCKETS];
+static int platform_id_table_ready;
+
+/* FNV-1a hash of the first len characters of str, ignoring case */
+static unsigned int platform_id_hash(const char *str, size_t len)
+{
+	unsigned int hash = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= (unsigned char)tolower((unsigned char)str[i]);
+		hash *= 16777619u;
+	}
+
+	return hash & (PLATFORM_ID_BUCKETS - 1);
+}
+
+static void platform_id_table_destroy(void *arg)
+{
+	struct platform_id_node *node, *next;
+	int i;
+
+	for (i = 0; i < PLATFORM_ID_BUCKETS; i++) {
+		for (node = platform_id_table[i]; node; node = next) {
+			next = node->next;
+			free(node);
+		}
+		platform_id_table[i] = NULL;
+	}
+	platform_id_table_ready = 0;
+}
+
+/*
+ * platform_id_table_add  -  hash a list of ids of a platform
+ *
+ * @ids:	null-terminated list of ids, may be NULL
+ * @index:	index of platform in platform_intf_list
+ * @probe_only:	ids are only used for auto-detection
+ */
+static void platform_id_table_add(const char **ids, int index, int probe_only)
+{
+	struct platform_id_node *node;
+	unsigned int bucket;
+
+	for (; ids && *ids; ids++) {
+		node = mosys_malloc(sizeof(*node));
+		node->id = *ids;
+		node->len = strlen(*ids);
+		node->index = index;
+		node->probe_only = probe_only;
+		bucket = platform_id_hash(node->id, node->len);
+		node->next = platform_id_table[bucket];
+		platform_id_table[bucket] = node;
+	}
+}
+
+/*
+ * platform_id_table_setup  -  hash ids of all supported platforms
+ *
+ * returns number of platforms in platform_intf_list
+ */
+static int platform_id_table_setup(void)
+{
+	struct platform_intf **_intf;
+	int index;
+
+	for (_intf = platform_intf_list, index = 0;
+	     _intf && *_intf; _intf++, index++) {
+		if (platform_id_table_ready)
+			continue;
+
+		platform_id_table_add((*_intf)->id_list, index, 0);
+		platform_id_table_add((*_intf)->probe_ids, index, 1);
+	}
+
+	if (!platform_id_table_ready) {
+		platform_id_table_ready = 1;
+		add_destroy_callback(platform_id_table_destroy, NULL);
+	}
+
+	return index;
+}
+
+/*
+ * platform_is_indexed  -  check if platform can be found by its ids
+ *
+ * returns 1 if platform has ids
+ * returns 0 if its probe must always be run
+ */
+static int platform_is_indexed(struct platform_intf *intf)
+{
+	return (intf->id_list && intf->id_list[0]) ||
+	       (intf->probe_ids && intf->probe_ids[0]);
+}
+
+/*
+ * platform_id_match  -  mark platforms with an id matching a string
+ *
+ * @str:	string to match, e.g. SMBIOS product name
+ * @probe_ids:	also match ids only used for auto-detection
+ * @matches:	array indexed like platform_intf_list, set to 1 on match
+ *
+ * Ids are matched like strlfind() matches them, case-insensitive against
+ * the start of the string. Every prefix of the string is looked up, so the
+ * cost depends on the length of the string, not the number of platforms.
+ *
+ * returns lowest index of a matching platform
+ * returns <0 if no platform matched
+ */
+static int platform_id_match(const char *str, int probe_ids, char *matches)
+{
+	struct platform_id_node *node;
+	size_t len, str_len;
+	int ret = -1;
+
+	if (!str)
+		return -1;
+
+	str_len = strlen(str);
+	for (len = 1; len <= str_len; len++) {
+		node = platform_id_table[platform_id_hash(str, len)];
+		for (; node; node = node->next) {
+			if (node->len != len || strncasecmp(str, node->id, len))
+				continue;
+			if (node->probe_only && !probe_ids)
+				continue;
+
+			lprintf(LOG_DEBUG, "\"%s\" matches id \"%s\" of %s\n",
+			        str, node->id,
+			        platform_intf_list[node->index]->name);
+			matches[node->index] = 1;
+			if (ret < 0 || node->index < ret)
+				ret = node->index;
+		}
+	}
+
+	return ret;
+}
+
+/*
+ * platform_identity_match  -  find candidate platforms for this system
+ *
+ * @matches:	array indexed like platform_intf_list, set to 1 on match
+ *
+ * SMBIOS tables only exist on x86, so they are only read if an x86
+ * platform is supported.
+ */
+static void platform_identity_match(char *matches)
+{
+	const struct platform_identity *identity;
+	struct platform_intf **_intf, *smbios_intf = NULL;
+	const char *p, *end;
+
+	for (_intf = platform_intf_list; _intf && *_intf; _intf++) {
+		if ((*_intf)->type == PLATFORM_X86 ||
+		    (*_intf)->type == PLATFORM_X86_64) {
+			smbios_intf = *_intf;
+			break;
+		}
+	}
+
+	identity = probe_identity(smbios_intf);
+
+	platform_id_match(identity->smbios_name, 1, matches);
+	platform_id_match(identity->cpu_model, 1, matches);
+
+	if (identity->frid) {
+		platform_id_match(identity->frid, 1, matches);
+		/* FRIDs are usually "<Vendor>_<Platform>" */
+		p = strchr(identity->frid, '_');
+		if (p)
+			platform_id_match(p + 1, 1, matches);
+	}
+
+	end = identity->fdt_compatible + identity->fdt_compatible_len;
+	for (p = identity->fdt_compatible; p && p < end; p += strlen(p) + 1) {
+		if (!memchr(p, '\0', end - p))
+			break;
+		platform_id_match(p, 1, matches);
+	}
+}
+
+/*
+ * platform_probe  -  run probe function of a platform
+ *
+ * @intf:	platform interface
+ *
+ * returns 1 if platform was found
+ * returns 0 otherwise
+ */
+static int platform_probe(struct platform_intf *intf)
+{
+	int rc;
+
+	lprintf(LOG_DEBUG, "Checking platform %s\n", intf->name);
+
+	if (!intf->probe)
+		return 0;
+
+	rc = intf->probe(intf);
+	if (rc < 0) {
+		lprintf(LOG_DEBUG, "Error encountered when "
+			"probing %s\n", intf->name);
+		return 0;
+	} else if (rc > 0) {
+		lprintf(LOG_DEBUG, "Platform %s found (via "
+		"probing)\n", intf->name);
+		return 1;
+	}
+
+	return 0;
+}
+
 /*
  * mosys_platform_setup  -  identify platform, setup interfaces and commands
  *
@@ -61,46 +289,98 @@
  */
 struct platform_intf *mosys_platform_setup(const char *p_opt)
 {
-	struct platform_intf **_intf, *intf;
+	struct platform_intf **_intf, *intf = NULL;
 	struct platform_intf *ret = NULL;
+	const char *list_name = NULL;
 	int intf_found = 0;
+	int num_intf, index;
+	char *matches, *probed;
 
-	/* attempt to probe platform name and match it to an interface */
-	for (_intf = platform_intf_list; _intf && *_intf; _intf++) {
-		intf = *_intf;
-
-		lprintf(LOG_DEBUG, "Checking platform %s\n", intf->name);
+	/* use common operations by default */
+	for (_intf = platform_intf_list; _intf && *_intf; _intf++)
+		(*_intf)->op = &platform_common_op;
 
-		/* use common operations by default */
-		intf->op = &platform_common_op;
+	num_intf = platform_id_table_setup();
+	if (!num_intf)
+		goto mosys_platform_setup_exit;
+	matches = mosys_zalloc(num_intf);
+	probed = mosys_zalloc(num_intf);
+
+	/* platform name specified by user */
+	if (p_opt) {
+		index = platform_id_match(p_opt, 0, matches);
+		if (index >= 0) {
+			intf = platform_intf_list[index];
+			intf_found = 1;
+		}
+		goto mosys_platform_setup_found;
+	}
 
-		/* platform name specified by user */
-		if (p_opt) {
-			if (strlfind(p_opt, &intf->id_list[0], 0)) {
-				intf_found = 1;
-				break;
-			} else {
-				continue;
-			}
+	/*
+	 * A platform detected earlier during this boot only needs its own
+	 * probe to be run again, which also restores any state the probe
+	 * sets up for the platform.
+	 */
+	index = platform_cache_lookup();
+	if (index >= 0) {
+		intf = platform_intf_list[index];
+		list_name = intf->name;
+		probed[index] = 1;
+		if (platform_probe(intf)) {
+			intf_found = 1;
+			if (platform_cache_verify(intf) < 0)
+				platform_cache_store(index, list_name, intf);
+			goto mosys_platform_setup_found;
 		}
+		lprintf(LOG_DEBUG, "Cached platform %s did not match\n",
+		        list_name);
+	}
+
+	/*
+	 * Gather identifying data once and probe, in list order, only the
+	 * platforms whose ids match it and those without ids. Since a probe
+	 * only succeeds on systems matching its ids, the first platform
+	 * found is the one probing every platform in order would find.
+	 */
+	platform_identity_match(matches);
+	for (index = 0; index < num_intf; index++) {
+		intf = platform_intf_list[index];
+		if (probed[index] ||
+		    (!matches[index] && platform_is_indexed(intf)))
+			continue;
 
-		/* auto-detect */
-		if (intf->probe) {
-			int rc = intf->probe(intf);
+		list_name = intf->name;
+		probed[index] = 1;
+		if (platform_probe(intf)) {
+			intf_found = 1;
+			break;
+		}
+	}
 
-			if (rc < 0) {
-				lprintf(LOG_DEBUG, "Error encountered when "
-					"probing %s\n", intf->name);
+	/* in case a probe matched data its ids do not cover */
+	if (!intf_found) {
+		for (index = 0; index < num_intf; index++) {
+			if (probed[index])
 				continue;
-			} else if (rc > 0) {
-				lprintf(LOG_DEBUG, "Platform %s found (via "
-				"probing)\n", intf->name);
+
+			intf = platform_intf_list[index];
+			list_name = intf->name;
+			if (platform_probe(intf)) {
+				lprintf(LOG_DEBUG, "%s matched none of its ids\n",
+				        list_name);
 				intf_found = 1;
 				break;
 			}
 		}
 	}
 
+	if (intf_found)
+		platform_cache_store(index, list_name, intf);
+
+mosys_platform_setup_found:
+	free(matches);
+	free(probed);
+
 	if (!intf_found)
 		goto mosys_platform_setup_exit;
 
@@ -108,22 +388,21 @@ struct platform_intf *mosys_platform_setup(const char *p_opt)
 	if (intf->setup && intf->setup(intf) < 0)
 		goto mosys_platform_setup_exit;
 
-	/* prepare interface operations */
-	if (intf_op_setup(intf) < 0) {
-		if (intf->destroy)
-			intf->destroy(intf);
-		intf_op_destroy(intf);
-		goto mosys_platform_setup_exit;
-	}
+	/*
+	 * Interface operations are prepared on first use, see
+	 * intf_op_ready().
+	 */
 
 	/* call platform-specific post-setup if found */
 	if (intf->setup_post &&
 	    intf->setup_post(intf) < 0) {
 		if (intf->destroy)
 			intf->destroy(intf);
+		intf_op_destroy(intf);
 		goto mosys_platform_setup_exit;
 	}
 
+	result_cache_install(intf);
 	ret = intf;
 
 mosys_platform_setup_exit:
@@ -142,6 +421,8 @@ void mosys_platform_destroy(struct platform_intf *intf)
 //	cleanup_destroy_callbacks();
 
 	if (intf) {
+		result_cache_remove(intf);
+
 		/* cleanup interface */
 		if (intf->destroy)
 			intf->destroy(intf);
@@ -152,14 +433,38 @@ void mosys_platform_destroy(struct platform_intf *intf)
 	}
 }
 
+/*
+ * mosys_platform_prepare_test - forget the ids hashed from the platform list
+ *
+ * This should only be used doing *TESTING*, after replacing entries of
+ * platform_intf_list, so the next platform setup hashes the new entries.
+ */
+void mosys_platform_prepare_test(void)
+{
+	platform_id_table_destroy(NULL);
+}
+
 /*
  * platform_cmd_usage  -  print usage text for command
  *
  * @cmd:	command pointer
+ *
+ * While output is captured, the usage becomes a record instead.
  */
 void platform_cmd_usage(struct platform_cmd *cmd)
 {
-	printf("usage: %s %s\n\n", cmd->name, cmd->usage ? : "");
+	struct kv_pair *kv;
+
+	if (!kv_pair_capturing()) {
+		printf("usage: %s %s\n\n", cmd->name, cmd->usage ? : "");
+		return;
+	}
+
+	kv = kv_pair_new();
+	kv_pair_add(kv, "command", cmd->name);
+	kv_pair_add(kv, "usage", cmd->usage ? : "");
+	kv_pair_print(kv);
+	kv_pair_free(kv);
 }
 
 /*
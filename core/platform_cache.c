@@ -0,0 +1,196 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * platform_cache.c: per-boot cache of detected platform
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mosys/globals.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "lib/file.h"
+#include "lib/probe.h"
+#include "lib/sku.h"
+
+#define PLATFORM_CACHE_FILE	"platform"
+
+/*
+ * platform_cache_get  -  look up value of key in cache file
+ *
+ * @fp:		cache file
+ * @key:	key to look up
+ * @buf:	buffer to store value in
+ * @len:	length of buffer
+ *
+ * returns 0 if key was found
+ * returns <0 otherwise
+ */
+static int platform_cache_get(FILE *fp, const char *key, char *buf, int len)
+{
+	char line[LINE_MAX];
+	size_t key_len = strlen(key);
+
+	rewind(fp);
+	while (fgets(line, sizeof(line), fp)) {
+		if (strncmp(line, key, key_len) || line[key_len] != '=')
+			continue;
+
+		line[strcspn(line, "\n")] = '\0';
+		snprintf(buf, len, "%s", line + key_len + 1);
+		return 0;
+	}
+
+	return -1;
+}
+
+int platform_cache_lookup(void)
+{
+	char path[PATH_MAX];
+	char val[LINE_MAX];
+	const char *boot_id;
+	struct platform_intf **_intf;
+	FILE *fp;
+	int index, ret = -1;
+
+	if (mosys_get_force_probe())
+		return -1;
+
+	boot_id = get_boot_id();
+	if (!boot_id)
+		return -1;
+
+	if (data_file_path(path, sizeof(path), PLATFORM_CACHE_FILE) < 0)
+		return -1;
+
+	fp = fopen(path, "r");
+	if (!fp)
+		return -1;
+
+	/* entries are only valid for the boot which wrote them */
+	if (platform_cache_get(fp, "boot_id", val, sizeof(val)) < 0 ||
+	    strcmp(val, boot_id))
+		goto platform_cache_lookup_exit;
+
+	if (platform_cache_get(fp, "index", val, sizeof(val)) < 0)
+		goto platform_cache_lookup_exit;
+	index = strtol(val, NULL, 10);
+	for (_intf = platform_intf_list; _intf && *_intf; _intf++) {
+		if (_intf - platform_intf_list == index)
+			break;
+	}
+	if (!_intf || !*_intf)
+		goto platform_cache_lookup_exit;
+
+	/* the platform list may differ if mosys was updated */
+	if (platform_cache_get(fp, "platform", val, sizeof(val)) < 0 ||
+	    strcmp(val, (*_intf)->name))
+		goto platform_cache_lookup_exit;
+
+	if (platform_cache_get(fp, "method", val, sizeof(val)) == 0)
+		lprintf(LOG_DEBUG, "%s: %s was detected via %s\n",
+		        __func__, (*_intf)->name, val);
+	ret = index;
+
+platform_cache_lookup_exit:
+	fclose(fp);
+	return ret;
+}
+
+int platform_cache_verify(struct platform_intf *intf)
+{
+	char path[PATH_MAX];
+	char val[LINE_MAX];
+	FILE *fp;
+	int ret = 0;
+
+	if (data_file_path(path, sizeof(path), PLATFORM_CACHE_FILE) < 0)
+		return -1;
+
+	fp = fopen(path, "r");
+	if (!fp)
+		return -1;
+
+	if (platform_cache_get(fp, "name", val, sizeof(val)) < 0 ||
+	    strcmp(val, intf->name))
+		ret = -1;
+
+	if (intf->sku_info && intf->sku_info->model &&
+	    (platform_cache_get(fp, "sku_model", val, sizeof(val)) < 0 ||
+	     strcmp(val, intf->sku_info->model)))
+		ret = -1;
+
+	fclose(fp);
+	return ret;
+}
+
+void platform_cache_store(int index, const char *list_name,
+                          struct platform_intf *intf)
+{
+	char path[PATH_MAX];
+	const struct sku_info *sku = intf->sku_info;
+	struct file_replace rep;
+	const char *boot_id;
+	FILE *fp;
+
+	boot_id = get_boot_id();
+	if (!boot_id)
+		return;
+
+	if (data_file_path(path, sizeof(path), PLATFORM_CACHE_FILE) < 0)
+		return;
+
+	fp = file_replace_begin(&rep, path, 0600);
+	if (!fp)
+		return;
+
+	fprintf(fp, "boot_id=%s\n", boot_id);
+	fprintf(fp, "index=%d\n", index);
+	fprintf(fp, "platform=%s\n", list_name);
+	fprintf(fp, "name=%s\n", intf->name);
+	fprintf(fp, "method=%s\n", probe_method() ? : "unknown");
+	if (sku) {
+		if (sku->brand)
+			fprintf(fp, "sku_brand=%s\n", sku->brand);
+		if (sku->model)
+			fprintf(fp, "sku_model=%s\n", sku->model);
+		if (sku->chassis)
+			fprintf(fp, "sku_chassis=%s\n", sku->chassis);
+		if (sku->customization)
+			fprintf(fp, "sku_customization=%s\n",
+			        sku->customization);
+	}
+
+	file_replace_commit(&rep);
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * platform_unittest.c: unit tests for platform detection
+ */
+
+#include <limits.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "cmockery.h"
+
+#include "mosys/alloc.h"
+#include "mosys/globals.h"
+#include "mosys/platform.h"
+
+#include "lib/math.h"
+
+/* device tree of the test system, matching only the probe ids of Bravo */
+#define TEST_COMPATIBLE		"StubCo,bravo-rev1\0stubco,generic"
+
+enum test_platform {
+	TEST_ALPHA,
+	TEST_ALPHABET,
+	TEST_BRAVO,
+	TEST_CHARLIE,
+	TEST_DELTA,
+	TEST_PLATFORMS,
+};
+
+static int test_probe_result[TEST_PLATFORMS];
+static int test_probe_calls[TEST_PLATFORMS];
+
+static struct platform_intf test_platforms[TEST_PLATFORMS];
+
+static int test_probe(struct platform_intf *intf)
+{
+	test_probe_calls[intf - test_platforms]++;
+	return test_probe_result[intf - test_platforms];
+}
+
+static const char *alpha_ids[] = { "Alpha", NULL };
+static const char *alphabet_ids[] = { "ALPHABET", NULL };
+static const char *bravo_ids[] = { "Bravo", NULL };
+static const char *bravo_probe_ids[] = { "STUBCO,bravo", NULL };
+static const char *delta_ids[] = { "delta", NULL };
+
+static struct platform_intf test_platforms[TEST_PLATFORMS] = {
+	[TEST_ALPHA] = {
+		.type		= PLATFORM_ARMV8,
+		.name		= "Alpha",
+		.id_list	= alpha_ids,
+		.probe		= test_probe,
+	},
+	[TEST_ALPHABET] = {
+		.type		= PLATFORM_ARMV8,
+		.name		= "Alphabet",
+		.id_list	= alphabet_ids,
+		.probe		= test_probe,
+	},
+	[TEST_BRAVO] = {
+		.type		= PLATFORM_ARMV8,
+		.name		= "Bravo",
+		.id_list	= bravo_ids,
+		.probe_ids	= bravo_probe_ids,
+		.probe		= test_probe,
+	},
+	/* no ids, so it is always a candidate */
+	[TEST_CHARLIE] = {
+		.type		= PLATFORM_ARMV8,
+		.name		= "Charlie",
+		.probe		= test_probe,
+	},
+	[TEST_DELTA] = {
+		.type		= PLATFORM_ARMV8,
+		.name		= "Delta",
+		.id_list	= delta_ids,
+		.probe		= test_probe,
+	},
+};
+
+/*
+ * test_setup  -  detect the platform with the given probe results
+ *
+ * @p_opt:	platform name given by the user, NULL to auto-detect
+ * @found:	platforms whose probe succeeds, bit per enum test_platform
+ *
+ * returns index of the platform found
+ * returns <0 if none was found
+ */
+static int test_setup(const char *p_opt, unsigned int found)
+{
+	struct platform_intf *intf;
+	int i;
+
+	for (i = 0; i < TEST_PLATFORMS; i++) {
+		test_probe_result[i] = !!(found & (1 << i));
+		test_probe_calls[i] = 0;
+	}
+
+	intf = mosys_platform_setup(p_opt);
+	if (!intf)
+		return -1;
+
+	mosys_platform_destroy(intf);
+	return intf - test_platforms;
+}
+
+static void name_test(void **state)
+{
+	/* ids match the start of the name, ignoring case */
+	assert_int_equal(TEST_ALPHA, test_setup("alpha", 0));
+	assert_int_equal(TEST_DELTA, test_setup("DELTA-rev2", 0));
+	assert_int_equal(-1, test_setup("alph", 0));
+
+	/* the first platform in the list wins */
+	assert_int_equal(TEST_ALPHA, test_setup("Alphabet", 0));
+
+	/* ids only used for auto-detection are not names */
+	assert_int_equal(TEST_BRAVO, test_setup("bravo", 0));
+	assert_int_equal(-1, test_setup("stubco,bravo", 0));
+	assert_int_equal(-1, test_setup("Charlie", 0));
+
+	/* the user is trusted, nothing is probed */
+	assert_int_equal(0, test_probe_calls[TEST_CHARLIE]);
+}
+
+static void detect_test(void **state)
+{
+	const unsigned int all = (1 << TEST_PLATFORMS) - 1;
+
+	/* only platforms matching the device tree or without ids are probed */
+	assert_int_equal(TEST_BRAVO, test_setup(NULL, all));
+	assert_int_equal(0, test_probe_calls[TEST_ALPHA]);
+	assert_int_equal(0, test_probe_calls[TEST_CHARLIE]);
+
+	assert_int_equal(TEST_CHARLIE,
+	                 test_setup(NULL, all & ~(1 << TEST_BRAVO)));
+	assert_int_equal(0, test_probe_calls[TEST_ALPHA]);
+	assert_int_equal(1, test_probe_calls[TEST_BRAVO]);
+
+	/* the rest are probed in list order if no candidate is found */
+	assert_int_equal(TEST_ALPHABET,
+	                 test_setup(NULL, (1 << TEST_ALPHABET) |
+	                                  (1 << TEST_DELTA)));
+	assert_int_equal(1, test_probe_calls[TEST_ALPHA]);
+	assert_int_equal(1, test_probe_calls[TEST_BRAVO]);
+	assert_int_equal(1, test_probe_calls[TEST_CHARLIE]);
+	assert_int_equal(0, test_probe_calls[TEST_DELTA]);
+
+	assert_int_equal(-1, test_setup(NULL, 0));
+	assert_int_equal(1, test_probe_calls[TEST_DELTA]);
+}
+
+/*
+ * The identity of the system is read once, so this has to run before any
+ * other test which auto-detects the platform.
+ */
+int platform_unittest(void)
+{
+	UnitTest tests[] = {
+		unit_test(name_test),
+		unit_test(detect_test),
+	};
+	char root[] = "/tmp/platform_test.XXXXXX";
+	char path[PATH_MAX];
+	const char *dirs[] = { "/proc", "/proc/device-tree" };
+	struct platform_intf **saved_list;
+	char *saved_root;
+	int saved_force_probe;
+	int count, i, rc;
+	FILE *fp;
+
+	for (count = 0; platform_intf_list[count]; count++)
+		;
+	if (count < TEST_PLATFORMS || !mkdtemp(root))
+		return -1;
+
+	for (i = 0; i < ARRAY_SIZE(dirs); i++) {
+		snprintf(path, sizeof(path), "%s%s", root, dirs[i]);
+		mkdir(path, 0700);
+	}
+	strcat(path, "/compatible");
+	fp = fopen(path, "w");
+	if (fp) {
+		fwrite(TEST_COMPATIBLE, sizeof(TEST_COMPATIBLE), 1, fp);
+		fclose(fp);
+	}
+
+	/* the test platforms take the place of the supported ones */
+	saved_list = mosys_malloc(count * sizeof(*saved_list));
+	memcpy(saved_list, platform_intf_list, count * sizeof(*saved_list));
+	for (i = 0; i < TEST_PLATFORMS; i++)
+		platform_intf_list[i] = &test_platforms[i];
+	platform_intf_list[TEST_PLATFORMS] = NULL;
+	mosys_platform_prepare_test();
+
+	saved_root = mosys_strdup(mosys_get_root_prefix());
+	mosys_set_root_prefix(root);
+	/* detection results of earlier runs are not of interest */
+	saved_force_probe = mosys_get_force_probe();
+	mosys_set_force_probe(1);
+
+	rc = run_tests(tests);
+
+	mosys_set_force_probe(saved_force_probe);
+	mosys_set_root_prefix(saved_root);
+	free(saved_root);
+
+	memcpy(platform_intf_list, saved_list, count * sizeof(*saved_list));
+	free(saved_list);
+	mosys_platform_prepare_test();
+
+	unlink(path);
+	for (i = ARRAY_SIZE(dirs) - 1; i >= 0; i--) {
+		snprintf(path, sizeof(path), "%s%s", root, dirs[i]);
+		rmdir(path);
+	}
+	rmdir(root);
+
+	return rc;
+}
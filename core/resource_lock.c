@@ -0,0 +1,206 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * resource_lock.c: locks for individual hardware resources
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mosys/alloc.h"
+#include "mosys/locks.h"
+#include "mosys/log.h"
+#include "mosys/resource_lock.h"
+
+#include "lib/math.h"
+#include "lib/string.h"
+
+static const char *resource_names[] = {
+	[RESOURCE_NONE]		= NULL,
+	[RESOURCE_HOST_FLASH]	= "host_flash",
+	[RESOURCE_EC_FLASH]	= "ec_flash",
+	[RESOURCE_EC]		= "ec",
+	[RESOURCE_CMOS]		= "cmos",
+	[RESOURCE_I2C_BUS]	= "i2c",
+};
+
+/* a resource lock held by this process */
+struct resource_lock {
+	enum resource_type type;
+	char *instance;
+	int count;			/* nested acquisitions */
+	struct ipc_lock lock;
+	struct resource_lock *next;
+};
+
+static struct resource_lock *resource_locks;
+static pthread_mutex_t resource_locks_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int instance_equal(const char *a, const char *b)
+{
+	if (!a || !b)
+		return a == b;
+	return !strcmp(a, b);
+}
+
+/*
+ * resource_lock_get  -  find or create lock for resource
+ *
+ * Locks stay in the list once created so their lock files are only
+ * opened while held. Must be called with resource_locks_lock held.
+ */
+static struct resource_lock *resource_lock_get(enum resource_type type,
+                                               const char *instance)
+{
+	struct resource_lock *res;
+	char *name;
+
+	for (res = resource_locks; res; res = res->next) {
+		if (res->type == type && instance_equal(res->instance, instance))
+			return res;
+	}
+
+	if (instance)
+		name = format_string("mosys_%s_%s",
+		                     resource_names[type], instance);
+	else
+		name = format_string("mosys_%s", resource_names[type]);
+
+	res = mosys_zalloc(sizeof(*res));
+	res->type = type;
+	res->instance = instance ? mosys_strdup(instance) : NULL;
+	res->lock.sem = -1;
+	res->lock.fd = -1;
+	res->lock.filename = name;
+#if defined(CONFIG_USE_SYSV_SEMAPHORE_LOCK)
+	{
+		/* keys after the fixed ones, collisions only over-serialize */
+		uint32_t hash = 2166136261U;
+		const char *p;
+
+		for (p = name; *p; p++)
+			hash = (hash ^ (uint8_t)*p) * 16777619U;
+		res->lock.key = MOSYS_IPC_LOCK_KEY + 2 + hash % 0x3fe;
+	}
+#endif
+
+	res->next = resource_locks;
+	resource_locks = res;
+	return res;
+}
+
+int mosys_acquire_resource(enum resource_type type, const char *instance,
+                           enum ipc_lock_mode mode, int timeout_secs)
+{
+	struct resource_lock *res;
+	int ret = 0;
+
+	if (type <= RESOURCE_NONE || type >= ARRAY_SIZE(resource_names))
+		return -1;
+
+	pthread_mutex_lock(&resource_locks_lock);
+	res = resource_lock_get(type, instance);
+
+	if (res->count == 0 || (mode == IPC_LOCK_EXCLUSIVE &&
+	                        res->lock.mode == IPC_LOCK_SHARED)) {
+		lprintf(LOG_DEBUG, "%s: %s (%s)\n", __func__,
+		        res->lock.filename,
+		        mode == IPC_LOCK_SHARED ? "shared" : "exclusive");
+		if (mosys_lock_mode(&res->lock, mode,
+		                    timeout_secs * 1000) < 0) {
+			lprintf(LOG_ERR, "Unable to lock %s\n",
+			        res->lock.filename);
+			/* a failed conversion drops the lock */
+			res->count = 0;
+			ret = -1;
+			goto mosys_acquire_resource_exit;
+		}
+	}
+	res->count++;
+
+mosys_acquire_resource_exit:
+	pthread_mutex_unlock(&resource_locks_lock);
+	return ret;
+}
+
+int mosys_release_resource(enum resource_type type, const char *instance)
+{
+	struct resource_lock *res;
+	int ret = 0;
+
+	if (type <= RESOURCE_NONE || type >= ARRAY_SIZE(resource_names))
+		return -1;
+
+	pthread_mutex_lock(&resource_locks_lock);
+	res = resource_lock_get(type, instance);
+
+	if (res->count == 0) {
+		ret = -1;
+		goto mosys_release_resource_exit;
+	}
+
+	if (--res->count == 0)
+		mosys_unlock(&res->lock);
+
+mosys_release_resource_exit:
+	pthread_mutex_unlock(&resource_locks_lock);
+	return ret;
+}
+
+int mosys_acquire_resources(const struct resource_claim *claims,
+                            int timeout_secs)
+{
+	const struct resource_claim *claim;
+
+	for (claim = claims; claim->type != RESOURCE_NONE; claim++) {
+		if (mosys_acquire_resource(claim->type, claim->instance,
+		                           claim->mode, timeout_secs) < 0)
+			goto mosys_acquire_resources_fail;
+	}
+
+	return 0;
+
+mosys_acquire_resources_fail:
+	while (claim-- > claims)
+		mosys_release_resource(claim->type, claim->instance);
+	return -1;
+}
+
+void mosys_release_resources(const struct resource_claim *claims)
+{
+	const struct resource_claim *claim;
+
+	for (claim = claims; claim->type != RESOURCE_NONE; claim++)
+		;
+	while (claim-- > claims)
+		mosys_release_resource(claim->type, claim->instance);
+}
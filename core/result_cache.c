@@ -0,0 +1,796 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * result_cache.c: memoize static hardware facts, optionally across processes
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mosys/alloc.h"
+#include "mosys/globals.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+#include "mosys/result_cache.h"
+
+#include "lib/file.h"
+#include "lib/math.h"
+
+#define RESULT_CACHE_KEY_LEN	48
+#define RESULT_CACHE_VALUE_LEN	208
+
+/*
+ * Values returned by identification getters are remembered for the rest
+ * of the process, so each of them is computed at most once. Callers own
+ * the strings returned by the getters, so memoized values are handed out
+ * as copies.
+ */
+struct result_memo {
+	char *key;
+	char *value;
+	struct result_memo *next;
+};
+
+static struct result_memo *result_memos;
+static pthread_mutex_t result_memo_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * result_memo_get  -  look up memoized value
+ *
+ * @key:	key value was stored under
+ *
+ * returns allocated copy of value which must be freed by caller
+ * returns NULL if value was not memoized
+ */
+static char *result_memo_get(const char *key)
+{
+	struct result_memo *memo;
+	char *value = NULL;
+
+	pthread_mutex_lock(&result_memo_lock);
+	for (memo = result_memos; memo; memo = memo->next) {
+		if (!strcmp(memo->key, key)) {
+			value = mosys_strdup(memo->value);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&result_memo_lock);
+
+	return value;
+}
+
+/*
+ * result_memo_put  -  memoize value
+ *
+ * @key:	key to store value under
+ * @value:	value to store
+ */
+static void result_memo_put(const char *key, const char *value)
+{
+	struct result_memo *memo;
+
+	pthread_mutex_lock(&result_memo_lock);
+	for (memo = result_memos; memo; memo = memo->next) {
+		if (!strcmp(memo->key, key))
+			goto result_memo_put_exit;
+	}
+
+	memo = mosys_malloc(sizeof(*memo));
+	memo->key = mosys_strdup(key);
+	memo->value = mosys_strdup(value);
+	memo->next = result_memos;
+	result_memos = memo;
+
+result_memo_put_exit:
+	pthread_mutex_unlock(&result_memo_lock);
+}
+
+static void result_memo_clear(void)
+{
+	struct result_memo *memo, *next;
+
+	pthread_mutex_lock(&result_memo_lock);
+	for (memo = result_memos; memo; memo = next) {
+		next = memo->next;
+		free(memo->key);
+		free(memo->value);
+		free(memo);
+	}
+	result_memos = NULL;
+	pthread_mutex_unlock(&result_memo_lock);
+}
+
+#if defined(CONFIG_SHARED_RESULT_CACHE)
+/*
+ * Values are kept in a POSIX shared memory segment so that every mosys
+ * process on the host can reuse them. Readers never block: the segment is
+ * guarded by a sequence counter which writers make odd while they update
+ * it, and readers retry if the counter changed while they were copying.
+ * Writers exclude each other by putting their pid in the segment.
+ *
+ * The segment is only created and written by root, and others may only
+ * read it, so that values computed by root are shared with every user.
+ * It is only trusted if it belongs to root and nobody else can write it,
+ * and its contents only for the boot and platform which wrote them.
+ */
+#define RESULT_CACHE_SHM_NAME	"/mosys_result_cache"
+#define RESULT_CACHE_SHM_MODE	0644
+#define RESULT_CACHE_MAGIC	0x4d524331	/* "MRC1" */
+#define RESULT_CACHE_ENTRIES	64
+#define RESULT_CACHE_RETRIES	1000
+
+struct result_cache_entry {
+	char key[RESULT_CACHE_KEY_LEN];
+	char value[RESULT_CACHE_VALUE_LEN];
+};
+
+struct result_cache {
+	uint32_t magic;
+	uint32_t seq;			/* odd while an update is in progress */
+	uint32_t generation;		/* bumped when values are invalidated */
+	char boot_id[40];
+	char platform[32];
+	uint32_t count;
+	struct result_cache_entry entries[RESULT_CACHE_ENTRIES];
+	/* last, so it reads as 0 in segments grown from the old layout */
+	uint32_t writer;		/* pid of writer, 0 if none */
+};
+
+static struct result_cache *result_cache;
+static int result_cache_writable;
+static int result_cache_opened;
+static pthread_mutex_t result_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * result_cache_open  -  map shared cache segment, creating it if needed
+ *
+ * returns pointer to cache
+ * returns NULL if the cache cannot be used
+ */
+static struct result_cache *result_cache_open(void)
+{
+	struct stat st;
+	int fd, prot = PROT_READ;
+
+	pthread_mutex_lock(&result_cache_lock);
+	if (result_cache_opened)
+		goto result_cache_open_exit;
+	result_cache_opened = 1;
+
+	if (geteuid() == 0) {
+		fd = shm_open(RESULT_CACHE_SHM_NAME, O_RDWR | O_CREAT,
+		              RESULT_CACHE_SHM_MODE);
+
+		/* left by another user, start over with one of our own */
+		if (fd >= 0 && fstat(fd, &st) == 0 && st.st_uid != 0) {
+			lprintf(LOG_DEBUG, "%s: Replacing %s, not owned by "
+			        "root\n", __func__, RESULT_CACHE_SHM_NAME);
+			close(fd);
+			shm_unlink(RESULT_CACHE_SHM_NAME);
+			fd = shm_open(RESULT_CACHE_SHM_NAME,
+			              O_RDWR | O_CREAT | O_EXCL,
+			              RESULT_CACHE_SHM_MODE);
+		}
+
+		/* the mode passed to shm_open() is subject to umask */
+		if (fd >= 0 && fchmod(fd, RESULT_CACHE_SHM_MODE) == 0)
+			result_cache_writable = 1;
+	} else {
+		fd = shm_open(RESULT_CACHE_SHM_NAME, O_RDONLY, 0);
+	}
+
+	if (fd < 0) {
+		lperror(LOG_DEBUG, "%s: Unable to open %s", __func__,
+		        RESULT_CACHE_SHM_NAME);
+		goto result_cache_open_exit;
+	}
+
+	if (fstat(fd, &st) < 0 || st.st_uid != 0 ||
+	    (st.st_mode & (S_IWGRP | S_IWOTH))) {
+		lprintf(LOG_DEBUG, "%s: Not using %s, not owned by root or "
+		        "writable by others\n", __func__,
+		        RESULT_CACHE_SHM_NAME);
+		result_cache_writable = 0;
+		goto result_cache_open_close;
+	}
+
+	if (st.st_size < sizeof(*result_cache)) {
+		if (!result_cache_writable ||
+		    ftruncate(fd, sizeof(*result_cache)) < 0)
+			goto result_cache_open_close;
+	}
+
+	if (result_cache_writable)
+		prot |= PROT_WRITE;
+	result_cache = mmap(NULL, sizeof(*result_cache), prot, MAP_SHARED,
+	                    fd, 0);
+	if (result_cache == MAP_FAILED) {
+		lperror(LOG_DEBUG, "%s: Unable to map %s", __func__,
+		        RESULT_CACHE_SHM_NAME);
+		result_cache = NULL;
+	}
+
+result_cache_open_close:
+	close(fd);
+result_cache_open_exit:
+	pthread_mutex_unlock(&result_cache_lock);
+	return result_cache;
+}
+
+/*
+ * result_cache_write_begin  -  take the writer side of the sequence lock
+ *
+ * @cache:	shared cache
+ *
+ * Writers hold the lock only while copying a few hundred bytes, but may be
+ * preempted while doing so, so a busy lock is only taken over once its
+ * owner has exited. The contents are then discarded, as the owner may
+ * have died halfway through an update.
+ *
+ * returns 0 to indicate the lock was taken
+ * returns <0 if another writer kept it busy
+ */
+static int result_cache_write_begin(struct result_cache *cache)
+{
+	uint32_t self = getpid(), owner;
+	int tries;
+
+	for (tries = 0; tries < RESULT_CACHE_RETRIES; tries++) {
+		owner = 0;
+		if (__atomic_compare_exchange_n(&cache->writer, &owner, self,
+		                                0, __ATOMIC_ACQUIRE,
+		                                __ATOMIC_RELAXED))
+			goto result_cache_write_begin_locked;
+		sched_yield();
+	}
+
+	/* fails if the lock changed hands since it was last seen */
+	if (kill(owner, 0) == 0 || errno != ESRCH ||
+	    !__atomic_compare_exchange_n(&cache->writer, &owner, self, 0,
+	                                 __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+		lprintf(LOG_DEBUG, "%s: Cache is busy\n", __func__);
+		return -1;
+	}
+
+	lprintf(LOG_DEBUG, "%s: Discarding cache of exited writer %u\n",
+	        __func__, owner);
+	if (__atomic_load_n(&cache->seq, __ATOMIC_RELAXED) & 1) {
+		cache->magic = 0;
+		return 0;
+	}
+
+result_cache_write_begin_locked:
+	__atomic_add_fetch(&cache->seq, 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return 0;
+}
+
+static void result_cache_write_end(struct result_cache *cache)
+{
+	__atomic_add_fetch(&cache->seq, 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&cache->writer, 0, __ATOMIC_RELEASE);
+}
+
+/* must be called in a write section */
+static int result_cache_current(struct result_cache *cache,
+                                const char *boot_id, const char *platform)
+{
+	return cache->magic == RESULT_CACHE_MAGIC &&
+	       !strncmp(cache->boot_id, boot_id, sizeof(cache->boot_id)) &&
+	       !strncmp(cache->platform, platform, sizeof(cache->platform));
+}
+
+/*
+ * result_cache_get  -  look up value in shared cache
+ *
+ * @intf:	platform interface
+ * @key:	key to look up
+ * @buf:	buffer to store value in
+ * @len:	length of buffer
+ * @generation:	filled in with generation of the cache contents
+ *
+ * returns 0 if value was found
+ * returns <0 otherwise
+ */
+static int result_cache_get(struct platform_intf *intf, const char *key,
+                            char *buf, size_t len, uint32_t *generation)
+{
+	struct result_cache *cache;
+	const char *boot_id;
+	uint32_t seq;
+	int tries, i, found;
+
+	*generation = 0;
+	boot_id = get_boot_id();
+	cache = result_cache_open();
+	if (!boot_id || !cache)
+		return -1;
+
+	for (tries = 0; tries < RESULT_CACHE_RETRIES; tries++) {
+		seq = __atomic_load_n(&cache->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1) {
+			sched_yield();
+			continue;
+		}
+
+		found = 0;
+		*generation = cache->generation;
+		if (result_cache_current(cache, boot_id, intf->name) &&
+		    !mosys_get_force_probe()) {
+			for (i = 0; i < __min(cache->count,
+			                      RESULT_CACHE_ENTRIES); i++) {
+				if (strncmp(cache->entries[i].key, key,
+				            RESULT_CACHE_KEY_LEN))
+					continue;
+				snprintf(buf, len, "%.*s",
+				         RESULT_CACHE_VALUE_LEN - 1,
+				         cache->entries[i].value);
+				found = 1;
+				break;
+			}
+		}
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&cache->seq, __ATOMIC_RELAXED) == seq)
+			return found ? 0 : -1;
+	}
+
+	return -1;
+}
+
+/*
+ * result_cache_put  -  store value in shared cache
+ *
+ * @intf:	platform interface
+ * @key:	key to store value under
+ * @value:	value to store
+ * @generation:	generation seen when the value was looked up
+ *
+ * The value is dropped if the cache was invalidated since, as it may have
+ * been computed from state that was changed.
+ */
+static void result_cache_put(struct platform_intf *intf, const char *key,
+                             const char *value, uint32_t generation)
+{
+	struct result_cache *cache;
+	struct result_cache_entry *entry = NULL;
+	const char *boot_id;
+	int i;
+
+	if (strlen(key) >= RESULT_CACHE_KEY_LEN ||
+	    strlen(value) >= RESULT_CACHE_VALUE_LEN)
+		return;
+
+	boot_id = get_boot_id();
+	cache = result_cache_open();
+	if (!boot_id || !cache || !result_cache_writable)
+		return;
+
+	if (result_cache_write_begin(cache) < 0)
+		return;
+
+	if (cache->generation != generation)
+		goto result_cache_put_exit;
+
+	if (!result_cache_current(cache, boot_id, intf->name)) {
+		memset(cache->entries, 0, sizeof(cache->entries));
+		cache->count = 0;
+		snprintf(cache->boot_id, sizeof(cache->boot_id), "%s",
+		         boot_id);
+		snprintf(cache->platform, sizeof(cache->platform), "%s",
+		         intf->name);
+		cache->magic = RESULT_CACHE_MAGIC;
+	}
+
+	for (i = 0; i < cache->count; i++) {
+		if (!strcmp(cache->entries[i].key, key)) {
+			entry = &cache->entries[i];
+			break;
+		}
+	}
+	if (!entry && cache->count < RESULT_CACHE_ENTRIES)
+		entry = &cache->entries[cache->count++];
+
+	if (entry) {
+		snprintf(entry->key, sizeof(entry->key), "%s", key);
+		snprintf(entry->value, sizeof(entry->value), "%s", value);
+	}
+
+result_cache_put_exit:
+	result_cache_write_end(cache);
+}
+
+static void result_cache_clear(void)
+{
+	struct result_cache *cache;
+
+	cache = result_cache_open();
+	if (!cache || !result_cache_writable)
+		return;
+
+	if (result_cache_write_begin(cache) < 0) {
+		lprintf(LOG_WARNING, "Unable to invalidate %s\n",
+		        RESULT_CACHE_SHM_NAME);
+		return;
+	}
+	cache->generation++;
+	cache->count = 0;
+	result_cache_write_end(cache);
+}
+#else
+static int result_cache_get(struct platform_intf *intf, const char *key,
+                            char *buf, size_t len, uint32_t *generation)
+{
+	*generation = 0;
+	return -1;
+}
+
+static void result_cache_put(struct platform_intf *intf, const char *key,
+                             const char *value, uint32_t generation)
+{
+}
+
+static void result_cache_clear(void)
+{
+}
+#endif	/* CONFIG_SHARED_RESULT_CACHE */
+
+static unsigned int result_cache_invalidate_count;
+
+void result_cache_invalidate(void)
+{
+	lprintf(LOG_DEBUG, "%s: Invalidating cached values\n", __func__);
+	/* counted first, so values being computed now are not memoized */
+	__atomic_add_fetch(&result_cache_invalidate_count, 1, __ATOMIC_SEQ_CST);
+	result_memo_clear();
+	result_cache_clear();
+}
+
+unsigned int result_cache_invalidations(void)
+{
+	return __atomic_load_n(&result_cache_invalidate_count,
+	                       __ATOMIC_ACQUIRE);
+}
+
+/*
+ * result_cache_string  -  return cached value or compute and cache it
+ *
+ * @intf:	platform interface
+ * @key:	cache key
+ * @getter:	function which computes the value
+ *
+ * returns allocated string which must be freed by caller
+ * returns NULL if value is not available
+ */
+static char *result_cache_string(struct platform_intf *intf, const char *key,
+                                 char *(*getter)(struct platform_intf *intf))
+{
+	char buf[RESULT_CACHE_VALUE_LEN];
+	unsigned int invalidations;
+	uint32_t generation;
+	char *value;
+
+	value = result_memo_get(key);
+	if (value)
+		return value;
+
+	invalidations = result_cache_invalidations();
+	if (result_cache_get(intf, key, buf, sizeof(buf), &generation) == 0) {
+		lprintf(LOG_DEBUG, "%s: %s=\"%s\"\n", __func__, key, buf);
+		result_memo_put(key, buf);
+		return mosys_strdup(buf);
+	}
+
+	value = getter(intf);
+	if (value) {
+		/* values computed across an invalidation may be stale */
+		if (invalidations == result_cache_invalidations())
+			result_memo_put(key, value);
+		result_cache_put(intf, key, value, generation);
+	}
+	return value;
+}
+
+/*
+ * Getters are wrapped in place, the original functions are kept in copies
+ * of the callback structures.
+ */
+static struct sys_cb orig_sys;
+static struct smbios_cb orig_smbios;
+static struct vpd_cb orig_vpd;
+static int result_cache_installed;
+
+#define RESULT_CACHE_GETTER(type, field)				\
+static char *cached_##type##_##field(struct platform_intf *intf)	\
+{									\
+	return result_cache_string(intf, #type "." #field,		\
+	                           orig_##type.field);			\
+}
+
+RESULT_CACHE_GETTER(sys, vendor)
+RESULT_CACHE_GETTER(sys, name)
+RESULT_CACHE_GETTER(sys, version)
+RESULT_CACHE_GETTER(sys, family)
+RESULT_CACHE_GETTER(sys, variant)
+RESULT_CACHE_GETTER(sys, chassis)
+RESULT_CACHE_GETTER(sys, brand)
+RESULT_CACHE_GETTER(sys, customization)
+RESULT_CACHE_GETTER(sys, model)
+RESULT_CACHE_GETTER(sys, firmware_vendor)
+RESULT_CACHE_GETTER(sys, firmware_version)
+RESULT_CACHE_GETTER(smbios, bios_vendor)
+RESULT_CACHE_GETTER(smbios, system_vendor)
+RESULT_CACHE_GETTER(smbios, system_name)
+RESULT_CACHE_GETTER(smbios, system_version)
+RESULT_CACHE_GETTER(smbios, system_family)
+RESULT_CACHE_GETTER(smbios, system_sku)
+RESULT_CACHE_GETTER(smbios, system_serial)
+RESULT_CACHE_GETTER(vpd, system_serial)
+RESULT_CACHE_GETTER(vpd, system_sku)
+RESULT_CACHE_GETTER(vpd, google_hwqualid)
+
+static int cached_sys_sku_number(struct platform_intf *intf)
+{
+	char buf[RESULT_CACHE_VALUE_LEN];
+	unsigned int invalidations;
+	uint32_t generation;
+	char *value;
+	int sku_number;
+
+	value = result_memo_get("sys.sku_number");
+	if (value) {
+		sku_number = strtol(value, NULL, 10);
+		free(value);
+		return sku_number;
+	}
+
+	invalidations = result_cache_invalidations();
+	if (result_cache_get(intf, "sys.sku_number", buf, sizeof(buf),
+	                     &generation) == 0) {
+		result_memo_put("sys.sku_number", buf);
+		return strtol(buf, NULL, 10);
+	}
+
+	sku_number = orig_sys.sku_number(intf);
+	if (sku_number >= 0) {
+		snprintf(buf, sizeof(buf), "%d", sku_number);
+		if (invalidations == result_cache_invalidations())
+			result_memo_put("sys.sku_number", buf);
+		result_cache_put(intf, "sys.sku_number", buf, generation);
+	}
+	return sku_number;
+}
+
+/*
+ * EC getters return strings owned by the driver, so memoized values are
+ * kept until the cache is removed rather than handed out as copies. Only
+ * the chip identity is memoized: the running firmware version changes
+ * when the EC jumps between its RO and RW images or is updated, so it is
+ * always queried. The other callback structures describe sensors, logs
+ * and other state that changes at runtime and are left alone.
+ */
+enum ec_field {
+	EC_FIELD_VENDOR,
+	EC_FIELD_NAME,
+	EC_FIELD_MAX,
+};
+
+static const char *ec_field_names[] = {
+	[EC_FIELD_VENDOR]	= "vendor",
+	[EC_FIELD_NAME]		= "name",
+};
+
+struct cached_ec {
+	const char *name;
+	struct ec_cb *ec;
+	struct ec_cb orig;
+	char *values[EC_FIELD_MAX];
+};
+
+static struct cached_ec cached_ecs[] = {
+	{ .name = "ec" },
+	{ .name = "pd" },
+	{ .name = "sh" },
+	{ .name = "fp" },
+};
+
+static const char *cached_ec_string(struct platform_intf *intf,
+                                    struct ec_cb *ec, enum ec_field field)
+{
+	struct cached_ec *cached = NULL;
+	const char *(*getter)(struct platform_intf *, struct ec_cb *);
+	char buf[RESULT_CACHE_VALUE_LEN];
+	char key[RESULT_CACHE_KEY_LEN];
+	uint32_t generation;
+	const char *value;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cached_ecs); i++) {
+		if (cached_ecs[i].ec == ec)
+			cached = &cached_ecs[i];
+	}
+	if (!cached)
+		return NULL;
+
+	if (field == EC_FIELD_VENDOR)
+		getter = cached->orig.vendor;
+	else
+		getter = cached->orig.name;
+
+	pthread_mutex_lock(&result_memo_lock);
+	value = cached->values[field];
+	pthread_mutex_unlock(&result_memo_lock);
+	if (value)
+		return value;
+
+	snprintf(key, sizeof(key), "%s.%s", cached->name,
+	         ec_field_names[field]);
+	if (result_cache_get(intf, key, buf, sizeof(buf), &generation) < 0) {
+		value = getter(intf, ec);
+		if (!value)
+			return NULL;
+		result_cache_put(intf, key, value, generation);
+		snprintf(buf, sizeof(buf), "%s", value);
+	}
+
+	pthread_mutex_lock(&result_memo_lock);
+	if (!cached->values[field])
+		cached->values[field] = mosys_strdup(buf);
+	value = cached->values[field];
+	pthread_mutex_unlock(&result_memo_lock);
+	return value;
+}
+
+static const char *cached_ec_vendor(struct platform_intf *intf,
+                                    struct ec_cb *ec)
+{
+	return cached_ec_string(intf, ec, EC_FIELD_VENDOR);
+}
+
+static const char *cached_ec_name(struct platform_intf *intf,
+                                  struct ec_cb *ec)
+{
+	return cached_ec_string(intf, ec, EC_FIELD_NAME);
+}
+
+#define RESULT_CACHE_WRAP(type, field)					\
+	do {								\
+		if (orig_##type.field)					\
+			intf->cb->type->field = cached_##type##_##field;	\
+	} while (0)
+
+void result_cache_install(struct platform_intf *intf)
+{
+	struct ec_cb *ecs[ARRAY_SIZE(cached_ecs)];
+	int i, j;
+
+	if (!intf->cb || result_cache_installed)
+		return;
+	result_cache_installed = 1;
+
+	if (intf->cb->sys) {
+		orig_sys = *intf->cb->sys;
+		RESULT_CACHE_WRAP(sys, vendor);
+		RESULT_CACHE_WRAP(sys, name);
+		RESULT_CACHE_WRAP(sys, version);
+		RESULT_CACHE_WRAP(sys, family);
+		RESULT_CACHE_WRAP(sys, variant);
+		RESULT_CACHE_WRAP(sys, chassis);
+		RESULT_CACHE_WRAP(sys, brand);
+		RESULT_CACHE_WRAP(sys, customization);
+		RESULT_CACHE_WRAP(sys, sku_number);
+		RESULT_CACHE_WRAP(sys, model);
+		RESULT_CACHE_WRAP(sys, firmware_vendor);
+		RESULT_CACHE_WRAP(sys, firmware_version);
+	}
+
+	if (intf->cb->smbios) {
+		orig_smbios = *intf->cb->smbios;
+		RESULT_CACHE_WRAP(smbios, bios_vendor);
+		RESULT_CACHE_WRAP(smbios, system_vendor);
+		RESULT_CACHE_WRAP(smbios, system_name);
+		RESULT_CACHE_WRAP(smbios, system_version);
+		RESULT_CACHE_WRAP(smbios, system_family);
+		RESULT_CACHE_WRAP(smbios, system_sku);
+		RESULT_CACHE_WRAP(smbios, system_serial);
+	}
+
+	if (intf->cb->vpd) {
+		orig_vpd = *intf->cb->vpd;
+		RESULT_CACHE_WRAP(vpd, system_serial);
+		RESULT_CACHE_WRAP(vpd, system_sku);
+		RESULT_CACHE_WRAP(vpd, google_hwqualid);
+	}
+
+	ecs[0] = intf->cb->ec;
+	ecs[1] = intf->cb->pd;
+	ecs[2] = intf->cb->sh;
+	ecs[3] = intf->cb->fp;
+	for (i = 0; i < ARRAY_SIZE(cached_ecs); i++) {
+		struct ec_cb *ec = ecs[i];
+
+		/* wrap each structure only once */
+		for (j = 0; j < i; j++) {
+			if (ecs[j] == ec)
+				ec = NULL;
+		}
+		if (!ec)
+			continue;
+
+		cached_ecs[i].ec = ec;
+		cached_ecs[i].orig = *ec;
+		if (ec->vendor)
+			ec->vendor = cached_ec_vendor;
+		if (ec->name)
+			ec->name = cached_ec_name;
+	}
+}
+
+void result_cache_remove(struct platform_intf *intf)
+{
+	int i, field;
+
+	if (!intf->cb || !result_cache_installed)
+		return;
+	result_cache_installed = 0;
+	result_memo_clear();
+
+	if (intf->cb->sys)
+		*intf->cb->sys = orig_sys;
+	if (intf->cb->smbios)
+		*intf->cb->smbios = orig_smbios;
+	if (intf->cb->vpd)
+		*intf->cb->vpd = orig_vpd;
+
+	for (i = 0; i < ARRAY_SIZE(cached_ecs); i++) {
+		struct cached_ec *cached = &cached_ecs[i];
+
+		if (!cached->ec)
+			continue;
+
+		cached->ec->vendor = cached->orig.vendor;
+		cached->ec->name = cached->orig.name;
+		cached->ec = NULL;
+		for (field = 0; field < EC_FIELD_MAX; field++) {
+			free(cached->values[field]);
+			cached->values[field] = NULL;
+		}
+	}
+}
@@ -0,0 +1,229 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * result_cache_unittest.c: unit tests for memoized getters
+ */
+
+#include <limits.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "cmockery.h"
+
+#include "mosys/alloc.h"
+#include "mosys/globals.h"
+#include "mosys/platform.h"
+#include "mosys/result_cache.h"
+
+#include "lib/math.h"
+
+#define TEST_BOOT_ID	"2b7d1f0c-6a3e-4d59-8c21-5e9f0a7b3c64\n"
+
+static const char *test_value;
+static int test_calls;
+static int test_invalidate;
+
+/* stands in for a getter reading hardware */
+static char *test_name(struct platform_intf *intf)
+{
+	test_calls++;
+	/* like a setter running while the value is computed */
+	if (test_invalidate)
+		result_cache_invalidate();
+	return mosys_strdup(test_value);
+}
+
+static struct sys_cb test_sys_cb = {
+	.name	= test_name,
+};
+
+static struct platform_cb test_cb = {
+	.sys	= &test_sys_cb,
+};
+
+static struct platform_intf cache_intf = {
+	.name	= "result_cache_test",
+	.cb	= &test_cb,
+};
+
+/* values can only be shared between processes by root */
+static int shared_cache_usable(void)
+{
+#if defined(CONFIG_SHARED_RESULT_CACHE)
+	return geteuid() == 0 && access("/dev/shm", W_OK) == 0;
+#else
+	return 0;
+#endif
+}
+
+static void test_start(const char *value)
+{
+	result_cache_install(&cache_intf);
+	assert_true(test_sys_cb.name != test_name);
+	/* start from an empty cache */
+	result_cache_invalidate();
+	test_value = value;
+	test_calls = 0;
+	test_invalidate = 0;
+}
+
+static void test_name_equal(const char *expect)
+{
+	char *value;
+
+	value = cache_intf.cb->sys->name(&cache_intf);
+	assert_string_equal(expect, value);
+	free(value);
+}
+
+static void memo_test(void **state)
+{
+	test_start("first");
+
+	test_name_equal("first");
+	test_name_equal("first");
+	assert_int_equal(1, test_calls);
+
+	/* kept even though the hardware changed... */
+	test_value = "second";
+	test_name_equal("first");
+	assert_int_equal(1, test_calls);
+
+	/* ...until something invalidates it */
+	result_cache_invalidate();
+	test_name_equal("second");
+	assert_int_equal(2, test_calls);
+
+	result_cache_remove(&cache_intf);
+	assert_true(test_sys_cb.name == test_name);
+}
+
+static void shared_test(void **state)
+{
+	if (!shared_cache_usable())
+		return;
+
+	test_start("shared");
+	test_name_equal("shared");
+	assert_int_equal(1, test_calls);
+
+	/* forget the values of this process, other processes see them */
+	result_cache_remove(&cache_intf);
+	result_cache_install(&cache_intf);
+	test_name_equal("shared");
+	assert_int_equal(1, test_calls);
+
+	/* invalidating drops them for every process */
+	result_cache_remove(&cache_intf);
+	result_cache_install(&cache_intf);
+	result_cache_invalidate();
+	test_value = "changed";
+	test_name_equal("changed");
+	assert_int_equal(2, test_calls);
+
+	result_cache_remove(&cache_intf);
+}
+
+static void generation_test(void **state)
+{
+	test_start("stale");
+
+	/* a value computed across an invalidation is returned... */
+	test_invalidate = 1;
+	test_name_equal("stale");
+	assert_int_equal(1, test_calls);
+
+	/* ...but neither memoized nor shared */
+	test_invalidate = 0;
+	test_value = "fresh";
+	test_name_equal("fresh");
+	assert_int_equal(2, test_calls);
+
+	result_cache_remove(&cache_intf);
+	result_cache_install(&cache_intf);
+	test_name_equal("fresh");
+	assert_int_equal(shared_cache_usable() ? 2 : 3, test_calls);
+
+	result_cache_remove(&cache_intf);
+}
+
+int result_cache_unittest(void)
+{
+	UnitTest tests[] = {
+		unit_test(memo_test),
+		unit_test(shared_test),
+		unit_test(generation_test),
+	};
+	char root[] = "/tmp/result_cache_test.XXXXXX";
+	char path[PATH_MAX];
+	const char *dirs[] = {
+		"/proc", "/proc/sys", "/proc/sys/kernel",
+		"/proc/sys/kernel/random",
+	};
+	char *saved_root;
+	FILE *fp;
+	int i, rc;
+
+	/* the shared cache is only used with a boot ID to tag it with */
+	if (!mkdtemp(root))
+		return -1;
+	for (i = 0; i < ARRAY_SIZE(dirs); i++) {
+		snprintf(path, sizeof(path), "%s%s", root, dirs[i]);
+		mkdir(path, 0700);
+	}
+	strcat(path, "/boot_id");
+	fp = fopen(path, "w");
+	if (fp) {
+		fputs(TEST_BOOT_ID, fp);
+		fclose(fp);
+	}
+
+	saved_root = mosys_strdup(mosys_get_root_prefix());
+	mosys_set_root_prefix(root);
+
+	rc = run_tests(tests);
+
+	mosys_set_root_prefix(saved_root);
+	free(saved_root);
+	unlink(path);
+	for (i = ARRAY_SIZE(dirs) - 1; i >= 0; i--) {
+		snprintf(path, sizeof(path), "%s%s", root, dirs[i]);
+		rmdir(path);
+	}
+	rmdir(root);
+
+	return rc;
+}
@@ -45,6 +45,7 @@
 
 #include "mosys/alloc.h"
 #include "mosys/globals.h"
+#include "mosys/intf_list.h"
 #include "mosys/log.h"
 #include "mosys/platform.h"
 
@@ -190,6 +191,9 @@ int cyapa_get_firmware_version(struct platform_intf *intf, uint8_t bus,
 {
 	int rc = 0;
 
+	if (intf_op_ready(intf, INTF_OP_I2C) < 0)
+		return -1;
+
 	rc = cyapa_get_firmware_version_sysfs(intf, bus, addr, buf);
 	if (rc != 0) {
 		lprintf(LOG_DEBUG, "%s: Using I2C fallback\n", __func__);
@@ -203,6 +207,9 @@ int cyapa_get_hardware_version(struct platform_intf *intf, uint8_t bus,
 {
 	int rc = 0;
 
+	if (intf_op_ready(intf, INTF_OP_I2C) < 0)
+		return -1;
+
 	rc = cyapa_get_hardware_version_sysfs(intf, bus, addr, buf);
 	if (rc != 0) {
 		lprintf(LOG_DEBUG, "%s: Using I2C fallback\n", __func__);
@@ -216,6 +223,9 @@ int cyapa_get_product_id(struct platform_intf *intf, uint8_t bus,
 {
 	int rc = 0;
 
+	if (intf_op_ready(intf, INTF_OP_I2C) < 0)
+		return -1;
+
 	rc = cyapa_get_product_id_sysfs(intf, bus, addr, buf);
 	if (rc != 0) {
 		lprintf(LOG_DEBUG, "%s: Using I2C fallback\n", __func__);
@@ -33,8 +33,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <pthread.h>
 
 #include "mosys/alloc.h"
+#include "mosys/callbacks.h"
 #include "mosys/kv_pair.h"
 #include "mosys/log.h"
 #include "mosys/platform.h"
@@ -389,35 +391,96 @@ struct nvram_cb cros_ec_nvram_cb = {
 	.vboot_write	= cros_ec_vboot_write,
 };
 
-int cros_ec_setup(struct platform_intf *intf)
+/* EC whose probe is deferred until its first command */
+struct cros_ec_deferred {
+	struct cros_ec_priv priv;	/* must be first */
+	void *saved_priv;		/* ec->priv to restore before setup */
+	int (*setup)(struct platform_intf *intf);
+	int failed;
+};
+
+static pthread_mutex_t cros_ec_deferred_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int cros_ec_command_deferred(struct platform_intf *intf,
+				    struct ec_cb *ec,
+				    int command, int command_version,
+				    const void *indata, int insize,
+				    const void *outdata, int outsize)
 {
-	MOSYS_CHECK(intf->cb && intf->cb->ec);
+	struct cros_ec_deferred *deferred = ec->priv;
+	struct cros_ec_priv *priv;
+	int failed;
+
+	pthread_mutex_lock(&cros_ec_deferred_lock);
+	if (ec->priv == deferred && !deferred->failed) {
+		lprintf(LOG_DEBUG, "%s: probing EC on first use\n", __func__);
+		ec->priv = deferred->saved_priv;
+		if (deferred->setup(intf) != 1) {
+			lprintf(LOG_ERR, "Unable to find EC\n");
+			deferred->failed = 1;
+			ec->priv = deferred;
+		}
+	}
+	failed = deferred->failed;
+	priv = ec->priv;
+	pthread_mutex_unlock(&cros_ec_deferred_lock);
+
+	if (failed)
+		return -1;
 
-	lprintf(LOG_DEBUG, "%s: Trying devfs interface...\n", __func__);
-	if (cros_ec_setup_dev(intf) == 1)
-		return 1;
+	return priv->cmd(intf, ec, command, command_version,
+			 indata, insize, outdata, outsize);
+}
 
+/*
+ * cros_ec_defer_setup  -  defer EC probing until first command
+ *
+ * @intf:	platform interface
+ * @ec:		EC interface, can be for any CrOS EC type (EC, PD, SH, etc)
+ * @setup:	function that probes the EC, returns 1 if detected
+ *
+ * Probing an EC means talking to it, which commands that do not use the
+ * EC should not pay for. This installs a command function that runs
+ * @setup the first time the EC is used.
+ *
+ * returns 0 to indicate success
+ */
+int cros_ec_defer_setup(struct platform_intf *intf, struct ec_cb *ec,
+			int (*setup)(struct platform_intf *intf))
+{
+	struct cros_ec_deferred *deferred;
+	struct cros_ec_priv *priv = ec->priv;
+
+	deferred = mosys_zalloc(sizeof(*deferred));
+	deferred->priv.cmd = cros_ec_command_deferred;
+	deferred->setup = setup;
+
+	/* platform was set up before and the EC never used */
+	if (priv && priv->cmd == cros_ec_command_deferred) {
+		struct cros_ec_deferred *old = ec->priv;
+		deferred->saved_priv = old->saved_priv;
+	} else
+		deferred->saved_priv = priv;
+
+	ec->priv = deferred;
+	add_destroy_callback(free, deferred);
 	return 0;
 }
 
+int cros_ec_setup(struct platform_intf *intf)
+{
+	MOSYS_CHECK(intf->cb && intf->cb->ec);
+	return cros_ec_defer_setup(intf, intf->cb->ec, cros_ec_setup_dev);
+}
+
 int cros_pd_setup(struct platform_intf *intf)
 {
 	MOSYS_CHECK(intf->cb && intf->cb->pd);
-
-	lprintf(LOG_DEBUG, "%s: Trying devfs interface...\n", __func__);
-	if (cros_pd_setup_dev(intf) == 1)
-		return 1;
-
-	return 0;
+	return cros_ec_defer_setup(intf, intf->cb->pd, cros_pd_setup_dev);
 }
 
 int cros_fp_setup(struct platform_intf *intf)
 {
 	MOSYS_CHECK(intf->cb && intf->cb->fp);
-
-	lprintf(LOG_DEBUG, "%s: Trying devfs interface...\n", __func__);
-	if (cros_fp_setup_dev(intf) == 1)
-		return 1;
-
-	return 0;
+	return cros_ec_defer_setup(intf, intf->cb->fp, cros_fp_setup_dev);
 }
@@ -32,6 +32,7 @@
  */
 
 #include <inttypes.h>
+#include <pthread.h>
 
 #include "mosys/alloc.h"
 #include "mosys/platform.h"
@@ -49,12 +50,13 @@ static uint8_t ich_io_sel_offsets[] = { 0x04, 0x34, 0x44 };
 static uint8_t ich_lvl_offsets[] = { 0x0c, 0x38, 0x48 };
 static uint8_t ich_gpio_inv_offset = 0x2c;	/* for port 1 only */
 
-struct {
+/* registers of one port */
+struct ich_gpio_regs {
 	uint16_t gpio_base;
 	uint8_t use_sel;
 	uint8_t io_sel;
 	uint8_t lvl;
-} ich_gpio_offsets;
+};
 
 /* returns 1 if GPIO is valid, 0 otherwise */
 static int ich_gpio_valid(enum ich_generation gen, struct gpio_map *gpio)
@@ -96,38 +98,45 @@ static int ich_gpio_valid(enum ich_generation gen, struct gpio_map *gpio)
 int ich_get_gpio_base(struct platform_intf *intf, uint16_t *val)
 {
 	static uint16_t ich_gpio_base = 0;
+	static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	int ret = 0;
 
-	if (ich_gpio_base) {
-		*val = ich_gpio_base;
-		return 0;
-	}
+	pthread_mutex_lock(&lock);
+	if (ich_gpio_base)
+		goto ich_get_gpio_base_exit;
 
 	if (pci_read16(intf, 0, 31, 0, 0x48, &ich_gpio_base) < 0) {
 		lprintf(LOG_DEBUG, "ICH GPIO: unable to find base\n");
-		return -1;
+		ich_gpio_base = 0;
+		ret = -1;
+		goto ich_get_gpio_base_exit;
 	}
 
 	/* lsb is enable bit */
 	ich_gpio_base &= ~1;
 
 	lprintf(LOG_DEBUG, "ICH GPIO: base is 0x%08x\n", ich_gpio_base);
+
+ich_get_gpio_base_exit:
 	*val = ich_gpio_base;
-	return 0;
+	pthread_mutex_unlock(&lock);
+	return ret;
 }
 
 /* select register set for given port */
 static int ich_get_regs(struct platform_intf *intf,
-                        enum ich_generation gen, struct gpio_map *gpio)
+                        enum ich_generation gen, struct gpio_map *gpio,
+                        struct ich_gpio_regs *regs)
 {
 	if (!ich_gpio_valid(gen, gpio))
 			return -1;
 
-	if (ich_get_gpio_base(intf, &ich_gpio_offsets.gpio_base) < 0)
+	if (ich_get_gpio_base(intf, &regs->gpio_base) < 0)
 		return -1;
 
-	ich_gpio_offsets.use_sel = ich_use_sel_offsets[gpio->port];
-	ich_gpio_offsets.io_sel = ich_io_sel_offsets[gpio->port];
-	ich_gpio_offsets.lvl = ich_lvl_offsets[gpio->port];
+	regs->use_sel = ich_use_sel_offsets[gpio->port];
+	regs->io_sel = ich_io_sel_offsets[gpio->port];
+	regs->lvl = ich_lvl_offsets[gpio->port];
 
 	return 0;
 }
@@ -135,12 +144,13 @@ static int ich_get_regs(struct platform_intf *intf,
 int ich_read_gpio(struct platform_intf *intf,
                   enum ich_generation gen, struct gpio_map *gpio)
 {
+	struct ich_gpio_regs regs;
 	uint32_t addr, val;
 
-	if (ich_get_regs(intf, gen, gpio) < 0)
+	if (ich_get_regs(intf, gen, gpio, &regs) < 0)
 		return -1;
 
-	addr = ich_gpio_offsets.gpio_base + ich_gpio_offsets.lvl;
+	addr = regs.gpio_base + regs.lvl;
 	if (io_read32(intf, addr, &val) < 0)
 		return -1;
 
@@ -150,6 +160,7 @@ int ich_read_gpio(struct platform_intf *intf,
 int ich_set_gpio(struct platform_intf *intf, enum ich_generation gen,
                  struct gpio_map *gpio, int state)
 {
+	struct ich_gpio_regs regs;
 	uint32_t addr, val;
 
 	if (gpio->type != GPIO_OUT) {
@@ -158,10 +169,10 @@ int ich_set_gpio(struct platform_intf *intf, enum ich_generation gen,
 		return -1;
 	}
 
-	if (ich_get_regs(intf, gen, gpio) < 0)
+	if (ich_get_regs(intf, gen, gpio, &regs) < 0)
 		return -1;
 
-	addr = ich_gpio_offsets.gpio_base + ich_gpio_offsets.use_sel;
+	addr = regs.gpio_base + regs.use_sel;
 	if (io_read32(intf, addr, &val) < 0)
 		return -1;
 	if (!(val & (1 << gpio->pin))) {
@@ -172,7 +183,7 @@ int ich_set_gpio(struct platform_intf *intf, enum ich_generation gen,
 			return -1;
 	}
 
-	addr = ich_gpio_offsets.gpio_base + ich_gpio_offsets.io_sel;
+	addr = regs.gpio_base + regs.io_sel;
 	if (io_read32(intf, addr, &val) < 0)
 		return -1;
 	if (val & (1 << gpio->pin)) {
@@ -183,7 +194,7 @@ int ich_set_gpio(struct platform_intf *intf, enum ich_generation gen,
 			return -1;
 	}
 
-	addr = ich_gpio_offsets.gpio_base + ich_gpio_offsets.lvl;
+	addr = regs.gpio_base + regs.lvl;
 	if (io_read32(intf, addr, &val) < 0)
 		return -1;
 	switch (state) {
@@ -214,6 +225,7 @@ int ich_set_gpio(struct platform_intf *intf, enum ich_generation gen,
 int ich_gpio_list(struct platform_intf *intf, enum ich_generation gen,
                   int port, int gpio_pins[], int num_gpios)
 {
+	struct ich_gpio_regs regs;
 	int i, state;
 	uint32_t addr, val;
 
@@ -227,17 +239,17 @@ int ich_gpio_list(struct platform_intf *intf, enum ich_generation gen,
 		gpio.pin = gpio_pins[i];	/* pin in port in device */
 		gpio.id = gpio.port + gpio.pin;
 
-		if (ich_get_regs(intf, gen, &gpio) < 0)
+		if (ich_get_regs(intf, gen, &gpio, &regs) < 0)
 			return -1;
 
 		/* skip if signal is "native function" instead of GPIO */
-		addr = ich_gpio_offsets.gpio_base + ich_gpio_offsets.use_sel;
+		addr = regs.gpio_base + regs.use_sel;
 		if (io_read32(intf, addr, &val) < 0)
 			return -1;
 		if ((val & (1 << gpio.pin)) == 0)
 			continue;
 
-		addr = ich_gpio_offsets.gpio_base + ich_gpio_offsets.io_sel;
+		addr = regs.gpio_base + regs.io_sel;
 		if (io_read32(intf, addr, &val) < 0)
 			return -1;
 		if ((val & (1 << gpio.pin)) == 0)
@@ -249,7 +261,7 @@ int ich_gpio_list(struct platform_intf *intf, enum ich_generation gen,
 		/* gpio negation only applies to pins 15:0 in port 1 (GP_LVL2
 		   set) and only if the pin is configured as an input */
 		if (port == 1 && gpio.pin < 16 && gpio.type == GPIO_IN) {
-			addr = ich_gpio_offsets.gpio_base + ich_gpio_inv_offset;
+			addr = regs.gpio_base + ich_gpio_inv_offset;
 			if (io_read32(intf, addr, &val) < 0)
 				return -1;
 			gpio.neg = (val >> gpio.pin) & 1;
@@ -126,6 +126,8 @@ int cros_pd_chip_info(struct platform_intf *intf,
 int cros_pd_flash_info(struct platform_intf *intf,
 		         struct ec_response_flash_info *info);
 
+int cros_ec_defer_setup(struct platform_intf *intf, struct ec_cb *ec,
+			int (*setup)(struct platform_intf *intf));
 int cros_ec_setup(struct platform_intf *intf);
 int cros_pd_setup(struct platform_intf *intf);
 int cros_fp_setup(struct platform_intf *intf);
@@ -36,6 +36,8 @@
 
 #include <inttypes.h>
 
+#include "mosys/intf_list.h"
+
 enum io_access_width {
 	IO_ACCESS_8	= 1,
 	IO_ACCESS_16	= 2,
@@ -115,6 +117,8 @@ static inline int
 io_read(struct platform_intf *intf, uint16_t reg,
         enum io_access_width size, void *data)
 {
+	if (intf_op_ready(intf, INTF_OP_IO) < 0)
+		return -1;
 	return intf->op->io->read(intf, reg, size, data);
 }
 
@@ -159,6 +163,8 @@ static inline int
 io_write(struct platform_intf *intf, uint16_t reg,
         enum io_access_width size, void *data)
 {
+	if (intf_op_ready(intf, INTF_OP_IO) < 0)
+		return -1;
 	return intf->op->io->write(intf, reg, size, data);
 }
 
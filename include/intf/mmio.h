@@ -34,6 +34,7 @@
 
 #include <inttypes.h>
 
+#include "mosys/intf_list.h"
 #include "mosys/platform.h"
 
 struct file_backed_range;
@@ -159,6 +160,8 @@ static inline int
 mmio_read(struct platform_intf *intf, uint64_t address,
           size_t length, void *data)
 {
+	if (intf_op_ready(intf, INTF_OP_MMIO) < 0)
+		return -1;
 	if (intf->op->mmio->read(intf, address, length, data) != length) {
 		return -1;
 	}
@@ -215,6 +218,8 @@ static inline int
 mmio_write(struct platform_intf *intf, uint64_t address,
            size_t length, const void *data)
 {
+	if (intf_op_ready(intf, INTF_OP_MMIO) < 0)
+		return -1;
 	if (intf->op->mmio->write(intf, address, length, data) != length) {
 		return -1;
 	}
@@ -269,6 +274,8 @@ mmio_write64(struct platform_intf *intf, uint64_t address, const uint64_t data)
 static inline int
 mmio_clear(struct platform_intf *intf, uint64_t address, int length)
 {
+	if (intf_op_ready(intf, INTF_OP_MMIO) < 0)
+		return -1;
 	if (intf->op->mmio->clear(intf, address, length) != length) {
 		return -1;
 	}
@@ -285,6 +292,8 @@ mmio_clear(struct platform_intf *intf, uint64_t address, int length)
 static inline void
 mmio_dump(struct platform_intf *intf, uint64_t address, int length)
 {
+	if (intf_op_ready(intf, INTF_OP_MMIO) < 0)
+		return;
 	intf->op->mmio->dump(intf, address, length);
 }
 
@@ -302,6 +311,8 @@ static inline void *
 mmio_map(struct platform_intf *intf, int flags,
          uint64_t address, unsigned int length)
 {
+	if (intf_op_ready(intf, INTF_OP_MMIO) < 0)
+		return NULL;
 	return intf->op->mmio->map(intf, flags, address, length);
 }
 
@@ -319,6 +330,8 @@ static inline int
 mmio_unmap(struct platform_intf *intf, void *mptr,
            uint64_t address, unsigned int length)
 {
+	if (intf_op_ready(intf, INTF_OP_MMIO) < 0)
+		return -1;
 	return intf->op->mmio->unmap(intf, mptr, address, length);
 }
 
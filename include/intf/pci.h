@@ -36,6 +36,8 @@
 
 #include <inttypes.h>
 
+#include "mosys/intf_list.h"
+
 struct platform_intf;
 
 typedef int (*pci_callback_t)(struct platform_intf *intf,
@@ -157,6 +159,8 @@ static inline int
 pci_read(struct platform_intf *intf, int bus, int dev, int func, int reg,
           size_t length, void *data)
 {
+	if (intf_op_ready(intf, INTF_OP_PCI) < 0)
+		return -1;
 	if (intf->op->pci->read(intf, bus, dev, func, reg, length, data)
 	    != length) {
 		return -1;
@@ -221,6 +225,8 @@ static inline int
 pci_write(struct platform_intf *intf, int bus, int dev, int func, int reg,
           size_t length, const void *data)
 {
+	if (intf_op_ready(intf, INTF_OP_PCI) < 0)
+		return -1;
 	if (intf->op->pci->write(intf, bus, dev, func, reg, length, data)
 	    != length) {
 		return -1;
@@ -281,6 +287,8 @@ pci_write64(struct platform_intf *intf, int bus, int dev, int func, int reg,
 static inline int
 pci_foreach(struct platform_intf *intf, pci_callback_t cb, void *data)
 {
+	if (intf_op_ready(intf, INTF_OP_PCI) < 0)
+		return -1;
 	return intf->op->pci->foreach(intf, cb, data);
 }
 
@@ -299,6 +307,8 @@ static inline int
 pci_foreach_in_bus(struct platform_intf *intf, int bus,
                    pci_callback_t cb, void *data)
 {
+	if (intf_op_ready(intf, INTF_OP_PCI) < 0)
+		return -1;
 	return intf->op->pci->foreach_in_bus(intf, bus, cb, data);
 }
 
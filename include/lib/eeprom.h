@@ -153,6 +153,47 @@ struct eeprom_dev {
 			     unsigned int len,
 			     uint8_t *data);
 
+	/*
+	 * write_range_by_name  -  write part of a region specified by name
+	 *
+	 * @intf:	platform interface
+	 * @eeprom:	eeprom interface
+	 * @name:	name of region to write
+	 * @offset:	offset of the data within the region
+	 * @len:	length of the data buffer
+	 * @data:	pointer to the data buffer to write
+	 *
+	 * This is optional. Devices which erase in blocks may implement it so
+	 * that small updates only touch the blocks which changed.
+	 *
+	 * returns the number of bytes written if successful
+	 * returns <0 to indicate error
+	 */
+	int (*write_range_by_name)(struct platform_intf *intf,
+				   struct eeprom *eeprom,
+				   const char *name,
+				   unsigned int offset,
+				   unsigned int len,
+				   uint8_t *data);
+
+	/*
+	 * prefetch  -  read several regions specified by name in one pass
+	 *
+	 * @intf:	platform interface
+	 * @eeprom:	eeprom interface
+	 * @names:	NULL-terminated list of region names
+	 *
+	 * This is optional. Devices which are slow to set up may implement it
+	 * to fetch all regions of interest at once, after which read_by_name
+	 * is served from cache.
+	 *
+	 * returns 0 if successful
+	 * returns <0 to indicate error
+	 */
+	int (*prefetch)(struct platform_intf *intf,
+			struct eeprom *eeprom,
+			const char **names);
+
 	/*
 	 * get_map  -  retrieve flash map
 	 *
@@ -213,6 +254,110 @@ extern int eeprom_mmio_read(struct platform_intf *intf, struct eeprom *eeprom,
  */
 extern struct fmap *eeprom_get_fmap(struct platform_intf *intf,
                                     struct eeprom *eeprom);
+/*
+ * eeprom_prefetch_regions - prefetch all regions described for an EEPROM
+ *
+ * @intf:	platform interface
+ * @eeprom:	eeprom structure
+ *
+ * Hands the names of all regions in eeprom->regions to the device's
+ * prefetch method, if it has one. Failure is not fatal since the regions
+ * can still be read one at a time.
+ *
+ * returns 0 if successful or if there is nothing to do
+ * returns <0 to indicate failure
+ */
+extern int eeprom_prefetch_regions(struct platform_intf *intf,
+				   struct eeprom *eeprom);
+
+/*
+ * eeprom_host_firmware_read - read host firmware ROM using flashrom
+ *
+ * @intf:	platform interface
+ * @eeprom:	eeprom structure
+ * @offset:	offset to start reading from
+ * @len:	number of bytes to read
+ * @data:	buffer to store data in
+ *
+ * Only the requested range is read, unless the whole ROM is cached.
+ *
+ * returns 0 if successful
+ * returns <0 to indicate failure
+ */
+extern int eeprom_host_firmware_read(struct platform_intf *intf,
+				     struct eeprom *eeprom,
+				     unsigned int offset, unsigned int len,
+				     void *data);
+
+/*
+ * eeprom_host_firmware_prefetch - prefetch regions of host firmware ROM
+ *
+ * @intf:	platform interface
+ * @eeprom:	eeprom structure
+ * @names:	NULL-terminated list of region names
+ *
+ * This is a prefetch method for host firmware ROMs accessed using flashrom.
+ *
+ * returns 0 if successful
+ * returns <0 to indicate failure
+ */
+extern int eeprom_host_firmware_prefetch(struct platform_intf *intf,
+					 struct eeprom *eeprom,
+					 const char **names);
+
+/*
+ * eeprom_mapped_flash_read - read host firmware ROM through its mapping
+ *
+ * @intf:	platform interface
+ * @eeprom:	eeprom structure
+ * @offset:	offset in ROM
+ * @len:	length of data
+ * @data:	data buffer
+ *
+ * On x86 the host firmware ROM is mapped just below 4GB, or at
+ * eeprom->addr.mmio if set. Ranges which are not covered by the mapping,
+ * for example regions that the flash descriptor hides from the host, are
+ * read using flashrom instead.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int eeprom_mapped_flash_read(struct platform_intf *intf,
+				    struct eeprom *eeprom,
+				    unsigned int offset, unsigned int len,
+				    void *data);
+
+/*
+ * eeprom_mapped_flash_read_by_name - read FMAP region through ROM mapping
+ *
+ * @intf:	platform interface
+ * @eeprom:	eeprom structure
+ * @name:	name of FMAP region
+ * @data:	double-pointer to data buffer to allocate and fill
+ *
+ * Falls back to flashrom if the region is not covered by the mapping.
+ *
+ * returns number of bytes read to indicate success
+ * returns <0 to indicate failure
+ */
+extern int eeprom_mapped_flash_read_by_name(struct platform_intf *intf,
+					    struct eeprom *eeprom,
+					    const char *name, uint8_t **data);
+
+/*
+ * eeprom_mapped_flash_get_map - return newly allocated copy of mapped FMAP
+ *
+ * @intf:	platform interface
+ * @eeprom:	eeprom structure
+ *
+ * Falls back to eeprom_get_fmap() if the ROM is not mapped.
+ *
+ * returns a newly allocated struct fmap if successful
+ * returns NULL to indicate error or if no fmap is found
+ */
+extern struct fmap *eeprom_mapped_flash_get_map(struct platform_intf *intf,
+						struct eeprom *eeprom);
+
 /*
  * eeprom_get_host_firmware_rom_size - obtain size of host's firmware ROM
  *
@@ -45,6 +45,9 @@ struct smbios_table_log;
 #define ELOG_MAGIC		0x474f4c45 /* 'ELOG' */
 #define ELOG_VERSION		1
 
+/* smallest unit the eventlog region of a ROM is erased in */
+#define ELOG_ERASE_BLOCK_SIZE	4096
+
 struct elog_header {
 	uint32_t elog_magic;
 	uint8_t elog_version;
@@ -52,6 +55,13 @@ struct elog_header {
 	uint8_t reserved[2];
 } __attribute__ ((packed));
 
+/* an event to be added to the log, see elog_add_events_manually() */
+struct elog_new_event {
+	uint8_t type;		/* enum smbios_log_entry_type */
+	size_t data_size;
+	uint8_t *data;
+};
+
 extern int elog_print_type(struct platform_intf *intf,
                            struct smbios_log_entry *entry, struct kv_pair *kv);
 extern int elog_print_data(struct platform_intf *intf,
@@ -64,6 +74,12 @@ extern int elog_print_multi(struct platform_intf *intf,
 extern int elog_add_event_manually(struct platform_intf *intf,
 				   enum smbios_log_entry_type type,
 				   size_t data_size, uint8_t *data);
+extern int elog_add_events_manually(struct platform_intf *intf,
+				    struct elog_new_event *events, int num);
+extern int elog_parse_event(const char *type, const char *hex,
+			    struct elog_new_event *event);
+extern int elog_parse_event_file(const char *path,
+				 struct elog_new_event **events);
 extern int elog_clear_manually(struct platform_intf *intf);
 extern int elog_fetch_from_smbios(struct platform_intf *intf,
 				  uint8_t **data, size_t *length,
@@ -73,6 +89,9 @@ extern int elog_fetch_from_flash(struct platform_intf *intf,
 				 off_t *header_offset, off_t *data_offset);
 extern int elog_write_to_flash(struct platform_intf *intf, uint8_t *data,
 			       size_t length);
+extern int elog_write_range_to_flash(struct platform_intf *intf,
+				     uint8_t *data, size_t length,
+				     off_t offset, size_t size);
 
 /*
  * Generic event log payloads modified by Google
@@ -438,4 +457,7 @@ struct elog_event_mem_cache_update {
 /* Unspecified/unknown error in user-mode */
 #define VBNV_RECOVERY_US_UNSPECIFIED  0xFF
 
+/* unittest stuff */
+extern int elog_unittest(void);
+
 #endif /* MOSYS_LIB_ELOG_H_ */
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * elog_cursor.h: persistent position in the event log
+ */
+
+#ifndef MOSYS_LIB_ELOG_CURSOR_H__
+#define MOSYS_LIB_ELOG_CURSOR_H__
+
+#include <inttypes.h>
+#include <sys/types.h>
+
+struct platform_intf;
+struct smbios_eventlog_iterator;
+struct smbios_log_entry;
+
+/*
+ * Position of the first entry which has not been read yet. The last entry
+ * read is remembered so that the position can be checked against the log
+ * before it is used.
+ */
+struct elog_cursor {
+	uint32_t offset;	/* offset of first unread entry */
+	uint32_t last_offset;	/* offset of last entry read */
+	uint32_t last_length;	/* length of last entry read, 0 if none */
+	uint32_t last_sum;	/* checksum of last entry read */
+	char last_time[13];	/* timestamp of last entry read, BCD digits */
+	int next_entry;		/* number of first unread entry */
+};
+
+/*
+ * elog_cursor_load  -  read cursor saved by an earlier invocation
+ *
+ * @cursor:	cursor to fill in
+ *
+ * returns 0 to indicate success
+ * returns <0 if there is no saved cursor, @cursor is reset in that case
+ */
+extern int elog_cursor_load(struct elog_cursor *cursor);
+
+/*
+ * elog_cursor_save  -  save cursor for the next invocation
+ *
+ * @cursor:	cursor to save
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int elog_cursor_save(const struct elog_cursor *cursor);
+
+/*
+ * elog_cursor_resume  -  find where to continue reading the log
+ *
+ * @cursor:	cursor loaded from disk
+ * @elog_iter:	iterator over the current log
+ *
+ * If the last entry read is no longer where the cursor expects it, the
+ * log was shrunk or cleared. After a shrink, the LOGCLEAR event records
+ * how many bytes were dropped from the start of the log, so reading
+ * continues where the remaining entries were moved to. If the last entry
+ * read was dropped as well, the whole log is read again and entries are
+ * numbered from 0.
+ *
+ * @elog_iter is positioned to return the first unread entry next.
+ *
+ * returns 1 if reading continues where the cursor left off
+ * returns 0 if the whole log has to be read
+ */
+extern int elog_cursor_resume(struct elog_cursor *cursor,
+                              struct smbios_eventlog_iterator *elog_iter);
+
+/*
+ * elog_cursor_advance  -  record last entry read
+ *
+ * @cursor:	cursor to update
+ * @offset:	offset of entry in log area
+ * @entry:	entry which was read
+ * @next_entry:	number of the entry following it
+ */
+extern void elog_cursor_advance(struct elog_cursor *cursor, off_t offset,
+                                struct smbios_log_entry *entry,
+                                int next_entry);
+
+/* unittest stuff */
+extern int elog_cursor_unittest(struct platform_intf *intf);
+
+#endif /* MOSYS_LIB_ELOG_CURSOR_H__ */
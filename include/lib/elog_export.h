@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * elog_export.h: event log container for offline decoding
+ */
+
+#ifndef MOSYS_LIB_ELOG_EXPORT_H__
+#define MOSYS_LIB_ELOG_EXPORT_H__
+
+#include <inttypes.h>
+#include <sys/types.h>
+
+struct platform_intf;
+
+#define ELOG_EXPORT_MAGIC		0x58474f4c /* 'LOGX' */
+#define ELOG_EXPORT_VERSION		1
+#define ELOG_EXPORT_PLATFORM_LEN	32
+#define ELOG_EXPORT_ALIGN		64
+
+/*
+ * An exported event log is this header followed by the raw log area at
+ * log_offset, which is aligned to ELOG_EXPORT_ALIGN so the file may be
+ * mapped and the log used in place. Fields are little-endian, like the
+ * event log itself. Readers accept headers larger than they know about.
+ */
+struct elog_export_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t header_size;	/* size of this header */
+	uint32_t log_offset;	/* offset of log area in file */
+	uint32_t log_length;	/* length of log area */
+	uint32_t header_offset;	/* offset of eventlog header in log area */
+	uint32_t data_offset;	/* offset of first event in log area */
+	char platform[ELOG_EXPORT_PLATFORM_LEN];	/* NUL-terminated */
+} __attribute__ ((packed));
+
+/* event log read back from an exported file */
+struct elog_export_log {
+	char platform[ELOG_EXPORT_PLATFORM_LEN];
+	uint8_t *data;		/* log area, in place in map */
+	size_t length;
+	off_t header_offset;
+	off_t data_offset;
+	void *map;		/* read-only mapping of the file */
+	size_t map_length;
+};
+
+/*
+ * elog_export  -  save the event log of this platform to a file
+ *
+ * @intf:	platform interface
+ * @path:	file to write, replaced atomically if it exists
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int elog_export(struct platform_intf *intf, const char *path);
+
+/*
+ * elog_import  -  read an event log saved by elog_export()
+ *
+ * @path:	file to read
+ * @log:	log to fill in, release with elog_import_free()
+ *
+ * The file is mapped and the log used in place, it must not be written.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int elog_import(const char *path, struct elog_export_log *log);
+
+/*
+ * elog_import_free  -  release an event log read by elog_import()
+ *
+ * @log:	log to release
+ */
+extern void elog_import_free(struct elog_export_log *log);
+
+#endif /* MOSYS_LIB_ELOG_EXPORT_H__ */
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * elog_query.h: filter and aggregate event log entries
+ */
+
+#ifndef MOSYS_LIB_ELOG_QUERY_H__
+#define MOSYS_LIB_ELOG_QUERY_H__
+
+#include <inttypes.h>
+#include <sys/types.h>
+#include <time.h>
+
+struct platform_intf;
+
+#define ELOG_QUERY_NUM_TYPES	256
+#define ELOG_QUERY_NO_TIME	((time_t)-1)
+
+/* the time index samples one in this many entries */
+#define ELOG_TIME_INDEX_STRIDE	16
+
+/*
+ * Columnar copy of the event log. Row i is entry number entry[i] of the log,
+ * has type type[i], was logged at time[i] (ELOG_QUERY_NO_TIME if the
+ * timestamp is invalid) and is found at offset[i] in log.
+ *
+ * Entries are numbered as eventlog list numbers them. An entry which list
+ * shows as several entries takes all of their numbers and is numbered by
+ * the first of them.
+ */
+struct elog_columns {
+	int count;
+	uint8_t *type;
+	time_t *time;
+	off_t *offset;
+	int *entry;
+	uint8_t *log;		/* raw log area */
+	size_t length;		/* length of raw log area */
+	int log_owned;		/* log is freed with the columns */
+};
+
+enum elog_query_aggregate {
+	ELOG_QUERY_COUNT,	/* count per type */
+	ELOG_QUERY_HOURLY,	/* count per type per hour */
+	ELOG_QUERY_FIRST_LAST,	/* first and last occurrence per type */
+};
+
+struct elog_query {
+	int type_filter;			/* only match types[] */
+	uint8_t types[ELOG_QUERY_NUM_TYPES];	/* non-zero to match type */
+	time_t since;		/* earliest time, ELOG_QUERY_NO_TIME if any */
+	time_t until;		/* latest time, ELOG_QUERY_NO_TIME if any */
+	int first_entry;	/* first entry number to match */
+	int last_entry;		/* last entry number to match, <0 if any */
+	enum elog_query_aggregate aggregate;
+};
+
+/*
+ * Sparse index of the event log, sample i is entry number entry[i] logged at
+ * time[i] and found at offset[i]. Since events are appended in order, the
+ * samples allow a time window to be located by binary search.
+ */
+struct elog_time_index {
+	int count;
+	time_t *time;
+	off_t *offset;
+	int *entry;
+	int ordered;		/* samples are in non-decreasing time order */
+};
+
+/* one result row, first and last are row numbers in elog_columns */
+struct elog_query_row {
+	uint8_t type;
+	time_t hour;		/* start of hour for ELOG_QUERY_HOURLY */
+	int count;
+	int first;
+	int last;
+};
+
+/*
+ * elog_columns_decode  -  build a columnar copy of the event log
+ *
+ * @intf:	platform interface
+ * @cols:	columns to fill in
+ * @query:	query the columns are decoded for, may be NULL
+ *
+ * The log is fetched, its header verified and its entries walked once.
+ * Entries of OEM types which fail verification are left out and, as in
+ * eventlog list, take no entry number.
+ *
+ * If the query restricts time or entry numbers, a time index is built and
+ * only the part of the log between the samples bounding the query's
+ * matches is decoded. Entries outside of it are left out.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int elog_columns_decode(struct platform_intf *intf,
+                               struct elog_columns *cols,
+                               const struct elog_query *query);
+
+/*
+ * elog_columns_decode_log  -  build a columnar copy of the given event log
+ *
+ * @intf:	platform interface, for its eventlog decoders
+ * @cols:	columns to fill in
+ * @query:	query the columns are decoded for, may be NULL
+ * @log:	log area, e.g. read back from a file
+ * @length:	length of log area
+ * @header_offset:	offset into log area of the header
+ * @data_offset:	offset into log area of the first event
+ *
+ * Like elog_columns_decode(), but the log is not fetched from the
+ * platform. It is used in place and must outlive the columns.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int elog_columns_decode_log(struct platform_intf *intf,
+                                   struct elog_columns *cols,
+                                   const struct elog_query *query,
+                                   uint8_t *log, size_t length,
+                                   off_t header_offset, off_t data_offset);
+
+/*
+ * elog_columns_free  -  release a columnar copy of the event log
+ *
+ * @cols:	columns to release
+ */
+extern void elog_columns_free(struct elog_columns *cols);
+
+/*
+ * elog_query_init  -  set up a query which matches all entries
+ *
+ * @query:	query to initialize
+ */
+extern void elog_query_init(struct elog_query *query);
+
+/*
+ * elog_query_run  -  filter and aggregate entries
+ *
+ * @cols:	decoded event log
+ * @query:	filters and aggregate to compute
+ * @rows:	pointer to store the allocated result rows in
+ *
+ * Rows are ordered by hour, for ELOG_QUERY_HOURLY, and then by type.
+ *
+ * returns the number of rows
+ */
+extern int elog_query_run(const struct elog_columns *cols,
+                          const struct elog_query *query,
+                          struct elog_query_row **rows);
+
+/* unittest stuff */
+extern int elog_query_unittest(void);
+
+#endif /* MOSYS_LIB_ELOG_QUERY_H__ */
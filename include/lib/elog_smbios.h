@@ -74,6 +74,10 @@ extern void smbios_free_eventlog_iterator(
     struct smbios_eventlog_iterator *elog_iter);
 extern int smbios_eventlog_iterator_reset(
     struct smbios_eventlog_iterator *elog_iter);
+extern int smbios_eventlog_iterator_seek(
+    struct smbios_eventlog_iterator *elog_iter, off_t offset);
+extern off_t smbios_eventlog_get_offset(
+    struct smbios_eventlog_iterator *elog_iter);
 extern struct smbios_log_entry *smbios_eventlog_get_next_entry(
     struct smbios_eventlog_iterator *elog_iter);
 extern struct smbios_log_entry *smbios_eventlog_get_current_entry(
@@ -113,4 +117,30 @@ extern int smbios_eventlog_foreach_event(struct platform_intf *intf,
 					 smbios_eventlog_callback callback,
 					 void *arg);
 
+/*
+ * smbios_eventlog_foreach_event_in - call callback for each event in the
+ *                                    given SMBIOS eventlog area.
+ *
+ * @intf - platform interface
+ * @data - log area, e.g. read back from a file rather than fetched
+ * @length - length of log area
+ * @header_offset - offset into log area of the header
+ * @data_offset - offset into log area of the first event
+ * @verify - optional function to call to verify the eventlog metadata
+ * @callback - function to call for each log entry
+ * @arg - optional argument to pass to callback
+ *
+ * returns the aggregation (OR) of return codes for each call to callback.
+ */
+extern int smbios_eventlog_foreach_event_in(struct platform_intf *intf,
+					    uint8_t *data, size_t length,
+					    off_t header_offset,
+					    off_t data_offset,
+					    smbios_eventlog_verify_header verify,
+					    smbios_eventlog_callback callback,
+					    void *arg);
+
+/* unittest stuff */
+extern int elog_smbios_unittest(void);
+
 #endif /* MOSYS_LIB_SMBIOS_H__ */
@@ -34,6 +34,11 @@
 #ifndef MOSYS_LIB_FILE_H__
 #define MOSYS_LIB_FILE_H__
 
+#include <limits.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
+
 enum file_mode {
 	FILE_READ,
 	FILE_WRITE,
@@ -49,4 +54,64 @@ extern void scanft_list_cleanup(struct ll_node **phead);
 
 extern int sysfs_lowest_smbus(const char *path, const char *name);
 
+/*
+ * get_boot_id  -  Obtain the random ID the kernel assigned to this boot
+ *
+ * The ID is read once and kept for the rest of the invocation.
+ *
+ * returns pointer to a static string to indicate success
+ * returns NULL to indicate failure
+ */
+extern const char *get_boot_id(void);
+
+/*
+ * data_file_path  -  Build the path of a file under MOSYS_DATA_ROOT
+ *
+ * @path:	buffer to store the path in
+ * @len:	size of buffer
+ * @name:	name of the file relative to MOSYS_DATA_ROOT
+ *
+ * Directories leading up to the file are created as needed.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int data_file_path(char *path, size_t len, const char *name);
+
+/* a file being replaced atomically, see file_replace_begin() */
+struct file_replace {
+	const char *path;		/* file to replace */
+	char tmp[PATH_MAX + 8];		/* temporary file next to it */
+	FILE *fp;
+};
+
+/*
+ * file_replace_begin  -  Start writing a new version of a file
+ *
+ * @rep:	state for the replacement, used until file_replace_commit()
+ * @path:	file to replace, must stay valid until file_replace_commit()
+ * @mode:	permissions of the new file
+ *
+ * Data goes to a temporary file in the same directory first, so readers
+ * see either the old or the new contents but never partial data.
+ *
+ * returns a stream to write the new contents to
+ * returns NULL to indicate failure
+ */
+extern FILE *file_replace_begin(struct file_replace *rep, const char *path,
+                                mode_t mode);
+
+/*
+ * file_replace_commit  -  Replace a file with the data written to its stream
+ *
+ * @rep:	state from file_replace_begin()
+ *
+ * The stream is closed in any case. If writing it failed, the file is left
+ * as it was.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int file_replace_commit(struct file_replace *rep);
+
 #endif	/* MOSYS_LIB_FILE_H__ */
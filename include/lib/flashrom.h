@@ -40,30 +40,110 @@ enum programmer_target {
 	EC_FIRMWARE,
 };
 
+/* a named region to be read using flashrom_read_regions() */
+struct flashrom_region {
+	const char *name;	/* FMAP area name */
+	uint8_t *buf;		/* allocated and filled when read */
+	int len;		/* bytes read, <0 if the region was not read */
+};
+
+/*
+ * struct flashrom_backend - Method used to carry out flashrom operations
+ *
+ * @name:		name of the backend, for debug output
+ * @setup:		prepare the backend to access the target (optional).
+ *			returns <0 if the backend cannot service the target,
+ *			in which case the next backend in line is tried.
+ * @read:		see flashrom_read()
+ * @read_range:		see flashrom_read_range()
+ * @read_by_name:	see flashrom_read_by_name()
+ * @read_regions:	see flashrom_read_regions()
+ * @write_by_name:	see flashrom_write_by_name()
+ * @write_range:	write len bytes at an arbitrary offset of the ROM
+ * @get_size:		return size of the target ROM in bytes, <0 on failure
+ *
+ * The flashrom_* functions below dispatch to the first backend whose setup
+ * succeeds for a given target. The choice is remembered for the rest of the
+ * invocation.
+ */
+struct flashrom_backend {
+	const char *name;
+	int (*setup)(enum programmer_target target);
+	int (*read)(uint8_t *buf, size_t size,
+	            enum programmer_target target, const char *region);
+	int (*read_range)(uint8_t *buf, unsigned int offset, unsigned int len,
+	            enum programmer_target target);
+	int (*read_by_name)(uint8_t **buf,
+	            enum programmer_target target, const char *region);
+	int (*read_regions)(struct flashrom_region *regions, int num,
+	            enum programmer_target target);
+	int (*write_by_name)(size_t size, uint8_t *buf,
+	            enum programmer_target target, const char *region);
+	int (*write_range)(uint8_t *buf, unsigned int offset, unsigned int len,
+	            enum programmer_target target);
+	int (*get_size)(enum programmer_target target);
+};
+
+/* runs the flashrom utility in a child process */
+extern struct flashrom_backend flashrom_exec_backend;
+#if defined(CONFIG_USE_LIBFLASHROM)
+/* accesses the flash chip in-process using libflashrom */
+extern struct flashrom_backend libflashrom_backend;
+
 /*
- * flashrom_read - Read ROM using Flashrom utility
+ * libflashrom_set_programmer - Use another programmer for a target
+ *
+ * @target:	target ROM
+ * @name:	programmer name, e.g. "dummy"
+ * @params:	programmer parameters, may be NULL
+ *
+ * This is meant for tests and benchmarks, which point a target at an
+ * emulated chip. Strings are not copied.
+ */
+extern void libflashrom_set_programmer(enum programmer_target target,
+				       const char *name, const char *params);
+#endif
+
+/*
+ * flashrom_read - Read ROM using Flashrom
  *
  * @buf:	output buffer
  * @size:	(expected) size of ROM
  * @target:	target ROM
  * @region:	region to include with -i (NULL to read entire ROM)
  *
- * This function reads the target ROM by calling Flashrom with appropriate
- * parameters. It will save the ROM to a temporary file and then copy the
- * file into the provided buffer.
+ * This function reads the target ROM using the selected flashrom backend and
+ * copies the image into the provided buffer.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
  */
 extern int flashrom_read(uint8_t *buf, size_t size,
                          enum programmer_target target, const char *region);
 
 /*
- * flashrom_read_by_name - Partial read using Flashrom utility
+ * flashrom_read_range - Read an arbitrary range of ROM using Flashrom
+ *
+ * @buf:	output buffer of at least len bytes
+ * @offset:	offset in ROM to start reading at
+ * @len:	number of bytes to read
+ * @target:	target ROM
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int flashrom_read_range(uint8_t *buf, unsigned int offset,
+                         unsigned int len, enum programmer_target target);
+
+/*
+ * flashrom_read_by_name - Partial read using Flashrom
  *
  * @buf:	double-pointer of buffer to allocate and fill
  * @target:	target ROM
  * @region:	region to include with -i
  *
- * This function reads the target ROM by calling Flashrom with appropriate
- * parameters. It will allocate the appropriate number of bytes in buf.
+ * This function reads a region of the target ROM using the selected flashrom
+ * backend. It will allocate the appropriate number of bytes in buf.
  *
  * returns number of bytes read from region to indicate success
  * returns <0 to indicate failure
@@ -72,22 +152,59 @@ extern int flashrom_read_by_name(uint8_t **buf,
                          enum programmer_target target, const char *region);
 
 /*
- * flashrom_write_by_name - Partial write using Flashrom utility
+ * flashrom_read_regions - Read several regions in a single pass
+ *
+ * @regions:	array of regions to read
+ * @num:	number of regions
+ * @target:	target ROM
+ *
+ * Regions which are not cached already are read in one flashrom pass, so
+ * the chip only needs to be set up and accessed once. The buffer of each
+ * region that was read is allocated and must be freed by the caller.
+ *
+ * returns 0 if all regions were read
+ * returns <0 if any region could not be read
+ */
+extern int flashrom_read_regions(struct flashrom_region *regions, int num,
+                         enum programmer_target target);
+
+/*
+ * flashrom_write_by_name - Partial write using Flashrom
  *
  * @size:	size of the data to write
  * @buf:	pointer to the buffer to write
  * @target:	target ROM
  * @region:	region to include with -i
  *
- * This function reads the target ROM by calling Flashrom with appropriate
- * parameters. It will allocate the appropriate number of bytes in buf.
+ * This function writes a region of the target ROM using the selected flashrom
+ * backend.
  *
- * returns number of bytes read from region to indicate success
+ * returns number of bytes written to region to indicate success
  * returns <0 to indicate failure
  */
 extern int flashrom_write_by_name(size_t size, uint8_t *buf,
                          enum programmer_target target, const char *region);
 
+/*
+ * flashrom_write_range_by_name - Write part of a region using Flashrom
+ *
+ * @size:	size of the data to write
+ * @buf:	pointer to the buffer to write
+ * @offset:	offset of the data within the region
+ * @target:	target ROM
+ * @region:	region to write to
+ *
+ * Only the given range is handed to flashrom, so only the erase blocks it
+ * overlaps are erased and programmed. The region is located using the FMAP
+ * area of the ROM.
+ *
+ * returns number of bytes written to indicate success
+ * returns <0 to indicate failure
+ */
+extern int flashrom_write_range_by_name(size_t size, uint8_t *buf,
+                         unsigned int offset, enum programmer_target target,
+                         const char *region);
+
 /*
  * flashrom_read_host_firmware_region - Read firmware region within ROM
  *
@@ -103,7 +220,7 @@ extern int flashrom_read_host_firmware_region(struct platform_intf *intf,
 							uint8_t **buf);
 
 /*
- * flashrom_get_rom_size - Obtain the ROM size by calling flashrom
+ * flashrom_get_rom_size - Obtain the ROM size using flashrom
  *
  * @intf:	the platform interface
  * @target:	target programmer (host, ec, etc)
@@ -114,4 +231,65 @@ extern int flashrom_read_host_firmware_region(struct platform_intf *intf,
 extern int flashrom_get_rom_size(struct platform_intf *intf,
 			enum programmer_target target);
 
+/*
+ * flashrom_cache_lookup - Copy an image or region from the firmware cache
+ *
+ * @target:	target ROM
+ * @region:	region name (NULL for the entire ROM)
+ * @buf:	double-pointer of buffer to allocate and fill
+ *
+ * The flashrom_* functions consult the cache before going to the chip, so
+ * callers normally need not use this directly.
+ *
+ * returns size of the copy to indicate success
+ * returns <0 if the data is not cached
+ */
+extern int flashrom_cache_lookup(enum programmer_target target,
+				const char *region, uint8_t **buf);
+
+/*
+ * flashrom_cache_read - Copy part of an image or region from the cache
+ *
+ * @target:	target ROM
+ * @region:	region name (NULL for the entire ROM)
+ * @buf:	buffer to fill
+ * @offset:	offset into the image or region
+ * @len:	number of bytes to copy
+ *
+ * returns 0 to indicate success
+ * returns <0 if the data is not cached
+ */
+extern int flashrom_cache_read(enum programmer_target target,
+				const char *region, uint8_t *buf,
+				size_t offset, size_t len);
+
+/*
+ * flashrom_cache_store - Store a copy of an image or region in the cache
+ *
+ * @target:	target ROM
+ * @region:	region name (NULL for the entire ROM)
+ * @buf:	data to store
+ * @size:	size of data
+ */
+extern void flashrom_cache_store(enum programmer_target target,
+				const char *region, const uint8_t *buf,
+				size_t size);
+
+/*
+ * flashrom_cache_invalidate - Drop everything cached for a target ROM
+ *
+ * @target:	target ROM
+ */
+extern void flashrom_cache_invalidate(enum programmer_target target);
+
+/*
+ * flashrom_cache_expire - Drop cached data which may have changed since
+ *
+ * Whole images and RW regions such as the event log and NVRAM are written
+ * by firmware and other programs, so a long-running process like mosysd
+ * calls this before each request. RO regions are kept unless another
+ * mosys process has written flash since.
+ */
+extern void flashrom_cache_expire(void);
+
 #endif /* MOSYS_LIB_FLASHROM_H__ */
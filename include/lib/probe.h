@@ -40,6 +40,37 @@ struct cros_compat_tuple {
 	char *revision;
 };
 
+/* Identifying data of the running platform, gathered once */
+struct platform_identity {
+	const char *smbios_name;	/* SMBIOS system product name */
+	const char *frid;		/* firmware revision ID, up to the dot */
+	const char *fdt_compatible;	/* null-separated compatible list */
+	int fdt_compatible_len;
+	const char *cpu_model;		/* model name from /proc/cpuinfo */
+};
+
+/*
+ * probe_identity - gather identifying data of the running platform
+ *
+ * @intf:	platform interface used to read SMBIOS tables, NULL to skip them
+ *
+ * Each source is read only once per process. The probe_* helpers below
+ * use the same data, so platform probes do not read it again. Fields
+ * which are not available are NULL.
+ *
+ * returns pointer to identity, valid until exit
+ */
+extern const struct platform_identity *probe_identity(
+					struct platform_intf *intf);
+
+/*
+ * probe_method - name of the probe helper which last found a match
+ *
+ * returns "frid", "smbios", "fdt", "cpuinfo" or "cmdline"
+ * returns NULL if no helper has matched
+ */
+extern const char *probe_method(void);
+
 /*
  * probe_frid - attempt to match platform to chromeos firmware revision id
  *
@@ -33,12 +33,14 @@
 #define MOSYS_LIB_SMBIOS_H__
 
 #include <inttypes.h>
+#include <stddef.h>
 
 #include "mosys/platform.h"
 
 #include "lib/smbios_tables.h"
 
 struct kv_pair;
+struct smbios_index_entry;
 
 /* SMBIOS Table Types */
 enum smbios_types {
@@ -86,6 +88,18 @@ enum smbios_types {
 	SMBIOS_TYPE_END = 127,
 };
 
+/* Read-only view of a table within the structure table */
+struct smbios_table_view {
+	const struct smbios_header *header;
+	const uint8_t *data;		/* formatted area following header */
+	size_t length;			/* length of formatted area */
+	struct smbios_index_entry *entry;
+};
+
+/* Offset of a field in the formatted area of a table, for view accessors */
+#define SMBIOS_FIELD(table, field) \
+	offsetof(struct smbios_table_##table, field)
+
 /* SMBIOS platform information callbacks */
 extern struct smbios_cb smbios_sysinfo_cb;
 
@@ -99,6 +113,26 @@ extern int smbios_find_table(struct platform_intf *intf,
                              enum smbios_types type,
                              int instance, struct smbios_table *table,
                              unsigned int baseaddr, unsigned int len);
+extern int smbios_find_table_view(struct platform_intf *intf,
+                                  enum smbios_types type, int instance,
+                                  struct smbios_table_view *view,
+                                  unsigned int baseaddr, unsigned int len);
+extern int smbios_view_get_u8(const struct smbios_table_view *view,
+                              size_t offset, uint8_t *val);
+extern int smbios_view_get_u16(const struct smbios_table_view *view,
+                               size_t offset, uint16_t *val);
+extern int smbios_view_get_u32(const struct smbios_table_view *view,
+                               size_t offset, uint32_t *val);
+extern const char *smbios_view_string(const struct smbios_table_view *view,
+                                      int number);
+extern const char *smbios_view_string_field(
+				const struct smbios_table_view *view,
+				size_t offset);
+extern char *smbios_view_strdup(const struct smbios_table_view *view,
+                                size_t offset);
+extern int smbios_count_tables(struct platform_intf *intf,
+                               enum smbios_types type,
+                               unsigned int baseaddr, unsigned int len);
 extern char *smbios_find_string(struct platform_intf *intf,
                                 enum smbios_types type, int number,
                              unsigned int baseaddr, unsigned int len);
@@ -115,4 +149,7 @@ extern char *smbios_sysinfo_get_family(struct platform_intf *intf);
 extern char *smbios_sysinfo_get_sku(struct platform_intf *intf);
 extern int smbios_sysinfo_get_sku_number(struct platform_intf *intf);
 
+/* unittest stuff */
+extern int smbios_unittest(struct platform_intf *intf);
+
 #endif /* MOSYS_LIB_SMBIOS_H__ */
@@ -37,6 +37,7 @@
 #define SMBIOS_LEGACY_ENTRY_BASE	0xf0000
 #define SMBIOS_LEGACY_ENTRY_LEN		0x10000
 #define SMBIOS_ENTRY_MAGIC		"_SM_"
+#define SMBIOS3_ENTRY_MAGIC		"_SM3_"
 
 /* Entry */
 struct smbios_entry {
@@ -56,6 +57,20 @@ struct smbios_entry {
 	uint8_t bcd_revision;
 } __attribute__ ((packed));
 
+/* SMBIOS 3.0 64-bit entry */
+struct smbios3_entry {
+	uint8_t anchor_string[5];
+	uint8_t entry_cksum;
+	uint8_t entry_length;
+	uint8_t major_ver;
+	uint8_t minor_ver;
+	uint8_t docrev;
+	uint8_t entry_rev;
+	uint8_t reserved;
+	uint32_t max_size;
+	uint64_t table_address;
+} __attribute__ ((packed));
+
 /* Header */
 struct smbios_header {
 	uint8_t type;
@@ -58,6 +58,9 @@ extern int vpd_find_table(struct platform_intf *intf,
                           enum vpd_types type,
                           int instance, struct vpd_table *table,
                           unsigned int baseaddr, unsigned int len);
+extern int vpd_count_tables(struct platform_intf *intf,
+                            enum vpd_types type,
+                            unsigned int baseaddr, unsigned int len);
 extern char *vpd_find_string(struct platform_intf *intf,
                              enum vpd_types type, int number,
                              unsigned int baseaddr, unsigned int len);
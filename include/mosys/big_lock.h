@@ -32,7 +32,42 @@
 #ifndef MOSYS_BIG_LOCK_H__
 #define MOSYS_BIG_LOCK_H__
 
+#include "mosys/ipc_lock.h"
+
 extern int mosys_acquire_big_lock(int timeout_secs);
+
+/*
+ * mosys_big_lock_enter  -  share the global lock held by this process
+ *
+ * Threads which run commands at the same time enter the lock for as long
+ * as they rely on it. Converting the lock, or releasing it for a child
+ * process, waits until no other thread is inside, and threads wait to
+ * enter while that is in progress.
+ *
+ * A thread which entered must not wait for another which entered while
+ * converting or releasing the lock, e.g. by holding a mutex it needs.
+ */
+extern void mosys_big_lock_enter(void);
+
+/*
+ * mosys_big_lock_leave  -  stop sharing the global lock
+ */
+extern void mosys_big_lock_leave(void);
+
+/*
+ * mosys_acquire_big_lock_mode  -  acquire global lock in given mode
+ *
+ * Commands which declare the resources they use only need the lock
+ * shared. Other commands keep it exclusive, as does other firmware
+ * tooling using the same lock file.
+ *
+ * returns 0 to indicate lock acquired or converted
+ * returns >0 to indicate lock was already held in this mode
+ * returns <0 to indicate failed to acquire lock
+ */
+extern int mosys_acquire_big_lock_mode(enum ipc_lock_mode mode,
+                                       int timeout_secs);
+extern int mosys_big_lock_is_held(void);
 /*
  * mosys_release_big_lock  -  release global lock
  *
@@ -40,6 +75,26 @@ extern int mosys_acquire_big_lock(int timeout_secs);
  * returns -1 if lock had not been held before the call
  */
 extern int mosys_release_big_lock(void);
+
+/*
+ * mosys_big_lock_suspend  -  release global lock for a child process
+ *
+ * Other threads stay out of the lock until mosys_big_lock_resume().
+ *
+ * returns 0 if lock was released, mosys_big_lock_resume() must follow
+ * returns -1 if lock had not been held before the call
+ */
+extern int mosys_big_lock_suspend(void);
+
+/*
+ * mosys_big_lock_resume  -  take back lock released by mosys_big_lock_suspend
+ *
+ * @timeout_secs:	seconds to wait for lock
+ *
+ * returns 0 to indicate lock acquired
+ * returns <0 to indicate failed to acquire lock
+ */
+extern int mosys_big_lock_resume(int timeout_secs);
 extern void mosys_big_lock_prepare_test(void);
 
 #endif /* MOSYS_BIG_LOCK_H__ */
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * daemon.h: mosysd protocol
+ */
+
+#ifndef MOSYS_DAEMON_H__
+#define MOSYS_DAEMON_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mosys/kv_pair.h"
+
+/* Default location of the mosysd socket */
+#define MOSYSD_SOCKET		"/run/mosysd.sock"
+
+#define MOSYSD_REQUEST_MAGIC	0x4d535251	/* "MSRQ" */
+#define MOSYSD_RESPONSE_MAGIC	0x4d535253	/* "MSRS" */
+
+/* Largest request or response accepted */
+#define MOSYSD_MAX_LEN		(1 << 24)
+
+/*
+ * A request is followed by len bytes: the single key (empty if not set)
+ * and then argc arguments, each terminated with a nul byte.
+ */
+struct mosysd_request {
+	uint32_t magic;
+	uint32_t style;			/* enum kv_pair_style */
+	uint32_t argc;
+	uint32_t len;
+} __attribute__ ((packed));
+
+/*
+ * A response is followed by len bytes of command output. The status is
+ * what mosys would have exited with when running the command itself.
+ */
+struct mosysd_response {
+	uint32_t magic;
+	int32_t status;
+	uint32_t len;
+} __attribute__ ((packed));
+
+/*
+ * mosysd_read_full  -  read exactly len bytes from fd
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure or end of file
+ */
+extern int mosysd_read_full(int fd, void *buf, size_t len);
+
+/*
+ * mosysd_write_full  -  write exactly len bytes to fd
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int mosysd_write_full(int fd, const void *buf, size_t len);
+
+/*
+ * mosysd_set_timeout  -  limit how long reads and writes on fd may block
+ *
+ * @fd:		connected socket
+ * @timeout_secs:	seconds after which a read or write fails
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int mosysd_set_timeout(int fd, int timeout_secs);
+
+/*
+ * mosysd_send_request  -  send a command to mosysd
+ *
+ * @fd:		connected socket
+ * @style:	output style
+ * @single_key:	key to print for KV_STYLE_SINGLE, may be NULL
+ * @argc:	number of arguments
+ * @argv:	command and its arguments
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int mosysd_send_request(int fd, enum kv_pair_style style,
+                               const char *single_key, int argc, char **argv);
+
+/*
+ * mosysd_recv_request  -  read a request from a client
+ *
+ * @fd:		connected socket
+ * @req:	OUTPUT request header
+ * @single_key:	OUTPUT single key, NULL if not set
+ * @argv:	OUTPUT allocated array of argc arguments
+ *
+ * The arguments point into *argv's allocation, a single free() of *argv
+ * releases everything.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int mosysd_recv_request(int fd, struct mosysd_request *req,
+                               char **single_key, char ***argv);
+
+/*
+ * mosysd_send_response  -  send command output and status to a client
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int mosysd_send_response(int fd, int status,
+                                const void *data, size_t len);
+
+/*
+ * mosysd_client  -  run a command through mosysd
+ *
+ * @path:	path of mosysd socket
+ * @style:	output style
+ * @single_key:	key to print for KV_STYLE_SINGLE, may be NULL
+ * @argc:	number of arguments
+ * @argv:	command and its arguments
+ *
+ * Output of the command is written to stdout.
+ *
+ * returns exit status of the command
+ * returns <0 if mosysd could not be reached
+ */
+extern int mosysd_client(const char *path, enum kv_pair_style style,
+                         const char *single_key, int argc, char **argv);
+
+/* unittest stuff */
+extern int daemon_unittest(void);
+
+#endif /* MOSYS_DAEMON_H__ */
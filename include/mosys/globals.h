@@ -58,6 +58,12 @@ extern void mosys_set_output_file(FILE *fp);
 extern int mosys_get_verbosity(void);
 extern void mosys_set_verbosity(int verbosity);
 
+/*
+ * manage whether platform detection ignores the per-boot cache
+ */
+extern int mosys_get_force_probe(void);
+extern void mosys_set_force_probe(int force);
+
 /*
  * OS detection
  */
@@ -38,15 +38,32 @@ struct platform_op;
 
 extern struct platform_op platform_common_op;
 
+/* interface operations that are set up on first use */
+enum intf_op_type {
+	INTF_OP_PCI,
+	INTF_OP_I2C,
+	INTF_OP_IO,
+	INTF_OP_MMIO,
+	INTF_OP_MAX,
+};
+
 /*
- * intf_op_setup  -  prepare interface operations
+ * intf_op_ready  -  prepare interface operation if not done already
  *
  * @intf:       platform interface
+ * @type:       interface operation type
+ *
+ * Operations are set up the first time they are used rather than during
+ * platform setup, so commands only pay for the hardware they touch. A
+ * failed setup is not retried until intf_op_destroy().
+ *
+ * returns 0 to indicate operation is ready for use
+ * returns <0 to indicate failure
  */
-extern int intf_op_setup(struct platform_intf *intf);
+extern int intf_op_ready(struct platform_intf *intf, enum intf_op_type type);
 
 /*
- * intf_op_destroy  -  clean up interface operations
+ * intf_op_destroy  -  clean up interface operations that were set up
  *
  * @intf:       platform interface
  */
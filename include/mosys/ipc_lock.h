@@ -35,6 +35,16 @@
 #include <sys/ipc.h>
 #include <unistd.h>
 
+/*
+ * Lock modes. A shared lock may be held by several processes at once,
+ * an exclusive lock only by one. SysV semaphores only support exclusive
+ * locks, so shared requests are taken exclusively there.
+ */
+enum ipc_lock_mode {
+	IPC_LOCK_EXCLUSIVE,
+	IPC_LOCK_SHARED,
+};
+
 /* a mosys lock */
 struct ipc_lock {
 	int is_held;	/* mosys internal */
@@ -46,6 +56,8 @@ struct ipc_lock {
 	/* Used by file lock */
 	char *filename;	/* provided by the developer */
 	int fd;		/* mosys internal */
+
+	enum ipc_lock_mode mode;	/* mosys internal */
 };
 
 /* don't use C99 initializers here, so this can be used in C++ code */
@@ -56,6 +68,7 @@ struct ipc_lock {
 		-1,		/* sem */	\
 		NULL,		/* filename */	\
 		-1,		/* fd */	\
+		IPC_LOCK_EXCLUSIVE, /* mode */	\
 	}
 
 #define LOCKFILE_INIT(lockfile) \
@@ -65,6 +78,7 @@ struct ipc_lock {
 		0,		/* sem */	\
 		lockfile,	/* filename */	\
 		-1,		/* fd */	\
+		IPC_LOCK_EXCLUSIVE, /* mode */	\
 	}
 
 /*
@@ -80,6 +94,21 @@ struct ipc_lock {
  */
 extern int mosys_lock(struct ipc_lock *lock, int timeout_msecs);
 
+/*
+ * mosys_lock_mode: acquire a mosys lock in the given mode
+ *
+ * If the lock is already held in the other mode it is converted. The
+ * conversion is not atomic; if it fails the lock is no longer held.
+ *
+ * timeout as for mosys_lock()
+ *
+ * return 0   = lock acquired or converted
+ * return >0  = lock was already held in this mode
+ * return <0  = failed to acquire lock
+ */
+extern int mosys_lock_mode(struct ipc_lock *lock, enum ipc_lock_mode mode,
+                           int timeout_msecs);
+
 /*
  * mosys_unlock: release a mosys lock
  *
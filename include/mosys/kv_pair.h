@@ -54,6 +54,12 @@ struct kv_pair {
 	struct kv_pair *next;
 };
 
+/* list of key=value pair lists, one per kv_pair_print() call */
+struct kv_record {
+	struct kv_pair *pairs;
+	struct kv_record *next;
+};
+
 extern enum kv_pair_style mosys_get_kv_pair_style(void);
 
 extern void mosys_set_kv_pair_style(enum kv_pair_style style);
@@ -151,4 +157,28 @@ extern int kv_pair_print_to_file(FILE* fp, struct kv_pair *kv_list,
  */
 extern int kv_pair_print(struct kv_pair *kv_list);
 
+/*
+ * kv_pair_capture  -  capture lists passed to kv_pair_print as records
+ *
+ * @records:	list to append records to, NULL to resume printing
+ *
+ * While capturing, kv_pair_print() appends a copy of each list to
+ * *records instead of formatting it.
+ */
+extern void kv_pair_capture(struct kv_record **records);
+
+/*
+ * kv_pair_capturing  -  check whether output is being captured
+ *
+ * returns 1 if kv_pair_capture() is active for this thread, 0 otherwise
+ */
+extern int kv_pair_capturing(void);
+
+/*
+ * kv_record_free  -  free a record list
+ *
+ * @records:	record list
+ */
+extern void kv_record_free(struct kv_record *records);
+
 #endif /* KV_PAIR_H__ */
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * library.h: mosys library interface
+ */
+
+#ifndef MOSYS_LIBRARY_H__
+#define MOSYS_LIBRARY_H__
+
+#include "mosys/kv_pair.h"
+
+/*
+ * The library shares the platform interface with the rest of mosys, so
+ * only one handle can be open at a time. Once open, queries may be made
+ * from several threads at once; output settings and captured records are
+ * kept per thread. Queries share the big lock, and one that has to take it
+ * exclusively or hand it to the flashrom utility waits for the others to
+ * finish, so such commands do not run concurrently with anything else.
+ */
+struct mosys_handle;
+
+/*
+ * mosys_open  -  detect platform and prepare it for queries
+ *
+ * @platform_id:	platform to use, NULL to auto-detect
+ *
+ * returns handle to pass to mosys_query() and mosys_close()
+ * returns NULL to indicate failure
+ */
+extern struct mosys_handle *mosys_open(const char *platform_id);
+
+/*
+ * mosys_query  -  run command and collect its output as records
+ *
+ * @handle:	handle from mosys_open()
+ * @path:	command, e.g. "platform name" or "smbios/info/bios"
+ * @records:	OUTPUT list of key=value records, free with kv_record_free()
+ *
+ * Path components are separated by '/' or whitespace. Each list the
+ * command would have printed becomes one record. Use mosys_query_argv()
+ * for arguments which contain separators.
+ *
+ * returns return value of command handler
+ * returns <0 to indicate failure
+ */
+extern int mosys_query(struct mosys_handle *handle, const char *path,
+                       struct kv_record **records);
+
+/*
+ * mosys_query_argv  -  run command and collect its output as records
+ *
+ * @handle:	handle from mosys_open()
+ * @argc:	number of arguments
+ * @argv:	command and its arguments
+ * @records:	OUTPUT list of key=value records, free with kv_record_free()
+ *
+ * returns return value of command handler
+ * returns <0 to indicate failure
+ */
+extern int mosys_query_argv(struct mosys_handle *handle, int argc,
+                            char **argv, struct kv_record **records);
+
+/*
+ * mosys_close  -  release platform and handle
+ *
+ * @handle:	handle from mosys_open()
+ */
+extern void mosys_close(struct mosys_handle *handle);
+
+/* unittest stuff */
+extern int library_unittest(void);
+
+#endif /* MOSYS_LIBRARY_H__ */
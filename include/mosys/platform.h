@@ -40,6 +40,7 @@
 
 struct kv_pair;
 struct gpio_map;
+struct resource_claim;
 struct nonspd_mem_info;
 
 #if 0
@@ -83,6 +84,8 @@ struct platform_cmd {
 			    struct platform_cmd *cmd,
 			    int argc, char **argv);
 	} arg;
+	/* hardware used by function, NULL if undeclared (see dispatch.c) */
+	const struct resource_claim *resources;
 };
 
 /* platform operations handlers */
@@ -221,6 +224,7 @@ struct memory_cb {
 enum smbios_log_entry_type;
 struct smbios_log_entry;
 struct smbios_table_log;
+struct elog_new_event;
 struct eventlog_cb {
 	int (*print_type)(struct platform_intf *intf,
 	                  struct smbios_log_entry *entry,
@@ -228,6 +232,7 @@ struct eventlog_cb {
 	int (*print_data)(struct platform_intf *intf,
 	                  struct smbios_log_entry *entry,
 	                  struct kv_pair *kv);
+	/* returns number of entries listed, start_id <0 only counts them */
 	int (*print_multi)(struct platform_intf *intf,
 			   struct smbios_log_entry *entry,
 			   int start_id);
@@ -236,10 +241,14 @@ struct eventlog_cb {
 	int (*verify_header)(struct elog_header *elog_header);
 	int (*add)(struct platform_intf *intf, enum smbios_log_entry_type type,
 		   size_t data_size, uint8_t *data);
+	int (*add_many)(struct platform_intf *intf,
+			struct elog_new_event *events, int num);
 	int (*clear)(struct platform_intf *intf);
 	int (*fetch)(struct platform_intf *intf, uint8_t **data,
 		     size_t *length, off_t *header_offset, off_t *data_offset);
 	int (*write)(struct platform_intf *intf, uint8_t *data, size_t length);
+	int (*write_range)(struct platform_intf *intf, uint8_t *data,
+			   size_t length, off_t offset, size_t size);
 };
 
 /* boot number callbacks */
@@ -512,6 +521,13 @@ struct platform_intf {
 	enum platform_type type;	/* numeric platform type */
 	const char *name;		/* canonical platform name */
 	const char **id_list;		/* list of supported ids */
+	/*
+	 * Further ids the probe matches on, e.g. variant names, used only
+	 * for auto-detection. A probe must not succeed on a system none of
+	 * whose identifying data starts with an id in id_list or probe_ids,
+	 * unless both are empty.
+	 */
+	const char **probe_ids;
 	const struct sku_info *sku_info;	/* SKU information */
 	struct platform_cmd **sub;	/* list of commands */
 	struct platform_op *op;		/* operations */
@@ -531,6 +547,63 @@ struct platform_intf {
 /* The global list of all platforms. */
 extern struct platform_intf *platform_intf_list[];
 
+/*
+ * platform_dispatch  -  run command given as arguments
+ *
+ * @intf:	platform interface
+ * @argc:	number of arguments
+ * @argv:	command and its arguments
+ * @usage:	prints program usage before command list, may be NULL
+ *
+ * returns return value of command handler
+ * returns <0 with errno set to ENOSYS if command is not found
+ */
+extern int platform_dispatch(struct platform_intf *intf, int argc,
+                             char **argv, void (*usage)(void));
+
+/*
+ * platform_cmd_find  -  find the command handler arguments lead to
+ *
+ * @intf:	platform interface
+ * @argc:	number of arguments
+ * @argv:	command and its arguments
+ *
+ * returns pointer to getter or setter
+ * returns NULL if arguments do not lead to one
+ */
+extern struct platform_cmd *platform_cmd_find(struct platform_intf *intf,
+                                              int argc, char **argv);
+
+/*
+ * platform_cache_lookup  -  find platform detected earlier during this boot
+ *
+ * Returns nothing if re-probing was requested.
+ *
+ * returns index of platform in platform_intf_list
+ * returns <0 if not cached
+ */
+extern int platform_cache_lookup(void);
+
+/*
+ * platform_cache_verify  -  check cached detection result
+ *
+ * @intf:	platform interface, after probing
+ *
+ * returns 0 if name and SKU in the cache match the interface
+ * returns <0 otherwise
+ */
+extern int platform_cache_verify(struct platform_intf *intf);
+
+/*
+ * platform_cache_store  -  save detection result for this boot
+ *
+ * @index:	index of platform in platform_intf_list
+ * @list_name:	name of platform before probing
+ * @intf:	platform interface, after probing
+ */
+extern void platform_cache_store(int index, const char *list_name,
+                                 struct platform_intf *intf);
+
 /*
  * mosys_platform_setup  -  determine current platform and return handler
  *
@@ -565,4 +638,8 @@ extern void print_tree(struct platform_intf *intf);
 
 extern int print_platforms(void);
 
+/* unittest stuff */
+extern void mosys_platform_prepare_test(void);
+extern int platform_unittest(void);
+
 #endif /* MOSYS_PLATFORM_H__ */
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * resource_lock.h: locks for individual hardware resources
+ */
+
+#ifndef MOSYS_RESOURCE_LOCK_H__
+#define MOSYS_RESOURCE_LOCK_H__
+
+#include "mosys/ipc_lock.h"
+
+/*
+ * Hardware resources which are locked individually. Locks are taken in
+ * the order listed here; I2C buses come last since the I2C interface
+ * locks them itself while a command already holds other resources.
+ */
+enum resource_type {
+	RESOURCE_NONE,		/* terminates a claim list */
+	RESOURCE_HOST_FLASH,
+	RESOURCE_EC_FLASH,
+	RESOURCE_EC,		/* instance is the EC name, e.g. "pd" */
+	RESOURCE_CMOS,
+	RESOURCE_I2C_BUS,	/* instance is the bus number */
+};
+
+/*
+ * A resource used by a command. Claim lists end with RESOURCE_NONE and
+ * must be in the order of enum resource_type.
+ */
+struct resource_claim {
+	enum resource_type type;
+	const char *instance;		/* NULL for single resources */
+	enum ipc_lock_mode mode;
+};
+
+/*
+ * mosys_acquire_resource  -  lock a hardware resource
+ *
+ * @type:	resource type
+ * @instance:	resource instance, NULL for single resources
+ * @mode:	IPC_LOCK_SHARED or IPC_LOCK_EXCLUSIVE
+ * @timeout_secs:	seconds to wait for lock
+ *
+ * Locks are counted, so a resource may be acquired again while held. A
+ * nested exclusive request converts a shared lock.
+ *
+ * returns 0 to indicate lock acquired
+ * returns <0 to indicate failure
+ */
+extern int mosys_acquire_resource(enum resource_type type,
+                                  const char *instance,
+                                  enum ipc_lock_mode mode, int timeout_secs);
+
+/*
+ * mosys_release_resource  -  unlock a hardware resource
+ *
+ * @type:	resource type
+ * @instance:	resource instance, NULL for single resources
+ *
+ * returns 0 if lock was released or is still held by an outer caller
+ * returns <0 if lock was not held
+ */
+extern int mosys_release_resource(enum resource_type type,
+                                  const char *instance);
+
+/*
+ * mosys_acquire_resources  -  lock all resources in claim list
+ *
+ * @claims:	claim list
+ * @timeout_secs:	seconds to wait for each lock
+ *
+ * returns 0 to indicate all locks acquired
+ * returns <0 to indicate failure, with no locks held
+ */
+extern int mosys_acquire_resources(const struct resource_claim *claims,
+                                   int timeout_secs);
+
+/*
+ * mosys_release_resources  -  unlock all resources in claim list
+ *
+ * @claims:	claim list
+ */
+extern void mosys_release_resources(const struct resource_claim *claims);
+
+#endif /* MOSYS_RESOURCE_LOCK_H__ */
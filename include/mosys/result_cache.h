@@ -0,0 +1,79 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * result_cache.h: memoize static hardware facts
+ */
+
+#ifndef MOSYS_RESULT_CACHE_H__
+#define MOSYS_RESULT_CACHE_H__
+
+struct platform_intf;
+
+/*
+ * result_cache_install  -  memoize static getters
+ *
+ * @intf:	platform interface
+ *
+ * Wraps the sys, smbios, vpd and EC identification getters of @intf so
+ * that each value is computed at most once per process. With
+ * CONFIG_SHARED_RESULT_CACHE, values are also reused by other mosys
+ * processes during the same boot.
+ */
+extern void result_cache_install(struct platform_intf *intf);
+
+/*
+ * result_cache_remove  -  restore getters wrapped by result_cache_install
+ *
+ * @intf:	platform interface
+ */
+extern void result_cache_remove(struct platform_intf *intf);
+
+/*
+ * result_cache_invalidate  -  drop all cached values
+ *
+ * Must be called after anything that may change cached values, such as
+ * writing to an EEPROM or to NVRAM.
+ */
+extern void result_cache_invalidate(void);
+
+/*
+ * result_cache_invalidations  -  count calls to result_cache_invalidate
+ *
+ * Lets callers keeping results of their own, such as mosysd, notice that
+ * values may have changed.
+ *
+ * returns number of times this process invalidated cached values
+ */
+extern unsigned int result_cache_invalidations(void);
+
+/* unittest stuff */
+extern int result_cache_unittest(void);
+
+#endif /* MOSYS_RESULT_CACHE_H__ */
@@ -38,13 +38,16 @@
 #include <inttypes.h>
 #include <string.h>
 #include <dirent.h>
+#include <pthread.h>
 #include <sys/ioctl.h>
 
 #include "mosys/alloc.h"
 #include "mosys/globals.h"
+#include "mosys/intf_list.h"
 #include "mosys/log.h"
 #include "mosys/list.h"
 #include "mosys/platform.h"
+#include "mosys/resource_lock.h"
 
 #include "intf/i2c.h"
 
@@ -63,13 +66,17 @@
  */
 #define BLOCK_WRITE_DELAY	1000
 #define BLOCK_WRITE_RETRIES	32
+#define I2C_LOCK_TIMEOUT_SECS	180
 
 struct i2c_handle {
 	struct i2c_addr addr;
 	int fd;
+	int read_words;		/* device answers SMBus word reads */
+	pthread_mutex_t lock;	/* serializes transactions with device */
 } i2c_handles[I2C_HANDLE_MAX];
 
 static int i2c_handle_num = 0;
+static pthread_mutex_t i2c_handles_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /*
  * i2c_open_dev  -  Open connection to I2C slave address
@@ -86,16 +93,22 @@ static int i2c_open_dev(struct platform_intf *intf, int bus, int address)
 	char devf[512];
 	int handle, fd;
 
+	if (intf_op_ready(intf, INTF_OP_I2C) < 0)
+		return -1;
+
+	pthread_mutex_lock(&i2c_handles_lock);
+
 	if (i2c_handle_num >= I2C_HANDLE_MAX) {
 		lprintf(LOG_NOTICE, "Out of I2C handles\n");
-		return -1;
+		handle = -1;
+		goto i2c_open_dev_exit;
 	}
 
 	for (handle = 0; handle < i2c_handle_num; handle++) {
 		if (i2c_handles[handle].addr.bus == bus &&
 		    i2c_handles[handle].addr.addr == address &&
 		    i2c_handles[handle].fd >= 0)
-			return handle;
+			goto i2c_open_dev_exit;
 	}
 
 	snprintf(devf, sizeof(devf), "%s/i2c-%d",
@@ -104,7 +117,8 @@ static int i2c_open_dev(struct platform_intf *intf, int bus, int address)
 	fd = open(devf, O_RDWR);
 	if (fd < 0) {
 		lperror(LOG_DEBUG, "Unable to open I2C device %s", devf);
-		return -1;
+		handle = -1;
+		goto i2c_open_dev_exit;
 	}
 
 #if defined (__linux__)
@@ -112,20 +126,80 @@ static int i2c_open_dev(struct platform_intf *intf, int bus, int address)
 		lperror(LOG_NOTICE, "Unable to set I2C slave address to 0x%02x",
 		        address);
 		close(fd);
-		return -1;
+		handle = -1;
+		goto i2c_open_dev_exit;
 	}
 #else
-	return -ENOSYS;
+	close(fd);
+	handle = -ENOSYS;
+	goto i2c_open_dev_exit;
 #endif
 
 	i2c_handles[i2c_handle_num].addr.bus = bus;
 	i2c_handles[i2c_handle_num].addr.addr = address;
 	i2c_handles[i2c_handle_num].fd = fd;
+	i2c_handles[i2c_handle_num].read_words = 1;
+	pthread_mutex_init(&i2c_handles[i2c_handle_num].lock, NULL);
 
 	lprintf(LOG_DEBUG, "Opened I2C handle %d to %d-%02x (fd %d)\n",
 	        i2c_handle_num, bus, address, fd);
 
-	return i2c_handle_num++;
+	handle = i2c_handle_num++;
+
+i2c_open_dev_exit:
+	pthread_mutex_unlock(&i2c_handles_lock);
+	return handle;
+}
+
+/*
+ * i2c_lock_dev  -  Open connection to I2C slave address and lock it
+ *
+ * @intf:       platform interface
+ * @bus:        I2C bus/adapter
+ * @address:    I2C slave address
+ *
+ * Transactions with different devices may run concurrently. Each
+ * transaction must be finished with i2c_unlock_dev().
+ *
+ * returns handle for open I2C device
+ * returns <0 to indicate error
+ */
+static int i2c_lock_dev(struct platform_intf *intf, int bus, int address)
+{
+	int handle;
+#if defined(CONFIG_USE_IPC_LOCK)
+	char instance[16];
+
+	/* other mosys processes may be using the same bus */
+	snprintf(instance, sizeof(instance), "%d", bus);
+	if (mosys_acquire_resource(RESOURCE_I2C_BUS, instance,
+	                           IPC_LOCK_EXCLUSIVE, I2C_LOCK_TIMEOUT_SECS) < 0)
+		return -1;
+#endif
+
+	handle = i2c_open_dev(intf, bus, address);
+	if (handle >= 0)
+		pthread_mutex_lock(&i2c_handles[handle].lock);
+#if defined(CONFIG_USE_IPC_LOCK)
+	else
+		mosys_release_resource(RESOURCE_I2C_BUS, instance);
+#endif
+
+	return handle;
+}
+
+static void i2c_unlock_dev(int handle)
+{
+#if defined(CONFIG_USE_IPC_LOCK)
+	char instance[16];
+
+	snprintf(instance, sizeof(instance), "%d",
+	         i2c_handles[handle].addr.bus);
+#endif
+	pthread_mutex_unlock(&i2c_handles[handle].lock);
+#if defined(CONFIG_USE_IPC_LOCK)
+	mosys_release_resource(RESOURCE_I2C_BUS, instance);
+#endif
 }
 
 /*
@@ -139,13 +213,16 @@ static void i2c_close_dev(struct platform_intf *intf)
 	int i;
 
 	// close all handles
+	pthread_mutex_lock(&i2c_handles_lock);
 	for (i = 0; i < i2c_handle_num; i++) {
 		close(i2c_handles[i].fd);
 		i2c_handles[i].fd = -1;
 		i2c_handles[i].addr.bus = -1;
 		i2c_handles[i].addr.addr = -1;
+		pthread_mutex_destroy(&i2c_handles[i].lock);
 	}
 	i2c_handle_num = 0;
+	pthread_mutex_unlock(&i2c_handles_lock);
 
 	/* we store these as const in the structure */
 	free((char *)intf->op->i2c->sys_root);
@@ -162,7 +239,7 @@ static int i2c_transfer(struct platform_intf *intf, int bus, int address,
 	int handle, fd;
 
 	/* open connection to i2c slave */
-	handle = i2c_open_dev(intf, bus, address);
+	handle = i2c_lock_dev(intf, bus, address);
 	if (handle < 0)
 		return -1;
 	fd = i2c_handles[handle].fd;
@@ -206,6 +283,7 @@ static int i2c_transfer(struct platform_intf *intf, int bus, int address,
 		ret = 0;
 	}
 
+	i2c_unlock_dev(handle);
 	free(msg);
 	return ret;
 }
@@ -215,7 +293,6 @@ static int smbus_read_reg(struct platform_intf *intf, int bus,
 {
 	int handle, fd, i;
 	int32_t result;
-	static int read_words = 1;
 
 	if (length < 1 || length > SPD_MAX_LENGTH) {
 		lprintf(LOG_NOTICE, "Invalid I2C read length: %d\n", length);
@@ -227,7 +304,7 @@ static int smbus_read_reg(struct platform_intf *intf, int bus,
 	        bus, address, reg);
 
 	/* open connection to i2c slave */
-	handle = i2c_open_dev(intf, bus, address);
+	handle = i2c_lock_dev(intf, bus, address);
 	if (handle < 0)
 		return -1;
 	fd = i2c_handles[handle].fd;
@@ -235,14 +312,14 @@ static int smbus_read_reg(struct platform_intf *intf, int bus,
 	memset(data, 0, length);
 	i = 0;
 	while (i < length) {
-		if (read_words && (i < length - 1)) {
+		if (i2c_handles[handle].read_words && (i < length - 1)) {
 			/* Do 2-byte reads whenever possible */
 			result = i2c_smbus_read_word_data(fd, reg + i);
 
                         if (result < 0) {
-				if (read_words) {
+				if (i2c_handles[handle].read_words) {
 					/* try again with byte read */
-					read_words = 0;
+					i2c_handles[handle].read_words = 0;
 					continue;
 				}
 				// COV_NF_START
@@ -271,6 +348,7 @@ static int smbus_read_reg(struct platform_intf *intf, int bus,
 		}
 	}
 
+	i2c_unlock_dev(handle);
 	return i;
 }
 
@@ -295,7 +373,7 @@ static int smbus_read16_dev(struct platform_intf *intf, int bus,
 	        length, bus, address, reg);
 
 	// open connection to i2c slave
-	handle = i2c_open_dev(intf, bus, address);
+	handle = i2c_lock_dev(intf, bus, address);
 	if (handle < 0)
 		return -1;
 	fd = i2c_handles[handle].fd;
@@ -308,7 +386,8 @@ static int smbus_read16_dev(struct platform_intf *intf, int bus,
 		lperror(LOG_NOTICE,
 		        "Failed to write I2C register 0x%04x from i2c-%d-%02x",
 		        reg, bus, address);
-		return -1;
+		i = -1;
+		goto smbus_read16_dev_exit;
 	}
 
 	// Read the block
@@ -318,11 +397,14 @@ static int smbus_read16_dev(struct platform_intf *intf, int bus,
 			lperror(LOG_NOTICE,
 			        "Failed to read I2C register 0x%04x "
 			        "from i2c-%d-%02x", reg + i, bus, address);
-			return -1;
+			i = -1;
+			goto smbus_read16_dev_exit;
 		}
 		dp[i] = result;
 	}
 
+smbus_read16_dev_exit:
+	i2c_unlock_dev(handle);
 	return i;
 }
 
@@ -338,7 +420,7 @@ static int smbus_read_raw(struct platform_intf *intf,
 	        __func__, bus, address);
 
 	/* open connection to i2c slave */
-	handle = i2c_open_dev(intf, bus, address);
+	handle = i2c_lock_dev(intf, bus, address);
 	if (handle < 0)
 		return -1;
 	fd = i2c_handles[handle].fd;
@@ -356,6 +438,7 @@ static int smbus_read_raw(struct platform_intf *intf,
 		dp[count] = result;
 	}
 
+	i2c_unlock_dev(handle);
 	return count;
 }
 
@@ -376,7 +459,7 @@ static int smbus_write_reg(struct platform_intf *intf, int bus,
 	        length, bus, address, reg);
 
 	/* open connection to i2c slave */
-	handle = i2c_open_dev(intf, bus, address);
+	handle = i2c_lock_dev(intf, bus, address);
 	if (handle < 0)
 		return -1;
 	fd = i2c_handles[handle].fd;
@@ -393,6 +476,7 @@ static int smbus_write_reg(struct platform_intf *intf, int bus,
 		}
 	}
 
+	i2c_unlock_dev(handle);
 	return i;
 }
 
@@ -452,7 +536,7 @@ static int smbus_write16_dev(struct platform_intf *intf,
 	int buf_len, count;
 
 	// Open connection to this address
-	handle = i2c_open_dev(intf, bus, address);
+	handle = i2c_lock_dev(intf, bus, address);
 	if (handle < 0)
 		return -1;
 
@@ -465,24 +549,26 @@ static int smbus_write16_dev(struct platform_intf *intf,
 		buf_len = __min(length, 31);
 		count = smbus_write16_buf(handle, reg, data_ptr, buf_len);
 		if (count != buf_len)
-			return written;
+			break;
 		length -= count;
 		written += count;
 		data_ptr += count;
 		reg += count;
 
 		if (length == 0)
-			return written;
+			break;
 
 		buf_len = 1;
 		count = smbus_write16_buf(handle, reg, data_ptr, buf_len);
 		if (count != buf_len)
-			return written;
+			break;
 		length -= buf_len;
 		written += buf_len;
 		data_ptr += buf_len;
 		reg += buf_len;
 	}
+
+	i2c_unlock_dev(handle);
 	return written;
 }
 
@@ -498,7 +584,7 @@ static int smbus_write_raw(struct platform_intf *intf,
 	        __func__, bus, address);
 
 	/* open connection to i2c slave */
-	handle = i2c_open_dev(intf, bus, address);
+	handle = i2c_lock_dev(intf, bus, address);
 	if (handle < 0)
 		return -1;
 	fd = i2c_handles[handle].fd;
@@ -514,6 +600,7 @@ static int smbus_write_raw(struct platform_intf *intf,
 		}
   	}
 
+	i2c_unlock_dev(handle);
 	return count;
 }
 
@@ -525,6 +612,10 @@ static int i2c_find_driver(struct platform_intf *intf, const char *module)
 	int len = strlen(module);
 	int ret = 0;
 
+	/* callers go on to use sys_root */
+	if (intf_op_ready(intf, INTF_OP_I2C) < 0)
+		return 0;
+
 	path = format_string("%s/proc/modules", mosys_get_root_prefix());
 	fp = fopen(path, "r");
 	free(path);
@@ -586,6 +677,9 @@ static struct ll_node *i2c_find_sysfs_dir(struct platform_intf *intf,
 	int bus, addr;
 	int len = strlen(name);
 
+	if (intf_op_ready(intf, INTF_OP_I2C) < 0)
+		return NULL;
+
 	if (!(dp = opendir(intf->op->i2c->sys_root))) {
 		lprintf(LOG_ERR, "Failed to open %s\n",
 		        intf->op->i2c->sys_root);
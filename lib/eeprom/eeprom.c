@@ -85,6 +85,75 @@ struct fmap *eeprom_get_fmap(struct platform_intf *intf, struct eeprom *eeprom)
 	return fmap;
 }
 
+int eeprom_prefetch_regions(struct platform_intf *intf,
+			    struct eeprom *eeprom)
+{
+	struct eeprom_region *region;
+	const char **names;
+	int num = 0, rc;
+
+	if (!eeprom->device->prefetch || !eeprom->regions)
+		return 0;
+
+	for (region = eeprom->regions; region->name; region++)
+		num++;
+	if (num == 0)
+		return 0;
+
+	names = mosys_zalloc((num + 1) * sizeof(*names));
+	for (num = 0, region = eeprom->regions; region->name; region++)
+		names[num++] = region->name;
+
+	rc = eeprom->device->prefetch(intf, eeprom, names);
+	if (rc < 0)
+		lprintf(LOG_DEBUG, "%s: failed to prefetch regions of %s\n",
+		        __func__, eeprom->name);
+
+	free(names);
+	return rc;
+}
+
+int eeprom_host_firmware_read(struct platform_intf *intf,
+			      struct eeprom *eeprom,
+			      unsigned int offset, unsigned int len, void *data)
+{
+	int rom_size;
+
+	if ((rom_size = eeprom->device->size(intf)) < 0)
+		return -1;
+
+	if (offset + len > rom_size || offset + len < offset)
+		return -1;
+
+	/* the whole ROM is read with flashrom_read() so that it is cached */
+	if (offset == 0 && len == rom_size)
+		return flashrom_read(data, len, HOST_FIRMWARE, NULL);
+
+	return flashrom_read_range(data, offset, len, HOST_FIRMWARE);
+}
+
+int eeprom_host_firmware_prefetch(struct platform_intf *intf,
+				  struct eeprom *eeprom, const char **names)
+{
+	struct flashrom_region *regions;
+	int i, num, rc;
+
+	for (num = 0; names[num]; num++)
+		;
+
+	regions = mosys_zalloc(num * sizeof(*regions));
+	for (i = 0; i < num; i++)
+		regions[i].name = names[i];
+
+	/* the regions stay cached, so the copies handed back are not needed */
+	rc = flashrom_read_regions(regions, num, HOST_FIRMWARE);
+	for (i = 0; i < num; i++)
+		free(regions[i].buf);
+	free(regions);
+
+	return rc;
+}
+
 int eeprom_get_host_firmware_rom_size(struct platform_intf *intf)
 {
 	return flashrom_get_rom_size(intf, HOST_FIRMWARE);
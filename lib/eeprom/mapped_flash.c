@@ -0,0 +1,307 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * mapped_flash.c: access memory-mapped host firmware ROM
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fmap.h>
+
+#include "mosys/alloc.h"
+#include "mosys/callbacks.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "intf/mmio.h"
+
+#include "lib/eeprom.h"
+#include "lib/flashrom.h"
+
+/*
+ * On x86 the chipset decodes the top of the BIOS region of the SPI flash
+ * just below 4GB, at most 16MB of it. The end of the BIOS region normally
+ * coincides with the end of the ROM.
+ */
+#define MAPPED_FLASH_TOP	0x100000000ULL
+#define MAPPED_FLASH_MAX_SIZE	(16 * 1024 * 1024)
+
+struct mapped_flash {
+	struct eeprom *eeprom;
+	uint8_t *map;
+	uint64_t base;		/* physical address of mapping */
+	unsigned int offset;	/* ROM offset of the start of the mapping */
+	unsigned int len;	/* length of mapping */
+	unsigned int rd_start;	/* readable range (ROM offsets) */
+	unsigned int rd_end;
+	struct fmap *fmap;	/* points into the mapping */
+	int unavailable;
+};
+
+static struct mapped_flash mapped_flash;
+static pthread_mutex_t mapped_flash_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#if defined(__i386__) || defined(__x86_64__)
+/* caller must hold mapped_flash_lock */
+static void mapped_flash_release(struct platform_intf *intf)
+{
+	if (mapped_flash.map)
+		intf->op->mmio->unmap(intf, mapped_flash.map,
+		                      mapped_flash.base, mapped_flash.len);
+	memset(&mapped_flash, 0, sizeof(mapped_flash));
+}
+
+static void mapped_flash_destroy(void *arg)
+{
+	pthread_mutex_lock(&mapped_flash_lock);
+	mapped_flash_release(arg);
+	pthread_mutex_unlock(&mapped_flash_lock);
+}
+#endif
+
+/*
+ * mapped_flash_setup  -  map the ROM and find its FMAP
+ *
+ * @intf:	platform interface
+ * @eeprom:	eeprom interface
+ * @rom_size:	size of the ROM, <=0 if unknown
+ *
+ * The caller must hold mapped_flash_lock. The mapping is only used if an FMAP is found at the place it claims to be,
+ * which also guards against the mapping not being decoded to flash. If the
+ * FMAP describes the BIOS region of a descriptor-mode ROM then reads are
+ * restricted to it, since other regions are not decoded.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int mapped_flash_setup(struct platform_intf *intf,
+			      struct eeprom *eeprom, int rom_size)
+{
+#if defined(__i386__) || defined(__x86_64__)
+	struct mapped_flash *m = &mapped_flash;
+	const struct fmap_area *area;
+	long int fmap_offset;
+
+	if (m->eeprom == eeprom && m->map)
+		return 0;
+	if (m->eeprom == eeprom && m->unavailable)
+		return -1;
+
+	if (m->map)
+		mapped_flash_release(intf);
+	m->eeprom = eeprom;
+
+	if (!intf->op || !intf->op->mmio || !intf->op->mmio->map)
+		goto mapped_flash_setup_exit_0;
+
+	if (rom_size <= 0)
+		goto mapped_flash_setup_exit_0;
+
+	m->len = rom_size > MAPPED_FLASH_MAX_SIZE ?
+	         MAPPED_FLASH_MAX_SIZE : rom_size;
+	m->offset = rom_size - m->len;
+	if (eeprom->addr.mmio)
+		m->base = eeprom->addr.mmio + m->offset;
+	else
+		m->base = MAPPED_FLASH_TOP - m->len;
+
+	m->map = intf->op->mmio->map(intf, O_RDONLY, m->base, m->len);
+	if (!m->map) {
+		lprintf(LOG_DEBUG, "%s: unable to map 0x%08llx\n",
+		        __func__, (unsigned long long)m->base);
+		goto mapped_flash_setup_exit_0;
+	}
+	add_destroy_callback(mapped_flash_destroy, intf);
+
+	fmap_offset = fmap_find(m->map, m->len);
+	if (fmap_offset < 0) {
+		lprintf(LOG_DEBUG, "%s: no FMAP in mapping\n", __func__);
+		goto mapped_flash_setup_exit_1;
+	}
+	m->fmap = (struct fmap *)(m->map + fmap_offset);
+
+	if (fmap_offset + fmap_size(m->fmap) > m->len) {
+		lprintf(LOG_DEBUG, "%s: FMAP is truncated\n", __func__);
+		goto mapped_flash_setup_exit_1;
+	}
+
+	if (m->fmap->size != rom_size) {
+		lprintf(LOG_DEBUG, "%s: FMAP describes a %u byte ROM, expected "
+		        "%d\n", __func__, m->fmap->size, rom_size);
+		goto mapped_flash_setup_exit_1;
+	}
+
+	/* make sure that the mapping lines up with the ROM's layout */
+	area = fmap_find_area(m->fmap, "FMAP");
+	if (area && area->offset != m->offset + fmap_offset) {
+		lprintf(LOG_DEBUG, "%s: FMAP found at 0x%08lx, expected "
+		        "0x%08x\n", __func__, m->offset + fmap_offset,
+		        area->offset);
+		goto mapped_flash_setup_exit_1;
+	}
+
+	m->rd_start = m->offset;
+	m->rd_end = rom_size;
+	area = fmap_find_area(m->fmap, "SI_BIOS");
+	if (area) {
+		if (area->offset > m->rd_start)
+			m->rd_start = area->offset;
+		if (area->offset + area->size < m->rd_end)
+			m->rd_end = area->offset + area->size;
+	}
+
+	lprintf(LOG_DEBUG, "%s: ROM offsets 0x%08x-0x%08x mapped at "
+	        "0x%08llx\n", __func__, m->rd_start, m->rd_end - 1,
+	        (unsigned long long)(m->base + m->rd_start - m->offset));
+	return 0;
+
+mapped_flash_setup_exit_1:
+	intf->op->mmio->unmap(intf, m->map, m->base, m->len);
+	m->map = NULL;
+	m->fmap = NULL;
+mapped_flash_setup_exit_0:
+	m->unavailable = 1;
+#endif
+	return -1;
+}
+
+/*
+ * mapped_flash_get  -  lock the mapping and set it up for an eeprom
+ *
+ * @intf:	platform interface
+ * @eeprom:	eeprom interface
+ *
+ * The ROM size may have to be read using flashrom, which drops the big lock
+ * and waits for other queries, so it is only read when the mapping needs to
+ * be set up and never with mapped_flash_lock held. The caller must release
+ * mapped_flash_lock whether or not this succeeds.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int mapped_flash_get(struct platform_intf *intf, struct eeprom *eeprom)
+{
+	struct mapped_flash *m = &mapped_flash;
+	int rom_size;
+
+	pthread_mutex_lock(&mapped_flash_lock);
+	if (m->eeprom == eeprom && (m->map || m->unavailable))
+		return m->map ? 0 : -1;
+	pthread_mutex_unlock(&mapped_flash_lock);
+
+	rom_size = -1;
+	if (intf->op && intf->op->mmio && intf->op->mmio->map)
+		rom_size = eeprom->device->size(intf);
+
+	pthread_mutex_lock(&mapped_flash_lock);
+	return mapped_flash_setup(intf, eeprom, rom_size);
+}
+
+/* returns pointer to the mapped range, or NULL if it is not mapped,
+   caller must hold mapped_flash_lock */
+static const uint8_t *mapped_flash_range(unsigned int offset, unsigned int len)
+{
+	struct mapped_flash *m = &mapped_flash;
+
+	if (!m->map)
+		return NULL;
+
+	if (offset < m->rd_start || offset + len > m->rd_end ||
+	    offset + len < offset)
+		return NULL;
+
+	return m->map + (offset - m->offset);
+}
+
+int eeprom_mapped_flash_read(struct platform_intf *intf,
+			     struct eeprom *eeprom,
+			     unsigned int offset, unsigned int len,
+			     void *data)
+{
+	const uint8_t *src = NULL;
+
+	if (mapped_flash_get(intf, eeprom) == 0)
+		src = mapped_flash_range(offset, len);
+	if (src)
+		memcpy(data, src, len);
+	pthread_mutex_unlock(&mapped_flash_lock);
+	if (src)
+		return 0;
+
+	lprintf(LOG_DEBUG, "%s: falling back to flashrom\n", __func__);
+	return eeprom_host_firmware_read(intf, eeprom, offset, len, data);
+}
+
+int eeprom_mapped_flash_read_by_name(struct platform_intf *intf,
+				     struct eeprom *eeprom,
+				     const char *name, uint8_t **data)
+{
+	const struct fmap_area *area = NULL;
+	const uint8_t *src = NULL;
+	int size = 0;
+
+	if (mapped_flash_get(intf, eeprom) == 0)
+		area = fmap_find_area(mapped_flash.fmap, name);
+	if (area)
+		src = mapped_flash_range(area->offset, area->size);
+	if (src) {
+		size = area->size;
+		*data = mosys_malloc(size);
+		memcpy(*data, src, size);
+	}
+	pthread_mutex_unlock(&mapped_flash_lock);
+	if (src)
+		return size;
+
+	lprintf(LOG_DEBUG, "%s: falling back to flashrom\n", __func__);
+	return flashrom_read_by_name(data, HOST_FIRMWARE, name);
+}
+
+struct fmap *eeprom_mapped_flash_get_map(struct platform_intf *intf,
+					 struct eeprom *eeprom)
+{
+	struct fmap *fmap = NULL;
+	int size;
+
+	if (mapped_flash_get(intf, eeprom) == 0) {
+		size = fmap_size(mapped_flash.fmap);
+		fmap = mosys_malloc(size);
+		memcpy(fmap, mapped_flash.fmap, size);
+	}
+	pthread_mutex_unlock(&mapped_flash_lock);
+
+	if (!fmap)
+		return eeprom_get_fmap(intf, eeprom);
+	return fmap;
+}
@@ -29,7 +29,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include <fmap.h>
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
 #include <time.h>
 #include <valstr.h>
@@ -614,6 +617,10 @@ static int elog_print_entry_me_ext(struct platform_intf *intf,
 	if (!desc || !value)
 		return 0;
 
+	/* only counting */
+	if (id < 0)
+		return 1;
+
 	kv = kv_pair_new();
 	kv_pair_fmt(kv, "entry", "%d", id);
 	smbios_eventlog_print_timestamp(intf, entry, kv);
@@ -624,12 +631,16 @@ static int elog_print_entry_me_ext(struct platform_intf *intf,
 	return 1;
 }
 
+/* entry id of the next event printed, or <0 when only counting */
+#define ME_EXT_ID(start_id, num_msg) \
+	((start_id) < 0 ? -1 : (start_id) + (num_msg))
+
 /*
  * elog_print_multi_me_ext  -  print management engine extended events
  *
  * @intf:	platform interface
  * @entry:	log entry
- * @start_id:	starting entry id
+ * @start_id:	starting entry id, <0 to count events without printing
  *
  * returns 0 to indicate nothing was printed
  * returns >0 to indicate how many events were printed
@@ -757,37 +768,37 @@ static int elog_print_multi_me_ext(struct platform_intf *intf,
 
 	/* Current Working State */
 	num_msg += elog_print_entry_me_ext(
-		intf, entry, start_id + num_msg, "ME Working State",
+		intf, entry, ME_EXT_ID(start_id, num_msg), "ME Working State",
 		val2str_default(me->current_working_state,
 				me_cws_values, NULL));
 
 	/* Current Operation State */
 	num_msg += elog_print_entry_me_ext(
-		intf, entry, start_id + num_msg, "ME Operation State",
+		intf, entry, ME_EXT_ID(start_id, num_msg), "ME Operation State",
 		val2str_default(me->operation_state,
 				me_opstate_values, NULL));
 
 	/* Current Operation Mode */
 	num_msg += elog_print_entry_me_ext(
-		intf, entry, start_id + num_msg, "ME Operation Mode",
+		intf, entry, ME_EXT_ID(start_id, num_msg), "ME Operation Mode",
 		val2str_default(me->operation_mode,
 				me_opmode_values, NULL));
 
 	/* Progress Phase */
 	num_msg += elog_print_entry_me_ext(
-		intf, entry, start_id + num_msg, "ME Progress Phase",
+		intf, entry, ME_EXT_ID(start_id, num_msg), "ME Progress Phase",
 		val2str_default(me->progress_code,
 				me_progress_values, NULL));
 
 	/* Power Management Event */
 	num_msg += elog_print_entry_me_ext(
-		intf, entry, start_id + num_msg, "ME PM Event",
+		intf, entry, ME_EXT_ID(start_id, num_msg), "ME PM Event",
 		val2str_default(me->current_pmevent,
 				me_pmevent_values, NULL));
 
 	/* Error Code (if non-zero) */
 	num_msg += elog_print_entry_me_ext(
-		intf, entry, start_id + num_msg, "ME Error Code",
+		intf, entry, ME_EXT_ID(start_id, num_msg), "ME Error Code",
 		val2str_default(me->error_code,
 				me_error_values, NULL));
 
@@ -807,7 +818,7 @@ static int elog_print_multi_me_ext(struct platform_intf *intf,
 	}
 
 	num_msg += elog_print_entry_me_ext(
-		intf, entry, start_id + num_msg, "ME Phase State",
+		intf, entry, ME_EXT_ID(start_id, num_msg), "ME Phase State",
 		val2str_default(me->current_state,
 				me_state_values, NULL));
 
@@ -819,7 +830,7 @@ static int elog_print_multi_me_ext(struct platform_intf *intf,
  *
  * @intf:	platform interface
  * @entry:	log entry
- * @start_id:	starting entry id
+ * @start_id:	starting entry id, <0 to count entries without printing
  *
  * returns 0 to indicate nothing was printed
  * returns >0 to indicate how many events were printed
@@ -966,65 +977,202 @@ static int elog_copy_events(struct platform_intf *intf,
 	return 0;
 }
 
-static int elog_events_size(struct platform_intf *intf,
-			    struct smbios_log_entry *entry,
-			    void *arg, int *complete)
+/*
+ * elog_shrink_events - drop the oldest events of an in-memory log
+ *
+ * @intf:          platform interface used for low level hardware access
+ * @data:          contents of the event log
+ * @length:        length of the event log
+ * @header_offset: offset of the header in the event log
+ * @data_offset:   offset of the first event in the event log
+ * @shrink_size:   minimum number of bytes of events to drop
+ * @events_size:   size of the events in the log, updated on return
+ *
+ * Whole events are dropped from the start of the log until at least
+ * shrink_size bytes are freed, the remaining events are moved to the start
+ * and a LOGCLEAR event recording the number of bytes dropped is appended.
+ */
+static void elog_shrink_events(struct platform_intf *intf, uint8_t *data,
+			       size_t length, off_t header_offset,
+			       off_t data_offset, size_t shrink_size,
+			       size_t *events_size)
 {
-	size_t *events_size = (size_t *)arg;
+	struct smbios_eventlog_iterator *elog_iter;
+	struct smbios_log_entry *entry;
+	uint32_t skipped = 0;
+
+	elog_iter = smbios_new_eventlog_iterator(intf, data, length,
+						 header_offset, data_offset);
+	while (skipped < shrink_size &&
+	       (entry = smbios_eventlog_get_next_entry(elog_iter)) != NULL)
+		skipped += entry->length;
+	smbios_free_eventlog_iterator(elog_iter);
+
+	*events_size -= skipped;
+	memmove(data + data_offset, data + data_offset + skipped,
+		*events_size);
+	memset(data + data_offset + *events_size, 0xff,
+	       length - data_offset - *events_size);
+
+	elog_prepare_entry(data + data_offset + *events_size,
+			   SMBIOS_EVENT_TYPE_LOGCLEAR,
+			   &skipped, sizeof(skipped));
+	*events_size += sizeof(struct smbios_log_entry) + sizeof(skipped) + 1;
+}
 
-	if (entry->length == 0) {
-		lprintf(LOG_WARNING, "Zero-length eventlog entry detected.\n");
-		*complete = 1;
+/*
+ * elog_parse_event - parse an event given as type and hex data strings
+ *
+ * @type:	event type, a number
+ * @hex:	event data as a series of hex bytes, may be NULL
+ * @event:	event to fill in, data is allocated
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+int elog_parse_event(const char *type, const char *hex,
+		     struct elog_new_event *event)
+{
+	char byte[3] = { 0, 0, 0 };
+	char *endptr;
+	long value;
+	size_t len;
+	int i;
+
+	value = strtol(type, &endptr, 0);
+	if (endptr == type || *endptr || value < 0 || value > 0xff)
+		return -1;
+
+	event->type = value;
+	event->data_size = 0;
+	event->data = NULL;
+
+	if (!hex)
+		return 0;
+
+	len = strlen(hex);
+	if (len % 2)
 		return -1;
+
+	event->data_size = len / 2;
+	event->data = mosys_malloc(event->data_size);
+	for (i = 0; i < event->data_size; i++) {
+		byte[0] = *hex++;
+		byte[1] = *hex++;
+		event->data[i] = strtol(byte, &endptr, 0);
+		if (endptr != &byte[2]) {
+			free(event->data);
+			event->data = NULL;
+			return -1;
+		}
 	}
 
-	*events_size += entry->length;
 	return 0;
 }
 
 /*
- * elog_add_event_manually - add an event by accessing the log directly.
+ * elog_parse_event_file - parse events listed in a file
+ *
+ * @path:	file to read, one "<event type> [event data]" per line
+ * @events:	pointer to store the allocated list of events in
+ *
+ * Blank lines and lines starting with '#' are ignored.
+ *
+ * returns the number of events to indicate success
+ * returns <0 to indicate failure
+ */
+int elog_parse_event_file(const char *path, struct elog_new_event **events)
+{
+	char line[LINE_MAX];
+	char *type, *hex, *extra, *saveptr;
+	FILE *fp;
+	int num = 0, line_num = 0;
+
+	if (!(fp = fopen(path, "r"))) {
+		lperror(LOG_ERR, "Unable to open %s", path);
+		return -1;
+	}
+
+	*events = NULL;
+	while (fgets(line, sizeof(line), fp)) {
+		line_num++;
+
+		type = strtok_r(line, " \t\r\n", &saveptr);
+		if (!type || type[0] == '#')
+			continue;
+		hex = strtok_r(NULL, " \t\r\n", &saveptr);
+		extra = strtok_r(NULL, " \t\r\n", &saveptr);
+
+		*events = mosys_realloc(*events, (num + 1) * sizeof(**events));
+		if (extra || elog_parse_event(type, hex, &(*events)[num])) {
+			lprintf(LOG_ERR, "%s:%d: invalid event\n",
+			        path, line_num);
+			goto elog_parse_event_file_fail;
+		}
+		num++;
+	}
+
+	fclose(fp);
+	return num;
+
+elog_parse_event_file_fail:
+	while (num--)
+		free((*events)[num].data);
+	free(*events);
+	*events = NULL;
+	fclose(fp);
+	return -1;
+}
+
+/*
+ * elog_add_events_manually - add several events by accessing the log directly.
  *
  * @intf:          platform interface used for low level hardware access
- * @type:          the type of event to add
- * @data_size:     the size of the data to add to the event
- * @data:          pointer to the data to add
+ * @events:        the events to add, in order
+ * @num:           number of events
+ *
+ * The log is fetched and walked once to find the end of the existing events.
+ * All events, and any LOGCLEAR needed to make room for them, are applied to
+ * that copy which is then committed with a single write. Unless the log was
+ * shrunk only the bytes of the new events are handed to the write_range
+ * callback, if the platform provides one.
  *
  * returns -1 on failure, 0 on success
  */
-int elog_add_event_manually(struct platform_intf *intf,
-			    enum smbios_log_entry_type type,
-			    size_t event_data_size, uint8_t *event_data)
+int elog_add_events_manually(struct platform_intf *intf,
+			     struct elog_new_event *events, int num)
 {
 	size_t full_threshold, shrink_size;
 
 	uint8_t *data;
-	uint8_t *new_data = NULL;
-	size_t length, data_size, events_size;
-	size_t event_size = sizeof(struct smbios_log_entry) +
-			    event_data_size + 1;
-	off_t header_offset, data_offset;
-	struct elog_copy_events_params params;
+	size_t length, events_size, event_size;
+	off_t header_offset, data_offset, dirty_offset;
+	struct smbios_eventlog_iterator *elog_iter;
+	struct smbios_log_entry *entry;
+	int i, shrunk = 0, corrupt = 0, rc = -1;
 
 	if (!intf->cb->eventlog->fetch || !intf->cb->eventlog->write) {
 		errno = ENOSYS;
 		return -1;
 	}
 
-  	/* Total event size must fit in length member of entry (1 byte) */
-	if (event_size > 0xff) {
-		lprintf(LOG_ERR, "Event data size %lu too large.\n",
-				event_data_size);
-		errno = EINVAL;
-		return -1;
+	for (i = 0; i < num; i++) {
+		event_size = sizeof(struct smbios_log_entry) +
+			     events[i].data_size + 1;
+
+		/* Total event size must fit in length member of entry (1 byte) */
+		if (event_size > 0xff) {
+			lprintf(LOG_ERR, "Event data size %lu too large.\n",
+					events[i].data_size);
+			errno = EINVAL;
+			return -1;
+		}
 	}
 
 	if (intf->cb->eventlog->fetch(intf, &data, &length, &header_offset,
 				      &data_offset))
 		return -1;
 
-	data_size = length - data_offset;
-
 	/*
 	 * Assume the full threshold is 3/4 the log size, and the shrink size
 	 * is 1/4 the size.
@@ -1032,63 +1180,93 @@ int elog_add_event_manually(struct platform_intf *intf,
 	full_threshold = (length * 3) / 4;
 	shrink_size = length / 4;
 
-	if (event_size > shrink_size) {
-		lprintf(LOG_WARNING, "Event size %d is too large.\n",
-			event_size);
-		return -1;
-	}
-
 	/* Figure out how much space the existing events take up. */
 	events_size = 0;
-	if (smbios_eventlog_foreach_event(intf, NULL, &elog_events_size,
-					  &events_size)) {
+	elog_iter = smbios_new_eventlog_iterator(intf, data, length,
+						 header_offset, data_offset);
+	while ((entry = smbios_eventlog_get_next_entry(elog_iter)) != NULL) {
+		if (entry->length == 0) {
+			lprintf(LOG_WARNING, "Zero-length eventlog entry "
+					     "detected.\n");
+			corrupt = 1;
+			break;
+		}
+
+		events_size += entry->length;
+	}
+	smbios_free_eventlog_iterator(elog_iter);
+
+	if (corrupt) {
 		lprintf(LOG_ERR, "Eventlog is corrupt and must be cleared "
 				"before adding new events.\n");
-		return -1;
+		goto elog_add_events_manually_exit;
 	}
 
-	/* Shrink the log if it's going to exceed the full threshold. */
-	if (events_size + event_size > full_threshold) {
-		uint32_t skipped;
-
-		new_data = mosys_malloc(length);
-		memcpy(new_data, data, data_offset);
-		memset(new_data + data_offset, 0xff, data_size);
+	dirty_offset = data_offset + events_size;
+	for (i = 0; i < num; i++) {
+		event_size = sizeof(struct smbios_log_entry) +
+			     events[i].data_size + 1;
 
-		params.dest = new_data + data_offset;
-		params.skipped = 0;
-		params.to_skip = shrink_size;
+		if (event_size > shrink_size) {
+			lprintf(LOG_WARNING, "Event size %d is too large.\n",
+				event_size);
+			goto elog_add_events_manually_exit;
+		}
 
-		if (smbios_eventlog_foreach_event(intf, NULL, &elog_copy_events,
-						  &params)) {
-			free(new_data);
-			return -1;
+		/* Shrink the log if it's going to exceed the full threshold. */
+		if (events_size + event_size > full_threshold) {
+			elog_shrink_events(intf, data, length, header_offset,
+					   data_offset, shrink_size,
+					   &events_size);
+			shrunk = 1;
 		}
 
-		skipped = params.skipped;
-		events_size -= skipped;
-		data = new_data;
-		elog_prepare_entry(data + data_offset + events_size,
-				   SMBIOS_EVENT_TYPE_LOGCLEAR,
-				   &skipped, sizeof(skipped));
-		events_size += sizeof(struct smbios_log_entry) +
-			sizeof(skipped) + 1;
+		/* Add the new event. */
+		if (elog_prepare_entry(data + data_offset + events_size,
+				       events[i].type, events[i].data,
+				       events[i].data_size))
+			goto elog_add_events_manually_exit;
+		events_size += event_size;
 	}
 
-	/* Add the new event. */
-	if (elog_prepare_entry(data + data_offset + events_size, type,
-			       event_data, event_data_size)) {
-		free(new_data);
-		return -1;
+	/* A shrunk log moved every event, so all of it must be written. */
+	if (!shrunk && intf->cb->eventlog->write_range) {
+		if (intf->cb->eventlog->write_range(intf, data, length,
+				dirty_offset,
+				data_offset + events_size - dirty_offset))
+			goto elog_add_events_manually_exit;
+	} else if (intf->cb->eventlog->write(intf, data, length)) {
+		goto elog_add_events_manually_exit;
 	}
 
-	if (intf->cb->eventlog->write(intf, data, length)) {
-		free(new_data);
-		return -1;
-	}
+	rc = 0;
 
-	free(new_data);
-	return 0;
+elog_add_events_manually_exit:
+	free(data);
+	return rc;
+}
+
+/*
+ * elog_add_event_manually - add an event by accessing the log directly.
+ *
+ * @intf:          platform interface used for low level hardware access
+ * @type:          the type of event to add
+ * @data_size:     the size of the data to add to the event
+ * @data:          pointer to the data to add
+ *
+ * returns -1 on failure, 0 on success
+ */
+int elog_add_event_manually(struct platform_intf *intf,
+			    enum smbios_log_entry_type type,
+			    size_t event_data_size, uint8_t *event_data)
+{
+	struct elog_new_event event = {
+		.type		= type,
+		.data_size	= event_data_size,
+		.data		= event_data,
+	};
+
+	return elog_add_events_manually(intf, &event, 1);
 }
 
 /*
@@ -1245,6 +1423,9 @@ int elog_fetch_from_flash(struct platform_intf *intf, uint8_t **data,
 	if (elog_find_log_in_flash(intf, &eeprom, &region))
 		return -1;
 
+	/* fetch the other regions of interest in the same pass */
+	eeprom_prefetch_regions(intf, eeprom);
+
 	bytes_read = eeprom->device->read_by_name(intf, eeprom,
 						region->name, data);
 	if (bytes_read < 0) {
@@ -1288,3 +1469,53 @@ int elog_write_to_flash(struct platform_intf *intf, uint8_t *data,
 
 	return 0;
 }
+
+/*
+ * elog_write_range_to_flash - write the erase blocks of the eventlog which
+ *                             overlap a range of it to flash.
+ *
+ * @intf:          platform interface used for low level hardware access
+ * @data:          pointer to the contents of the event log
+ * @length:        length of the event log
+ * @offset:        offset of the changed bytes in the event log
+ * @size:          number of changed bytes
+ *
+ * The eventlog region starts on an erase block boundary, so the range is
+ * widened to whole erase blocks relative to the start of the log. Devices
+ * which cannot write part of a region get the whole log instead.
+ *
+ * returns -1 on failure, 0 on success
+ */
+int elog_write_range_to_flash(struct platform_intf *intf, uint8_t *data,
+			      size_t length, off_t offset, size_t size)
+{
+	struct eeprom *eeprom;
+	struct eeprom_region *region;
+	off_t start, end;
+	int bytes_written;
+
+	if (offset < 0 || offset + size > length)
+		return -1;
+
+	if (elog_find_log_in_flash(intf, &eeprom, &region))
+		return -1;
+
+	if (!eeprom->device->write_range_by_name)
+		return elog_write_to_flash(intf, data, length);
+
+	start = offset & ~(off_t)(ELOG_ERASE_BLOCK_SIZE - 1);
+	end = (offset + size + ELOG_ERASE_BLOCK_SIZE - 1) &
+	      ~(off_t)(ELOG_ERASE_BLOCK_SIZE - 1);
+	if (end > length)
+		end = length;
+
+	bytes_written = eeprom->device->write_range_by_name(intf, eeprom,
+						region->name, start,
+						end - start, data + start);
+	if (bytes_written != end - start) {
+		lprintf(LOG_WARNING, "Failed to write event log to flash.\n");
+		return -1;
+	}
+
+	return 0;
+}
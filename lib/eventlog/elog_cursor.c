@@ -0,0 +1,271 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * elog_cursor.c: persistent position in the event log
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mosys/alloc.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "lib/elog_cursor.h"
+#include "lib/elog_smbios.h"
+#include "lib/file.h"
+
+#define ELOG_CURSOR_FILE	"eventlog_cursor"
+
+/* Offset and size of data dropped from the start of the log by a LOGCLEAR */
+struct elog_cursor_clear {
+	off_t offset;
+	uint32_t skipped;
+};
+
+/* FNV-1a hash of entry, including its timestamp and any checksum byte */
+static uint32_t elog_cursor_sum(struct smbios_log_entry *entry)
+{
+	const uint8_t *ptr = (const uint8_t *)entry;
+	uint32_t hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < entry->length; i++) {
+		hash ^= ptr[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static void elog_cursor_time(struct smbios_log_entry *entry, char *buf,
+                             size_t len)
+{
+	snprintf(buf, len, "%02x%02x%02x%02x%02x%02x", entry->year,
+	         entry->month, entry->day, entry->hour, entry->minute,
+	         entry->second);
+}
+
+int elog_cursor_load(struct elog_cursor *cursor)
+{
+	char path[PATH_MAX];
+	char line[LINE_MAX];
+	unsigned int val;
+	int found = 0;
+	FILE *fp;
+
+	memset(cursor, 0, sizeof(*cursor));
+
+	if (data_file_path(path, sizeof(path), ELOG_CURSOR_FILE) < 0)
+		return -1;
+
+	fp = fopen(path, "r");
+	if (!fp)
+		return -1;
+
+	while (fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, "\n")] = '\0';
+		if (sscanf(line, "offset=%u", &val) == 1) {
+			cursor->offset = val;
+			found++;
+		} else if (sscanf(line, "last_offset=%u", &val) == 1) {
+			cursor->last_offset = val;
+			found++;
+		} else if (sscanf(line, "last_length=%u", &val) == 1) {
+			cursor->last_length = val;
+			found++;
+		} else if (sscanf(line, "last_sum=%x", &val) == 1) {
+			cursor->last_sum = val;
+			found++;
+		} else if (!strncmp(line, "last_time=", 10)) {
+			snprintf(cursor->last_time, sizeof(cursor->last_time),
+			         "%s", line + 10);
+			found++;
+		} else if (sscanf(line, "next_entry=%u", &val) == 1) {
+			cursor->next_entry = val;
+			found++;
+		}
+	}
+	fclose(fp);
+
+	if (found != 6) {
+		lprintf(LOG_DEBUG, "%s: Ignoring incomplete %s\n",
+		        __func__, path);
+		memset(cursor, 0, sizeof(*cursor));
+		return -1;
+	}
+
+	return 0;
+}
+
+int elog_cursor_save(const struct elog_cursor *cursor)
+{
+	char path[PATH_MAX];
+	struct file_replace rep;
+	FILE *fp;
+
+	if (data_file_path(path, sizeof(path), ELOG_CURSOR_FILE) < 0)
+		return -1;
+
+	fp = file_replace_begin(&rep, path, 0600);
+	if (!fp) {
+		lprintf(LOG_ERR, "Unable to create %s\n", path);
+		return -1;
+	}
+
+	fprintf(fp, "offset=%u\n", cursor->offset);
+	fprintf(fp, "last_offset=%u\n", cursor->last_offset);
+	fprintf(fp, "last_length=%u\n", cursor->last_length);
+	fprintf(fp, "last_sum=%08x\n", cursor->last_sum);
+	fprintf(fp, "last_time=%s\n", cursor->last_time);
+	fprintf(fp, "next_entry=%d\n", cursor->next_entry);
+
+	if (file_replace_commit(&rep) < 0) {
+		lprintf(LOG_ERR, "Unable to write %s\n", path);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * elog_cursor_match  -  check for last entry read at an offset
+ *
+ * @cursor:	cursor
+ * @elog_iter:	iterator over the current log
+ * @offset:	offset to look at
+ *
+ * On a match, @elog_iter is left pointing at the matching entry so that
+ * the next entry returned is the first unread one.
+ *
+ * returns 1 if the entry at @offset is the last entry read
+ * returns 0 otherwise
+ */
+static int elog_cursor_match(struct elog_cursor *cursor,
+                             struct smbios_eventlog_iterator *elog_iter,
+                             off_t offset)
+{
+	struct smbios_log_entry *entry;
+	char time[sizeof(cursor->last_time)];
+
+	if (smbios_eventlog_iterator_seek(elog_iter, offset) < 0)
+		return 0;
+
+	entry = smbios_eventlog_get_next_entry(elog_iter);
+	if (!entry || entry->length != cursor->last_length)
+		return 0;
+
+	elog_cursor_time(entry, time, sizeof(time));
+	if (strcmp(time, cursor->last_time) ||
+	    elog_cursor_sum(entry) != cursor->last_sum)
+		return 0;
+
+	return 1;
+}
+
+int elog_cursor_resume(struct elog_cursor *cursor,
+                       struct smbios_eventlog_iterator *elog_iter)
+{
+	struct smbios_log_entry *entry;
+	struct elog_cursor_clear *clears = NULL;
+	int num_clears = 0, i, ret = 0;
+	uint32_t skipped, total = 0;
+
+	if (!cursor->last_length)
+		goto elog_cursor_resume_exit;
+
+	if (elog_cursor_match(cursor, elog_iter, cursor->last_offset)) {
+		ret = 1;
+		goto elog_cursor_resume_exit;
+	}
+
+	/* the log was shrunk or cleared, find out by how much */
+	smbios_eventlog_iterator_reset(elog_iter);
+	while ((entry = smbios_eventlog_get_next_entry(elog_iter)) != NULL) {
+		if (entry->type != SMBIOS_EVENT_TYPE_LOGCLEAR ||
+		    entry->length < sizeof(*entry) + sizeof(skipped))
+			continue;
+
+		clears = mosys_realloc(clears,
+		                       (num_clears + 1) * sizeof(*clears));
+		memcpy(&skipped, entry->data, sizeof(skipped));
+		clears[num_clears].offset =
+			smbios_eventlog_get_offset(elog_iter);
+		clears[num_clears].skipped = skipped;
+		num_clears++;
+	}
+
+	/*
+	 * Every shrink since the last read moved the entry further towards
+	 * the start of the log, and appended a LOGCLEAR after it.
+	 */
+	for (i = num_clears - 1; i >= 0; i--) {
+		total += clears[i].skipped;
+		if (total > cursor->last_offset ||
+		    cursor->last_offset - total >= clears[i].offset)
+			continue;
+
+		if (elog_cursor_match(cursor, elog_iter,
+		                      cursor->last_offset - total)) {
+			lprintf(LOG_DEBUG, "%s: Log was shrunk by %u bytes\n",
+			        __func__, total);
+			cursor->last_offset -= total;
+			cursor->offset = cursor->last_offset +
+			                 cursor->last_length;
+			ret = 1;
+			goto elog_cursor_resume_exit;
+		}
+	}
+
+	lprintf(LOG_DEBUG, "%s: Last entry read is gone, reading whole log\n",
+	        __func__);
+
+elog_cursor_resume_exit:
+	free(clears);
+	if (!ret) {
+		memset(cursor, 0, sizeof(*cursor));
+		smbios_eventlog_iterator_reset(elog_iter);
+	}
+	return ret;
+}
+
+void elog_cursor_advance(struct elog_cursor *cursor, off_t offset,
+                         struct smbios_log_entry *entry, int next_entry)
+{
+	cursor->last_offset = offset;
+	cursor->last_length = entry->length;
+	cursor->last_sum = elog_cursor_sum(entry);
+	elog_cursor_time(entry, cursor->last_time, sizeof(cursor->last_time));
+	cursor->offset = offset + entry->length;
+	cursor->next_entry = next_entry;
+}
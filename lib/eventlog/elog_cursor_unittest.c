@@ -0,0 +1,266 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * elog_cursor_unittest.c: unit tests for the event log cursor
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cmockery.h"
+
+#include "mosys/platform.h"
+
+#include "lib/elog_cursor.h"
+#include "lib/elog_smbios.h"
+
+#define TEST_LOG_SIZE	256
+
+/* a log area, filled with entries one after another */
+struct test_log {
+	uint8_t data[TEST_LOG_SIZE];
+	size_t len;
+};
+
+static struct platform_intf *test_intf;
+
+static void log_init(struct test_log *log)
+{
+	memset(log->data, SMBIOS_EVENT_TYPE_ENDLOG, sizeof(log->data));
+	log->len = 0;
+}
+
+/*
+ * log_add  -  append an entry
+ *
+ * @log:	log to append to
+ * @type:	entry type
+ * @second:	timestamp seconds, in BCD, to tell entries apart
+ * @data:	32-bit entry data, e.g. boot count or bytes cleared
+ *
+ * returns offset of entry
+ */
+static size_t log_add(struct test_log *log, uint8_t type, uint8_t second,
+                      uint32_t data)
+{
+	struct smbios_log_entry *entry;
+	size_t offset = log->len;
+
+	entry = (struct smbios_log_entry *)&log->data[offset];
+	memset(entry, 0, sizeof(*entry));
+	entry->type = type;
+	entry->length = sizeof(*entry) + sizeof(data);
+	entry->year = 0x18;
+	entry->month = 0x01;
+	entry->day = 0x01;
+	entry->second = second;
+	memcpy(entry->data, &data, sizeof(data));
+	log->len += entry->length;
+
+	return offset;
+}
+
+static size_t log_add_boot(struct test_log *log, uint8_t second)
+{
+	return log_add(log, SMBIOS_EVENT_TYPE_BOOT, second, second);
+}
+
+/* log with entries starting at the given seconds, cursor after the last */
+static void log_read(struct test_log *log, struct elog_cursor *cursor,
+                     const uint8_t *seconds, int num)
+{
+	size_t offset = 0;
+	int i;
+
+	log_init(log);
+	for (i = 0; i < num; i++)
+		offset = log_add_boot(log, seconds[i]);
+
+	memset(cursor, 0, sizeof(*cursor));
+	elog_cursor_advance(cursor, offset,
+	                    (struct smbios_log_entry *)&log->data[offset], num);
+}
+
+/*
+ * resume  -  resume reading log and return second of next entry read
+ *
+ * returns timestamp seconds of first unread entry
+ * returns -1 if there is none
+ */
+static int resume(struct test_log *log, struct elog_cursor *cursor, int *ret)
+{
+	struct smbios_eventlog_iterator *elog_iter;
+	struct smbios_log_entry *entry;
+	int second = -1;
+
+	elog_iter = smbios_new_eventlog_iterator(test_intf, log->data,
+	                                         sizeof(log->data), 0, 0);
+	*ret = elog_cursor_resume(cursor, elog_iter);
+	entry = smbios_eventlog_get_next_entry(elog_iter);
+	if (entry)
+		second = entry->type == SMBIOS_EVENT_TYPE_LOGCLEAR ?
+		         0xcc : entry->second;
+	smbios_free_eventlog_iterator(elog_iter);
+
+	return second;
+}
+
+static void append_test(void **state)
+{
+	const uint8_t seconds[] = { 0x01, 0x02, 0x03 };
+	struct test_log log;
+	struct elog_cursor cursor;
+	int ret;
+
+	log_read(&log, &cursor, seconds, 3);
+
+	/* nothing new */
+	assert_int_equal(-1, resume(&log, &cursor, &ret));
+	assert_int_equal(1, ret);
+
+	log_add_boot(&log, 0x04);
+	log_add_boot(&log, 0x05);
+	assert_int_equal(0x04, resume(&log, &cursor, &ret));
+	assert_int_equal(1, ret);
+	assert_int_equal(3, cursor.next_entry);
+
+	/* no cursor saved yet, read from the start */
+	memset(&cursor, 0, sizeof(cursor));
+	assert_int_equal(0x01, resume(&log, &cursor, &ret));
+	assert_int_equal(0, ret);
+}
+
+static void shrink_test(void **state)
+{
+	const uint8_t seconds[] = { 0x01, 0x02, 0x03 };
+	struct test_log log;
+	struct elog_cursor cursor, saved;
+	size_t entry_len;
+	int ret;
+
+	log_read(&log, &cursor, seconds, 3);
+	saved = cursor;
+	entry_len = cursor.last_length;
+
+	/* the first entry was dropped, the others moved to the start */
+	log_init(&log);
+	log_add_boot(&log, 0x02);
+	log_add_boot(&log, 0x03);
+	log_add(&log, SMBIOS_EVENT_TYPE_LOGCLEAR, 0x10, entry_len);
+	log_add_boot(&log, 0x11);
+
+	assert_int_equal(0xcc, resume(&log, &cursor, &ret));
+	assert_int_equal(1, ret);
+	assert_int_equal(saved.last_offset - entry_len, cursor.last_offset);
+	assert_int_equal(cursor.last_offset + entry_len, cursor.offset);
+	assert_int_equal(saved.next_entry, cursor.next_entry);
+}
+
+static void multiple_shrink_test(void **state)
+{
+	const uint8_t seconds[] = { 0x01, 0x02, 0x03 };
+	struct test_log log;
+	struct elog_cursor cursor;
+	size_t entry_len;
+	int ret;
+
+	log_read(&log, &cursor, seconds, 3);
+	entry_len = cursor.last_length;
+
+	/* shrunk twice, by one entry each time, before reading again */
+	log_init(&log);
+	log_add_boot(&log, 0x03);
+	log_add(&log, SMBIOS_EVENT_TYPE_LOGCLEAR, 0x10, entry_len);
+	log_add(&log, SMBIOS_EVENT_TYPE_LOGCLEAR, 0x20, entry_len);
+
+	assert_int_equal(0xcc, resume(&log, &cursor, &ret));
+	assert_int_equal(1, ret);
+	assert_int_equal(0, cursor.last_offset);
+
+	/* the last entry read was dropped by the second shrink */
+	log_read(&log, &cursor, seconds, 3);
+	log_init(&log);
+	log_add(&log, SMBIOS_EVENT_TYPE_LOGCLEAR, 0x10, entry_len);
+	log_add(&log, SMBIOS_EVENT_TYPE_LOGCLEAR, 0x20, 3 * entry_len);
+	log_add_boot(&log, 0x21);
+
+	assert_int_equal(0xcc, resume(&log, &cursor, &ret));
+	assert_int_equal(0, ret);
+	assert_int_equal(0, cursor.last_length);
+	assert_int_equal(0, cursor.next_entry);
+}
+
+static void clear_test(void **state)
+{
+	const uint8_t seconds[] = { 0x01, 0x02, 0x03 };
+	struct test_log log;
+	struct elog_cursor cursor;
+	size_t log_len;
+	int ret;
+
+	log_read(&log, &cursor, seconds, 3);
+	log_len = log.len;
+
+	/* everything was cleared, read the whole log again */
+	log_init(&log);
+	log_add(&log, SMBIOS_EVENT_TYPE_LOGCLEAR, 0x10, log_len);
+	log_add_boot(&log, 0x11);
+
+	assert_int_equal(0xcc, resume(&log, &cursor, &ret));
+	assert_int_equal(0, ret);
+	assert_int_equal(0, cursor.last_length);
+	assert_int_equal(0, cursor.next_entry);
+
+	/* a new log happens to have an entry where the last one read was */
+	log_read(&log, &cursor, seconds, 3);
+	log_init(&log);
+	log_add_boot(&log, 0x31);
+	log_add_boot(&log, 0x32);
+	log_add_boot(&log, 0x33);
+
+	assert_int_equal(0x31, resume(&log, &cursor, &ret));
+	assert_int_equal(0, ret);
+}
+
+int elog_cursor_unittest(struct platform_intf *intf)
+{
+	UnitTest tests[] = {
+		unit_test(append_test),
+		unit_test(shrink_test),
+		unit_test(multiple_shrink_test),
+		unit_test(clear_test),
+	};
+
+	test_intf = intf;
+	return run_tests(tests);
+}
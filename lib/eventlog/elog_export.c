@@ -0,0 +1,174 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * elog_export.c: event log container for offline decoding
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mosys/alloc.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "lib/elog_export.h"
+#include "lib/file.h"
+
+/* offset of the log area, the header padded to ELOG_EXPORT_ALIGN */
+#define ELOG_EXPORT_LOG_OFFSET						\
+	((sizeof(struct elog_export_header) + ELOG_EXPORT_ALIGN - 1) &	\
+	 ~(ELOG_EXPORT_ALIGN - 1))
+
+int elog_export(struct platform_intf *intf, const char *path)
+{
+	struct elog_export_header header;
+	uint8_t pad[ELOG_EXPORT_ALIGN] = { 0 };
+	uint8_t *data;
+	size_t length;
+	off_t header_offset, data_offset;
+	struct file_replace rep;
+	FILE *fp;
+	int rc = -1;
+
+	if (!intf->cb->eventlog || !intf->cb->eventlog->fetch)
+		return -1;
+
+	if (intf->cb->eventlog->fetch(intf, &data, &length, &header_offset,
+				      &data_offset))
+		return -1;
+
+	memset(&header, 0, sizeof(header));
+	header.magic = ELOG_EXPORT_MAGIC;
+	header.version = ELOG_EXPORT_VERSION;
+	header.header_size = sizeof(header);
+	header.log_offset = ELOG_EXPORT_LOG_OFFSET;
+	header.log_length = length;
+	header.header_offset = header_offset;
+	header.data_offset = data_offset;
+	strncpy(header.platform, intf->name, sizeof(header.platform) - 1);
+
+	fp = file_replace_begin(&rep, path, 0644);
+	if (!fp) {
+		lprintf(LOG_ERR, "Unable to create %s\n", path);
+		goto elog_export_exit;
+	}
+
+	fwrite(&header, sizeof(header), 1, fp);
+	fwrite(pad, header.log_offset - sizeof(header), 1, fp);
+	fwrite(data, length, 1, fp);
+
+	if (file_replace_commit(&rep) < 0) {
+		lprintf(LOG_ERR, "Unable to write %s\n", path);
+		goto elog_export_exit;
+	}
+
+	rc = 0;
+
+elog_export_exit:
+	free(data);
+	return rc;
+}
+
+int elog_import(const char *path, struct elog_export_log *log)
+{
+	const struct elog_export_header *header;
+	struct stat st;
+	uint8_t *map;
+	int fd, rc = -1;
+
+	memset(log, 0, sizeof(*log));
+
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		lperror(LOG_ERR, "Unable to open %s", path);
+		return -1;
+	}
+
+	if (fstat(fd, &st) < 0 || st.st_size < sizeof(*header)) {
+		lprintf(LOG_ERR, "%s: not an exported event log\n", path);
+		close(fd);
+		return -1;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		lperror(LOG_ERR, "Unable to map %s", path);
+		return -1;
+	}
+
+	header = (const struct elog_export_header *)map;
+	if (header->magic != ELOG_EXPORT_MAGIC) {
+		lprintf(LOG_ERR, "%s: not an exported event log\n", path);
+		goto elog_import_exit;
+	}
+
+	if (header->version != ELOG_EXPORT_VERSION ||
+	    header->header_size < sizeof(*header)) {
+		lprintf(LOG_ERR, "%s: unsupported version %u\n", path,
+		        header->version);
+		goto elog_import_exit;
+	}
+
+	if (header->log_offset < header->header_size ||
+	    header->log_offset > st.st_size ||
+	    header->log_length > st.st_size - header->log_offset ||
+	    header->data_offset > header->log_length ||
+	    header->header_offset > header->data_offset ||
+	    memchr(header->platform, '\0', sizeof(header->platform)) == NULL) {
+		lprintf(LOG_ERR, "%s: corrupt header\n", path);
+		goto elog_import_exit;
+	}
+
+	strcpy(log->platform, header->platform);
+	log->length = header->log_length;
+	log->header_offset = header->header_offset;
+	log->data_offset = header->data_offset;
+	log->data = map + header->log_offset;
+	log->map = map;
+	log->map_length = st.st_size;
+	return 0;
+
+elog_import_exit:
+	munmap(map, st.st_size);
+	return rc;
+}
+
+void elog_import_free(struct elog_export_log *log)
+{
+	if (log->map)
+		munmap(log->map, log->map_length);
+	memset(log, 0, sizeof(*log));
+}
@@ -0,0 +1,400 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * elog_query.c: filter and aggregate event log entries
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mosys/alloc.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "lib/elog_query.h"
+#include "lib/elog_smbios.h"
+#include "lib/smbios_tables.h"
+
+/* entry selected by a query, with the key it is grouped by */
+struct elog_query_match {
+	time_t hour;
+	uint8_t type;
+	int entry;
+};
+
+/*
+ * elog_entry_listed  -  count the entries eventlog list shows for an entry
+ *
+ * @intf:	platform interface
+ * @entry:	log entry
+ *
+ * OEM entries which fail verification are not listed, entries handled by
+ * print_multi are listed as as many entries as it prints.
+ *
+ * returns the number of entry numbers the entry takes
+ */
+static int elog_entry_listed(struct platform_intf *intf,
+			     struct smbios_log_entry *entry)
+{
+	int count;
+
+	if (entry->type >= SMBIOS_EVENT_TYPE_OEM &&
+	    intf->cb->eventlog->verify &&
+	    !intf->cb->eventlog->verify(intf, entry))
+		return 0;
+
+	if (intf->cb->eventlog->print_multi) {
+		count = intf->cb->eventlog->print_multi(intf, entry, -1);
+		if (count > 0)
+			return count;
+	}
+
+	return 1;
+}
+
+/*
+ * elog_time_index_build  -  sample the time of every few entries
+ *
+ * @intf:	platform interface
+ * @elog_iter:	iterator over the log
+ * @index:	index to fill in
+ *
+ * Entries are only walked, their timestamps are decoded for the samples.
+ * An entry with an invalid timestamp is not sampled, the next valid one is,
+ * and neither is an entry which is not listed.
+ */
+static void elog_time_index_build(struct platform_intf *intf,
+				  struct smbios_eventlog_iterator *elog_iter,
+				  struct elog_time_index *index)
+{
+	struct smbios_log_entry *entry;
+	int num = 0, listed, alloc = 0, due = 1;
+	time_t time;
+
+	memset(index, 0, sizeof(*index));
+	index->ordered = 1;
+
+	smbios_eventlog_iterator_reset(elog_iter);
+	while ((entry = smbios_eventlog_get_next_entry(elog_iter)) != NULL) {
+		if (entry->length == 0)
+			break;
+
+		listed = elog_entry_listed(intf, entry);
+		if (!listed)
+			continue;
+
+		if (num / ELOG_TIME_INDEX_STRIDE !=
+		    (num + listed - 1) / ELOG_TIME_INDEX_STRIDE ||
+		    num % ELOG_TIME_INDEX_STRIDE == 0)
+			due = 1;
+		num += listed;
+		if (!due || smbios_eventlog_event_time(entry, &time) < 0)
+			continue;
+
+		if (index->count == alloc) {
+			alloc = alloc ? alloc * 2 : 16;
+			index->time = mosys_realloc(index->time,
+						    alloc * sizeof(*index->time));
+			index->offset = mosys_realloc(index->offset,
+					alloc * sizeof(*index->offset));
+			index->entry = mosys_realloc(index->entry,
+					alloc * sizeof(*index->entry));
+		}
+
+		if (index->count && time < index->time[index->count - 1])
+			index->ordered = 0;
+		index->time[index->count] = time;
+		index->offset[index->count] = smbios_eventlog_get_offset(elog_iter);
+		index->entry[index->count] = num - listed;
+		index->count++;
+		due = 0;
+	}
+
+	smbios_eventlog_iterator_reset(elog_iter);
+}
+
+static void elog_time_index_free(struct elog_time_index *index)
+{
+	free(index->time);
+	free(index->offset);
+	free(index->entry);
+}
+
+/*
+ * elog_time_index_bounds  -  find which samples a query's matches lie between
+ *
+ * @index:	time index of the log
+ * @query:	query to be run
+ * @first:	pointer to store the last sample known to precede all matches
+ *		in, -1 if matches may precede all samples
+ * @end:	pointer to store the first sample known to follow all matches
+ *		in, index->count if matches may follow all samples
+ *
+ * Times are only used if the samples are in order, which holds as long as
+ * events were logged in order. Entry numbers can be used regardless.
+ */
+static void elog_time_index_bounds(const struct elog_time_index *index,
+				   const struct elog_query *query,
+				   int *first, int *end)
+{
+	int lo, hi, mid;
+
+	/* last sample logged before since, or numbered up to first_entry */
+	lo = -1;
+	hi = index->count - 1;
+	while (lo < hi) {
+		mid = hi - (hi - lo) / 2;
+		if (index->entry[mid] <= query->first_entry ||
+		    (index->ordered && query->since != ELOG_QUERY_NO_TIME &&
+		     index->time[mid] < query->since))
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	*first = lo;
+
+	/* first sample logged after until, or numbered past last_entry */
+	lo = *first + 1;
+	hi = index->count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if ((query->last_entry >= 0 &&
+		     index->entry[mid] > query->last_entry) ||
+		    (index->ordered && query->until != ELOG_QUERY_NO_TIME &&
+		     index->time[mid] > query->until))
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	*end = lo;
+}
+
+int elog_columns_decode(struct platform_intf *intf, struct elog_columns *cols,
+                        const struct elog_query *query)
+{
+	uint8_t *log;
+	size_t length;
+	off_t header_offset, data_offset;
+
+	memset(cols, 0, sizeof(*cols));
+
+	if (!intf->cb->eventlog || !intf->cb->eventlog->fetch)
+		return -1;
+
+	if (intf->cb->eventlog->fetch(intf, &log, &length, &header_offset,
+				      &data_offset))
+		return -1;
+
+	if (elog_columns_decode_log(intf, cols, query, log, length,
+				    header_offset, data_offset) < 0) {
+		free(log);
+		return -1;
+	}
+
+	cols->log_owned = 1;
+	return 0;
+}
+
+int elog_columns_decode_log(struct platform_intf *intf,
+                            struct elog_columns *cols,
+                            const struct elog_query *query,
+                            uint8_t *log, size_t length,
+                            off_t header_offset, off_t data_offset)
+{
+	struct smbios_eventlog_iterator *elog_iter;
+	struct smbios_log_entry *entry;
+	struct elog_time_index index;
+	off_t start, end;
+	int alloc, num = 0, listed, first, last;
+
+	memset(cols, 0, sizeof(*cols));
+	cols->log = log;
+	cols->length = length;
+
+	elog_iter = smbios_new_eventlog_iterator(intf, cols->log, cols->length,
+						 header_offset, data_offset);
+
+	if (intf->cb->eventlog->verify_header &&
+	    intf->cb->eventlog->verify_header(
+			smbios_eventlog_get_header(elog_iter)) < 0) {
+		smbios_free_eventlog_iterator(elog_iter);
+		elog_columns_free(cols);
+		return -1;
+	}
+
+	/* narrow down the part of the log which the query may match */
+	start = data_offset;
+	end = cols->length;
+	if (query && (query->since != ELOG_QUERY_NO_TIME ||
+		      query->until != ELOG_QUERY_NO_TIME ||
+		      query->first_entry > 0 || query->last_entry >= 0)) {
+		elog_time_index_build(intf, elog_iter, &index);
+		elog_time_index_bounds(&index, query, &first, &last);
+		if (first >= 0) {
+			start = index.offset[first];
+			num = index.entry[first];
+			smbios_eventlog_iterator_seek(elog_iter, start);
+		}
+		if (last < index.count)
+			end = index.offset[last];
+		elog_time_index_free(&index);
+	}
+
+	/* every entry takes at least the size of its header */
+	alloc = (end - start) / sizeof(*entry) + 1;
+	cols->type = mosys_malloc(alloc * sizeof(*cols->type));
+	cols->time = mosys_malloc(alloc * sizeof(*cols->time));
+	cols->offset = mosys_malloc(alloc * sizeof(*cols->offset));
+	cols->entry = mosys_malloc(alloc * sizeof(*cols->entry));
+
+	while ((entry = smbios_eventlog_get_next_entry(elog_iter)) != NULL) {
+		if (entry->length == 0) {
+			lprintf(LOG_ERR, "Zero-length eventlog entry "
+					 "detected.\n");
+			break;
+		}
+
+		if (smbios_eventlog_get_offset(elog_iter) >= end ||
+		    cols->count == alloc)
+			break;
+
+		listed = elog_entry_listed(intf, entry);
+		if (!listed)
+			continue;
+
+		cols->type[cols->count] = entry->type;
+		if (smbios_eventlog_event_time(entry,
+					       &cols->time[cols->count]) < 0)
+			cols->time[cols->count] = ELOG_QUERY_NO_TIME;
+		cols->offset[cols->count] = smbios_eventlog_get_offset(elog_iter);
+		cols->entry[cols->count] = num;
+		num += listed;
+		cols->count++;
+	}
+	smbios_free_eventlog_iterator(elog_iter);
+
+	return 0;
+}
+
+void elog_columns_free(struct elog_columns *cols)
+{
+	free(cols->type);
+	free(cols->time);
+	free(cols->offset);
+	free(cols->entry);
+	if (cols->log_owned)
+		free(cols->log);
+	memset(cols, 0, sizeof(*cols));
+}
+
+void elog_query_init(struct elog_query *query)
+{
+	memset(query, 0, sizeof(*query));
+	query->since = ELOG_QUERY_NO_TIME;
+	query->until = ELOG_QUERY_NO_TIME;
+	query->last_entry = -1;
+	query->aggregate = ELOG_QUERY_COUNT;
+}
+
+static int elog_query_match_cmp(const void *a, const void *b)
+{
+	const struct elog_query_match *x = a, *y = b;
+
+	if (x->hour != y->hour)
+		return x->hour < y->hour ? -1 : 1;
+	if (x->type != y->type)
+		return x->type < y->type ? -1 : 1;
+	return x->entry - y->entry;
+}
+
+int elog_query_run(const struct elog_columns *cols,
+                   const struct elog_query *query,
+                   struct elog_query_row **rows)
+{
+	struct elog_query_match *matches;
+	struct elog_query_row *row = NULL;
+	int timed = query->since != ELOG_QUERY_NO_TIME ||
+		    query->until != ELOG_QUERY_NO_TIME ||
+		    query->aggregate == ELOG_QUERY_HOURLY;
+	int i, num = 0, num_rows = 0;
+
+	*rows = NULL;
+
+	if (cols->count == 0)
+		return 0;
+
+	/* filter, one column at a time for each entry */
+	matches = mosys_malloc(cols->count * sizeof(*matches));
+	for (i = 0; i < cols->count; i++) {
+		time_t time = cols->time[i];
+
+		if (cols->entry[i] < query->first_entry ||
+		    (query->last_entry >= 0 &&
+		     cols->entry[i] > query->last_entry))
+			continue;
+		if (query->type_filter && !query->types[cols->type[i]])
+			continue;
+		if (timed && time == ELOG_QUERY_NO_TIME)
+			continue;
+		if (query->since != ELOG_QUERY_NO_TIME && time < query->since)
+			continue;
+		if (query->until != ELOG_QUERY_NO_TIME && time > query->until)
+			continue;
+
+		matches[num].hour = 0;
+		if (query->aggregate == ELOG_QUERY_HOURLY)
+			matches[num].hour = time - time % 3600;
+		matches[num].type = cols->type[i];
+		matches[num].entry = i;
+		num++;
+	}
+
+	qsort(matches, num, sizeof(*matches), elog_query_match_cmp);
+
+	/* matches with the same key are adjacent now, one row per key */
+	for (i = 0; i < num; i++) {
+		if (!row || row->hour != matches[i].hour ||
+		    row->type != matches[i].type) {
+			*rows = mosys_realloc(*rows,
+					      (num_rows + 1) * sizeof(**rows));
+			row = &(*rows)[num_rows++];
+			row->type = matches[i].type;
+			row->hour = matches[i].hour;
+			row->count = 0;
+			row->first = matches[i].entry;
+		}
+
+		row->count++;
+		row->last = matches[i].entry;
+	}
+
+	free(matches);
+	return num_rows;
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * elog_query_unittest.c: unit tests for event log queries
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmockery.h"
+
+#include "mosys/alloc.h"
+#include "mosys/platform.h"
+
+#include "lib/elog.h"
+#include "lib/elog_query.h"
+#include "lib/smbios_tables.h"
+
+#define TEST_LOG_SIZE	256
+
+/* 2018-01-01 00:00:00 UTC */
+#define TEST_TIME	1514764800
+
+static uint8_t test_log[TEST_LOG_SIZE];
+static size_t test_log_len;
+
+/*
+ * log_add  -  append an entry with a checksum
+ *
+ * @type:	entry type
+ * @hour:	timestamp hour, in BCD
+ * @data:	entry data
+ * @size:	size of entry data
+ * @csum_ok:	non-zero to make the checksum valid
+ */
+static void log_add(uint8_t type, uint8_t hour, const void *data, size_t size,
+                    int csum_ok)
+{
+	struct smbios_log_entry *entry;
+	size_t i;
+	uint8_t sum = 0;
+
+	entry = (struct smbios_log_entry *)&test_log[test_log_len];
+	memset(entry, 0, sizeof(*entry));
+	entry->type = type;
+	entry->length = sizeof(*entry) + size + 1;
+	entry->year = 0x18;
+	entry->month = 0x01;
+	entry->day = 0x01;
+	entry->hour = hour;
+	memcpy(entry->data, data, size);
+
+	for (i = 0; i < entry->length - 1u; i++)
+		sum += ((uint8_t *)entry)[i];
+	entry->data[size] = -sum + (csum_ok ? 0 : 1);
+
+	test_log_len += entry->length;
+}
+
+static int test_fetch(struct platform_intf *intf, uint8_t **data,
+                      size_t *length, off_t *header_offset,
+                      off_t *data_offset)
+{
+	*data = mosys_malloc(sizeof(test_log));
+	memcpy(*data, test_log, sizeof(test_log));
+	*length = sizeof(test_log);
+	*header_offset = 0;
+	*data_offset = 0;
+	return 0;
+}
+
+static struct eventlog_cb test_eventlog_cb = {
+	.print_multi	= &elog_print_multi,
+	.verify		= &elog_verify,
+	.fetch		= &test_fetch,
+};
+
+static struct platform_cb test_cb = {
+	.eventlog	= &test_eventlog_cb,
+};
+
+static struct platform_intf test_intf = {
+	.name		= "Test",
+	.cb		= &test_cb,
+};
+
+/*
+ * Log of a boot, an OEM entry with a bad checksum, ME extended data which
+ * is listed as six entries, and two more boots an hour apart.
+ */
+static void log_build(void)
+{
+	const struct elog_event_data_me_extended me = {
+		.current_working_state = 0x05,
+		.operation_state = 0x00,
+		.operation_mode = 0x02,
+		.error_code = 0x00,	/* not listed */
+		.progress_code = ELOG_ME_PHASE_ROM,
+		.current_pmevent = 0x00,
+		.current_state = 0x00,
+	};
+	const uint32_t boot = 1;
+
+	memset(test_log, SMBIOS_EVENT_TYPE_ENDLOG, sizeof(test_log));
+	test_log_len = 0;
+
+	log_add(SMBIOS_EVENT_TYPE_BOOT, 0x00, &boot, sizeof(boot), 1);
+	log_add(ELOG_TYPE_OS_EVENT, 0x00, &boot, sizeof(boot), 0);
+	log_add(ELOG_TYPE_MANAGEMENT_ENGINE_EXT, 0x00, &me, sizeof(me), 1);
+	log_add(SMBIOS_EVENT_TYPE_BOOT, 0x01, &boot, sizeof(boot), 1);
+	log_add(SMBIOS_EVENT_TYPE_BOOT, 0x02, &boot, sizeof(boot), 1);
+}
+
+/* columns for the rows given, entries numbered from 0 */
+static void cols_build(struct elog_columns *cols, const uint8_t *types,
+                       const time_t *times, int count)
+{
+	int i;
+
+	memset(cols, 0, sizeof(*cols));
+	cols->count = count;
+	cols->type = mosys_malloc(count * sizeof(*cols->type));
+	cols->time = mosys_malloc(count * sizeof(*cols->time));
+	cols->offset = mosys_malloc(count * sizeof(*cols->offset));
+	cols->entry = mosys_malloc(count * sizeof(*cols->entry));
+	for (i = 0; i < count; i++) {
+		cols->type[i] = types[i];
+		cols->time[i] = times[i];
+		cols->offset[i] = 0;
+		cols->entry[i] = i;
+	}
+}
+
+static const uint8_t run_types[] = { 0x17, 0x17, 0x16, 0x17, 0x16, 0x17 };
+static const time_t run_times[] = {
+	TEST_TIME,
+	TEST_TIME + 60,
+	TEST_TIME + 3600,
+	ELOG_QUERY_NO_TIME,
+	TEST_TIME + 3660,
+	TEST_TIME + 7200,
+};
+
+static void run_count_test(void **state)
+{
+	struct elog_columns cols;
+	struct elog_query query;
+	struct elog_query_row *rows;
+
+	cols_build(&cols, run_types, run_times, 6);
+	elog_query_init(&query);
+
+	/* one row per type, in type order */
+	assert_int_equal(2, elog_query_run(&cols, &query, &rows));
+	assert_int_equal(0x16, rows[0].type);
+	assert_int_equal(2, rows[0].count);
+	assert_int_equal(2, rows[0].first);
+	assert_int_equal(4, rows[0].last);
+	assert_int_equal(0x17, rows[1].type);
+	assert_int_equal(4, rows[1].count);
+	assert_int_equal(0, rows[1].first);
+	assert_int_equal(5, rows[1].last);
+	free(rows);
+
+	/* type filter */
+	query.type_filter = 1;
+	query.types[0x16] = 1;
+	assert_int_equal(1, elog_query_run(&cols, &query, &rows));
+	assert_int_equal(0x16, rows[0].type);
+	assert_int_equal(2, rows[0].count);
+	free(rows);
+
+	/* entry range */
+	elog_query_init(&query);
+	query.first_entry = 1;
+	query.last_entry = 3;
+	assert_int_equal(2, elog_query_run(&cols, &query, &rows));
+	assert_int_equal(1, rows[0].count);
+	assert_int_equal(2, rows[1].count);
+	assert_int_equal(1, rows[1].first);
+	assert_int_equal(3, rows[1].last);
+	free(rows);
+
+	/* nothing matches */
+	query.first_entry = 6;
+	query.last_entry = -1;
+	assert_int_equal(0, elog_query_run(&cols, &query, &rows));
+	free(rows);
+
+	elog_columns_free(&cols);
+}
+
+static void run_time_test(void **state)
+{
+	struct elog_columns cols;
+	struct elog_query query;
+	struct elog_query_row *rows;
+
+	cols_build(&cols, run_types, run_times, 6);
+
+	/* bounds are inclusive, entries without a time never match */
+	elog_query_init(&query);
+	query.since = TEST_TIME + 60;
+	query.until = TEST_TIME + 3660;
+	assert_int_equal(2, elog_query_run(&cols, &query, &rows));
+	assert_int_equal(0x16, rows[0].type);
+	assert_int_equal(2, rows[0].count);
+	assert_int_equal(0x17, rows[1].type);
+	assert_int_equal(1, rows[1].count);
+	assert_int_equal(1, rows[1].first);
+	free(rows);
+
+	/* rows by hour, then by type */
+	elog_query_init(&query);
+	query.aggregate = ELOG_QUERY_HOURLY;
+	assert_int_equal(3, elog_query_run(&cols, &query, &rows));
+	assert_true(rows[0].hour == TEST_TIME);
+	assert_int_equal(0x17, rows[0].type);
+	assert_int_equal(2, rows[0].count);
+	assert_true(rows[1].hour == TEST_TIME + 3600);
+	assert_int_equal(0x16, rows[1].type);
+	assert_int_equal(2, rows[1].count);
+	assert_true(rows[2].hour == TEST_TIME + 7200);
+	assert_int_equal(0x17, rows[2].type);
+	assert_int_equal(1, rows[2].count);
+	free(rows);
+
+	elog_columns_free(&cols);
+}
+
+static void decode_numbering_test(void **state)
+{
+	struct elog_columns cols;
+	struct elog_query query;
+	struct elog_query_row *rows;
+
+	log_build();
+
+	/* numbered like eventlog list */
+	assert_int_equal(0, elog_columns_decode(&test_intf, &cols, NULL));
+	assert_int_equal(4, cols.count);
+	assert_int_equal(SMBIOS_EVENT_TYPE_BOOT, cols.type[0]);
+	assert_int_equal(0, cols.entry[0]);
+	assert_int_equal(ELOG_TYPE_MANAGEMENT_ENGINE_EXT, cols.type[1]);
+	assert_int_equal(1, cols.entry[1]);
+	assert_int_equal(7, cols.entry[2]);
+	assert_int_equal(8, cols.entry[3]);
+	assert_true(cols.time[3] == TEST_TIME + 7200);
+	elog_columns_free(&cols);
+
+	/* a query by entry number uses the same numbers */
+	elog_query_init(&query);
+	query.first_entry = 7;
+	query.last_entry = 7;
+	assert_int_equal(0, elog_columns_decode(&test_intf, &cols, &query));
+	assert_int_equal(1, elog_query_run(&cols, &query, &rows));
+	assert_int_equal(SMBIOS_EVENT_TYPE_BOOT, rows[0].type);
+	assert_int_equal(1, rows[0].count);
+	assert_int_equal(7, cols.entry[rows[0].first]);
+	free(rows);
+	elog_columns_free(&cols);
+}
+
+int elog_query_unittest(void)
+{
+	UnitTest tests[] = {
+		unit_test(run_count_test),
+		unit_test(run_time_test),
+		unit_test(decode_numbering_test),
+	};
+
+	return run_tests(tests);
+}
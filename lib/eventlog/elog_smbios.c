@@ -33,7 +33,7 @@
  * eventlog.c: SMBIOS event log access.
  */
 
-#define _XOPEN_SOURCE 600 /* for strptime + snprintf */
+#define _XOPEN_SOURCE 600 /* for localtime_r + snprintf */
 #include <stdlib.h>
 #include <inttypes.h>
 #include <unistd.h>
@@ -61,6 +61,7 @@ struct smbios_eventlog_iterator {
 	int log_area_length;  /* length of log */
 	int header_offset;    /* offset into log area to read the header. */
 	int data_offset;      /* offset into log area of first data element */
+	int start_offset;     /* offset of entry to start iterating at */
 	int current_offset;   /* current offset into log_area */
 	uint8_t *log_area;    /* log area */
 };
@@ -127,6 +128,7 @@ int smbios_eventlog_iterator_reset(struct smbios_eventlog_iterator *elog_iter)
 		return -1;
 
 	elog_iter->current_offset = -1;
+	elog_iter->start_offset = elog_iter->data_offset;
 
 	return 0;
 }
@@ -153,7 +155,7 @@ struct smbios_log_entry *smbios_eventlog_get_next_entry(
 	if (elog_iter->current_offset < 0) {
 		/* If current_offset is pointing "before" the first entry move
 		 * to first entry. */
-		next_offset = elog_iter->data_offset;
+		next_offset = elog_iter->start_offset;
 	} else {
 		/* Point next_offset to the next entry. */
 		entry =(void *)&elog_iter->log_area[elog_iter->current_offset];
@@ -189,6 +191,47 @@ struct smbios_log_entry *smbios_eventlog_get_next_entry(
 	return entry;
 }
 
+/*
+ * smbios_eventlog_iterator_seek - point the iterator "before" the entry at
+ *                                 a given offset.
+ *
+ * @elog_iter:   eventlog iterator to move
+ * @offset:      offset into log area of entry to be returned next
+ *
+ * Entries before @offset are skipped without being looked at, so @offset
+ * must be the offset of an entry obtained from an earlier walk of the same
+ * log.
+ *
+ * returns < 0 on error, 0 on success.
+ */
+int smbios_eventlog_iterator_seek(struct smbios_eventlog_iterator *elog_iter,
+				  off_t offset)
+{
+	if (elog_iter == NULL || offset < elog_iter->data_offset ||
+	    offset >= elog_iter->log_area_length)
+		return -1;
+
+	elog_iter->current_offset = -1;
+	elog_iter->start_offset = offset;
+
+	return 0;
+}
+
+/*
+ * smbios_eventlog_get_offset - retrieve offset of current event log entry
+ *
+ * @elog_iter:   eventlog iterator
+ *
+ * returns offset into log area of current entry, < 0 if there is none.
+ */
+off_t smbios_eventlog_get_offset(struct smbios_eventlog_iterator *elog_iter)
+{
+	if (elog_iter == NULL)
+		return -1;
+
+	return elog_iter->current_offset;
+}
+
 /*
  * smbios_eventlog_get_current_entry - retrieve current event log entry
  *
@@ -286,6 +329,7 @@ void smbios_eventlog_print_timestamp(struct platform_intf *intf,
 				     struct kv_pair *kv)
 {
 	char tm_string[40];
+	struct tm tm;
 	time_t time;
 
 	if (!intf || !entry || !kv)
@@ -303,12 +347,29 @@ void smbios_eventlog_print_timestamp(struct platform_intf *intf,
 	}
 
 	strftime(tm_string, sizeof(tm_string),
-		 "%Y-%m-%d %H:%M:%S", localtime(&time));
+		 "%Y-%m-%d %H:%M:%S", localtime_r(&time, &tm));
 
 	/* print the timestamp */
 	kv_pair_add(kv, "timestamp", tm_string);
 }
 
+/* Every byte with two BCD digits maps to their value, all others to 0xff */
+#define BCD_ROW(tens)							\
+	(tens) * 10 + 0, (tens) * 10 + 1, (tens) * 10 + 2,		\
+	(tens) * 10 + 3, (tens) * 10 + 4, (tens) * 10 + 5,		\
+	(tens) * 10 + 6, (tens) * 10 + 7, (tens) * 10 + 8,		\
+	(tens) * 10 + 9, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+
+static const uint8_t bcd_to_bin[256] = {
+	BCD_ROW(0), BCD_ROW(1), BCD_ROW(2), BCD_ROW(3), BCD_ROW(4),
+	BCD_ROW(5), BCD_ROW(6), BCD_ROW(7), BCD_ROW(8), BCD_ROW(9),
+	[0xa0 ... 0xff] = 0xff,
+};
+
+/* Days in a non-leap year before the first of each month */
+static const uint16_t days_before_month[12] = {
+	0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334,
+};
 
 /*
  * smbios_eventlog_event_time - obtain time of smbios event entry in
@@ -317,36 +378,42 @@ void smbios_eventlog_print_timestamp(struct platform_intf *intf,
  * @entry - smbios event
  * @time - time_t variable to fill in
  *
+ * The timestamp is taken to be UTC, and fields are range checked the way
+ * strptime() does, so a day past the end of its month rolls over into the
+ * next one. Years 69 to 99 are in the 20th century, others in the 21st.
+ *
  * returns 0 on succes, < 0 on failure
  */
 int smbios_eventlog_event_time(struct smbios_log_entry *entry, time_t *time)
 {
-	int ret;
-	struct tm tm;
-	char tm_string[20];
-	const char *tm_format = "%y-%m-%d%t%H:%M:%S";
+	int year, month, day, hour, minute, second;
+	long days;
 
 	MOSYS_DCHECK(time);
 
-	ret = 0;
-	/* make certain _all_ members of tm get initialized */
-	memset(&tm, 0, sizeof(tm));
-	snprintf(tm_string, sizeof(tm_string), "%02x-%02x-%02x %02x:%02x:%02x",
-		 entry->year, entry->month, entry->day,
-		 entry->hour, entry->minute, entry->second);
-
-	if (strptime(tm_string, tm_format, &tm) == NULL) {
-		ret = -1;
-	} else {
-		/* Set DST flag to -1 to indicate "not available" and let
-		 * system determine if DST is on based on date */
-		tm.tm_isdst = -1;
+	year = bcd_to_bin[entry->year];
+	month = bcd_to_bin[entry->month];
+	day = bcd_to_bin[entry->day];
+	hour = bcd_to_bin[entry->hour];
+	minute = bcd_to_bin[entry->minute];
+	second = bcd_to_bin[entry->second];
 
-		*time = mktime(&tm);
-		*time += tm.__tm_gmtoff; /* force adjust for timezone */
-	}
+	if (year > 99 || month < 1 || month > 12 || day < 1 || day > 31 ||
+	    hour > 23 || minute > 59 || second > 61)
+		return -1;
 
-	return ret;
+	year += year < 69 ? 2000 : 1900;
+
+	/* days since 1970-01-01, counting leap days of earlier years */
+	days = 365L * (year - 1970) +
+	       (year - 1) / 4 - (year - 1) / 100 + (year - 1) / 400 -
+	       (1969 / 4 - 1969 / 100 + 1969 / 400) +
+	       days_before_month[month - 1] + day - 1;
+	if (month > 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))
+		days++;
+
+	*time = ((days * 24 + hour) * 60 + minute) * 60 + second;
+	return 0;
 }
 
 /*
@@ -367,10 +434,6 @@ int smbios_eventlog_foreach_event(struct platform_intf *intf,
 	uint8_t *data;
 	size_t length;
 	off_t header_offset, data_offset;
-	struct smbios_eventlog_iterator *elog_iter;
-	struct smbios_log_entry *entry;
-	int complete;
-	int ret;
 
 	MOSYS_DCHECK(intf);
 	MOSYS_DCHECK(callback);
@@ -380,6 +443,41 @@ int smbios_eventlog_foreach_event(struct platform_intf *intf,
 		return -1;
 	}
 
+	return smbios_eventlog_foreach_event_in(intf, data, length,
+						header_offset, data_offset,
+						verify, callback, arg);
+}
+
+/*
+ * smbios_eventlog_foreach_event_in - call callback for each event in the
+ *                                    given SMBIOS eventlog area.
+ *
+ * @intf - platform interface
+ * @data - log area
+ * @length - length of log area
+ * @header_offset - offset into log area of the header
+ * @data_offset - offset into log area of the first event
+ * @verify - optional function to call to verify the eventlog metadata
+ * @callback - function to call for each log entry
+ * @arg - optional argument to pass to callback
+ *
+ * returns the aggregation (OR) of return codes for each call to callback.
+ */
+int smbios_eventlog_foreach_event_in(struct platform_intf *intf,
+                                     uint8_t *data, size_t length,
+                                     off_t header_offset, off_t data_offset,
+                                     smbios_eventlog_verify_header verify,
+                                     smbios_eventlog_callback callback,
+                                     void *arg)
+{
+	struct smbios_eventlog_iterator *elog_iter;
+	struct smbios_log_entry *entry;
+	int complete;
+	int ret;
+
+	MOSYS_DCHECK(intf);
+	MOSYS_DCHECK(callback);
+
 	/* Obtain handle to eventlog. */
 	elog_iter = smbios_new_eventlog_iterator(intf, data, length,
 						 header_offset, data_offset);
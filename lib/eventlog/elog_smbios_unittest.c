@@ -0,0 +1,113 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * elog_smbios_unittest.c: unit tests for SMBIOS event log helpers
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "cmockery.h"
+
+#include "mosys/platform.h"
+
+#include "lib/elog_smbios.h"
+
+static void set_time(struct smbios_log_entry *entry, uint8_t year,
+		     uint8_t month, uint8_t day, uint8_t hour,
+		     uint8_t minute, uint8_t second)
+{
+	memset(entry, 0, sizeof(*entry));
+	entry->year = year;
+	entry->month = month;
+	entry->day = day;
+	entry->hour = hour;
+	entry->minute = minute;
+	entry->second = second;
+}
+
+static void event_time_test(void **state)
+{
+	struct smbios_log_entry entry;
+	time_t time;
+
+	/* the epoch, and years 69 to 99 are in the 20th century */
+	set_time(&entry, 0x70, 0x01, 0x01, 0x00, 0x00, 0x00);
+	assert_int_equal(0, smbios_eventlog_event_time(&entry, &time));
+	assert_int_equal(0, time);
+	set_time(&entry, 0x69, 0x12, 0x31, 0x23, 0x59, 0x59);
+	assert_int_equal(0, smbios_eventlog_event_time(&entry, &time));
+	assert_int_equal(-1, time);
+
+	/* leap days */
+	set_time(&entry, 0x00, 0x02, 0x29, 0x12, 0x00, 0x00);
+	assert_int_equal(0, smbios_eventlog_event_time(&entry, &time));
+	assert_int_equal(951825600, time);
+	set_time(&entry, 0x00, 0x03, 0x01, 0x00, 0x00, 0x00);
+	assert_int_equal(0, smbios_eventlog_event_time(&entry, &time));
+	assert_int_equal(951868800, time);
+	set_time(&entry, 0x24, 0x12, 0x31, 0x23, 0x59, 0x59);
+	assert_int_equal(0, smbios_eventlog_event_time(&entry, &time));
+	assert_int_equal(1735689599, time);
+
+	/* a day past the end of its month rolls over */
+	set_time(&entry, 0x23, 0x02, 0x31, 0x00, 0x00, 0x00);
+	assert_int_equal(0, smbios_eventlog_event_time(&entry, &time));
+	assert_int_equal(1677801600, time);
+
+	/* out of range fields and digits which are not BCD */
+	set_time(&entry, 0x20, 0x00, 0x01, 0x00, 0x00, 0x00);
+	assert_int_equal(-1, smbios_eventlog_event_time(&entry, &time));
+	set_time(&entry, 0x20, 0x13, 0x01, 0x00, 0x00, 0x00);
+	assert_int_equal(-1, smbios_eventlog_event_time(&entry, &time));
+	set_time(&entry, 0x20, 0x01, 0x32, 0x00, 0x00, 0x00);
+	assert_int_equal(-1, smbios_eventlog_event_time(&entry, &time));
+	set_time(&entry, 0x20, 0x01, 0x01, 0x24, 0x00, 0x00);
+	assert_int_equal(-1, smbios_eventlog_event_time(&entry, &time));
+	set_time(&entry, 0x20, 0x01, 0x01, 0x00, 0x60, 0x00);
+	assert_int_equal(-1, smbios_eventlog_event_time(&entry, &time));
+	set_time(&entry, 0x1a, 0x01, 0x01, 0x00, 0x00, 0x00);
+	assert_int_equal(-1, smbios_eventlog_event_time(&entry, &time));
+	set_time(&entry, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff);
+	assert_int_equal(-1, smbios_eventlog_event_time(&entry, &time));
+}
+
+int elog_smbios_unittest(void)
+{
+	UnitTest tests[] = {
+		unit_test(event_time_test),
+	};
+
+	return run_tests(tests);
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * elog_unittest.c: unit tests for event log helpers
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cmockery.h"
+
+#include "mosys/platform.h"
+
+#include "lib/elog.h"
+
+static void parse_event_test(void **state)
+{
+	struct elog_new_event event;
+
+	assert_int_equal(0, elog_parse_event("0x17", NULL, &event));
+	assert_int_equal(0x17, event.type);
+	assert_int_equal(0, event.data_size);
+	assert_true(event.data == NULL);
+
+	assert_int_equal(0, elog_parse_event("160", "0102", &event));
+	assert_int_equal(0xa0, event.type);
+	assert_int_equal(2, event.data_size);
+	assert_int_equal(0x01, event.data[0]);
+	assert_int_equal(0x02, event.data[1]);
+	free(event.data);
+
+	/* types are bytes, data is whole bytes */
+	assert_int_equal(-1, elog_parse_event("0x100", NULL, &event));
+	assert_int_equal(-1, elog_parse_event("-1", NULL, &event));
+	assert_int_equal(-1, elog_parse_event("boot", NULL, &event));
+	assert_int_equal(-1, elog_parse_event("0x17", "010", &event));
+	assert_int_equal(-1, elog_parse_event("0x17", "01zz", &event));
+}
+
+/* write lines to a temporary file, returns its path */
+static char *write_file(const char *contents)
+{
+	static char path[] = "/tmp/elog_unittest.XXXXXX";
+	int fd;
+
+	strcpy(path, "/tmp/elog_unittest.XXXXXX");
+	fd = mkstemp(path);
+	assert_true(fd >= 0);
+	assert_int_equal(strlen(contents),
+	                 write(fd, contents, strlen(contents)));
+	close(fd);
+
+	return path;
+}
+
+static void parse_event_file_test(void **state)
+{
+	struct elog_new_event *events;
+	char *path;
+	int i;
+
+	path = write_file("# boot, then a custom event\n"
+	                  "0x17\n"
+	                  "\n"
+	                  "  0xa0\t0102  \n"
+	                  "0xa1 03\n");
+	assert_int_equal(3, elog_parse_event_file(path, &events));
+	assert_int_equal(0x17, events[0].type);
+	assert_int_equal(0, events[0].data_size);
+	assert_int_equal(0xa0, events[1].type);
+	assert_int_equal(2, events[1].data_size);
+	assert_int_equal(0x02, events[1].data[1]);
+	assert_int_equal(0xa1, events[2].type);
+	assert_int_equal(1, events[2].data_size);
+	assert_int_equal(0x03, events[2].data[0]);
+	for (i = 0; i < 3; i++)
+		free(events[i].data);
+	free(events);
+	unlink(path);
+
+	/* an empty file adds nothing */
+	path = write_file("# nothing\n");
+	assert_int_equal(0, elog_parse_event_file(path, &events));
+	assert_true(events == NULL);
+	unlink(path);
+
+	/* any bad line fails the whole file */
+	path = write_file("0x17\n0xa0 01 02\n");
+	assert_int_equal(-1, elog_parse_event_file(path, &events));
+	assert_true(events == NULL);
+	unlink(path);
+
+	path = write_file("0x17\n0x1ff\n");
+	assert_int_equal(-1, elog_parse_event_file(path, &events));
+	unlink(path);
+
+	assert_int_equal(-1, elog_parse_event_file("/nonexistent", &events));
+}
+
+int elog_unittest(void)
+{
+	UnitTest tests[] = {
+		unit_test(parse_event_test),
+		unit_test(parse_event_file_test),
+	};
+
+	return run_tests(tests);
+}
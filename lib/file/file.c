@@ -48,6 +48,7 @@
 #include "mosys/globals.h"
 #include "mosys/list.h"
 #include "mosys/log.h"
+#include "mosys/platform.h"
 
 #include "lib/file.h"
 
@@ -320,3 +321,112 @@ int sysfs_lowest_smbus(const char *path, const char *name)
 		ret = sysfs_lowbus;
 	return ret;
 }
+
+const char *get_boot_id(void)
+{
+	static char boot_id[40];
+	char path[PATH_MAX];
+	FILE *fp;
+	size_t len;
+
+	if (boot_id[0])
+		return boot_id;
+
+	snprintf(path, sizeof(path), "%s/proc/sys/kernel/random/boot_id",
+	         mosys_get_root_prefix());
+	fp = fopen(path, "r");
+	if (!fp) {
+		lperror(LOG_DEBUG, "Unable to open %s", path);
+		return NULL;
+	}
+
+	if (!fgets(boot_id, sizeof(boot_id), fp)) {
+		lprintf(LOG_DEBUG, "Unable to read %s\n", path);
+		boot_id[0] = '\0';
+		fclose(fp);
+		return NULL;
+	}
+	fclose(fp);
+
+	len = strlen(boot_id);
+	if (len && boot_id[len - 1] == '\n')
+		boot_id[len - 1] = '\0';
+
+	return boot_id;
+}
+
+int data_file_path(char *path, size_t len, const char *name)
+{
+	char *p;
+
+	if (snprintf(path, len, "%s%s/%s", mosys_get_root_prefix(),
+	             MOSYS_DATA_ROOT, name) >= len)
+		return -1;
+
+	/* create leading directories, skipping the root prefix itself */
+	p = path + strlen(mosys_get_root_prefix()) + 1;
+	while ((p = strchr(p, '/')) != NULL) {
+		*p = '\0';
+		if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+			lperror(LOG_DEBUG, "Unable to create %s", path);
+			*p = '/';
+			return -1;
+		}
+		*p++ = '/';
+	}
+
+	return 0;
+}
+
+FILE *file_replace_begin(struct file_replace *rep, const char *path,
+                         mode_t mode)
+{
+	int fd;
+
+	rep->path = path;
+	rep->fp = NULL;
+
+	if (snprintf(rep->tmp, sizeof(rep->tmp), "%s.XXXXXX",
+	             path) >= sizeof(rep->tmp)) {
+		lprintf(LOG_DEBUG, "%s: Path too long: %s\n", __func__, path);
+		return NULL;
+	}
+
+	if ((fd = mkstemp(rep->tmp)) < 0) {
+		lperror(LOG_DEBUG, "%s: Unable to create %s",
+		        __func__, rep->tmp);
+		return NULL;
+	}
+
+	/* mkstemp() creates the file readable by its owner only */
+	if (fchmod(fd, mode) < 0 || !(rep->fp = fdopen(fd, "w"))) {
+		lperror(LOG_DEBUG, "%s: Unable to open %s",
+		        __func__, rep->tmp);
+		close(fd);
+		unlink(rep->tmp);
+		return NULL;
+	}
+
+	return rep->fp;
+}
+
+int file_replace_commit(struct file_replace *rep)
+{
+	int failed = ferror(rep->fp);
+
+	if (fclose(rep->fp) != 0 || failed) {
+		lprintf(LOG_DEBUG, "%s: Unable to write %s\n",
+		        __func__, rep->tmp);
+		unlink(rep->tmp);
+		return -1;
+	}
+
+	if (rename(rep->tmp, rep->path) < 0) {
+		lperror(LOG_DEBUG, "%s: Unable to rename %s",
+		        __func__, rep->tmp);
+		unlink(rep->tmp);
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,418 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * cache.c: firmware image cache
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "mosys/alloc.h"
+#include "mosys/callbacks.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "lib/file.h"
+#include "lib/flashrom.h"
+
+/*
+ * Images and regions read from a ROM are kept in memory for the rest of the
+ * invocation so that each one is fetched at most once. A NULL region name
+ * denotes the whole image. Entries are only used with the cache locked, and
+ * handed out as copies.
+ */
+struct flashrom_cache_entry {
+	enum programmer_target target;
+	char *region;
+	uint8_t *buf;
+	size_t size;
+	struct flashrom_cache_entry *next;
+};
+
+static struct flashrom_cache_entry *flashrom_cache;
+static int flashrom_cache_registered;
+static pthread_mutex_t flashrom_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* read-only regions only change when the firmware is updated */
+static int flashrom_region_is_ro(const char *region)
+{
+	return region && (!strncmp(region, "RO_", 3) ||
+	                  !strcmp(region, "FMAP"));
+}
+
+#if defined(CONFIG_PERSISTENT_FIRMWARE_CACHE)
+#define FWCACHE_DIR		"fwcache"
+#define FWCACHE_GENERATION	FWCACHE_DIR "/generation"
+
+/*
+ * Persisted regions are prefixed with this header. A file is only valid for
+ * the boot it was written in and as long as mosys has not written to flash
+ * since, which is tracked by the generation counter.
+ */
+struct fwcache_file_header {
+	char boot_id[40];
+	uint32_t generation;
+	uint32_t size;
+} __attribute__ ((packed));
+
+/* generation the in-memory cache was last checked against */
+static uint32_t fwcache_generation;
+
+static uint32_t fwcache_get_generation(void)
+{
+	char path[PATH_MAX];
+	unsigned int generation = 0;
+	FILE *fp;
+
+	if (data_file_path(path, sizeof(path), FWCACHE_GENERATION) < 0)
+		return 0;
+
+	fp = fopen(path, "r");
+	if (!fp)
+		return 0;
+	if (fscanf(fp, "%u", &generation) != 1)
+		generation = 0;
+	fclose(fp);
+
+	return generation;
+}
+
+static void fwcache_bump_generation(void)
+{
+	char path[PATH_MAX];
+	uint32_t generation;
+	FILE *fp;
+
+	generation = fwcache_get_generation() + 1;
+	if (data_file_path(path, sizeof(path), FWCACHE_GENERATION) < 0)
+		return;
+
+	fp = fopen(path, "w");
+	if (!fp) {
+		lperror(LOG_DEBUG, "%s: Unable to open %s", __func__, path);
+		return;
+	}
+	fprintf(fp, "%u\n", generation);
+	fclose(fp);
+}
+
+static int fwcache_file_path(char *path, size_t len,
+			     enum programmer_target target, const char *region)
+{
+	char name[NAME_MAX];
+
+	snprintf(name, sizeof(name), FWCACHE_DIR "/%d_%s", target, region);
+	return data_file_path(path, len, name);
+}
+
+static int fwcache_load(enum programmer_target target, const char *region,
+			uint8_t **buf)
+{
+	struct fwcache_file_header header;
+	char path[PATH_MAX];
+	const char *boot_id;
+	struct stat st;
+	FILE *fp;
+	int rc = -1;
+
+	if (!flashrom_region_is_ro(region) || !(boot_id = get_boot_id()))
+		return -1;
+
+	if (fwcache_file_path(path, sizeof(path), target, region) < 0)
+		return -1;
+
+	fp = fopen(path, "r");
+	if (!fp)
+		return -1;
+
+	if (fread(&header, sizeof(header), 1, fp) != 1)
+		goto fwcache_load_exit;
+
+	if (strncmp(header.boot_id, boot_id, sizeof(header.boot_id)) ||
+	    header.generation != fwcache_get_generation()) {
+		lprintf(LOG_DEBUG, "%s: %s is stale\n", __func__, path);
+		goto fwcache_load_exit;
+	}
+
+	/* do not trust the size of a truncated or corrupted file */
+	if (fstat(fileno(fp), &st) < 0 ||
+	    header.size != st.st_size - sizeof(header)) {
+		lprintf(LOG_DEBUG, "%s: %s is corrupted\n", __func__, path);
+		goto fwcache_load_exit;
+	}
+
+	*buf = mosys_malloc(header.size);
+	if (fread(*buf, header.size, 1, fp) != 1) {
+		free(*buf);
+		goto fwcache_load_exit;
+	}
+
+	lprintf(LOG_DEBUG, "%s: loaded %s\n", __func__, path);
+	rc = header.size;
+fwcache_load_exit:
+	fclose(fp);
+	return rc;
+}
+
+static void fwcache_store(enum programmer_target target, const char *region,
+			  const uint8_t *buf, size_t size)
+{
+	struct fwcache_file_header header;
+	char path[PATH_MAX];
+	struct file_replace rep;
+	const char *boot_id;
+	FILE *fp;
+
+	if (!flashrom_region_is_ro(region) || !(boot_id = get_boot_id()))
+		return;
+
+	if (fwcache_file_path(path, sizeof(path), target, region) < 0)
+		return;
+
+	memset(&header, 0, sizeof(header));
+	strncpy(header.boot_id, boot_id, sizeof(header.boot_id) - 1);
+	header.generation = fwcache_get_generation();
+	header.size = size;
+
+	fp = file_replace_begin(&rep, path, 0600);
+	if (!fp)
+		return;
+
+	fwrite(&header, sizeof(header), 1, fp);
+	fwrite(buf, size, 1, fp);
+	file_replace_commit(&rep);
+}
+#endif	/* CONFIG_PERSISTENT_FIRMWARE_CACHE */
+
+static void flashrom_cache_destroy(void *arg)
+{
+	struct flashrom_cache_entry *entry;
+
+	pthread_mutex_lock(&flashrom_cache_lock);
+	while (flashrom_cache) {
+		entry = flashrom_cache;
+		flashrom_cache = entry->next;
+		free(entry->region);
+		free(entry->buf);
+		free(entry);
+	}
+
+	flashrom_cache_registered = 0;
+	pthread_mutex_unlock(&flashrom_cache_lock);
+}
+
+static struct flashrom_cache_entry *flashrom_cache_find(
+				enum programmer_target target,
+				const char *region)
+{
+	struct flashrom_cache_entry *entry;
+
+	for (entry = flashrom_cache; entry; entry = entry->next) {
+		if (entry->target != target)
+			continue;
+		if (!region && !entry->region)
+			return entry;
+		if (region && entry->region && !strcmp(region, entry->region))
+			return entry;
+	}
+
+	return NULL;
+}
+
+static struct flashrom_cache_entry *flashrom_cache_add(
+				enum programmer_target target,
+				const char *region, uint8_t *buf, size_t size)
+{
+	struct flashrom_cache_entry *entry;
+
+	if (!flashrom_cache_registered) {
+		add_destroy_callback(flashrom_cache_destroy, NULL);
+		flashrom_cache_registered = 1;
+	}
+
+	entry = mosys_zalloc(sizeof(*entry));
+	entry->target = target;
+	if (region)
+		entry->region = mosys_strdup(region);
+	entry->buf = buf;
+	entry->size = size;
+	entry->next = flashrom_cache;
+	flashrom_cache = entry;
+
+	return entry;
+}
+
+/* must be called with the cache locked */
+static struct flashrom_cache_entry *flashrom_cache_get(
+				enum programmer_target target,
+				const char *region)
+{
+	struct flashrom_cache_entry *entry;
+
+	entry = flashrom_cache_find(target, region);
+#if defined(CONFIG_PERSISTENT_FIRMWARE_CACHE)
+	if (!entry) {
+		uint8_t *buf;
+		int len;
+
+		len = fwcache_load(target, region, &buf);
+		if (len >= 0)
+			entry = flashrom_cache_add(target, region, buf, len);
+	}
+#endif
+
+	return entry;
+}
+
+int flashrom_cache_lookup(enum programmer_target target, const char *region,
+			  uint8_t **buf)
+{
+	struct flashrom_cache_entry *entry;
+	int rc = -1;
+
+	pthread_mutex_lock(&flashrom_cache_lock);
+	entry = flashrom_cache_get(target, region);
+	if (entry) {
+		*buf = mosys_malloc(entry->size);
+		memcpy(*buf, entry->buf, entry->size);
+		rc = entry->size;
+	}
+	pthread_mutex_unlock(&flashrom_cache_lock);
+
+	return rc;
+}
+
+int flashrom_cache_read(enum programmer_target target, const char *region,
+			uint8_t *buf, size_t offset, size_t len)
+{
+	struct flashrom_cache_entry *entry;
+	int rc = -1;
+
+	pthread_mutex_lock(&flashrom_cache_lock);
+	entry = flashrom_cache_get(target, region);
+	if (entry && offset + len >= offset && offset + len <= entry->size) {
+		memcpy(buf, &entry->buf[offset], len);
+		rc = 0;
+	}
+	pthread_mutex_unlock(&flashrom_cache_lock);
+
+	return rc;
+}
+
+void flashrom_cache_store(enum programmer_target target,
+			  const char *region, const uint8_t *buf, size_t size)
+{
+	struct flashrom_cache_entry *entry;
+	uint8_t *copy;
+
+	copy = mosys_malloc(size);
+	memcpy(copy, buf, size);
+
+	pthread_mutex_lock(&flashrom_cache_lock);
+	entry = flashrom_cache_find(target, region);
+	if (entry) {
+		free(entry->buf);
+		entry->buf = copy;
+		entry->size = size;
+	} else {
+		flashrom_cache_add(target, region, copy, size);
+	}
+
+#if defined(CONFIG_PERSISTENT_FIRMWARE_CACHE)
+	fwcache_store(target, region, buf, size);
+#endif
+	pthread_mutex_unlock(&flashrom_cache_lock);
+}
+
+void flashrom_cache_expire(void)
+{
+	struct flashrom_cache_entry **pentry, *entry;
+	int keep_ro = 1;
+#if defined(CONFIG_PERSISTENT_FIRMWARE_CACHE)
+	uint32_t generation;
+#endif
+
+	pthread_mutex_lock(&flashrom_cache_lock);
+#if defined(CONFIG_PERSISTENT_FIRMWARE_CACHE)
+	generation = fwcache_get_generation();
+
+	/* another mosys process has written flash */
+	if (generation != fwcache_generation) {
+		fwcache_generation = generation;
+		keep_ro = 0;
+	}
+#endif
+
+	pentry = &flashrom_cache;
+	while ((entry = *pentry) != NULL) {
+		if (keep_ro && flashrom_region_is_ro(entry->region)) {
+			pentry = &entry->next;
+			continue;
+		}
+
+		*pentry = entry->next;
+		free(entry->region);
+		free(entry->buf);
+		free(entry);
+	}
+	pthread_mutex_unlock(&flashrom_cache_lock);
+}
+
+void flashrom_cache_invalidate(enum programmer_target target)
+{
+	struct flashrom_cache_entry **pentry, *entry;
+
+	pthread_mutex_lock(&flashrom_cache_lock);
+	pentry = &flashrom_cache;
+	while ((entry = *pentry) != NULL) {
+		if (entry->target != target) {
+			pentry = &entry->next;
+			continue;
+		}
+
+		*pentry = entry->next;
+		free(entry->region);
+		free(entry->buf);
+		free(entry);
+	}
+
+#if defined(CONFIG_PERSISTENT_FIRMWARE_CACHE)
+	/* stale files are detected and rewritten on next use */
+	fwcache_bump_generation();
+#endif
+	pthread_mutex_unlock(&flashrom_cache_lock);
+}
@@ -35,6 +35,7 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
@@ -56,6 +57,9 @@
 
 #define MAX_ARRAY_SIZE 256
 
+/* seconds to wait for the big lock after flashrom has run */
+#define FLASHROM_LOCK_TIMEOUT_SECS 180
+
 static int in_android = 0;
 
 enum pipe_direction {
@@ -121,7 +125,8 @@ static int do_cmd(const char *cmd, char *const *argv,
 	}
 
 #if defined(CONFIG_USE_IPC_LOCK)
-	if (mosys_release_big_lock() < 0)
+	/* other threads wait until the lock is taken back */
+	if (mosys_big_lock_suspend() < 0)
 		re_acquire_lock = 0;
 #endif
 	if (argv != NULL) {
@@ -226,11 +231,17 @@ static int do_cmd(const char *cmd, char *const *argv,
 	}
 
 #if defined(CONFIG_USE_IPC_LOCK)
-        /* try to get lock */
-        if (re_acquire_lock && (mosys_acquire_big_lock(50000) < 0)) {
+	/*
+	 * Take the lock back in the mode it was held in. A command holding
+	 * it shared may also hold resource locks other processes sharing
+	 * the big lock are waiting for, so waiting for it exclusively here
+	 * could deadlock against them.
+	 */
+	if (re_acquire_lock &&
+	    mosys_big_lock_resume(FLASHROM_LOCK_TIMEOUT_SECS) < 0) {
 		lprintf(LOG_DEBUG, "%s: could not re-acquire lock\n", __func__);
 		rc = -1;
-        }
+	}
 #endif
 	close(null_fd);
 	return rc;
@@ -292,11 +303,10 @@ static int append_programmer_arg(const enum programmer_target target,
 	return ret;
 }
 
-/* returns pointer to string containing flashrom path if successful,
-   returns NULL otherwise */
-static const char *flashrom_path(void)
+/* fills path (PATH_MAX bytes) with the flashrom path and sets *android if
+   it is the Android one, returns 0 if successful and <0 otherwise */
+static int flashrom_path_lookup(char *path, int *android)
 {
-	static char path[PATH_MAX];
 	int fd;
 	int i = 0;
 	struct stat s;
@@ -314,10 +324,10 @@ static const char *flashrom_path(void)
 	   reason, stat() was seg faulting in Android */
 	fd = open(android_path, O_RDONLY);
 	if (fstat(fd, &s) == 0) {
-		in_android = 1;
+		*android = 1;
 		strcpy(path, android_path);
 		close(fd);
-		return path;
+		return 0;
 	}
 	close(fd);
 
@@ -325,10 +335,10 @@ static const char *flashrom_path(void)
 	args[i++] = strdup(which_cmd);
 	args[i++] = strdup("flashrom");
 	args[i++] = NULL;
-	memset(path, 0, sizeof(path));
+	memset(path, 0, PATH_MAX);
 	if (do_cmd(which_cmd, args, pipes, ARRAY_SIZE(pipes)) < 0) {
 		lprintf(LOG_DEBUG, "Unable to determine flashrom path\n");
-		return NULL;
+		return -1;
 	}
 
 	for (i = 0; i < PATH_MAX; i++) {
@@ -341,12 +351,42 @@ static const char *flashrom_path(void)
 	lprintf(LOG_DEBUG, "%s: path: \"%s\"\n", __func__, path);
 	for (i = 0; args[i] != NULL; i++)
 		free(args[i]);
+	return 0;
+}
+
+/* returns pointer to string containing flashrom path if successful,
+   returns NULL otherwise */
+static const char *flashrom_path(void)
+{
+	static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	static char path[PATH_MAX];
+	static int resolved;
+	char found[PATH_MAX];
+	int android = 0;
+
+	pthread_mutex_lock(&lock);
+	if (resolved) {
+		pthread_mutex_unlock(&lock);
+		return path;
+	}
+	pthread_mutex_unlock(&lock);
+
+	/* the lookup runs a command, so it is done without the lock held */
+	if (flashrom_path_lookup(found, &android) < 0)
+		return NULL;
+
+	pthread_mutex_lock(&lock);
+	if (!resolved) {
+		strcpy(path, found);
+		in_android = android;
+		resolved = 1;
+	}
+	pthread_mutex_unlock(&lock);
 	return path;
 }
 
-/* TODO: add arbitrary range support */
-int flashrom_read(uint8_t *buf, size_t size,
-                  enum programmer_target target, const char *region)
+static int exec_read(uint8_t *buf, size_t size,
+                     enum programmer_target target, const char *region)
 {
 	int fd, rc = -1;
 	char filename[] = "flashrom_XXXXXX";
@@ -413,8 +453,8 @@ flashrom_read_exit_0:
 	return rc;
 }
 
-int flashrom_read_by_name(uint8_t **buf,
-                  enum programmer_target target, const char *region)
+static int exec_read_by_name(uint8_t **buf,
+                             enum programmer_target target, const char *region)
 {
 	int fd, rc = -1;
 	struct stat s;
@@ -484,8 +524,8 @@ flashrom_read_exit_0:
 	return rc;
 }
 
-int flashrom_write_by_name(size_t size, uint8_t *buf,
-                  enum programmer_target target, const char *region)
+static int exec_write_by_name(size_t size, uint8_t *buf,
+                              enum programmer_target target, const char *region)
 {
 	int fd, written, rc = -1;
 	const char *path;
@@ -560,39 +600,268 @@ flashrom_write_exit_0:
 	return rc;
 }
 
-int flashrom_read_host_firmware_region(struct platform_intf *intf,
-							uint8_t **buf)
+/*
+ * exec_mkstemp - Create a temporary file for exchanging data with flashrom
+ *
+ * @full_filename:	buffer of PATH_MAX bytes to store the file name in
+ *
+ * returns open file descriptor to indicate success
+ * returns <0 to indicate failure
+ */
+static int exec_mkstemp(char *full_filename)
 {
-	int rc, i;
-	uint8_t *fmap_buf;
-	const char *regions[] = { "COREBOOT", "BOOT_STUB" };
+	int fd;
 
-	rc = flashrom_read_by_name(&fmap_buf, HOST_FIRMWARE, "FMAP");
-	if (rc > 0) {
-		for (i = 0; i < ARRAY_SIZE(regions); i++) {
-			if (fmap_find_area((struct fmap *)fmap_buf, regions[i])) {
-				rc = flashrom_read_by_name(buf,
-						HOST_FIRMWARE, regions[i]);
-				break;
-			}
-		}
-		free(fmap_buf);
+	/* In Android, no tmp, but /data is writable */
+	strcpy(full_filename, in_android ? "/data/" : "/tmp/");
+	strcat(full_filename, "flashrom_XXXXXX");
+	fd = mkstemp(full_filename);
+	if (fd < 0)
+		lperror(LOG_DEBUG,
+			"Unable to make temporary file for flashrom");
+	return fd;
+}
+
+/*
+ * exec_read_file - Read back a file written by flashrom
+ *
+ * @filename:	name of file
+ * @buf:	double-pointer of buffer to allocate and fill
+ *
+ * returns number of bytes read to indicate success
+ * returns <0 to indicate failure
+ */
+static int exec_read_file(const char *filename, uint8_t **buf)
+{
+	struct stat s;
+	int fd, rc = -1;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	if (fstat(fd, &s) < 0 || s.st_size == 0) {
+		lprintf(LOG_DEBUG, "%s: Cannot stat %s\n", __func__, filename);
+		goto exec_read_file_exit;
+	}
+
+	*buf = mosys_malloc(s.st_size);
+	if (read(fd, *buf, s.st_size) != s.st_size) {
+		lperror(LOG_DEBUG, "%s: Unable to read %s", __func__, filename);
+		free(*buf);
+		goto exec_read_file_exit;
+	}
+
+	rc = s.st_size;
+exec_read_file_exit:
+	close(fd);
+	return rc;
+}
+
+static int exec_read_range(uint8_t *buf, unsigned int offset,
+                           unsigned int len, enum programmer_target target)
+{
+	char layout_file[PATH_MAX], data_file[PATH_MAX];
+	char region_file[PATH_MAX + 8];
+	char *args[MAX_ARRAY_SIZE];
+	char layout[32];
+	uint8_t *data;
+	const char *path;
+	int fd, n, i = 0, rc = -1;
+
+	if ((path = flashrom_path()) == NULL)
+		return -1;
+
+	/* describe the range using a layout file with a single region */
+	if ((fd = exec_mkstemp(layout_file)) < 0)
+		return -1;
+	n = snprintf(layout, sizeof(layout), "0x%08x:0x%08x range\n",
+	             offset, offset + len - 1);
+	if (write(fd, layout, n) != n) {
+		lperror(LOG_DEBUG, "%s: Unable to write layout", __func__);
+		close(fd);
+		goto exec_read_range_exit_0;
+	}
+	close(fd);
+
+	if ((fd = exec_mkstemp(data_file)) < 0)
+		goto exec_read_range_exit_0;
+	close(fd);
+
+	args[i++] = strdup(path);
+	if ((n = append_programmer_arg(target, i, args)) < 0) {
+		args[i] = NULL;
+		goto exec_read_range_exit_1;
+	}
+	i += n;
+
+	args[i++] = strdup("-l");
+	args[i++] = strdup(layout_file);
+	args[i++] = strdup("-i");
+	snprintf(region_file, sizeof(region_file), "range:%s", data_file);
+	args[i++] = strdup(region_file);
+	args[i++] = strdup("-r");
+	args[i++] = NULL;
+
+	if (do_cmd(path, args, NULL, 0) < 0) {
+		lprintf(LOG_DEBUG, "Unable to read range 0x%08x-0x%08x\n",
+		        offset, offset + len - 1);
+		goto exec_read_range_exit_1;
+	}
+
+	n = exec_read_file(data_file, &data);
+	if (n < 0)
+		goto exec_read_range_exit_1;
+	if (n == len) {
+		memcpy(buf, data, len);
+		rc = 0;
 	} else {
-		/* FMAP blob might still be in the ROM but without its own area
-		 * defined. Try looking for the firmware regions directly. */
-		for (i = 0; i < ARRAY_SIZE(regions); i++) {
-			rc = flashrom_read_by_name(buf,
-					HOST_FIRMWARE, regions[i]);
-			if (rc > 0)
-				break;
+		lprintf(LOG_DEBUG, "%s: Read %d bytes, expected %u\n",
+		        __func__, n, len);
+	}
+	free(data);
+
+exec_read_range_exit_1:
+	for (i = 0; args[i] != NULL; i++)
+		free(args[i]);
+	unlink(data_file);
+exec_read_range_exit_0:
+	unlink(layout_file);
+	return rc;
+}
+
+static int exec_write_range(uint8_t *buf, unsigned int offset,
+                            unsigned int len, enum programmer_target target)
+{
+	char layout_file[PATH_MAX], data_file[PATH_MAX];
+	char region_file[PATH_MAX + 8];
+	char *args[MAX_ARRAY_SIZE];
+	char layout[32];
+	const char *path;
+	int fd, n, i = 0, rc = -1;
+
+	if ((path = flashrom_path()) == NULL)
+		return -1;
+
+	/* describe the range using a layout file with a single region */
+	if ((fd = exec_mkstemp(layout_file)) < 0)
+		return -1;
+	n = snprintf(layout, sizeof(layout), "0x%08x:0x%08x range\n",
+	             offset, offset + len - 1);
+	if (write(fd, layout, n) != n) {
+		lperror(LOG_DEBUG, "%s: Unable to write layout", __func__);
+		close(fd);
+		goto exec_write_range_exit_0;
+	}
+	close(fd);
+
+	if ((fd = exec_mkstemp(data_file)) < 0)
+		goto exec_write_range_exit_0;
+	if (write(fd, buf, len) != len) {
+		lperror(LOG_DEBUG, "%s: Unable to write %s", __func__,
+		        data_file);
+		close(fd);
+		goto exec_write_range_exit_1;
+	}
+	close(fd);
+
+	args[i++] = strdup(path);
+	if ((n = append_programmer_arg(target, i, args)) < 0) {
+		args[i] = NULL;
+		goto exec_write_range_exit_2;
+	}
+	i += n;
+
+	args[i++] = strdup("-l");
+	args[i++] = strdup(layout_file);
+	args[i++] = strdup("-i");
+	snprintf(region_file, sizeof(region_file), "range:%s", data_file);
+	args[i++] = strdup(region_file);
+	args[i++] = strdup("-w");
+	args[i++] = strdup("--fast-verify");
+	args[i++] = NULL;
+
+	if (do_cmd(path, args, NULL, 0) < 0) {
+		lprintf(LOG_DEBUG, "Unable to write range 0x%08x-0x%08x\n",
+		        offset, offset + len - 1);
+		goto exec_write_range_exit_2;
+	}
+
+	rc = len;
+
+exec_write_range_exit_2:
+	for (i = 0; args[i] != NULL; i++)
+		free(args[i]);
+exec_write_range_exit_1:
+	unlink(data_file);
+exec_write_range_exit_0:
+	unlink(layout_file);
+	return rc;
+}
+
+static int exec_read_regions(struct flashrom_region *regions, int num,
+                             enum programmer_target target)
+{
+	char (*files)[PATH_MAX];
+	char region_file[PATH_MAX + FMAP_STRLEN];
+	char *args[MAX_ARRAY_SIZE];
+	const char *path;
+	int fd, n, r, i = 0, rc = -1;
+
+	/* two arguments per region plus the programmer, -r and terminator */
+	if (num > (MAX_ARRAY_SIZE - 8) / 2)
+		return -1;
+
+	if ((path = flashrom_path()) == NULL)
+		return -1;
+
+	files = mosys_zalloc(num * sizeof(*files));
+	args[i++] = strdup(path);
+	if ((n = append_programmer_arg(target, i, args)) < 0) {
+		args[i] = NULL;
+		goto exec_read_regions_exit;
+	}
+	i += n;
+
+	for (r = 0; r < num; r++) {
+		if ((fd = exec_mkstemp(files[r])) < 0) {
+			args[i] = NULL;
+			goto exec_read_regions_exit;
 		}
+		close(fd);
+
+		args[i++] = strdup("-i");
+		snprintf(region_file, sizeof(region_file), "%s:%s",
+		         regions[r].name, files[r]);
+		args[i++] = strdup(region_file);
+	}
+	args[i++] = strdup("-r");
+	args[i++] = NULL;
+
+	if (do_cmd(path, args, NULL, 0) < 0) {
+		lprintf(LOG_DEBUG, "Unable to read %d regions\n", num);
+		goto exec_read_regions_exit;
 	}
 
+	rc = 0;
+	for (r = 0; r < num; r++) {
+		regions[r].len = exec_read_file(files[r], &regions[r].buf);
+		if (regions[r].len < 0)
+			rc = -1;
+	}
+
+exec_read_regions_exit:
+	for (i = 0; args[i] != NULL; i++)
+		free(args[i]);
+	for (r = 0; r < num; r++) {
+		if (files[r][0])
+			unlink(files[r]);
+	}
+	free(files);
 	return rc;
 }
 
-int flashrom_get_rom_size(struct platform_intf *intf,
-			enum programmer_target target)
+static int exec_get_size(enum programmer_target target)
 {
 	int ret = -1;
 	const char *path;
@@ -636,3 +905,263 @@ flashrom_get_rom_size_exit_1:
 flashrom_get_rom_size_exit_0:
 	return ret;
 }
+
+struct flashrom_backend flashrom_exec_backend = {
+	.name		= "exec",
+	.read		= exec_read,
+	.read_range	= exec_read_range,
+	.read_by_name	= exec_read_by_name,
+	.read_regions	= exec_read_regions,
+	.write_by_name	= exec_write_by_name,
+	.write_range	= exec_write_range,
+	.get_size	= exec_get_size,
+};
+
+/* backends in order of preference, the last one is the fallback */
+static struct flashrom_backend *flashrom_backends[] = {
+#if defined(CONFIG_USE_LIBFLASHROM)
+	&libflashrom_backend,
+#endif
+	&flashrom_exec_backend,
+};
+
+/*
+ * flashrom_get_backend - Select the backend used to access a target
+ *
+ * @target:	target ROM
+ *
+ * returns pointer to backend
+ */
+static struct flashrom_backend *flashrom_get_backend(
+					enum programmer_target target)
+{
+	static struct flashrom_backend *selected[EC_FIRMWARE + 1];
+	static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	struct flashrom_backend *backend;
+	int i;
+
+	if (target > EC_FIRMWARE)
+		return &flashrom_exec_backend;
+
+	pthread_mutex_lock(&lock);
+	if (selected[target]) {
+		backend = selected[target];
+		goto flashrom_get_backend_exit;
+	}
+
+	/* the exec backend has no setup step, so it always gets picked */
+	for (i = 0; i < ARRAY_SIZE(flashrom_backends); i++) {
+		backend = flashrom_backends[i];
+		if (!backend->setup || backend->setup(target) == 0)
+			break;
+
+		lprintf(LOG_DEBUG, "%s: %s backend unavailable for "
+		        "target %d\n", __func__, backend->name, target);
+	}
+
+	lprintf(LOG_DEBUG, "%s: using %s backend for target %d\n",
+	        __func__, backend->name, target);
+	selected[target] = backend;
+
+flashrom_get_backend_exit:
+	pthread_mutex_unlock(&lock);
+	return backend;
+}
+
+int flashrom_read(uint8_t *buf, size_t size,
+                  enum programmer_target target, const char *region)
+{
+	/* a cached copy of the whole ROM will also do for a single region */
+	if (flashrom_cache_read(target, NULL, buf, 0, size) == 0)
+		return 0;
+
+	if (flashrom_get_backend(target)->read(buf, size, target, region) < 0)
+		return -1;
+
+	if (!region)
+		flashrom_cache_store(target, NULL, buf, size);
+	return 0;
+}
+
+int flashrom_read_range(uint8_t *buf, unsigned int offset, unsigned int len,
+                        enum programmer_target target)
+{
+	if (!len || offset + len < offset)
+		return -1;
+
+	if (flashrom_cache_read(target, NULL, buf, offset, len) == 0)
+		return 0;
+
+	return flashrom_get_backend(target)->read_range(buf, offset,
+	                                                len, target);
+}
+
+int flashrom_read_by_name(uint8_t **buf,
+                  enum programmer_target target, const char *region)
+{
+	int rc;
+
+	if (!region)
+		return -1;
+
+	rc = flashrom_cache_lookup(target, region, buf);
+	if (rc >= 0)
+		return rc;
+
+	rc = flashrom_get_backend(target)->read_by_name(buf, target, region);
+	if (rc > 0)
+		flashrom_cache_store(target, region, *buf, rc);
+	return rc;
+}
+
+int flashrom_read_regions(struct flashrom_region *regions, int num,
+                          enum programmer_target target)
+{
+	struct flashrom_region *pending;
+	int i, j, n = 0, rc = 0;
+
+	pending = mosys_zalloc(num * sizeof(*pending));
+	for (i = 0; i < num; i++) {
+		regions[i].buf = NULL;
+		regions[i].len = -1;
+
+		regions[i].len = flashrom_cache_lookup(target, regions[i].name,
+		                                       &regions[i].buf);
+		if (regions[i].len >= 0)
+			continue;
+
+		pending[n].name = regions[i].name;
+		pending[n++].len = -1;
+	}
+
+	/* fetch everything that was not cached in a single pass */
+	if (n && flashrom_get_backend(target)->read_regions(pending,
+							n, target) < 0)
+		rc = -1;
+
+	for (i = 0, j = 0; i < num && j < n; i++) {
+		if (regions[i].buf)
+			continue;
+
+		regions[i] = pending[j++];
+		if (regions[i].len > 0)
+			flashrom_cache_store(target, regions[i].name,
+			                     regions[i].buf, regions[i].len);
+		else
+			rc = -1;
+	}
+
+	free(pending);
+	return rc;
+}
+
+int flashrom_write_by_name(size_t size, uint8_t *buf,
+                  enum programmer_target target, const char *region)
+{
+	if (!region)
+		return -1;
+
+	/* regions may overlap, so nothing cached for the ROM can be trusted */
+	flashrom_cache_invalidate(target);
+	return flashrom_get_backend(target)->write_by_name(size, buf,
+	                                                   target, region);
+}
+
+/*
+ * flashrom_region_range - Locate a region using the FMAP of the ROM
+ *
+ * @target:	target ROM
+ * @region:	FMAP area name
+ * @start:	pointer to store the region's offset in
+ * @len:	pointer to store the region's length in
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int flashrom_region_range(enum programmer_target target,
+                                 const char *region,
+                                 unsigned int *start, unsigned int *len)
+{
+	const struct fmap_area *area;
+	uint8_t *fmap_buf;
+	int rc = -1;
+
+	if (flashrom_read_by_name(&fmap_buf, target, "FMAP") <= 0)
+		return -1;
+
+	area = fmap_find_area((struct fmap *)fmap_buf, region);
+	if (area) {
+		*start = area->offset;
+		*len = area->size;
+		rc = 0;
+	} else {
+		lprintf(LOG_DEBUG, "%s: Region \"%s\" not found\n",
+		        __func__, region);
+	}
+
+	free(fmap_buf);
+	return rc;
+}
+
+int flashrom_write_range_by_name(size_t size, uint8_t *buf,
+                  unsigned int offset, enum programmer_target target,
+                  const char *region)
+{
+	unsigned int start, len;
+
+	if (!region || !size)
+		return -1;
+
+	if (flashrom_region_range(target, region, &start, &len) < 0)
+		return -1;
+
+	if (offset >= len || size > len - offset) {
+		lprintf(LOG_DEBUG, "%s: Range 0x%x+0x%zx exceeds region "
+		        "\"%s\"\n", __func__, offset, size, region);
+		return -1;
+	}
+
+	flashrom_cache_invalidate(target);
+	if (flashrom_get_backend(target)->write_range(buf, start + offset,
+	                                              size, target) < 0)
+		return -1;
+
+	return size;
+}
+
+int flashrom_read_host_firmware_region(struct platform_intf *intf,
+							uint8_t **buf)
+{
+	int rc, i;
+	uint8_t *fmap_buf;
+	const char *regions[] = { "COREBOOT", "BOOT_STUB" };
+
+	rc = flashrom_read_by_name(&fmap_buf, HOST_FIRMWARE, "FMAP");
+	if (rc > 0) {
+		for (i = 0; i < ARRAY_SIZE(regions); i++) {
+			if (fmap_find_area((struct fmap *)fmap_buf, regions[i])) {
+				rc = flashrom_read_by_name(buf,
+						HOST_FIRMWARE, regions[i]);
+				break;
+			}
+		}
+		free(fmap_buf);
+	} else {
+		/* FMAP blob might still be in the ROM but without its own area
+		 * defined. Try looking for the firmware regions directly. */
+		for (i = 0; i < ARRAY_SIZE(regions); i++) {
+			rc = flashrom_read_by_name(buf,
+					HOST_FIRMWARE, regions[i]);
+			if (rc > 0)
+				break;
+		}
+	}
+
+	return rc;
+}
+
+int flashrom_get_rom_size(struct platform_intf *intf,
+			enum programmer_target target)
+{
+	return flashrom_get_backend(target)->get_size(target);
+}
@@ -0,0 +1,527 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * libflashrom.c: in-process flashrom backend
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libflashrom.h>
+
+#include "mosys/alloc.h"
+#include "mosys/callbacks.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "lib/flashrom.h"
+#include "lib/math.h"
+
+/*
+ * Programmer and chip state is kept around for the rest of the invocation
+ * so that subsequent operations on the same target need not re-initialize
+ * the programmer and re-probe the chip.
+ */
+struct libflashrom_target {
+	const char *prog_name;
+	const char *prog_params;
+	struct flashrom_programmer *prog;
+	struct flashrom_flashctx *flash;
+	struct flashrom_layout *fmap;	/* layout read from the ROM's FMAP */
+	size_t size;
+	int unavailable;
+};
+
+static struct libflashrom_target libflashrom_targets[] = {
+	[INTERNAL_BUS_I2C]	= { "internal", "bus=i2c" },
+	[INTERNAL_BUS_LPC]	= { "internal", "bus=lpc" },
+	[INTERNAL_BUS_SPI]	= { "internal", "bus=spi" },
+	[HOST_FIRMWARE]		= { "host", NULL },
+	[EC_FIRMWARE]		= { "ec", NULL },
+};
+
+static int libflashrom_initialized;
+
+static int libflashrom_log(enum flashrom_log_level level,
+			   const char *format, va_list args)
+{
+	char msg[256];
+
+	if (level > FLASHROM_MSG_INFO)
+		return 0;
+
+	vsnprintf(msg, sizeof(msg), format, args);
+	return lprintf(level == FLASHROM_MSG_ERROR ? LOG_ERR : LOG_DEBUG,
+		       "libflashrom: %s", msg);
+}
+
+static void libflashrom_target_release(struct libflashrom_target *t)
+{
+	if (t->fmap) {
+		flashrom_layout_release(t->fmap);
+		t->fmap = NULL;
+	}
+	if (t->flash) {
+		flashrom_flash_release(t->flash);
+		t->flash = NULL;
+	}
+	if (t->prog) {
+		flashrom_programmer_shutdown(t->prog);
+		t->prog = NULL;
+	}
+}
+
+static void libflashrom_destroy(void *arg)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(libflashrom_targets); i++)
+		libflashrom_target_release(&libflashrom_targets[i]);
+
+	flashrom_shutdown();
+	libflashrom_initialized = 0;
+}
+
+static int libflashrom_setup_unlocked(enum programmer_target target)
+{
+	struct libflashrom_target *t;
+
+	if (target >= ARRAY_SIZE(libflashrom_targets) ||
+	    !libflashrom_targets[target].prog_name)
+		return -1;
+
+	t = &libflashrom_targets[target];
+	if (t->flash)
+		return 0;
+	if (t->unavailable)
+		return -1;
+
+	if (!libflashrom_initialized) {
+		if (flashrom_init(1)) {
+			lprintf(LOG_DEBUG, "%s: Failed to initialize "
+			        "libflashrom\n", __func__);
+			return -1;
+		}
+		flashrom_set_log_callback(libflashrom_log);
+		add_destroy_callback(libflashrom_destroy, NULL);
+		libflashrom_initialized = 1;
+	}
+
+	if (flashrom_programmer_init(&t->prog,
+				     t->prog_name, t->prog_params)) {
+		lprintf(LOG_DEBUG, "%s: Failed to initialize programmer "
+		        "\"%s\"\n", __func__, t->prog_name);
+		t->prog = NULL;
+		goto libflashrom_setup_exit;
+	}
+
+	if (flashrom_flash_probe(&t->flash, t->prog, NULL)) {
+		lprintf(LOG_DEBUG, "%s: No flash chip found on programmer "
+		        "\"%s\"\n", __func__, t->prog_name);
+		t->flash = NULL;
+		goto libflashrom_setup_exit;
+	}
+
+	t->size = flashrom_flash_getsize(t->flash);
+	/* match the flashrom utility's default of verifying what we wrote */
+	flashrom_flag_set(t->flash, FLASHROM_FLAG_VERIFY_AFTER_WRITE, true);
+	flashrom_flag_set(t->flash, FLASHROM_FLAG_VERIFY_WHOLE_CHIP, false);
+	return 0;
+
+libflashrom_setup_exit:
+	libflashrom_target_release(t);
+	t->unavailable = 1;
+	return -1;
+}
+
+/*
+ * libflashrom_region_layout  -  Build a layout containing a single region
+ *
+ * @t:		target
+ * @region:	FMAP area name
+ * @layout:	pointer to layout to allocate
+ * @start:	pointer to store the region's offset in
+ * @len:	pointer to store the region's length in
+ *
+ * The FMAP is read from the ROM once per target. Regions are included in a
+ * fresh layout each time since inclusion cannot be undone on a layout.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int libflashrom_region_layout(struct libflashrom_target *t,
+				     const char *region,
+				     struct flashrom_layout **layout,
+				     unsigned int *start, unsigned int *len)
+{
+	if (!t->fmap && flashrom_layout_read_fmap_from_rom(&t->fmap,
+							t->flash, 0, t->size)) {
+		lprintf(LOG_DEBUG, "%s: Unable to read FMAP\n", __func__);
+		t->fmap = NULL;
+		return -1;
+	}
+
+	if (flashrom_layout_get_region_range(t->fmap, region, start, len)) {
+		lprintf(LOG_DEBUG, "%s: Region \"%s\" not found\n",
+		        __func__, region);
+		return -1;
+	}
+
+	if (flashrom_layout_new(layout))
+		return -1;
+
+	if (flashrom_layout_add_region(*layout, *start, *start + *len - 1,
+				       region) ||
+	    flashrom_layout_include_region(*layout, region)) {
+		flashrom_layout_release(*layout);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int libflashrom_read_unlocked(uint8_t *buf, size_t size,
+				     enum programmer_target target,
+				     const char *region)
+{
+	struct libflashrom_target *t = &libflashrom_targets[target];
+	struct flashrom_layout *layout = NULL;
+	unsigned int start, len;
+	int rc = -1;
+
+	if (size != t->size) {
+		lprintf(LOG_DEBUG, "%s: Size of image: %zu, expected %zu\n",
+		        __func__, t->size, size);
+		return -1;
+	}
+
+	if (region) {
+		if (libflashrom_region_layout(t, region,
+					      &layout, &start, &len) < 0)
+			return -1;
+		flashrom_layout_set(t->flash, layout);
+	}
+
+	if (flashrom_image_read(t->flash, buf, size) == 0)
+		rc = 0;
+
+	if (layout) {
+		flashrom_layout_set(t->flash, NULL);
+		flashrom_layout_release(layout);
+	}
+	return rc;
+}
+
+static int libflashrom_read_by_name_unlocked(uint8_t **buf,
+					     enum programmer_target target,
+					     const char *region)
+{
+	struct libflashrom_target *t = &libflashrom_targets[target];
+	struct flashrom_layout *layout;
+	unsigned int start, len;
+	uint8_t *image;
+	int rc = -1;
+
+	if (libflashrom_region_layout(t, region, &layout, &start, &len) < 0)
+		return -1;
+
+	/* libflashrom operates on buffers the size of the whole chip */
+	image = mosys_malloc(t->size);
+	flashrom_layout_set(t->flash, layout);
+	if (flashrom_image_read(t->flash, image, t->size)) {
+		lprintf(LOG_DEBUG, "Unable to read region \"%s\"\n", region);
+		goto libflashrom_read_by_name_exit;
+	}
+
+	*buf = mosys_malloc(len);
+	memcpy(*buf, &image[start], len);
+	rc = len;
+
+libflashrom_read_by_name_exit:
+	flashrom_layout_set(t->flash, NULL);
+	flashrom_layout_release(layout);
+	free(image);
+	return rc;
+}
+
+static int libflashrom_read_range_unlocked(uint8_t *buf, unsigned int offset,
+					   unsigned int len,
+					   enum programmer_target target)
+{
+	struct libflashrom_target *t = &libflashrom_targets[target];
+	struct flashrom_layout *layout;
+	uint8_t *image;
+	int rc = -1;
+
+	if (offset + len > t->size)
+		return -1;
+
+	if (flashrom_layout_new(&layout))
+		return -1;
+	if (flashrom_layout_add_region(layout, offset, offset + len - 1,
+				       "range") ||
+	    flashrom_layout_include_region(layout, "range"))
+		goto libflashrom_read_range_exit_0;
+
+	image = mosys_malloc(t->size);
+	flashrom_layout_set(t->flash, layout);
+	if (flashrom_image_read(t->flash, image, t->size)) {
+		lprintf(LOG_DEBUG, "Unable to read range 0x%08x-0x%08x\n",
+		        offset, offset + len - 1);
+		goto libflashrom_read_range_exit_1;
+	}
+
+	memcpy(buf, &image[offset], len);
+	rc = 0;
+
+libflashrom_read_range_exit_1:
+	flashrom_layout_set(t->flash, NULL);
+	free(image);
+libflashrom_read_range_exit_0:
+	flashrom_layout_release(layout);
+	return rc;
+}
+
+static int libflashrom_read_regions_unlocked(struct flashrom_region *regions,
+					     int num,
+					     enum programmer_target target)
+{
+	struct libflashrom_target *t = &libflashrom_targets[target];
+	struct flashrom_layout *layout;
+	unsigned int *start, *len;
+	uint8_t *image = NULL;
+	int i, rc = -1;
+
+	if (!t->fmap && flashrom_layout_read_fmap_from_rom(&t->fmap,
+							t->flash, 0, t->size)) {
+		t->fmap = NULL;
+		return -1;
+	}
+
+	if (flashrom_layout_new(&layout))
+		return -1;
+
+	start = mosys_zalloc(num * sizeof(*start));
+	len = mosys_zalloc(num * sizeof(*len));
+	for (i = 0; i < num; i++) {
+		if (flashrom_layout_get_region_range(t->fmap, regions[i].name,
+						     &start[i], &len[i]) ||
+		    flashrom_layout_add_region(layout, start[i],
+					       start[i] + len[i] - 1,
+					       regions[i].name) ||
+		    flashrom_layout_include_region(layout, regions[i].name)) {
+			lprintf(LOG_DEBUG, "%s: Region \"%s\" not found\n",
+			        __func__, regions[i].name);
+			goto libflashrom_read_regions_exit;
+		}
+	}
+
+	image = mosys_malloc(t->size);
+	flashrom_layout_set(t->flash, layout);
+	if (flashrom_image_read(t->flash, image, t->size)) {
+		lprintf(LOG_DEBUG, "Unable to read %d regions\n", num);
+		goto libflashrom_read_regions_exit;
+	}
+
+	for (i = 0; i < num; i++) {
+		regions[i].buf = mosys_malloc(len[i]);
+		memcpy(regions[i].buf, &image[start[i]], len[i]);
+		regions[i].len = len[i];
+	}
+	rc = 0;
+
+libflashrom_read_regions_exit:
+	flashrom_layout_set(t->flash, NULL);
+	flashrom_layout_release(layout);
+	free(image);
+	free(start);
+	free(len);
+	return rc;
+}
+
+static int libflashrom_write_by_name_unlocked(size_t size, uint8_t *buf,
+					      enum programmer_target target,
+					      const char *region)
+{
+	struct libflashrom_target *t = &libflashrom_targets[target];
+	struct flashrom_layout *layout;
+	unsigned int start, len;
+	uint8_t *image;
+	int rc = -1;
+
+	if (libflashrom_region_layout(t, region, &layout, &start, &len) < 0)
+		return -1;
+
+	if (size != len) {
+		lprintf(LOG_DEBUG, "%s: Size of data: %zu, region \"%s\" "
+		        "is %u bytes\n", __func__, size, region, len);
+		goto libflashrom_write_by_name_exit_0;
+	}
+
+	/* only the included region is written, the rest is don't-care */
+	image = mosys_malloc(t->size);
+	memset(image, 0xff, t->size);
+	memcpy(&image[start], buf, size);
+
+	flashrom_layout_set(t->flash, layout);
+	if (flashrom_image_write(t->flash, image, t->size, NULL)) {
+		lprintf(LOG_DEBUG, "Unable to write region \"%s\"\n", region);
+		goto libflashrom_write_by_name_exit_1;
+	}
+
+	rc = size;
+
+libflashrom_write_by_name_exit_1:
+	flashrom_layout_set(t->flash, NULL);
+	free(image);
+libflashrom_write_by_name_exit_0:
+	flashrom_layout_release(layout);
+	return rc;
+}
+
+static int libflashrom_write_range_unlocked(uint8_t *buf, unsigned int offset,
+					    unsigned int len,
+					    enum programmer_target target)
+{
+	struct libflashrom_target *t = &libflashrom_targets[target];
+	struct flashrom_layout *layout;
+	uint8_t *image;
+	int rc = -1;
+
+	if (offset + len > t->size)
+		return -1;
+
+	if (flashrom_layout_new(&layout))
+		return -1;
+	if (flashrom_layout_add_region(layout, offset, offset + len - 1,
+				       "range") ||
+	    flashrom_layout_include_region(layout, "range"))
+		goto libflashrom_write_range_exit_0;
+
+	/* only the included range is written, the rest is don't-care */
+	image = mosys_malloc(t->size);
+	memset(image, 0xff, t->size);
+	memcpy(&image[offset], buf, len);
+
+	flashrom_layout_set(t->flash, layout);
+	if (flashrom_image_write(t->flash, image, t->size, NULL)) {
+		lprintf(LOG_DEBUG, "Unable to write range 0x%08x-0x%08x\n",
+		        offset, offset + len - 1);
+		goto libflashrom_write_range_exit_1;
+	}
+
+	rc = len;
+
+libflashrom_write_range_exit_1:
+	flashrom_layout_set(t->flash, NULL);
+	free(image);
+libflashrom_write_range_exit_0:
+	flashrom_layout_release(layout);
+	return rc;
+}
+
+/* libflashrom is not thread-safe, so operations are serialized */
+static pthread_mutex_t libflashrom_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define LIBFLASHROM_LOCKED(op, params, args)				\
+static int libflashrom_##op params					\
+{									\
+	int rc;								\
+									\
+	pthread_mutex_lock(&libflashrom_lock);				\
+	rc = libflashrom_##op##_unlocked args;				\
+	pthread_mutex_unlock(&libflashrom_lock);			\
+	return rc;							\
+}
+
+LIBFLASHROM_LOCKED(setup, (enum programmer_target target), (target))
+LIBFLASHROM_LOCKED(read,
+		   (uint8_t *buf, size_t size, enum programmer_target target,
+		    const char *region),
+		   (buf, size, target, region))
+LIBFLASHROM_LOCKED(read_by_name,
+		   (uint8_t **buf, enum programmer_target target,
+		    const char *region),
+		   (buf, target, region))
+LIBFLASHROM_LOCKED(read_range,
+		   (uint8_t *buf, unsigned int offset, unsigned int len,
+		    enum programmer_target target),
+		   (buf, offset, len, target))
+LIBFLASHROM_LOCKED(read_regions,
+		   (struct flashrom_region *regions, int num,
+		    enum programmer_target target),
+		   (regions, num, target))
+LIBFLASHROM_LOCKED(write_by_name,
+		   (size_t size, uint8_t *buf, enum programmer_target target,
+		    const char *region),
+		   (size, buf, target, region))
+LIBFLASHROM_LOCKED(write_range,
+		   (uint8_t *buf, unsigned int offset, unsigned int len,
+		    enum programmer_target target),
+		   (buf, offset, len, target))
+
+void libflashrom_set_programmer(enum programmer_target target,
+				 const char *name, const char *params)
+{
+	struct libflashrom_target *t;
+
+	if (target >= ARRAY_SIZE(libflashrom_targets))
+		return;
+
+	pthread_mutex_lock(&libflashrom_lock);
+	t = &libflashrom_targets[target];
+	libflashrom_target_release(t);
+	t->prog_name = name;
+	t->prog_params = params;
+	t->unavailable = 0;
+	pthread_mutex_unlock(&libflashrom_lock);
+}
+
+static int libflashrom_get_size(enum programmer_target target)
+{
+	return libflashrom_targets[target].size;
+}
+
+struct flashrom_backend libflashrom_backend = {
+	.name		= "libflashrom",
+	.setup		= libflashrom_setup,
+	.read		= libflashrom_read,
+	.read_range	= libflashrom_read_range,
+	.read_by_name	= libflashrom_read_by_name,
+	.read_regions	= libflashrom_read_regions,
+	.write_by_name	= libflashrom_write_by_name,
+	.write_range	= libflashrom_write_range,
+	.get_size	= libflashrom_get_size,
+};
@@ -35,6 +35,7 @@
 #include <ctype.h>
 #include <string.h>
 #include <limits.h>
+#include <pthread.h>
 #include <unistd.h>
 
 #include "mosys/alloc.h"
@@ -54,71 +55,259 @@
 #define LINE_MAX	512
 #endif
 
-int probe_frid(const char *frids[])
+/* helper which last matched the platform, for diagnostics */
+static __thread const char *last_method;
+
+const char *probe_method(void)
+{
+	return last_method;
+}
+
+/*
+ * identity_frid  -  return platform name from firmware revision ID
+ *
+ * The FRID begins with the platform name, followed by a dot, followed by
+ * the revision. Only the platform name is kept.
+ *
+ * returns pointer to platform name, valid until exit
+ * returns NULL if not available
+ */
+static const char *identity_frid(void)
 {
-	int ret = 0;
-	off_t len;
 	static char *id = NULL;
+	static int probed = 0;
+	static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	char *raw_frid = NULL, *tmp;
+	off_t len;
 
-	if (!id) {
-		char *raw_frid = NULL, *tmp;
-
-		if (acpi_get_frid(&raw_frid) < 0)
-			goto probe_frid_done;
-
-		/* FRID begins with platform name, followed by a dot, followed
-		 * by revision ID */
-		tmp = strchr(raw_frid, '.');
-		if (!tmp) {
-			lprintf(LOG_DEBUG, "%s: Invalid FRID: \"%s\"\n",
-			                   __func__, raw_frid);
-			free(raw_frid);
-			goto probe_frid_done;
-		}
+	pthread_mutex_lock(&lock);
+	if (probed)
+		goto identity_frid_exit;
+	probed = 1;
+
+	if (acpi_get_frid(&raw_frid) < 0)
+		goto identity_frid_exit;
 
-		len = tmp - raw_frid + 1;
-		id = mosys_malloc(len + 1);
-		snprintf(id, len, "%s", raw_frid);
-		lprintf(LOG_DEBUG, "%s: Platform name: \"%s\"\n", __func__, id);
+	tmp = strchr(raw_frid, '.');
+	if (!tmp) {
+		lprintf(LOG_DEBUG, "%s: Invalid FRID: \"%s\"\n",
+		                   __func__, raw_frid);
 		free(raw_frid);
+		goto identity_frid_exit;
+	}
+
+	len = tmp - raw_frid + 1;
+	id = mosys_malloc(len + 1);
+	snprintf(id, len, "%s", raw_frid);
+	lprintf(LOG_DEBUG, "%s: Platform name: \"%s\"\n", __func__, id);
+	free(raw_frid);
+	add_destroy_callback(free, id);
+
+identity_frid_exit:
+	pthread_mutex_unlock(&lock);
+	return id;
+}
+
+/*
+ * identity_smbios_name  -  return SMBIOS system product name
+ *
+ * @intf:	platform interface
+ *
+ * returns pointer to product name, valid until exit
+ * returns NULL if not available
+ */
+static const char *identity_smbios_name(struct platform_intf *intf)
+{
+	static char *id = NULL;
+	static int probed = 0;
+	static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	struct smbios_table_view view;
+
+	pthread_mutex_lock(&lock);
+	if (probed || !intf)
+		goto identity_smbios_name_exit;
+	probed = 1;
+
+	if (smbios_find_table_view(intf, SMBIOS_TYPE_SYSTEM, 0, &view,
+				   SMBIOS_LEGACY_ENTRY_BASE,
+				   SMBIOS_LEGACY_ENTRY_LEN) == 0) {
+		id = smbios_view_strdup(&view, SMBIOS_FIELD(system, name));
 		add_destroy_callback(free, id);
 	}
 
-	if (strlfind(id, frids, 0)) {
+identity_smbios_name_exit:
+	pthread_mutex_unlock(&lock);
+	return id;
+}
+
+#define FDT_COMPATIBLE	"/proc/device-tree/compatible"
+
+/*
+ * identity_fdt_compatible  -  return FDT compatible list
+ *
+ * @len:	OUTPUT length of list in bytes
+ *
+ * Device tree "compatible" data consists of a list of comma-separated
+ * pairs with a NULL after each pair. For example, "foo,bar\0bam,baz\0"
+ * is foo,bar and bam,baz.
+ *
+ * returns pointer to list, valid until exit
+ * returns NULL if not available
+ */
+static const char *identity_fdt_compatible(int *len)
+{
+	static char *compat = NULL;
+	static int compat_len = 0;
+	static int probed = 0;
+	static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	char path[PATH_MAX];
+	char buf[256];
+	int fd, n;
+
+	pthread_mutex_lock(&lock);
+	if (probed)
+		goto identity_fdt_compatible_exit;
+	probed = 1;
+
+	snprintf(path, PATH_MAX, "%s/%s",
+			mosys_get_root_prefix(), FDT_COMPATIBLE);
+	fd = file_open(path, FILE_READ);
+	if (fd < 0) {
+		lprintf(LOG_DEBUG, "Cannot open %s\n", path);
+		goto identity_fdt_compatible_exit;
+	}
+
+	while ((n = read(fd, buf, sizeof(buf))) > 0) {
+		compat = mosys_realloc(compat, compat_len + n);
+		memcpy(compat + compat_len, buf, n);
+		compat_len += n;
+	}
+	close(fd);
+
+	if (compat)
+		add_destroy_callback(free, compat);
+
+identity_fdt_compatible_exit:
+	*len = compat_len;
+	pthread_mutex_unlock(&lock);
+	return compat;
+}
+
+/*
+ * identity_cpu_model  -  return CPU model name from /proc/cpuinfo
+ *
+ * returns pointer to model name, valid until exit
+ * returns NULL if not available
+ */
+static const char *identity_cpu_model(void)
+{
+	static char *model = NULL;
+	static int probed = 0;
+	static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	char path[PATH_MAX];
+	char line[LINE_MAX], *ptr;
+	FILE *cpuinfo;
+	size_t len;
+
+	pthread_mutex_lock(&lock);
+	if (probed)
+		goto identity_cpu_model_exit;
+	probed = 1;
+
+	snprintf(path, sizeof(path), "%s/proc/cpuinfo",
+	         mosys_get_root_prefix());
+	cpuinfo = fopen(path, "rb");
+	if (!cpuinfo)
+		goto identity_cpu_model_exit;
+
+	while (fgets(line, sizeof(line), cpuinfo) != NULL) {
+		if (strncmp(line, "model name", strlen("model name")))
+			continue;
+
+		ptr = line + strlen("model name");
+		while (isspace((unsigned char)*ptr) || (*ptr == ':'))
+			ptr++;
+		len = strlen(ptr);
+		while (len && isspace((unsigned char)ptr[len - 1]))
+			ptr[--len] = '\0';
+
+		model = mosys_strdup(ptr);
+		add_destroy_callback(free, model);
+		break;
+	}
+	fclose(cpuinfo);
+
+identity_cpu_model_exit:
+	pthread_mutex_unlock(&lock);
+	return model;
+}
+
+const struct platform_identity *probe_identity(struct platform_intf *intf)
+{
+	static struct platform_identity identity;
+	static int probed = 0;
+	static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+	pthread_mutex_lock(&lock);
+	if (probed)
+		goto probe_identity_exit;
+	probed = 1;
+
+	identity.smbios_name = identity_smbios_name(intf);
+	identity.frid = identity_frid();
+	identity.fdt_compatible =
+		identity_fdt_compatible(&identity.fdt_compatible_len);
+	identity.cpu_model = identity_cpu_model();
+
+	lprintf(LOG_DEBUG, "%s: smbios \"%s\", frid \"%s\", cpu \"%s\"\n",
+	        __func__, identity.smbios_name ? : "",
+	        identity.frid ? : "", identity.cpu_model ? : "");
+
+probe_identity_exit:
+	pthread_mutex_unlock(&lock);
+	return &identity;
+}
+
+int probe_frid(const char *frids[])
+{
+	const char *id;
+
+	id = identity_frid();
+	if (id && strlfind(id, frids, 0)) {
 		lprintf(LOG_DEBUG, "%s: matched id \"%s\"\n", __func__, id);
-		ret = 1;
+		last_method = "frid";
+		return 1;
 	}
 
-probe_frid_done:
-	return ret;
+	return 0;
 }
 
 int probe_smbios(struct platform_intf *intf, const char *ids[])
 {
 	static char *id = NULL;
+	static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
 	int ret = 0;
 
+	pthread_mutex_lock(&lock);
 	if (id)
 		goto probe_smbios_cmp;
 
 	/* Attempt platform-specific SMBIOS handler if one exists, else use the
 	 * default approach. */
-	if (intf->cb->smbios && intf->cb->smbios->system_name) {
+	if (intf->cb->smbios && intf->cb->smbios->system_name)
 		id = intf->cb->smbios->system_name(intf);
-	} else {
-		struct smbios_table table;
-		if (smbios_find_table(intf, SMBIOS_TYPE_SYSTEM, 0, &table,
-				      SMBIOS_LEGACY_ENTRY_BASE,
-				      SMBIOS_LEGACY_ENTRY_LEN) == 0)
-			id = table.string[table.data.system.name];
-	}
+	else
+		id = (char *)identity_smbios_name(intf);
 
 probe_smbios_cmp:
+	pthread_mutex_unlock(&lock);
+
 	if (!id) {
 		ret = 0;
 		lprintf(LOG_SPEW, "%s: cannot find product name\n", __func__);
 	} else if (strlfind(id, ids, 0)) {
 		ret = 1;
+		last_method = "smbios";
 		lprintf(LOG_DEBUG, "%s: matched id \"%s\"\n", __func__, id);
 	}
 	return ret;
@@ -168,6 +357,7 @@ int probe_cpuinfo(struct platform_intf *intf,
 			lprintf(LOG_DEBUG, "no\n");
 		} else {
 			lprintf(LOG_DEBUG, "yes\n");
+			last_method = "cpuinfo";
 			ret = 1;
 		}
 	}
@@ -241,8 +431,10 @@ int probe_cmdline(const char *key, int cs)
 			ret = 1;
 	}
 
-	if (ret)
+	if (ret) {
 		lprintf(LOG_DEBUG, "Found match on kernel command-line\n", key);
+		last_method = "cmdline";
+	}
 probe_cmdline_done:
 	fclose(cmdline);
 	return ret;
@@ -302,69 +494,45 @@ char *fdt_model(void)
 	return model;
 }
 
-#define FDT_COMPATIBLE	"/proc/device-tree/compatible"
 int probe_fdt_compatible(const char *id_list[], int num_ids, int allow_partial)
 {
-	int ret = -1, i, fd;
-	char path[PATH_MAX];
-	char compat[64];	/* arbitrarily chosen max size */
-	char *p;
+	const char *compat, *p, *end;
+	int len, i;
 
 	lprintf(LOG_DEBUG, "Probing platform with FDT compatible node\n");
 
-	snprintf(path, PATH_MAX, "%s/%s",
-			mosys_get_root_prefix(), FDT_COMPATIBLE);
-	fd = file_open(path, FILE_READ);
-	if (fd < 0) {
-		lprintf(LOG_DEBUG, "Cannot open %s\n", path);
+	compat = identity_fdt_compatible(&len);
+	if (!compat)
 		return -1;
-	}
 
-	/*
-	 * Device tree "compatible" data consists of a list of comma-separated
-	 * pairs with a NULL after each pair. For example, "foo,bar\0bam,baz\0"
-	 * is foo,bar and bam,baz.
-	 */
-	p = &compat[0];
-	while (read(fd, p, 1) == 1) {
-		if (*p != 0) {
-			p++;
-			if (p - &compat[0] > sizeof(compat)) {
-				lprintf(LOG_ERR,
-					"FDT compatible identifier too long\n");
-				goto probe_fdt_compatible_exit;
-			}
-			continue;
-		}
+	/* only entries which are null-terminated are considered */
+	end = compat + len;
+	for (p = compat; p < end; p += strlen(p) + 1) {
+		if (!memchr(p, '\0', end - p))
+			break;
 
 		for (i = 0; (i < num_ids) && id_list[i]; i++) {
 			int cmp = 0;
 
 			lprintf(LOG_DEBUG, "\t\"%s\" == \"%s\" ? ",
-					&compat[0], id_list[i]);
+					p, id_list[i]);
 
-			if (allow_partial) {
-				cmp = strncmp(&compat[0],
-					id_list[i], strlen(id_list[i]));
-			} else {
-				cmp = strcmp(&compat[0], id_list[i]);
-			}
+			if (allow_partial)
+				cmp = strncmp(p, id_list[i], strlen(id_list[i]));
+			else
+				cmp = strcmp(p, id_list[i]);
 
 			if (!cmp) {
 				lprintf(LOG_DEBUG, "yes\n");
-				ret = i;
-				goto probe_fdt_compatible_exit;
+				last_method = "fdt";
+				return i;
 			} else {
 				lprintf(LOG_DEBUG, "no\n");
 			}
 		}
-
-		p = &compat[0];
 	}
 
-probe_fdt_compatible_exit:
-	close(fd);
-	return ret;
+	return -1;
 }
 
 struct cros_compat_tuple *cros_fdt_tuple(void)
@@ -9,7 +9,6 @@
 #include <unistd.h>
 
 #include "mosys/alloc.h"
-#include "mosys/big_lock.h"
 #include "mosys/callbacks.h"
 #include "mosys/globals.h"
 #include "mosys/log.h"
@@ -18,29 +17,9 @@
 #include "lib/file.h"
 #include "lib/sku.h"
 #include "lib/string.h"
+#include "lib/vpd_kv.h"
 
 
-static int _release_lock(void)
-{
-#if defined(CONFIG_USE_IPC_LOCK)
-	return mosys_release_big_lock() >= 0;
-#endif
-	return 0;
-}
-
-static int _acquire_lock()
-{
-#if defined(CONFIG_USE_IPC_LOCK)
-	/* Timeout copied from lib/flashrom/flashrom.c */
-	if (mosys_acquire_big_lock(50000) < 0) {
-		lprintf(LOG_DEBUG, "%s: could not re-acquire lock\n",
-			__func__);
-		return -1;
-	}
-#endif
-	return 0;
-}
-
 /*
  * Strips the "end of line" character (\n) in string.
  */
@@ -75,27 +54,6 @@ static char *_read_close_stripped_line(FILE *fp)
 	return mosys_strdup(buffer);
 }
 
-/*
- * Reads and returns a VPD value.
- */
-static char *_get_vpd_value(const char *key_name)
-{
-	char command[PATH_MAX];
-	FILE *fp = NULL;
-	int relock = 0;
-	char *value;
-
-	snprintf(command, sizeof(command), "vpd_get_value %s", key_name);
-	command[sizeof(command) - 1] = '\0';
-
-	relock = _release_lock();
-	fp = popen(command, "r");
-	value = _read_close_stripped_line(fp);
-	if (relock)
-		_acquire_lock();
-	return value;
-}
-
 /*
  * Extracts the SERIES part from VPD "customization_id".
  *
@@ -107,7 +65,7 @@ static char *_extract_customization_id_series_part(void)
 	char *customization_id;
 	char *series = NULL, *dash;
 
-	customization_id = _get_vpd_value("customization_id");
+	customization_id = vpd_kv_get("customization_id");
 	if (!customization_id)
 		return NULL;
 
@@ -163,7 +121,7 @@ char *sku_get_brand(struct platform_intf *intf)
 	if (fp)
 		return _read_close_stripped_line(fp);
 
-	return _get_vpd_value("rlz_brand_code");
+	return vpd_kv_get("rlz_brand_code");
 }
 
 char *sku_get_chassis(struct platform_intf *intf)
@@ -207,7 +165,7 @@ char *sku_get_model(struct platform_intf *intf)
 char *sku_get_customization(struct platform_intf *intf)
 {
 	const struct sku_info *info = intf->sku_info;
-	char *result = _get_vpd_value("customization_id");
+	char *result = vpd_kv_get("customization_id");
 
 	/* Unlike other SKU values, we trust VPD than mosys table. */
 	if (result)
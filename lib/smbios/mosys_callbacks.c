@@ -106,16 +106,16 @@ smbios_scan_sysfs_exit:
 char *smbios_bios_get_vendor(struct platform_intf *intf)
 {
 	char *str = NULL;
-	struct smbios_table table;
+	struct smbios_table_view view;
 
-	if (smbios_find_table(intf, SMBIOS_TYPE_BIOS, 0, &table,
-			      SMBIOS_LEGACY_ENTRY_BASE,
-			      SMBIOS_LEGACY_ENTRY_LEN) < 0) {
+	if (smbios_find_table_view(intf, SMBIOS_TYPE_BIOS, 0, &view,
+				   SMBIOS_LEGACY_ENTRY_BASE,
+				   SMBIOS_LEGACY_ENTRY_LEN) < 0) {
 		lprintf(LOG_DEBUG, "%s: normal method failed, "
 		                   "trying sysfs\n", __func__);
 		str = smbios_scan_sysfs("bios_vendor");
 	} else {
-		str = mosys_strdup(table.string[table.data.bios.vendor]);
+		str = smbios_view_strdup(&view, SMBIOS_FIELD(bios, vendor));
 	}
 
 	return str;
@@ -132,17 +132,17 @@ char *smbios_bios_get_vendor(struct platform_intf *intf)
 char *smbios_sysinfo_get_vendor(struct platform_intf *intf)
 {
 	char *str = NULL;
-	struct smbios_table table;
+	struct smbios_table_view view;
 
-	if (smbios_find_table(intf, SMBIOS_TYPE_SYSTEM, 0, &table,
-			      SMBIOS_LEGACY_ENTRY_BASE,
-			      SMBIOS_LEGACY_ENTRY_LEN) < 0) {
+	if (smbios_find_table_view(intf, SMBIOS_TYPE_SYSTEM, 0, &view,
+				   SMBIOS_LEGACY_ENTRY_BASE,
+				   SMBIOS_LEGACY_ENTRY_LEN) < 0) {
 		lprintf(LOG_DEBUG, "%s: normal method failed, "
 		                   "trying sysfs\n", __func__);
 		str = smbios_scan_sysfs("sys_vendor");
 	} else {
-		str = mosys_strdup(table.string
-				   [table.data.system.manufacturer]);
+		str = smbios_view_strdup(&view,
+				 SMBIOS_FIELD(system, manufacturer));
 	}
 
 	return str;
@@ -159,15 +159,15 @@ char *smbios_sysinfo_get_vendor(struct platform_intf *intf)
 char *smbios_sysinfo_get_name(struct platform_intf *intf)
 {
 	char *str = NULL;
-	struct smbios_table table;
+	struct smbios_table_view view;
 
-	if (smbios_find_table(intf, SMBIOS_TYPE_SYSTEM, 0, &table,
-			      SMBIOS_LEGACY_ENTRY_BASE,
-			      SMBIOS_LEGACY_ENTRY_LEN) < 0) {
+	if (smbios_find_table_view(intf, SMBIOS_TYPE_SYSTEM, 0, &view,
+				   SMBIOS_LEGACY_ENTRY_BASE,
+				   SMBIOS_LEGACY_ENTRY_LEN) < 0) {
 		lprintf(LOG_DEBUG, "%s: attempting to use sysfs\n", __func__);
 		str = smbios_scan_sysfs("product_name");
 	} else {
-		str = mosys_strdup(table.string[table.data.system.name]);
+		str = smbios_view_strdup(&view, SMBIOS_FIELD(system, name));
 	}
 
 	return str;
@@ -184,16 +184,16 @@ char *smbios_sysinfo_get_name(struct platform_intf *intf)
 char *smbios_sysinfo_get_version(struct platform_intf *intf)
 {
 	char *str = NULL;
-	struct smbios_table table;
+	struct smbios_table_view view;
 
-	if (smbios_find_table(intf, SMBIOS_TYPE_SYSTEM, 0, &table,
-			      SMBIOS_LEGACY_ENTRY_BASE,
-			      SMBIOS_LEGACY_ENTRY_LEN) < 0) {
+	if (smbios_find_table_view(intf, SMBIOS_TYPE_SYSTEM, 0, &view,
+				   SMBIOS_LEGACY_ENTRY_BASE,
+				   SMBIOS_LEGACY_ENTRY_LEN) < 0) {
 		lprintf(LOG_INFO, "%s: normal approach failed, trying sysfs\n",
 		                  __func__);
 		str = smbios_scan_sysfs("product_version");
 	} else {
-		str = mosys_strdup(table.string[table.data.system.version]);
+		str = smbios_view_strdup(&view, SMBIOS_FIELD(system, version));
 	}
 
 	return str;
@@ -209,14 +209,14 @@ char *smbios_sysinfo_get_version(struct platform_intf *intf)
  */
 char *smbios_sysinfo_get_family(struct platform_intf *intf)
 {
-	struct smbios_table table;
+	struct smbios_table_view view;
 
-	if (smbios_find_table(intf, SMBIOS_TYPE_SYSTEM, 0, &table,
-			      SMBIOS_LEGACY_ENTRY_BASE,
-			      SMBIOS_LEGACY_ENTRY_LEN) < 0)
+	if (smbios_find_table_view(intf, SMBIOS_TYPE_SYSTEM, 0, &view,
+				   SMBIOS_LEGACY_ENTRY_BASE,
+				   SMBIOS_LEGACY_ENTRY_LEN) < 0)
 		return NULL;
 
-	return mosys_strdup(table.string[table.data.system.family]);
+	return smbios_view_strdup(&view, SMBIOS_FIELD(system, family));
 }
 
 /*
@@ -229,14 +229,14 @@ char *smbios_sysinfo_get_family(struct platform_intf *intf)
  */
 char *smbios_sysinfo_get_sku(struct platform_intf *intf)
 {
-	struct smbios_table table;
+	struct smbios_table_view view;
 
-	if (smbios_find_table(intf, SMBIOS_TYPE_SYSTEM, 0, &table,
-			      SMBIOS_LEGACY_ENTRY_BASE,
-			      SMBIOS_LEGACY_ENTRY_LEN) < 0)
+	if (smbios_find_table_view(intf, SMBIOS_TYPE_SYSTEM, 0, &view,
+				   SMBIOS_LEGACY_ENTRY_BASE,
+				   SMBIOS_LEGACY_ENTRY_LEN) < 0)
 		return NULL;
 
-	return mosys_strdup(table.string[table.data.system.sku_number]);
+	return smbios_view_strdup(&view, SMBIOS_FIELD(system, sku_number));
 }
 
 /*
@@ -282,32 +282,32 @@ struct smbios_cb smbios_sysinfo_cb = {
  */
 int smbios_dimm_count(struct platform_intf *intf)
 {
-	int status = 0, dimm_cnt = 0;
-	struct smbios_table table;
-
-	while (status == 0) {
-		status = smbios_find_table(intf, SMBIOS_TYPE_MEMORY, dimm_cnt,
-					   &table,
-					   SMBIOS_LEGACY_ENTRY_BASE,
-					   SMBIOS_LEGACY_ENTRY_LEN);
-		if (status == 0)
-			dimm_cnt++;
-	}
+	int dimm_cnt;
+
+	dimm_cnt = smbios_count_tables(intf, SMBIOS_TYPE_MEMORY,
+				       SMBIOS_LEGACY_ENTRY_BASE,
+				       SMBIOS_LEGACY_ENTRY_LEN);
 
-	return dimm_cnt;
+	return dimm_cnt < 0 ? 0 : dimm_cnt;
 }
 
 int smbios_dimm_speed(struct platform_intf *intf,
 		     int dimm, struct kv_pair *kv)
 {
-	struct smbios_table table;
-	if (smbios_find_table(intf, SMBIOS_TYPE_MEMORY, dimm, &table,
-			      SMBIOS_LEGACY_ENTRY_BASE,
-			      SMBIOS_LEGACY_ENTRY_LEN) < 0) {
+	struct smbios_table_view view;
+	uint16_t speed;
+
+	if (smbios_find_table_view(intf, SMBIOS_TYPE_MEMORY, dimm, &view,
+				   SMBIOS_LEGACY_ENTRY_BASE,
+				   SMBIOS_LEGACY_ENTRY_LEN) < 0) {
 		return -1;
 	}
 
-	kv_pair_fmt(kv, "speed", "%d MHz", table.data.mem_device.speed);
+	if (smbios_view_get_u16(&view, SMBIOS_FIELD(memory_device, speed),
+				&speed) < 0)
+		speed = 0;
+
+	kv_pair_fmt(kv, "speed", "%d MHz", speed);
 
 	return 0;
 }
@@ -31,10 +31,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <unistd.h>
 #include <string.h>
 #include <fcntl.h>
 #include <ctype.h>
+#include <pthread.h>
 
 #if defined (__linux__)
 #include <sys/klog.h>
@@ -53,16 +55,44 @@
 #include "lib/smbios.h"
 #include "lib/string.h"
 
+/* Maximum number of table types, including OEM-specific types */
+#define SMBIOS_NUM_TYPES	256
+
+/* Location of a table and its strings, which are resolved on demand */
+struct smbios_index_entry {
+	uint32_t offset;		/* offset of table in data */
+	int num_strings;		/* <0 until strings are resolved */
+	const char **strings;		/* pointers into string table */
+};
+
+/* Tables of one type, in the order they appear in the structure table */
+struct smbios_type_index {
+	int count;
+	int alloc;
+	struct smbios_index_entry *tables;
+};
+
+/* Location of tables exported by the kernel */
+#define SMBIOS_SYSFS_ENTRY_POINT	"/sys/firmware/dmi/tables/smbios_entry_point"
+#define SMBIOS_SYSFS_TABLE		"/sys/firmware/dmi/tables/DMI"
+
 /* Iterator used for table parsing */
 struct smbios_iterator {
-	struct smbios_entry *entry;	/* entry pointer */
-	struct smbios_header *header;	/* current header */
+	uint64_t table_address;		/* physical address of table */
+	uint32_t table_length;		/* length of table data */
+	int mapped;			/* data is mapped from memory */
 	uint8_t *data;			/* table data */
-	uint8_t *current;		/* pointer into data */
+	struct smbios_type_index index[SMBIOS_NUM_TYPES];
 };
 
 static struct smbios_iterator *smbios_itr = NULL;
 
+/*
+ * Protects iterator setup and lazy string resolution. The index itself is
+ * not modified once built, so lookups may run concurrently.
+ */
+static pthread_mutex_t smbios_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * smbios_parse_string_table  -  parse strings into table structure
  *
@@ -290,6 +320,78 @@ int smbios_find_entry(struct platform_intf *intf, struct smbios_entry *entry,
 	return 0;
 }
 
+/* header of an indexed table */
+static inline struct smbios_header *smbios_index_header(
+				struct smbios_index_entry *entry)
+{
+	return (struct smbios_header *)(smbios_itr->data + entry->offset);
+}
+
+/* start of string table of an indexed table */
+static inline char *smbios_index_strings(struct smbios_index_entry *entry)
+{
+	return (char *)smbios_itr->data + entry->offset +
+	       smbios_index_header(entry)->length;
+}
+
+/*
+ * smbios_itr_build_index  -  index all tables by type and instance
+ *
+ * @itr:	iterator whose tables to index
+ *
+ * The structure table is walked once. Tables are recorded in the order
+ * they appear so that instance numbers match a linear search. Walking
+ * stops at the end-of-table marker or at the first malformed table.
+ */
+static void smbios_itr_build_index(struct smbios_iterator *itr)
+{
+	struct smbios_header *header;
+	struct smbios_type_index *idx;
+	struct smbios_index_entry *entry;
+	const uint8_t *end = itr->data + itr->table_length;
+	const uint8_t *ptr = itr->data;
+	const uint8_t *strings;
+
+	while (ptr + sizeof(*header) <= end) {
+		header = (struct smbios_header *)ptr;
+		if (header->length < sizeof(*header) ||
+		    ptr + header->length > end) {
+			lprintf(LOG_DEBUG, "%s: malformed table at offset "
+			        "%u\n", __func__, (unsigned int)(ptr - itr->data));
+			break;
+		}
+
+		/* the string table ends with two consecutive nul bytes */
+		for (strings = ptr + header->length;
+		     strings + 1 < end && (strings[0] || strings[1]);
+		     strings++)
+			;
+		if (strings + 1 >= end) {
+			lprintf(LOG_DEBUG, "%s: unterminated strings at "
+			        "offset %u\n", __func__,
+			        (unsigned int)(ptr - itr->data));
+			break;
+		}
+
+		idx = &itr->index[header->type];
+		if (idx->count == idx->alloc) {
+			idx->alloc = idx->alloc ? idx->alloc * 2 : 4;
+			idx->tables = mosys_realloc(idx->tables, idx->alloc *
+			                            sizeof(*idx->tables));
+		}
+
+		entry = &idx->tables[idx->count++];
+		entry->offset = ptr - itr->data;
+		entry->num_strings = -1;
+		entry->strings = NULL;
+
+		if (header->type == SMBIOS_TYPE_END)
+			break;
+
+		ptr = strings + 2;
+	}
+}
+
 /*
  * smbios_itr_destroy  -  clean up iterator
  *
@@ -298,22 +400,201 @@ int smbios_find_entry(struct platform_intf *intf, struct smbios_entry *entry,
 static void smbios_itr_destroy(void *arg)
 {
 	struct platform_intf *intf = arg;
+	int type, i;
+
 	if (smbios_itr) {
+		/* clean up index */
+		for (type = 0; type < SMBIOS_NUM_TYPES; type++) {
+			struct smbios_type_index *idx = &smbios_itr->index[type];
+
+			for (i = 0; i < idx->count; i++)
+				free(idx->tables[i].strings);
+			free(idx->tables);
+		}
 		/* clean up smbios table buffer */
-		if (smbios_itr->data) {
+		if (smbios_itr->data && smbios_itr->mapped) {
 			mmio_unmap(intf, smbios_itr->data,
-			           smbios_itr->entry->table_address,
-			           smbios_itr->entry->table_length);
+			           smbios_itr->table_address,
+			           smbios_itr->table_length);
+		} else {
+			free(smbios_itr->data);
 		}
-		/* clean up smbios entry */
-		if (smbios_itr->entry)
-			free(smbios_itr->entry);
 		/* clean up iterator */
 		free(smbios_itr);
 		smbios_itr = NULL;
 	}
 }
 
+/*
+ * smbios_sysfs_read  -  read a file exported by the kernel
+ *
+ * @name:	path of file, relative to root prefix
+ * @buf:	buffer to allocate and fill in
+ *
+ * returns number of bytes read and allocates *buf
+ * returns <0 to indicate failure
+ */
+static int smbios_sysfs_read(const char *name, uint8_t **buf)
+{
+	char path[PATH_MAX];
+	uint8_t *data = NULL;
+	size_t alloc = 0, total = 0;
+	ssize_t len;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s%s", mosys_get_root_prefix(), name);
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		lperror(LOG_DEBUG, "Unable to open %s", path);
+		return -1;
+	}
+
+	/* sysfs does not report a size for these files, read until EOF */
+	do {
+		if (total == alloc) {
+			alloc = alloc ? alloc * 2 : 4096;
+			data = mosys_realloc(data, alloc);
+		}
+		len = read(fd, data + total, alloc - total);
+		if (len > 0)
+			total += len;
+	} while (len > 0);
+	close(fd);
+
+	if (len < 0 || total == 0) {
+		lprintf(LOG_DEBUG, "Unable to read %s\n", path);
+		free(data);
+		return -1;
+	}
+
+	*buf = data;
+	return total;
+}
+
+/*
+ * smbios_sysfs_setup  -  load tables exported in sysfs
+ *
+ * @itr:	iterator to fill in
+ *
+ * The kernel exports the entry point and the structure table under
+ * /sys/firmware/dmi/tables on EFI and legacy systems alike, so no search
+ * of physical memory is needed. Both the 32-bit and the SMBIOS 3.0 64-bit
+ * entry points are understood.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int smbios_sysfs_setup(struct smbios_iterator *itr)
+{
+	uint8_t *ep, csum;
+	uint8_t *data;
+	uint32_t table_length;
+	uint64_t table_address;
+	int ep_len, len, i;
+
+	ep_len = smbios_sysfs_read(SMBIOS_SYSFS_ENTRY_POINT, &ep);
+	if (ep_len < 0)
+		return -1;
+
+	if (ep_len >= sizeof(struct smbios3_entry) &&
+	    !memcmp(ep, SMBIOS3_ENTRY_MAGIC, strlen(SMBIOS3_ENTRY_MAGIC))) {
+		struct smbios3_entry *entry = (struct smbios3_entry *)ep;
+
+		lprintf(LOG_DEBUG, "SMBIOS Entry Version:   %d.%d (64-bit)\n",
+		        entry->major_ver, entry->minor_ver);
+		if (entry->entry_length > ep_len) {
+			lprintf(LOG_DEBUG, "Truncated SMBIOS 3.0 entry\n");
+			free(ep);
+			return -1;
+		}
+		for (csum = i = 0; i < entry->entry_length; i++)
+			csum += ep[i];
+		table_address = entry->table_address;
+		table_length = entry->max_size;
+	} else if (ep_len >= sizeof(struct smbios_entry) &&
+	           !memcmp(ep, SMBIOS_ENTRY_MAGIC,
+	                   strlen(SMBIOS_ENTRY_MAGIC))) {
+		struct smbios_entry *entry = (struct smbios_entry *)ep;
+
+		lprintf(LOG_DEBUG, "SMBIOS Entry Version:   %d.%d\n",
+		        entry->major_ver, entry->minor_ver);
+		if (entry->entry_length > ep_len) {
+			lprintf(LOG_DEBUG, "Truncated SMBIOS entry\n");
+			free(ep);
+			return -1;
+		}
+		for (csum = i = 0; i < entry->entry_length; i++)
+			csum += ep[i];
+		table_address = entry->table_address;
+		table_length = entry->table_length;
+	} else {
+		lprintf(LOG_DEBUG, "Unknown SMBIOS entry in %s\n",
+		        SMBIOS_SYSFS_ENTRY_POINT);
+		free(ep);
+		return -1;
+	}
+	free(ep);
+
+	if (csum != 0)
+		lprintf(LOG_DEBUG, "Invalid SMBIOS checksum: %02x\n", csum);
+
+	len = smbios_sysfs_read(SMBIOS_SYSFS_TABLE, &data);
+	if (len < 0)
+		return -1;
+
+	/* for 3.0 entries the length is only an upper bound */
+	if (table_length == 0 || table_length > len)
+		table_length = len;
+
+	lprintf(LOG_DEBUG, "SMBIOS Table Address:   0x%016" PRIx64 "\n",
+	        table_address);
+	lprintf(LOG_DEBUG, "SMBIOS Table Length:    %u\n", table_length);
+
+	itr->table_address = table_address;
+	itr->table_length = table_length;
+	itr->mapped = 0;
+	itr->data = data;
+	return 0;
+}
+
+/*
+ * smbios_mem_setup  -  search physical memory for tables
+ *
+ * @intf:	platform interface
+ * @itr:	iterator to fill in
+ * @baseaddr:	base address to start searching in
+ * @len:	length of region to search (in bytes)
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int smbios_mem_setup(struct platform_intf *intf,
+                            struct smbios_iterator *itr,
+                            unsigned int baseaddr, unsigned int len)
+{
+	struct smbios_entry entry;
+
+	/* search for entry pointer */
+	if (smbios_find_entry(intf, &entry, baseaddr, len) < 0)
+		return -1;
+	if (entry.table_length == 0)
+		return -1;
+
+	/* mmap in entire smbios area */
+	itr->data = mmio_map(intf, O_RDONLY,
+	                     entry.table_address, entry.table_length);
+	if (itr->data == NULL) {
+		lprintf(LOG_ERR, "Unable to find SMBIOS tables at 0x%08x\n",
+		        entry.table_address);
+		return -1;
+	}
+
+	itr->table_address = entry.table_address;
+	itr->table_length = entry.table_length;
+	itr->mapped = 1;
+	return 0;
+}
+
 /*
  * smbios_itr_setup  -  setup iterator for smbios searching
  *
@@ -321,137 +602,294 @@ static void smbios_itr_destroy(void *arg)
  * @baseaddr:	base address to start searching in
  * @len:	length of region to search (in bytes)
  *
+ * Tables exported by the kernel are preferred. Physical memory and the
+ * kernel log are only searched when those are not available.
+ *
  * returns 0 to indicate successful setup or reset to setup
  * returns <0 to indicate failure
  */
 static int smbios_itr_setup(struct platform_intf *intf,
                             unsigned int baseaddr, unsigned int len)
 {
+	int ret = 0;
+
+	pthread_mutex_lock(&smbios_lock);
+
 	/* already setup? */
-	if (smbios_itr) {
-		/* reset to start of tables */
-		smbios_itr->current = smbios_itr->data;
-		smbios_itr->header =
-		        (struct smbios_header *)smbios_itr->current;
-		return 0;
-	}
+	if (smbios_itr)
+		goto smbios_itr_setup_exit;
 
 	/* setup iterator */
 	smbios_itr = mosys_malloc(sizeof(*smbios_itr));
 	memset(smbios_itr, 0, sizeof(*smbios_itr));
 
-	smbios_itr->entry = mosys_malloc(sizeof(*smbios_itr->entry));
-	memset(smbios_itr->entry, 0, sizeof(*smbios_itr->entry));
-
-	/* search for entry pointer */
-	if (smbios_find_entry(intf, smbios_itr->entry, baseaddr, len) < 0) {
+	if (smbios_sysfs_setup(smbios_itr) < 0 &&
+	    smbios_mem_setup(intf, smbios_itr, baseaddr, len) < 0) {
 		smbios_itr_destroy(intf);
-		return -1;
+		ret = -1;
+		goto smbios_itr_setup_exit;
 	}
-	if (smbios_itr->entry->table_length == 0) {
-		smbios_itr_destroy(intf);
-		return -1;
+
+	if (mosys_get_verbosity() == LOG_DEBUG)
+		print_buffer(smbios_itr->data, smbios_itr->table_length);
+
+	/* make sure we get torn down at exit time. */
+	add_destroy_callback(smbios_itr_destroy, intf);
+
+	smbios_itr_build_index(smbios_itr);
+
+smbios_itr_setup_exit:
+	pthread_mutex_unlock(&smbios_lock);
+	return ret;
+}
+
+/*
+ * smbios_find_table_raw  -  locate table in index
+ *
+ * @intf:	platform interface
+ * @type:	smbios table type
+ * @instance:	smbios table instance
+ * @baseaddr:	base address to start searching in
+ * @len:	length of region to search (in bytes)
+ *
+ * returns pointer to index entry if found
+ * returns NULL if not found
+ */
+static struct smbios_index_entry *smbios_find_table_raw(
+				struct platform_intf *intf,
+				enum smbios_types type, int instance,
+				unsigned int baseaddr, unsigned int len)
+{
+	struct smbios_type_index *idx;
+
+	if (type >= SMBIOS_NUM_TYPES || instance < 0)
+		return NULL;
+
+	if (smbios_itr_setup(intf, baseaddr, len) < 0)
+		return NULL;
+
+	idx = &smbios_itr->index[type];
+	if (instance >= idx->count)
+		return NULL;
+
+	if (mosys_get_verbosity() == LOG_DEBUG)
+		print_buffer(smbios_itr->data + idx->tables[instance].offset,
+		             smbios_index_header(&idx->tables[instance])->length);
+
+	return &idx->tables[instance];
+}
+
+/*
+ * smbios_index_string  -  look up string of an indexed table
+ *
+ * @entry:	index entry of table
+ * @num:	number of string to return (0-based)
+ *
+ * The table's strings are located the first time any of them is needed.
+ *
+ * returns pointer to string within the structure table
+ * returns NULL if not found
+ */
+static const char *smbios_index_string(struct smbios_index_entry *entry,
+                                       int num)
+{
+	const char *ptr, *end;
+	int count;
+
+	pthread_mutex_lock(&smbios_lock);
+	if (entry->num_strings < 0) {
+		end = (const char *)smbios_itr->data +
+		      smbios_itr->table_length;
+		ptr = smbios_index_strings(entry);
+
+		for (count = 0; ptr < end && *ptr; count++)
+			ptr += strnlen(ptr, end - ptr) + 1;
+
+		/* one extra slot keeps the allocation non-empty */
+		entry->strings = mosys_calloc(count + 1,
+		                              sizeof(*entry->strings));
+		ptr = smbios_index_strings(entry);
+		for (count = 0; ptr < end && *ptr; count++) {
+			entry->strings[count] = ptr;
+			ptr += strnlen(ptr, end - ptr) + 1;
+		}
+		entry->num_strings = count;
 	}
+	pthread_mutex_unlock(&smbios_lock);
 
-	/* mmap in entire smbios area */
-	smbios_itr->data = mmio_map(intf, O_RDONLY,
-	                            smbios_itr->entry->table_address,
-	                            smbios_itr->entry->table_length);
+	if (num < 0 || num >= entry->num_strings)
+		return NULL;
 
-	if (smbios_itr->data == NULL) {
-		lprintf(LOG_ERR, "Unable to find SMBIOS tables at 0x%08x\n",
-		        smbios_itr->entry->table_address);
-		smbios_itr_destroy(intf);
+	return entry->strings[num];
+}
+
+/*
+ * smbios_find_table_view  -  locate SMBIOS table without copying it
+ *
+ * @intf:	platform interface
+ * @type:	smbios table type to locate
+ * @instance:	what instance to retrieve (0-based)
+ * @view:	OUTPUT view of table
+ * @baseaddr:	base address to start searching in
+ * @len:	length of region to search (in bytes)
+ *
+ * The view points into the structure table and remains valid until the
+ * platform interface is destroyed.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+int smbios_find_table_view(struct platform_intf *intf,
+                           enum smbios_types type, int instance,
+                           struct smbios_table_view *view,
+                           unsigned int baseaddr, unsigned int len)
+{
+	struct smbios_index_entry *entry;
+
+	if (!view || type > SMBIOS_TYPE_END)
+		return -1;
+
+	entry = smbios_find_table_raw(intf, type, instance, baseaddr, len);
+	if (!entry) {
+		lprintf(LOG_DEBUG, "Unable to locate table %d:%d\n",
+		        type, instance);
 		return -1;
 	}
 
-	if (mosys_get_verbosity() == LOG_DEBUG)
-		print_buffer(smbios_itr->data, smbios_itr->entry->table_length);
+	view->header = smbios_index_header(entry);
+	view->data = (const uint8_t *)view->header + sizeof(*view->header);
+	view->length = view->header->length - sizeof(*view->header);
+	view->entry = entry;
 
-	/* start pointer at table start */
-	smbios_itr->current = smbios_itr->data;
-	smbios_itr->header = (struct smbios_header *)smbios_itr->current;
+	return 0;
+}
 
-	/* make sure we get torn down at exit time. */
-	add_destroy_callback(smbios_itr_destroy, intf);
+/*
+ * smbios_view_get_u8  -  read byte field of table
+ *
+ * @view:	table view
+ * @offset:	offset of field in formatted area, after the header
+ * @val:	OUTPUT value of field
+ *
+ * Fields added by later SMBIOS versions may be absent from a table, so
+ * every access is checked against the length of the formatted area.
+ *
+ * returns 0 to indicate success
+ * returns <0 if field is not present
+ */
+int smbios_view_get_u8(const struct smbios_table_view *view,
+                       size_t offset, uint8_t *val)
+{
+	if (offset + sizeof(*val) > view->length)
+		return -1;
 
+	*val = view->data[offset];
 	return 0;
 }
 
 /*
- * smbios_itr_next  -  find next table from current iterator
+ * smbios_view_get_u16  -  read 16-bit field of table
  *
- * @intf	platform interface
+ * @view:	table view
+ * @offset:	offset of field in formatted area, after the header
+ * @val:	OUTPUT value of field
  *
- * returns 0 if found
- * returns 1 if search wrapped to start
- * returns <0 if iterator not setup or invalid
+ * returns 0 to indicate success
+ * returns <0 if field is not present
  */
-static int smbios_itr_next(struct platform_intf *intf)
+int smbios_view_get_u16(const struct smbios_table_view *view,
+                        size_t offset, uint16_t *val)
 {
-	int rc = 0;
+	if (offset + sizeof(*val) > view->length)
+		return -1;
+
+	memcpy(val, view->data + offset, sizeof(*val));
+	return 0;
+}
 
-	if (!smbios_itr || !smbios_itr->current || !smbios_itr->header)
+/*
+ * smbios_view_get_u32  -  read 32-bit field of table
+ *
+ * @view:	table view
+ * @offset:	offset of field in formatted area, after the header
+ * @val:	OUTPUT value of field
+ *
+ * returns 0 to indicate success
+ * returns <0 if field is not present
+ */
+int smbios_view_get_u32(const struct smbios_table_view *view,
+                        size_t offset, uint32_t *val)
+{
+	if (offset + sizeof(*val) > view->length)
 		return -1;
 
-	/* adjust pointer to end of table data + strings */
-	smbios_itr->current += smbios_itr->header->length +
-		smbios_string_table_len((char *)smbios_itr->current +
-		                        smbios_itr->header->length);
-
-	/* check for overflow */
-	if (smbios_itr->current >= (smbios_itr->data +
-				    smbios_itr->entry->table_length - 1)) {
-		/* start pointer over */
-		lprintf(LOG_DEBUG, "smbios_itr_next: search wrapped\n");
-		smbios_itr->current = smbios_itr->data;
-		rc = 1;
-	}
+	memcpy(val, view->data + offset, sizeof(*val));
+	return 0;
+}
 
-	/* adjust header pointer */
-	smbios_itr->header = (struct smbios_header *)smbios_itr->current;
+/*
+ * smbios_view_string  -  look up string of table by number
+ *
+ * @view:	table view
+ * @number:	string number as stored in table fields (1-based)
+ *
+ * returns pointer to string within the structure table
+ * returns NULL if string is not set or not present
+ */
+const char *smbios_view_string(const struct smbios_table_view *view,
+                               int number)
+{
+	if (number < 1)
+		return NULL;
 
-	return rc;
+	return smbios_index_string(view->entry, number - 1);
 }
 
 /*
- * smbios_find_table_raw  -  locate table and store in buffer
+ * smbios_view_string_field  -  look up string referenced by table field
  *
- * @intf:	platform interface
- * @type:	smbios table type
- * @instance:	smbios table instance
- * @baseaddr:	base address to start searching in
- * @len:	length of region to search (in bytes)
+ * @view:	table view
+ * @offset:	offset of string number field in formatted area
  *
- * returns 0 if found
- * returns <0 if not found
+ * returns pointer to string within the structure table
+ * returns NULL if string is not set or not present
  */
-static int smbios_find_table_raw(struct platform_intf *intf,
-                                 enum smbios_types type, int instance,
-                                 unsigned int baseaddr, unsigned int len)
+const char *smbios_view_string_field(const struct smbios_table_view *view,
+                                     size_t offset)
 {
-	int ret = -1;
+	uint8_t number;
 
-	/* start iterator */
-	if (smbios_itr_setup(intf, baseaddr, len) >= 0) {
-		do {
-			/* check for correct type */
-			if (smbios_itr->header->type != type)
-				continue;
+	if (smbios_view_get_u8(view, offset, &number) < 0)
+		return NULL;
 
-			/* check for correct instance */
-			if (instance-- > 0)
-				continue;
+	return smbios_view_string(view, number);
+}
 
-			if (mosys_get_verbosity() == LOG_DEBUG)
-				print_buffer(smbios_itr->current,
-				             smbios_itr->header->length);
+/*
+ * smbios_view_strdup  -  copy string referenced by table field
+ *
+ * @view:	table view
+ * @offset:	offset of string number field in formatted area
+ *
+ * Non-printable characters are replaced as in the parsed string table,
+ * and a missing string yields an empty string.
+ *
+ * returns allocated buffer containing null-terminated string
+ *         !! caller is expected to free returned buffer !!
+ */
+char *smbios_view_strdup(const struct smbios_table_view *view,
+                         size_t offset)
+{
+	const char *str;
+	char *ret;
+	int i;
 
-			/* found */
-			ret = 0;
-			break;
+	str = smbios_view_string_field(view, offset);
+	ret = mosys_strdup(str ? str : "");
 
-		} while (smbios_itr_next(intf) == 0);
+	for (i = 0; ret[i]; i++) {
+		if (!isprint(ret[i]))
+			ret[i] = '.';
 	}
 
 	return ret;
@@ -467,6 +905,9 @@ static int smbios_find_table_raw(struct platform_intf *intf,
  * @baseaddr:	base address to start searching in
  * @len:	length of region to search (in bytes)
  *
+ * This copies the table and all of its strings, callers which only need
+ * a few fields should use smbios_find_table_view() instead.
+ *
  * returns 0 to indicate success
  * returns <0 to indicate failure
  */
@@ -474,31 +915,52 @@ int smbios_find_table(struct platform_intf *intf, enum smbios_types type,
                       int instance, struct smbios_table *table,
                       unsigned int baseaddr, unsigned int len)
 {
-	if (!table || type > SMBIOS_TYPE_END)
+	struct smbios_table_view view;
+
+	if (!table)
 		return -1;
 
-	/* get the table as raw buffer */
-	if (smbios_find_table_raw(intf, type, instance, baseaddr, len) < 0) {
-		lprintf(LOG_DEBUG, "Unable to locate table %d:%d\n",
-		        type, instance);
+	if (smbios_find_table_view(intf, type, instance, &view,
+	                           baseaddr, len) < 0)
 		return -1;
-	}
 
 	/* copy header first */
 	memset(table, 0, sizeof(*table));
-	memcpy(&table->header, smbios_itr->header, sizeof(table->header));
+	memcpy(&table->header, view.header, sizeof(table->header));
 
 	/* then table data */
-	memcpy(&table->data.data, smbios_itr->current + sizeof(table->header),
-	       smbios_itr->header->length - sizeof(table->header));
+	memcpy(&table->data.data, view.data, view.length);
 
 	/* finally parse table strings */
-	smbios_parse_string_table((char *)smbios_itr->current +
-	                          smbios_itr->header->length, table->string);
+	smbios_parse_string_table(smbios_index_strings(view.entry),
+	                          table->string);
 
 	return 0;
 }
 
+/*
+ * smbios_count_tables  -  count SMBIOS tables of a given type
+ *
+ * @intf:	platform interface
+ * @type:	smbios table type to count
+ * @baseaddr:	base address to start searching in
+ * @len:	length of region to search (in bytes)
+ *
+ * returns number of tables
+ * returns <0 to indicate failure
+ */
+int smbios_count_tables(struct platform_intf *intf, enum smbios_types type,
+                        unsigned int baseaddr, unsigned int len)
+{
+	if (type > SMBIOS_TYPE_END)
+		return -1;
+
+	if (smbios_itr_setup(intf, baseaddr, len) < 0)
+		return -1;
+
+	return smbios_itr->index[type].count;
+}
+
 /*
  * smbios_find_string  -  locate specific string in SMBIOS table
  *                        (conforms to legacy smbios utility)
@@ -517,21 +979,15 @@ char *smbios_find_string(struct platform_intf *intf,
                          enum smbios_types type, int number,
                          unsigned int baseaddr, unsigned int len)
 {
-	char *sptr;
-
-	if (type > SMBIOS_TYPE_END)
-		return NULL;
+	struct smbios_table_view view;
+	const char *sptr;
 
 	/* get instance 0 of the table */
-	if (smbios_find_table_raw(intf, type, 0, baseaddr, len) < 0) {
-		lprintf(LOG_DEBUG, "Unable to locate table %d\n", type);
+	if (smbios_find_table_view(intf, type, 0, &view, baseaddr, len) < 0)
 		return NULL;
-	}
 
 	/* lookup string location in table */
-	sptr = smbios_get_string((char *)smbios_itr->current +
-				 smbios_itr->header->length,
-				 number);
+	sptr = smbios_view_string(&view, number + 1);
 
 	if (!sptr) {
 		lprintf(LOG_DEBUG, "String %d not found in table %d\n",
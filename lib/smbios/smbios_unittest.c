@@ -0,0 +1,178 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * smbios_unittest.c: SMBIOS table lookup and thread-safety tests
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmockery.h"
+
+#include "mosys/kv_pair.h"
+#include "mosys/platform.h"
+
+#include "lib/smbios.h"
+
+/*
+ * Tables are read from sys/firmware/dmi/tables under the test data
+ * prefix: a type 1 table named "Sysfs" and five type 17 tables whose
+ * first strings are "DIMM0" through "DIMM4".
+ */
+#define TEST_DIMMS		5
+#define STRESS_THREADS		8
+#define STRESS_ITERATIONS	1000
+
+static struct platform_intf *intf;
+
+static void table_lookup_test(void **state)
+{
+	struct smbios_table_view view;
+	char name[8];
+	int i;
+
+	assert_int_equal(TEST_DIMMS,
+	                 smbios_count_tables(intf, SMBIOS_TYPE_MEMORY,
+	                                     SMBIOS_LEGACY_ENTRY_BASE,
+	                                     SMBIOS_LEGACY_ENTRY_LEN));
+
+	assert_int_equal(0, smbios_find_table_view(intf, SMBIOS_TYPE_SYSTEM,
+	                                           0, &view,
+	                                           SMBIOS_LEGACY_ENTRY_BASE,
+	                                           SMBIOS_LEGACY_ENTRY_LEN));
+	assert_string_equal("Sysfs", smbios_view_string_field(&view,
+	                    SMBIOS_FIELD(system, name)));
+
+	for (i = 0; i < TEST_DIMMS; i++) {
+		assert_int_equal(0, smbios_find_table_view(intf,
+		                 SMBIOS_TYPE_MEMORY, i, &view,
+		                 SMBIOS_LEGACY_ENTRY_BASE,
+		                 SMBIOS_LEGACY_ENTRY_LEN));
+		snprintf(name, sizeof(name), "DIMM%d", i);
+		assert_string_equal(name, smbios_view_string(&view, 1));
+	}
+
+	assert_int_equal(-1, smbios_find_table_view(intf, SMBIOS_TYPE_MEMORY,
+	                                            TEST_DIMMS, &view,
+	                                            SMBIOS_LEGACY_ENTRY_BASE,
+	                                            SMBIOS_LEGACY_ENTRY_LEN));
+}
+
+/*
+ * stress_thread  -  look up tables and capture output from one thread
+ *
+ * @arg:	thread number
+ *
+ * returns NULL if every lookup and captured record was as expected
+ */
+static void *stress_thread(void *arg)
+{
+	long id = (long)arg;
+	struct smbios_table_view view;
+	struct kv_record *records = NULL, *record;
+	struct kv_pair *kv;
+	char thread[8];
+	const char *str;
+	void *ret = NULL;
+	int i;
+
+	snprintf(thread, sizeof(thread), "%ld", id);
+	mosys_set_kv_pair_style(KV_STYLE_PAIR);
+	kv_pair_capture(&records);
+
+	for (i = 0; i < STRESS_ITERATIONS; i++) {
+		/* spread threads over instances so strings resolve in parallel */
+		if (smbios_find_table_view(intf, SMBIOS_TYPE_MEMORY,
+		                           (i + id) % TEST_DIMMS, &view,
+		                           SMBIOS_LEGACY_ENTRY_BASE,
+		                           SMBIOS_LEGACY_ENTRY_LEN) < 0) {
+			ret = (void *)-1;
+			continue;
+		}
+
+		str = smbios_view_string(&view, 1);
+		kv = kv_pair_new();
+		kv_pair_add(kv, "thread", thread);
+		kv_pair_add(kv, "dimm", str ? str : "");
+		kv_pair_print(kv);
+		kv_pair_free(kv);
+	}
+
+	kv_pair_capture(NULL);
+
+	/* records must come from this thread only, in order */
+	for (i = 0, record = records; record; i++, record = record->next) {
+		char name[8];
+
+		snprintf(name, sizeof(name), "DIMM%ld", (i + id) % TEST_DIMMS);
+		if (!record->pairs || strcmp(record->pairs->value, thread) ||
+		    !record->pairs->next ||
+		    strcmp(record->pairs->next->value, name))
+			ret = (void *)-1;
+	}
+	if (i != STRESS_ITERATIONS)
+		ret = (void *)-1;
+
+	kv_record_free(records);
+	return ret;
+}
+
+static void concurrent_lookup_test(void **state)
+{
+	pthread_t threads[STRESS_THREADS];
+	void *ret;
+	long i;
+
+	for (i = 0; i < STRESS_THREADS; i++)
+		assert_int_equal(0, pthread_create(&threads[i], NULL,
+		                                   stress_thread, (void *)i));
+
+	for (i = 0; i < STRESS_THREADS; i++) {
+		assert_int_equal(0, pthread_join(threads[i], &ret));
+		assert_true(ret == NULL);
+	}
+}
+
+int smbios_unittest(struct platform_intf *platform_intf)
+{
+	/* concurrent_lookup_test runs first so threads race on setup */
+	UnitTest tests[] = {
+		unit_test(concurrent_lookup_test),
+		unit_test(table_lookup_test),
+	};
+
+	intf = platform_intf;
+	return run_tests(tests);
+}
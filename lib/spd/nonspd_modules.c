@@ -706,9 +706,10 @@ int spd_set_nonspd_info(struct platform_intf *intf,
                         const struct nonspd_mem_info **info)
 {
 	int dimm = 0, index;
-	struct smbios_table table;
+	struct smbios_table_view view;
+	const char *part_num;
 
-	if (smbios_find_table(intf, SMBIOS_TYPE_MEMORY, dimm, &table,
+	if (smbios_find_table_view(intf, SMBIOS_TYPE_MEMORY, dimm, &view,
 			SMBIOS_LEGACY_ENTRY_BASE,
 			SMBIOS_LEGACY_ENTRY_LEN) < 0) {
 		lprintf(LOG_ERR, "%s: SMBIOS Memory info table missing\n"
@@ -716,8 +717,13 @@ int spd_set_nonspd_info(struct platform_intf *intf,
 		return -1;
 	}
 
+	part_num = smbios_view_string_field(&view,
+				SMBIOS_FIELD(memory_device, part_number));
+	if (!part_num)
+		part_num = "";
+
 	for (index = 0; index < ARRAY_SIZE(nospdmemory); index++) {
-		if (!strncmp(table.string[table.data.mem_device.part_number],
+		if (!strncmp(part_num,
 			nospdmemory[index]->part_num,
 			sizeof(nospdmemory[index]->part_num))) {
 			*info = nospdmemory[index];
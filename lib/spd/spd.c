@@ -243,19 +243,30 @@ struct spd_device *new_spd_device(struct platform_intf *intf, int dimm)
 static int find_spd_by_part_number(struct platform_intf *intf, int dimm,
 				   uint8_t *spd, uint32_t num_spd)
 {
-	char *smbios_part_num;
+	char smbios_part_num[SMBIOS_MAX_STRING_LENGTH];
+	char *str;
 	uint8_t i;
 	uint8_t *ptr;
-	struct smbios_table table;
+	struct smbios_table_view view;
 
 	lprintf(LOG_DEBUG, "Use SMBIOS type 17 to get memory information\n");
-	if (smbios_find_table(intf, SMBIOS_TYPE_MEMORY, dimm, &table,
-			      SMBIOS_LEGACY_ENTRY_BASE,
-			      SMBIOS_LEGACY_ENTRY_LEN) < 0) {
+	if (smbios_find_table_view(intf, SMBIOS_TYPE_MEMORY, dimm, &view,
+				   SMBIOS_LEGACY_ENTRY_BASE,
+				   SMBIOS_LEGACY_ENTRY_LEN) < 0) {
 		lprintf(LOG_DEBUG, "Can't find smbios type17\n");
 		return -1;
 	}
-	smbios_part_num = table.string[table.data.mem_device.part_number];
+
+	/*
+	 * Match the part number as it was stored in the parsed string table:
+	 * sanitized, truncated and zero-padded, so that it is never compared
+	 * beyond its buffer.
+	 */
+	memset(smbios_part_num, 0, sizeof(smbios_part_num));
+	str = smbios_view_strdup(&view,
+				 SMBIOS_FIELD(memory_device, part_number));
+	strncpy(smbios_part_num, str, sizeof(smbios_part_num) - 1);
+	free(str);
 
 	for (i = 0; i < num_spd; i++) {
 		ptr = (spd + i * 256);
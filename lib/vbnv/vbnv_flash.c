@@ -155,6 +155,9 @@ static int vbnv_fetch_from_flash(struct platform_intf *intf, uint8_t *block)
 	if (vbnv_find_eeprom(intf, &eeprom, &region))
 		return -1;
 
+	/* fetch the other regions of interest in the same pass */
+	eeprom_prefetch_regions(intf, eeprom);
+
 	bytes_read = eeprom->device->read_by_name(intf, eeprom,
 						region->name, &data);
 	if (bytes_read < 0) {
@@ -35,6 +35,7 @@
 #include <string.h>
 #include <fcntl.h>
 #include <ctype.h>
+#include <pthread.h>
 #include <uuid/uuid.h>
 
 #include "mosys/alloc.h"
@@ -46,6 +47,7 @@
 
 #include "intf/mmio.h"
 
+#include "lib/math.h"
 #include "lib/string.h"
 #include "lib/vpd.h"
 #include "lib/vpd_binary_blob.h"
@@ -58,16 +60,38 @@
 unsigned int vpd_rom_base;
 unsigned int vpd_rom_size;
 
+/* Maximum number of table types */
+#define VPD_NUM_TYPES		256
+
+/* Location of a table and its strings */
+struct vpd_index_entry {
+	uint32_t offset;		/* offset of table in data */
+	uint32_t strings;		/* offset of string table in data */
+};
+
+/* Tables of one type, in the order they appear in the structure table */
+struct vpd_type_index {
+	int count;
+	int alloc;
+	struct vpd_index_entry *tables;
+};
+
 /* Iterator used for table parsing */
 struct vpd_iterator {
 	struct vpd_entry *entry;	/* entry pointer */
-	struct vpd_header *header;	/* current header */
+	unsigned int table_address;	/* address data is mapped from */
 	uint8_t *data;			/* table data */
-	uint8_t *current;		/* pointer into data */
+	struct vpd_type_index index[VPD_NUM_TYPES];
 };
 
 static struct vpd_iterator *vpd_itr = NULL;
 
+/*
+ * Protects iterator setup. The index is not modified once built, so
+ * lookups may run concurrently.
+ */
+static pthread_mutex_t vpd_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * vpd_parse_string_table  -  parse strings into table structure
  *
@@ -162,53 +186,38 @@ char *vpd_get_string(const char *ptr, int num)
 }
 
 /*
- * vpd_find_entry  -  locate entry pointer
+ * vpd_check_entry  -  locate entry pointer in a mapped region
  *
- * @intf:	platform interface
  * @entry:	buffer to store entry pointer must be allocated by caller
- * @baseaddr:	address to begin search
- * @len:	length of region to search (in bytes)
- * @offset:	offset to store entry point structure address, if found
+ * @data:	mapped region
+ * @len:	length of region (in bytes)
+ * @offset:	offset to store entry point structure offset, if found
  *
  * returns 0 to indicate success
  * returns <0 if not found
  */
-int vpd_find_entry(struct platform_intf *intf,
-                   struct vpd_entry *entry,
-                   unsigned long int baseaddr,
-                   unsigned long int len,
-                   size_t *offset)
+static int vpd_check_entry(struct vpd_entry *entry, uint8_t *data,
+                           unsigned long int len, size_t *offset)
 {
 	uint8_t csum;
-	uint8_t *data;
 	int i;
 	uint8_t vpd_magic[] = VPD_ENTRY_MAGIC;
 
-	data = mmio_map(intf, O_RDONLY, baseaddr, len);
-	if (data == NULL) {
-		lprintf(LOG_DEBUG, "Unable to map VPD entry buffer.\n");
-		return -1;
-	}
-
 	if (find_pattern(data, len,
 	                 &vpd_magic[0], 4, 16, offset) < 0) {
 		lprintf(LOG_DEBUG, "Unable to find VPD entry.\n");
-		mmio_unmap(intf, data, baseaddr, len);
 		return -1;
 	}
 
-	lprintf(LOG_DEBUG, "VPD Table Entry @ 0x%x\n", baseaddr + *offset);
-
 	/* copy entry into user-provided buffer */
 	memset(entry, 0, sizeof(*entry));
-	memcpy(entry, data + *offset, sizeof(*entry));
+	memcpy(entry, data + *offset, __min(sizeof(*entry), len - *offset));
 
 	/* verify entry pointer checksum */
-	for (csum = i = 0; i < entry->entry_length; i++)
+	for (csum = i = 0; i < entry->entry_length &&
+	     *offset + i < len; i++)
 		csum += data[*offset + i];
 
-	mmio_unmap(intf, data, baseaddr, len);
-
 	if (csum != 0) {
 		lprintf(LOG_DEBUG, "Invalid VPD checksum: %02x\n", csum);
 	}
@@ -225,6 +234,99 @@ int vpd_find_entry(struct platform_intf *intf,
 	return 0;
 }
 
+/*
+ * vpd_find_entry  -  locate entry pointer
+ *
+ * @intf:	platform interface
+ * @entry:	buffer to store entry pointer must be allocated by caller
+ * @baseaddr:	address to begin search
+ * @len:	length of region to search (in bytes)
+ * @offset:	offset to store entry point structure address, if found
+ *
+ * returns 0 to indicate success
+ * returns <0 if not found
+ */
+int vpd_find_entry(struct platform_intf *intf,
+                   struct vpd_entry *entry,
+                   unsigned long int baseaddr,
+                   unsigned long int len,
+                   size_t *offset)
+{
+	uint8_t *data;
+	int ret;
+
+	data = mmio_map(intf, O_RDONLY, baseaddr, len);
+	if (data == NULL) {
+		lprintf(LOG_DEBUG, "Unable to map VPD entry buffer.\n");
+		return -1;
+	}
+
+	ret = vpd_check_entry(entry, data, len, offset);
+	if (ret == 0)
+		lprintf(LOG_DEBUG, "VPD Table Entry @ 0x%x\n",
+		        baseaddr + *offset);
+
+	mmio_unmap(intf, data, baseaddr, len);
+	return ret;
+}
+
+/*
+ * vpd_itr_build_index  -  index all tables by type and instance
+ *
+ * @itr:	iterator whose tables to index
+ *
+ * The structure table is walked once. Tables are recorded in the order
+ * they appear so that instance numbers match a linear search. Walking
+ * stops at the end-of-table marker or at the first malformed table.
+ */
+static void vpd_itr_build_index(struct vpd_iterator *itr)
+{
+	struct vpd_header *header;
+	struct vpd_type_index *idx;
+	struct vpd_index_entry *entry;
+	const uint8_t *end = itr->data + itr->entry->table_length;
+	const uint8_t *ptr = itr->data;
+	const uint8_t *strings, *next;
+
+	while (ptr + sizeof(*header) <= end) {
+		header = (struct vpd_header *)ptr;
+		if (header->length < sizeof(*header) ||
+		    ptr + header->length > end) {
+			lprintf(LOG_DEBUG, "%s: malformed table at offset "
+			        "%u\n", __func__, (unsigned int)(ptr - itr->data));
+			break;
+		}
+
+		/* the string table ends with two consecutive nul bytes */
+		strings = ptr + header->length;
+		for (next = strings;
+		     next + 1 < end && (next[0] || next[1]); next++)
+			;
+		if (next + 1 >= end) {
+			lprintf(LOG_DEBUG, "%s: unterminated strings at "
+			        "offset %u\n", __func__,
+			        (unsigned int)(ptr - itr->data));
+			break;
+		}
+
+		idx = &itr->index[header->type];
+		if (idx->count == idx->alloc) {
+			idx->alloc = idx->alloc ? idx->alloc * 2 : 4;
+			idx->tables = mosys_realloc(idx->tables, idx->alloc *
+			                            sizeof(*idx->tables));
+		}
+
+		entry = &idx->tables[idx->count++];
+		entry->offset = ptr - itr->data;
+		entry->strings = strings - itr->data;
+
+		if (header->type == VPD_TYPE_END)
+			break;
+
+		ptr = next + 2;
+	}
+}
+
 /*
  * vpd_itr_destroy  -  clean up iterator
  *
@@ -233,11 +335,16 @@ int vpd_find_entry(struct platform_intf *intf,
 static void vpd_itr_destroy(void *arg)
 {
 	struct platform_intf *intf = arg;
+	int type;
+
 	if (vpd_itr) {
+		/* clean up index */
+		for (type = 0; type < VPD_NUM_TYPES; type++)
+			free(vpd_itr->index[type].tables);
 		/* clean up vpd table buffer */
 		if (vpd_itr->data) {
 			mmio_unmap(intf, vpd_itr->data,
-			           vpd_itr->entry->table_address,
+			           vpd_itr->table_address,
 			           vpd_itr->entry->table_length);
 		}
 		/* clean up vpd entry */
@@ -256,43 +363,46 @@ static void vpd_itr_destroy(void *arg)
  * @baseaddr:	base address to start searching in
  * @len:	length of region to search (in bytes)
  *
- * returns 0 to indicate successful setup or reset to setup
+ * The search region is mapped once and searched for an entry point with
+ * a valid table, then the tables are indexed.
+ *
+ * returns 0 to indicate successful setup or that iterator is set up
  * returns <0 to indicate failure
  */
 static int vpd_itr_setup(struct platform_intf *intf,
                          unsigned int baseaddr, unsigned int len)
 {
-	unsigned int addr, remaining;
-	size_t offset;
-	int entry_found = 0;
+	uint8_t *region;
+	size_t start = 0, offset;
+	uint32_t x;
+	int entry_found = 0, ret = -1;
+
+	pthread_mutex_lock(&vpd_lock);
 
 	/* already setup? */
 	if (vpd_itr) {
-		/* reset to start of tables */
-		vpd_itr->current = vpd_itr->data;
-		vpd_itr->header =
-		        (struct vpd_header *)vpd_itr->current;
-		return 0;
+		ret = 0;
+		goto vpd_itr_setup_exit;
 	}
 
-	/* setup iterator */
-	vpd_itr = mosys_malloc(sizeof(*vpd_itr));
-	memset(vpd_itr, 0, sizeof(*vpd_itr));
-
-	vpd_itr->entry = mosys_malloc(sizeof(*vpd_itr->entry));
-	memset(vpd_itr->entry, 0, sizeof(*vpd_itr->entry));
+	region = mmio_map(intf, O_RDONLY, baseaddr, len);
+	if (region == NULL) {
+		lprintf(LOG_DEBUG, "Unable to map VPD entry buffer.\n");
+		goto vpd_itr_setup_exit;
+	}
 
-	addr = baseaddr;
-	remaining = len;
-	while (!entry_found) {
-		uint32_t x;
+	/* setup iterator */
+	vpd_itr = mosys_zalloc(sizeof(*vpd_itr));
+	vpd_itr->entry = mosys_zalloc(sizeof(*vpd_itr->entry));
 
+	while (!entry_found && start < len) {
 		/* search for entry pointer with a valid table */
-		if (vpd_find_entry(intf, vpd_itr->entry,
-		                   addr, remaining, &offset) < 0) {
-			vpd_itr_destroy(intf);
-			return -1;
-		}
+		if (vpd_check_entry(vpd_itr->entry, region + start,
+		                    len - start, &offset) < 0)
+			break;
+		offset += start;
+		lprintf(LOG_DEBUG, "VPD Table Entry @ 0x%x\n",
+		        baseaddr + offset);
 
 		x = vpd_itr->entry->table_address +
 		    vpd_itr->entry->table_length;
@@ -307,73 +417,43 @@ static int vpd_itr_setup(struct platform_intf *intf,
 			entry_found = 1;
 		}
 
-		addr = baseaddr + offset + 16;
-		remaining = baseaddr + len - addr;
+		start = offset + 16;
+	}
+	mmio_unmap(intf, region, baseaddr, len);
+
+	if (!entry_found) {
+		vpd_itr_destroy(intf);
+		goto vpd_itr_setup_exit;
 	}
 
 	/* mmap in entire vpd area */
-	vpd_itr->data = mmio_map(intf, O_RDONLY,
-	                         baseaddr + vpd_itr->entry->table_address,
+	vpd_itr->table_address = baseaddr + vpd_itr->entry->table_address;
+	vpd_itr->data = mmio_map(intf, O_RDONLY, vpd_itr->table_address,
 	                         vpd_itr->entry->table_length);
 
 	if (vpd_itr->data == NULL) {
 		lprintf(LOG_ERR, "Unable to find VPD tables at 0x%08x\n",
 		        vpd_itr->entry->table_address);
 		vpd_itr_destroy(intf);
-		return -1;
+		goto vpd_itr_setup_exit;
 	}
 
 	if (mosys_get_verbosity() == LOG_DEBUG)
 		print_buffer(vpd_itr->data, vpd_itr->entry->table_length);
 
-	/* start pointer at table start */
-	vpd_itr->current = vpd_itr->data;
-	vpd_itr->header = (struct vpd_header *)vpd_itr->current;
+	vpd_itr_build_index(vpd_itr);
 
 	/* make sure we get torn down at exit time. */
 	add_destroy_callback(vpd_itr_destroy, intf);
+	ret = 0;
 
-	return 0;
-}
-
-/*
- * vpd_itr_next  -  find next table from current iterator
- *
- * @intf	platform interface
- *
- * returns 0 if found
- * returns 1 if search wrapped to start
- * returns <0 if iterator not setup or invalid
- */
-static int vpd_itr_next(struct platform_intf *intf)
-{
-	int rc = 0;
-
-	if (!vpd_itr || !vpd_itr->current || !vpd_itr->header)
-		return -1;
-
-	/* adjust pointer to end of table data + strings */
-	vpd_itr->current += vpd_itr->header->length +
-		vpd_string_table_len((char *)vpd_itr->current +
-		                        vpd_itr->header->length);
-
-	/* check for overflow */
-	if (vpd_itr->current >= (vpd_itr->data +
-				 vpd_itr->entry->table_length - 1)) {
-		/* start pointer over */
-		lprintf(LOG_DEBUG, "vpd_itr_next: search wrapped\n");
-		vpd_itr->current = vpd_itr->data;
-		rc = 1;
-	}
-
-	/* adjust header pointer */
-	vpd_itr->header = (struct vpd_header *)vpd_itr->current;
-
-	return rc;
+vpd_itr_setup_exit:
+	pthread_mutex_unlock(&vpd_lock);
+	return ret;
 }
 
 /*
- * vpd_find_table_raw  -  locate table and store in buffer
+ * vpd_find_table_raw  -  locate table in index
  *
  * @intf:	platform interface
  * @type:	vpd table type
@@ -381,38 +461,31 @@ static int vpd_itr_next(struct platform_intf *intf)
  * @baseaddr:	base address to start searching in
  * @len:	length of region to search (in bytes)
  *
- * returns 0 if found
- * returns <0 if not found
+ * returns pointer to index entry if found
+ * returns NULL if not found
  */
-static int vpd_find_table_raw(struct platform_intf *intf,
+static struct vpd_index_entry *vpd_find_table_raw(struct platform_intf *intf,
                                  enum vpd_types type, int instance,
                                  unsigned int baseaddr, unsigned int len)
 {
-	int ret = -1;
-
-	/* start iterator */
-	if (vpd_itr_setup(intf, baseaddr, len) >= 0) {
-		do {
-			/* check for correct type */
-			if (vpd_itr->header->type != type)
-				continue;
+	struct vpd_type_index *idx;
 
-			/* check for correct instance */
-			if (instance-- > 0)
-				continue;
+	if (type >= VPD_NUM_TYPES || instance < 0)
+		return NULL;
 
-			if (mosys_get_verbosity() == LOG_DEBUG)
-				print_buffer(vpd_itr->current,
-				             vpd_itr->header->length);
+	if (vpd_itr_setup(intf, baseaddr, len) < 0)
+		return NULL;
 
-			/* found */
-			ret = 0;
-			break;
+	idx = &vpd_itr->index[type];
+	if (instance >= idx->count)
+		return NULL;
 
-		} while (vpd_itr_next(intf) == 0);
-	}
+	if (mosys_get_verbosity() == LOG_DEBUG)
+		print_buffer(vpd_itr->data + idx->tables[instance].offset,
+		             idx->tables[instance].strings -
+		             idx->tables[instance].offset);
 
-	return ret;
+	return &idx->tables[instance];
 }
 
 /*
@@ -432,31 +505,59 @@ int vpd_find_table(struct platform_intf *intf, enum vpd_types type,
                       int instance, struct vpd_table *table,
                       unsigned int baseaddr, unsigned int len)
 {
+	struct vpd_index_entry *entry;
+	struct vpd_header *header;
+
 	if (!table)
 		return -1;
 
 	/* get the table as raw buffer */
-	if (vpd_find_table_raw(intf, type, instance, baseaddr, len) < 0) {
+	entry = vpd_find_table_raw(intf, type, instance, baseaddr, len);
+	if (!entry) {
 		lprintf(LOG_DEBUG, "Unable to locate table %d:%d\n",
 		        type, instance);
 		return -1;
 	}
+	header = (struct vpd_header *)(vpd_itr->data + entry->offset);
 
 	/* copy header first */
 	memset(table, 0, sizeof(*table));
-	memcpy(&table->header, vpd_itr->header, sizeof(table->header));
+	memcpy(&table->header, header, sizeof(table->header));
 
 	/* then table data */
-	memcpy(&table->data.data, vpd_itr->current + sizeof(table->header),
-	       vpd_itr->header->length - sizeof(table->header));
+	memcpy(&table->data.data, vpd_itr->data + entry->offset +
+	       sizeof(table->header), header->length - sizeof(table->header));
 
 	/* finally parse table strings */
-	vpd_parse_string_table((char *)vpd_itr->current +
-	                          vpd_itr->header->length, table->string);
+	vpd_parse_string_table((char *)vpd_itr->data + entry->strings,
+	                       table->string);
 
 	return 0;
 }
 
+/*
+ * vpd_count_tables  -  count VPD tables of a given type
+ *
+ * @intf:	platform interface
+ * @type:	vpd table type to count
+ * @baseaddr:	base address to start searching in
+ * @len:	length of region to search (in bytes)
+ *
+ * returns number of tables
+ * returns <0 to indicate failure
+ */
+int vpd_count_tables(struct platform_intf *intf, enum vpd_types type,
+                     unsigned int baseaddr, unsigned int len)
+{
+	if (type >= VPD_NUM_TYPES)
+		return -1;
+
+	if (vpd_itr_setup(intf, baseaddr, len) < 0)
+		return -1;
+
+	return vpd_itr->index[type].count;
+}
+
 /*
  * vpd_find_string  -  locate specific string in VPD table
  *
@@ -474,22 +575,21 @@ char *vpd_find_string(struct platform_intf *intf,
                          enum vpd_types type, int number,
                          unsigned int baseaddr, unsigned int len)
 {
+	struct vpd_index_entry *entry;
 	char *sptr;
 
 	if (type > VPD_TYPE_END)
 		return NULL;
 
 	/* get instance 0 of the table */
-	if (vpd_find_table_raw(intf, type, 0, baseaddr, len) < 0) {
+	entry = vpd_find_table_raw(intf, type, 0, baseaddr, len);
+	if (!entry) {
 		lprintf(LOG_ERR, "Unable to locate table %d\n", type);
 		return NULL;
 	}
 
 	/* lookup string location in table */
-	sptr = vpd_get_string((char *)vpd_itr->current +
-				 vpd_itr->header->length,
-				 number);
-
+	sptr = vpd_get_string((char *)vpd_itr->data + entry->strings, number);
 	if (!sptr) {
 		lprintf(LOG_DEBUG, "String %d not found in table %d\n",
 		        number, type);
@@ -0,0 +1,382 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * vpd_kv.c: VPD 2.0 key/value lookup
+ */
+
+#include <dirent.h>
+#include <endian.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mosys/alloc.h"
+#include "mosys/callbacks.h"
+#include "mosys/globals.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "lib/flashrom.h"
+#include "lib/math.h"
+#include "lib/vpd_kv.h"
+#include "lib/vpd_tables.h"
+
+#define VPD_KV_SYSFS_DIR	"/sys/firmware/vpd"
+
+/*
+ * The VPD 2.0 data may be preceded by an info header, which is encoded as
+ * an info entry: type, key length, version and "gVpdInfo" as the key, then
+ * the length of the 32-bit little-endian size which follows as its value.
+ */
+#define VPD_INFO_MAGIC		"\xfe\x09\x01gVpdInfo\x04"
+#define VPD_INFO_MAGIC_LEN	12
+#define VPD_INFO_HEADER_LEN	16		/* magic + 32-bit size */
+
+/* Older layouts start with a VPD 1.x entry point, data is at 0x600 */
+#define VPD_ENTRY_MAGIC_LEN	4
+#define VPD_LEGACY_OFFSET	0x600
+
+/* Entry types */
+#define VPD_KV_TYPE_TERMINATOR	0x00
+#define VPD_KV_TYPE_STRING	0x01
+#define VPD_KV_TYPE_INFO	0xfe
+#define VPD_KV_TYPE_ERASED	0xff		/* implicit terminator */
+
+/* Number of buckets in value hash table, must be a power of two */
+#define VPD_KV_BUCKETS		64
+
+/* Value, linked into a hash bucket */
+struct vpd_kv_node {
+	char *key;
+	char *value;
+	struct vpd_kv_node *next;
+};
+
+static struct vpd_kv_node *vpd_kv_table[VPD_KV_BUCKETS];
+static int vpd_kv_loaded;
+static pthread_mutex_t vpd_kv_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *vpd_kv_partitions[][2] = {
+	/* sysfs directory, flash region */
+	{ "ro", "RO_VPD" },
+	{ "rw", "RW_VPD" },
+};
+
+/* FNV-1a hash of the first len bytes of key */
+static unsigned int vpd_kv_hash(const char *key, size_t len)
+{
+	unsigned int hash = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= (unsigned char)key[i];
+		hash *= 16777619u;
+	}
+
+	return hash & (VPD_KV_BUCKETS - 1);
+}
+
+static struct vpd_kv_node *vpd_kv_find(const char *key, size_t len)
+{
+	struct vpd_kv_node *node;
+
+	node = vpd_kv_table[vpd_kv_hash(key, len)];
+	for (; node; node = node->next) {
+		if (!strncmp(node->key, key, len) && !node->key[len])
+			return node;
+	}
+
+	return NULL;
+}
+
+/*
+ * vpd_kv_add  -  add value to hash table
+ *
+ * @key:	key, need not be NUL-terminated
+ * @key_len:	length of key
+ * @value:	value, need not be NUL-terminated
+ * @value_len:	length of value
+ *
+ * Partitions are loaded in order of precedence, so a key which is
+ * already present is left alone.
+ */
+static void vpd_kv_add(const char *key, size_t key_len,
+                       const char *value, size_t value_len)
+{
+	struct vpd_kv_node *node;
+	unsigned int bucket;
+
+	if (!key_len || vpd_kv_find(key, key_len))
+		return;
+
+	node = mosys_malloc(sizeof(*node));
+	node->key = mosys_malloc(key_len + 1);
+	memcpy(node->key, key, key_len);
+	node->key[key_len] = '\0';
+	node->value = mosys_malloc(value_len + 1);
+	memcpy(node->value, value, value_len);
+	node->value[value_len] = '\0';
+
+	bucket = vpd_kv_hash(key, key_len);
+	node->next = vpd_kv_table[bucket];
+	vpd_kv_table[bucket] = node;
+}
+
+static void vpd_kv_destroy(void *arg)
+{
+	struct vpd_kv_node *node, *next;
+	int i;
+
+	pthread_mutex_lock(&vpd_kv_lock);
+	for (i = 0; i < VPD_KV_BUCKETS; i++) {
+		for (node = vpd_kv_table[i]; node; node = next) {
+			next = node->next;
+			free(node->key);
+			free(node->value);
+			free(node);
+		}
+		vpd_kv_table[i] = NULL;
+	}
+	vpd_kv_loaded = 0;
+	pthread_mutex_unlock(&vpd_kv_lock);
+}
+
+/*
+ * vpd_kv_decode_len  -  decode length of key or value
+ *
+ * @buf:	buffer to decode from
+ * @size:	size of buffer
+ * @offset:	offset of encoded length, advanced past it
+ * @len:	decoded length
+ *
+ * Lengths are stored big-endian, seven bits per byte, with the top bit
+ * set in every byte but the last.
+ *
+ * returns 0 to indicate success
+ * returns <0 if the length is truncated or too large
+ */
+static int vpd_kv_decode_len(const uint8_t *buf, size_t size,
+                             size_t *offset, size_t *len)
+{
+	uint8_t byte;
+	int i;
+
+	*len = 0;
+	for (i = 0; i < 4; i++) {
+		if (*offset >= size)
+			return -1;
+		byte = buf[(*offset)++];
+		*len = (*len << 7) | (byte & 0x7f);
+		if (!(byte & 0x80))
+			return 0;
+	}
+
+	return -1;
+}
+
+/*
+ * vpd_kv_parse  -  add encoded values to hash table
+ *
+ * @buf:	encoded values
+ * @size:	size of buffer
+ *
+ * returns number of values found
+ */
+static int vpd_kv_parse(const uint8_t *buf, size_t size)
+{
+	size_t offset = 0, key_len, value_len, key_offset;
+	int type, count = 0;
+
+	while (offset < size) {
+		type = buf[offset++];
+		if (type == VPD_KV_TYPE_TERMINATOR ||
+		    type == VPD_KV_TYPE_ERASED)
+			break;
+		if (type != VPD_KV_TYPE_STRING && type != VPD_KV_TYPE_INFO) {
+			lprintf(LOG_DEBUG, "%s: Unknown type 0x%02x at %zu\n",
+			        __func__, type, offset - 1);
+			break;
+		}
+
+		if (vpd_kv_decode_len(buf, size, &offset, &key_len) < 0 ||
+		    key_len > size - offset)
+			break;
+		key_offset = offset;
+		offset += key_len;
+
+		if (vpd_kv_decode_len(buf, size, &offset, &value_len) < 0 ||
+		    value_len > size - offset)
+			break;
+
+		if (type == VPD_KV_TYPE_STRING) {
+			vpd_kv_add((const char *)&buf[key_offset], key_len,
+			           (const char *)&buf[offset], value_len);
+			count++;
+		}
+		offset += value_len;
+	}
+
+	return count;
+}
+
+/*
+ * vpd_kv_load_sysfs  -  load values exported by the kernel
+ *
+ * @name:	name of partition directory
+ *
+ * returns 0 to indicate success
+ * returns <0 if the partition is not exported
+ */
+static int vpd_kv_load_sysfs(const char *name)
+{
+	char dir_path[PATH_MAX];
+	char *value = NULL;
+	size_t value_size = 0, len;
+	struct dirent *ent;
+	DIR *dir;
+	ssize_t n;
+	int fd;
+
+	snprintf(dir_path, sizeof(dir_path), "%s%s/%s",
+	         mosys_get_root_prefix(), VPD_KV_SYSFS_DIR, name);
+	dir = opendir(dir_path);
+	if (!dir) {
+		lperror(LOG_DEBUG, "Unable to open %s", dir_path);
+		return -1;
+	}
+
+	while ((ent = readdir(dir)) != NULL) {
+		if (ent->d_name[0] == '.')
+			continue;
+
+		fd = openat(dirfd(dir), ent->d_name, O_RDONLY);
+		if (fd < 0)
+			continue;
+
+		/* sysfs does not report the size, so read until EOF */
+		len = 0;
+		do {
+			if (len == value_size) {
+				value_size += 4096;
+				value = mosys_realloc(value, value_size);
+			}
+			n = read(fd, &value[len], value_size - len);
+			if (n > 0)
+				len += n;
+		} while (n > 0);
+		close(fd);
+		if (n < 0)
+			continue;
+
+		vpd_kv_add(ent->d_name, strlen(ent->d_name), value, len);
+	}
+	closedir(dir);
+	free(value);
+
+	return 0;
+}
+
+/*
+ * vpd_kv_load_flash  -  load values from host firmware
+ *
+ * @region:	name of VPD region
+ *
+ * returns 0 to indicate success
+ * returns <0 if the region cannot be read
+ */
+static int vpd_kv_load_flash(const char *region)
+{
+	uint8_t *buf = NULL;
+	size_t offset = 0, size;
+	uint32_t info_size;
+	int len;
+
+	len = flashrom_read_by_name(&buf, HOST_FIRMWARE, region);
+	if (len < 0) {
+		lprintf(LOG_DEBUG, "%s: Unable to read %s\n", __func__, region);
+		return -1;
+	}
+	size = len;
+
+	if (size >= VPD_INFO_HEADER_LEN &&
+	    !memcmp(buf, VPD_INFO_MAGIC, VPD_INFO_MAGIC_LEN)) {
+		memcpy(&info_size, &buf[VPD_INFO_MAGIC_LEN],
+		       sizeof(info_size));
+		info_size = le32toh(info_size);
+		offset = VPD_INFO_HEADER_LEN;
+		if (info_size < size - offset)
+			size = offset + info_size;
+	} else if (size > VPD_LEGACY_OFFSET &&
+	           !memcmp(buf, VPD_ENTRY_MAGIC, VPD_ENTRY_MAGIC_LEN)) {
+		offset = VPD_LEGACY_OFFSET;
+	}
+
+	lprintf(LOG_DEBUG, "%s: %d values in %s\n", __func__,
+	        vpd_kv_parse(&buf[offset], size - offset), region);
+	free(buf);
+	return 0;
+}
+
+/* load all values, must be called with vpd_kv_lock held */
+static void vpd_kv_load(void)
+{
+	int i;
+
+	if (vpd_kv_loaded)
+		return;
+	vpd_kv_loaded = 1;
+
+	for (i = 0; i < ARRAY_SIZE(vpd_kv_partitions); i++) {
+		if (vpd_kv_load_sysfs(vpd_kv_partitions[i][0]) < 0)
+			vpd_kv_load_flash(vpd_kv_partitions[i][1]);
+	}
+
+	add_destroy_callback(vpd_kv_destroy, NULL);
+}
+
+char *vpd_kv_get(const char *key)
+{
+	struct vpd_kv_node *node;
+	char *value = NULL;
+
+	pthread_mutex_lock(&vpd_kv_lock);
+	vpd_kv_load();
+	node = vpd_kv_find(key, strlen(key));
+	if (node && *node->value)
+		value = mosys_strdup(node->value);
+	pthread_mutex_unlock(&vpd_kv_lock);
+
+	return value;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * vpd_kv_unittest.c: unit tests for VPD 2.0 key/value lookup
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmockery.h"
+
+#include "mosys/callbacks.h"
+#include "mosys/platform.h"
+
+#include "lib/flashrom.h"
+#include "lib/vpd_kv.h"
+
+/*
+ * RO_VPD is served from the firmware cache since there is no RO directory
+ * in the test sysfs. The RW directory has "region" set to "gb" and a 5000
+ * byte "long_value" which repeats the alphabet.
+ */
+
+#define TEST_INFO_HEADER	"\xfe\x09\x01gVpdInfo\x04"
+
+/* info header, size covering the first two entries, then a third */
+static const uint8_t test_vpd_info[] =
+	TEST_INFO_HEADER "\x21\x00\x00\x00"
+	"\x01\x0dserial_number\x06" "ABC123"
+	"\x01\x06region\x02us"
+	"\x01\x06hidden\x01x"
+	"\xff";
+
+/* no header, key with a two byte length, erased space ends the data */
+static const uint8_t test_vpd_bare[] =
+	"\x01\x81\x00"
+	"kkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkk"
+	"kkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkk"
+	"kkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkk"
+	"kkkkkkkkkkkkkkkkkkkkkkkkkkkkkkkk\x01v"
+	"\x01\x0dserial_number\x00"
+	"\xff\xff\xff\xff";
+
+static char *test_get(const uint8_t *vpd, size_t size, const char *key)
+{
+	flashrom_cache_store(HOST_FIRMWARE, "RO_VPD", vpd, size);
+	return vpd_kv_get(key);
+}
+
+static void test_reset(void)
+{
+	invoke_destroy_callbacks();
+	flashrom_cache_invalidate(HOST_FIRMWARE);
+}
+
+static void info_header_test(void **state)
+{
+	char *value;
+
+	value = test_get(test_vpd_info, sizeof(test_vpd_info), "serial_number");
+	assert_string_equal("ABC123", value);
+	free(value);
+
+	/* RO takes precedence over RW */
+	value = vpd_kv_get("region");
+	assert_string_equal("us", value);
+	free(value);
+
+	/* entries past the size in the header are ignored */
+	assert_true(vpd_kv_get("hidden") == NULL);
+
+	test_reset();
+}
+
+static void bare_test(void **state)
+{
+	char key[129];
+	char *value;
+
+	memset(key, 'k', sizeof(key) - 1);
+	key[sizeof(key) - 1] = '\0';
+	value = test_get(test_vpd_bare, sizeof(test_vpd_bare), key);
+	assert_string_equal("v", value);
+	free(value);
+
+	/* empty values are treated as missing */
+	assert_true(vpd_kv_get("serial_number") == NULL);
+
+	value = vpd_kv_get("region");
+	assert_string_equal("gb", value);
+	free(value);
+
+	test_reset();
+}
+
+static void sysfs_long_value_test(void **state)
+{
+	char *value;
+	int i;
+
+	value = test_get(test_vpd_info, sizeof(test_vpd_info), "long_value");
+	assert_true(value != NULL);
+	assert_int_equal(5000, strlen(value));
+	for (i = 0; i < 5000; i++) {
+		if (value[i] != 'a' + i % 26)
+			break;
+	}
+	assert_int_equal(5000, i);
+	free(value);
+
+	test_reset();
+}
+
+int vpd_kv_unittest(void)
+{
+	UnitTest tests[] = {
+		unit_test(info_header_test),
+		unit_test(bare_test),
+		unit_test(sysfs_long_value_test),
+	};
+
+	return run_tests(tests);
+}
@@ -39,6 +39,7 @@
 #include "mosys/alloc.h"
 #include "mosys/big_lock.h"
 #include "mosys/command_list.h"
+#include "mosys/daemon.h"
 #include "mosys/globals.h"
 #include "mosys/kv_pair.h"
 #include "mosys/log.h"
@@ -54,6 +55,9 @@ static void usage(void)
 	"    -s [key]      print value for single key\n"
 	"    -v            verbose (can be used multiple times)\n"
 	"    -f            force (ignore mosys lock, sanity checks, etc)\n"
+	"    -r            re-probe platform (ignore cached detection)\n"
+	"    -b [file]     run commands from file, one per line (- for stdin)\n"
+	"    -c [socket]   run command through mosysd listening on socket\n"
 	"    -t            display command tree for detected platform\n"
 	"    -S            print supported platform IDs\n"
 	"    -p [id]       specify platform id (bypass auto-detection)\n"
@@ -62,152 +66,182 @@ static void usage(void)
 	"\n", PROGRAM);
 }
 
-static void sub_list(struct platform_cmd *sub)
-{
-	struct platform_cmd *_sub;
-
-	if (!sub)
-		return;
+/* Maximum number of arguments on a line in batch mode */
+#define BATCH_MAX_ARGS	64
 
-	printf("  Commands:\n");
-	for (_sub = sub->arg.sub; _sub && _sub->name; _sub++) {
-		if (_sub->desc)
-			printf("    %-12s  %s\n", _sub->name, _sub->desc);
-	}
-	printf("\n");
-}
-
-static int sub_main(struct platform_intf *intf,
-		    struct platform_cmd *sub, int argc, char **argv)
+/*
+ * batch_split  -  split command line into arguments
+ *
+ * @line:	line to split, modified in place
+ * @argv:	OUTPUT array of arguments
+ * @max:	size of argv
+ *
+ * Arguments are separated by whitespace. Double quotes group words into
+ * a single argument.
+ *
+ * returns number of arguments
+ * returns <0 to indicate failure
+ */
+static int batch_split(char *line, char **argv, int max)
 {
-	struct platform_cmd *cmd;
+	char *p = line, *out;
+	int argc = 0, quoted;
 
-	if (!intf || !sub) {
-		errno = ENOSYS;
-		return -1;
-	}
+	while (1) {
+		while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+			p++;
+		if (*p == '\0')
+			break;
 
-	switch (sub->type) {
-	case ARG_TYPE_GETTER:
-	case ARG_TYPE_SETTER:
-		if (!sub->arg.func) {
-			lprintf(LOG_ERR, "Undefined Function\n");
+		if (argc == max) {
+			lprintf(LOG_ERR, "Too many arguments\n");
 			return -1;
 		}
 
-		/* this is a function, it might have more args */
-		if (argc > 0 && strcmp(argv[0], "help") == 0) {
-			platform_cmd_usage(sub);
-			return 0;
-		}
-
-		/* run command handler */
-		return sub->arg.func(intf, sub, argc, argv);
-
-	case ARG_TYPE_SUB:
-		if (argc == 0) {
-			sub_list(sub);
-			return -1;	/* generic error */
-		}
-
-		/* this is a sub-command, we must have some more args */
-		if (argc == 0 || strcmp(argv[0], "help") == 0) {
-			sub_list(sub);
-			return 0;
-		}
-
-		/* search for matching sub-command */
-		for (cmd = sub->arg.sub; cmd && cmd->name; cmd++) {
-			if (strlen(cmd->name) != strlen(argv[0]))
+		/* strip quotes while copying argument in place */
+		argv[argc++] = out = p;
+		for (quoted = 0; *p; p++) {
+			if (*p == '"') {
+				quoted = !quoted;
 				continue;
-			if (strcmp(cmd->name, argv[0]) == 0) {
-				lprintf(LOG_DEBUG, "Subcommand %s (%s)\n",
-					cmd->name, cmd->desc);
-				return sub_main(intf, cmd, argc - 1,
-						&(argv[1]));
 			}
+			if (!quoted && (*p == ' ' || *p == '\t' ||
+			                *p == '\n' || *p == '\r'))
+				break;
+			*out++ = *p;
 		}
-		break;
-
-	default:
-		lprintf(LOG_ERR, "Unknown subcommand type\n");
-		return -1;
+		if (quoted) {
+			lprintf(LOG_ERR, "Unterminated quote\n");
+			return -1;
+		}
+		if (*p)
+			p++;
+		*out = '\0';
 	}
 
-	lprintf(LOG_WARNING, "Command not found\n\n");
-	sub_list(sub);
+	return argc;
+}
+
+/*
+ * batch_skip_line  -  skip the rest of a line which did not fit the buffer
+ *
+ * @fp:		file being read
+ *
+ * returns 1 if characters were skipped
+ * returns 0 if only the end of the line was left
+ */
+static int batch_skip_line(FILE *fp)
+{
+	int c, skipped = 0;
+
+	while ((c = getc(fp)) != EOF && c != '\n')
+		skipped = 1;
 
-	errno = EINVAL;	/* unknown or invalid subcommand argument */
-	return -1;
+	return skipped;
 }
 
-static int intf_main(struct platform_intf *intf, int argc, char **argv)
+/*
+ * batch_main  -  run commands read from a file against one platform setup
+ *
+ * @intf:	platform interface
+ * @file:	file to read commands from, "-" for stdin
+ *
+ * Each non-empty line which does not start with '#' is run as if it was
+ * given on the command line. The output of each command is followed by
+ * a delimiter line with its exit status and the command itself:
+ *   --- exit <status>: <command>
+ * Lines longer than LINE_MAX are not run and fail with EINVAL.
+ *
+ * returns 0 if all commands succeeded
+ * returns <0 if a command failed or the file could not be read
+ */
+static int batch_main(struct platform_intf *intf, const char *file)
 {
-	struct platform_cmd **_sub, *sub;
-	int do_list = 0;
+	char line[LINE_MAX], cmd[LINE_MAX];
+	char *argv[BATCH_MAX_ARGS];
+	FILE *fp;
+	size_t len;
+	int argc, rc, errsv, status, too_long;
 	int ret = 0;
 
-	if (!intf || !intf->sub) {
-		lprintf(LOG_ERR, "No commands defined for this platform\n");
-		errno = ENOSYS;
-		return -1;
+	if (!strcmp(file, "-")) {
+		fp = stdin;
+	} else {
+		fp = fopen(file, "r");
+		if (!fp) {
+			lperror(LOG_ERR, "Unable to open %s", file);
+			return -1;
+		}
 	}
 
-	if (argc == 0 || strcmp(argv[0], "help") == 0) {
-		do_list = 1;
-		usage();
-		printf("  Commands:\n");
-	}
+	while (fgets(line, sizeof(line), fp)) {
+		/* fgets() returns the rest of a long line as the next one */
+		len = strlen(line);
+		too_long = line[len - 1] != '\n' && batch_skip_line(fp);
 
-	/* go through subcommand list for this interface */
-	for (_sub = intf->sub; _sub && *_sub; _sub++) {
+		line[strcspn(line, "\r\n")] = '\0';
+		snprintf(cmd, sizeof(cmd), "%s", line);
 
-		sub = *_sub;
-		if (do_list) {
-			/*FIXME: if the intf had a main sub, call sub_list */
-			printf("    %-12s  %s\n", sub->name, sub->desc);
+		argc = batch_split(line, argv, BATCH_MAX_ARGS);
+		if (argc == 0 || (argc > 0 && argv[0][0] == '#'))
 			continue;
-		}
 
-		lprintf(LOG_DEBUG, "Command: %s (%s)\n", sub->name, argv[0]);
-
-		/* is this sub-command is the one they asked for? */
-		if (strlen(sub->name) != strlen(argv[0]))
-			continue;
-		if (strcmp(sub->name, argv[0]) == 0) {
-			lprintf(LOG_DEBUG, "Found command %s (%s)\n",
-				sub->name, sub->desc);
-			return sub_main(intf, sub, argc - 1, &(argv[1]));
+		if (too_long) {
+			lprintf(LOG_ERR, "Line longer than %d characters\n",
+			        LINE_MAX - 1);
+			rc = -1;
+			errsv = EINVAL;
+		} else if (argc < 0) {
+			rc = -1;
+			errsv = EINVAL;
+		} else {
+			errno = 0;
+			rc = platform_dispatch(intf, argc, argv, usage);
+			errsv = errno;
+			if (rc < 0 && errsv == ENOSYS)
+				lprintf(LOG_ERR, "Command not supported on "
+				        "this platform\n");
 		}
-	}
 
-	if (do_list) {
-		printf("\n");
-		if (argc == 0)
+		/* same status the command would have exited with */
+		status = (rc < 0 && errsv > 0) ? errsv : rc;
+		if (status)
 			ret = -1;
-		return ret;
+
+		fflush(mosys_get_output_file());
+		fprintf(mosys_get_output_file(), "--- exit %d: %s\n",
+		        status, cmd);
+		fflush(mosys_get_output_file());
 	}
 
-	lprintf(LOG_WARNING, "Command not found\n\n");
-	errno = ENOSYS;
-	return intf_main(intf, 0, NULL);	/* trigger a help listing */
+	if (fp != stdin)
+		fclose(fp);
+
+	return ret;
 }
 
 #define LOCK_TIMEOUT_SECS 180
 
 int mosys_main(int argc, char **argv)
 {
-	int rc, errsv;
+	int rc, errsv = 0;
 	int argflag;
 	int verbose = 0;
 	int force_lock = 0;
 	int print_platforms_opt = 0;
 	int showtree = 0;
 	char *p_opt = NULL;
+	char *batch_file = NULL;
+	char *client_socket = NULL;
 	struct platform_intf *intf;
 	enum kv_pair_style style = KV_STYLE_VALUE;
 
-	while ((argflag = getopt(argc, argv, "klvftSs:p:Vh")) > 0) {
+	/*
+	 * Options end at the command name. Command arguments may start with
+	 * '-', e.g. "eventlog list --since-cursor", and must not be taken
+	 * for mosys options.
+	 */
+	while ((argflag = getopt(argc, argv, "+klvfrtSs:p:b:c:Vh")) > 0) {
 		switch (argflag) {
 		case 'k':
 			style = KV_STYLE_PAIR;
@@ -229,6 +263,9 @@ int mosys_main(int argc, char **argv)
 		case 'f':
 			force_lock = 1;
 			break;
+		case 'r':
+			mosys_set_force_probe(1);
+			break;
 		case 't':
 			showtree = 1;
 			break;
@@ -238,6 +275,12 @@ int mosys_main(int argc, char **argv)
 		case 'p':
 			p_opt = optarg;
 			break;
+		case 'b':
+			batch_file = optarg;
+			break;
+		case 'c':
+			client_socket = optarg;
+			break;
 		case 'V':
 			printf("mosys version %s\n", VERSION);
 			exit(EXIT_SUCCESS);
@@ -264,9 +307,21 @@ int mosys_main(int argc, char **argv)
 	 */
 	mosys_log_init(PROGRAM, CONFIG_LOGLEVEL+verbose, NULL);
 
+	/* let mosysd run the command, it holds the platform set up already */
+	if (client_socket) {
+		rc = mosysd_client(client_socket, style, kv_get_single_key(),
+		                   argc - optind, &(argv[optind]));
+		goto do_exit_1;
+	}
+
 #if defined(CONFIG_USE_IPC_LOCK)
-	/* try to get lock */
-	if (!force_lock && (mosys_acquire_big_lock(LOCK_TIMEOUT_SECS) < 0)) {
+	/*
+	 * try to get lock, shared until a command needs it exclusively
+	 * (see platform_dispatch)
+	 */
+	if (!force_lock &&
+	    (mosys_acquire_big_lock_mode(IPC_LOCK_SHARED,
+	                                 LOCK_TIMEOUT_SECS) < 0)) {
 		rc = -1;
 		goto do_exit_1;
 	}
@@ -290,9 +345,14 @@ int mosys_main(int argc, char **argv)
 		goto do_exit_3;
 	}
 
-	/* run command */
+	/* run commands */
 	errno = 0;
-	rc = intf_main(intf, argc - optind, &(argv[optind]));
+	if (batch_file) {
+		rc = batch_main(intf, batch_file);
+		errsv = 0;
+		goto do_exit_3;
+	}
+	rc = platform_dispatch(intf, argc - optind, &(argv[optind]), usage);
 	errsv = errno;
 	if (rc < 0 && errsv == ENOSYS)
 		lprintf(LOG_ERR, "Command not supported on this platform\n");
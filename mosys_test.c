@@ -36,8 +36,18 @@
 
 #include "cmockery.h"
 
+#include "mosys/daemon.h"
+#include "mosys/library.h"
 #include "mosys/log.h"
 #include "mosys/platform.h"
+#include "mosys/result_cache.h"
+
+#include "lib/elog.h"
+#include "lib/elog_cursor.h"
+#include "lib/elog_query.h"
+#include "lib/elog_smbios.h"
+#include "lib/smbios.h"
+#include "lib/vpd_kv.h"
 
 const char *test_ids[] = {
 	"TEST",
@@ -66,6 +76,18 @@ int main(int argc, char **argv)
 	rc |= file_unittest(intf);
 	rc |= math_unittest();
 	rc |= io_unittest(intf);
+	rc |= smbios_unittest(intf);
+	rc |= elog_unittest();
+	rc |= elog_cursor_unittest(intf);
+	rc |= elog_query_unittest();
+	rc |= elog_smbios_unittest();
+	rc |= vpd_kv_unittest();
+	rc |= daemon_unittest();
+	rc |= library_unittest();
+	/* first to auto-detect, the identity it sets up stays cached */
+	rc |= platform_unittest();
+	/* last, the boot ID it sets up stays cached */
+	rc |= result_cache_unittest();
 
 	if (rc == 0)
 		fprintf(stdout, "Unit tests passed.\n");
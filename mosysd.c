@@ -0,0 +1,573 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * mosysd.c: daemon serving mosys commands over a Unix socket
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "mosys/alloc.h"
+#include "mosys/big_lock.h"
+#include "mosys/daemon.h"
+#include "mosys/globals.h"
+#include "mosys/kv_pair.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+#include "mosys/result_cache.h"
+
+#include "lib/flashrom.h"
+
+#define LOCK_TIMEOUT_SECS 180
+
+/* clients served at once, further connections wait in the backlog */
+#define MAX_CLIENTS		16
+
+/* seconds a client may take to send its request or read the response */
+#define CLIENT_TIMEOUT_SECS	10
+
+/*
+ * Output of the getters under these commands does not change while the
+ * system is up, so successful results are kept and served without
+ * touching hardware until a setter may have changed them.
+ */
+static const char *static_commands[] = {
+	"memory",
+	"platform",
+	"smbios",
+	NULL
+};
+
+/* Cached output of a command */
+struct response_cache {
+	char *key;
+	size_t key_len;
+	int status;
+	char *data;
+	size_t len;
+	struct response_cache *next;
+};
+
+static struct platform_intf *intf;
+static struct response_cache *cache;
+static unsigned int cache_generation;	/* result_cache_invalidations() */
+static pthread_rwlock_t cache_lock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t hw_lock = PTHREAD_MUTEX_INITIALIZER;
+static sem_t client_slots;
+static volatile sig_atomic_t stop;
+
+static void usage(void)
+{
+	printf("usage: %s [options]\n\n"
+	"  Options:\n"
+	"    -s [socket]   listen on socket (default: %s)\n"
+	"    -p [id]       specify platform id (bypass auto-detection)\n"
+	"    -r            re-probe platform (ignore cached detection)\n"
+	"    -v            verbose (can be used multiple times)\n"
+	"    -h            print this help\n"
+	"    -V            print version\n"
+	"\n", PROGRAM, MOSYSD_SOCKET);
+}
+
+static void handle_signal(int sig)
+{
+	stop = 1;
+}
+
+/*
+ * is_static_command  -  check if output of command can be cached
+ *
+ * Only getters are cached, setters under the same commands must run
+ * every time.
+ *
+ * returns 1 if command output is static
+ * returns 0 otherwise
+ */
+static int is_static_command(int argc, char **argv)
+{
+	struct platform_cmd *leaf;
+	const char **cmd;
+
+	/* a command asked for help only prints it */
+	if (argc < 2 || !strcmp(argv[argc - 1], "help"))
+		return 0;
+
+	leaf = platform_cmd_find(intf, argc, argv);
+	if (!leaf || leaf->type != ARG_TYPE_GETTER)
+		return 0;
+
+	for (cmd = static_commands; *cmd; cmd++) {
+		if (!strcmp(argv[0], *cmd))
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * cache_key  -  build cache key from output options and arguments
+ *
+ * returns allocated key, its length stored in *len
+ */
+static char *cache_key(enum kv_pair_style style, const char *single_key,
+                       int argc, char **argv, size_t *len)
+{
+	char *key, *p;
+	int i;
+
+	*len = 1 + strlen(single_key ? : "") + 1;
+	for (i = 0; i < argc; i++)
+		*len += strlen(argv[i]) + 1;
+
+	p = key = mosys_malloc(*len);
+	*p++ = style;
+	strcpy(p, single_key ? : "");
+	p += strlen(p) + 1;
+	for (i = 0; i < argc; i++) {
+		strcpy(p, argv[i]);
+		p += strlen(p) + 1;
+	}
+
+	return key;
+}
+
+/*
+ * cache_lookup  -  copy cached output for key
+ *
+ * returns 0 if found, with allocated copy of output in *data
+ * returns <0 if not found
+ */
+static int cache_lookup(const char *key, size_t key_len,
+                        int *status, char **data, size_t *len)
+{
+	struct response_cache *entry;
+	int ret = -1;
+
+	pthread_rwlock_rdlock(&cache_lock);
+	if (cache_generation != result_cache_invalidations())
+		goto cache_lookup_exit;
+
+	for (entry = cache; entry; entry = entry->next) {
+		if (entry->key_len != key_len ||
+		    memcmp(entry->key, key, key_len))
+			continue;
+
+		*status = entry->status;
+		*len = entry->len;
+		*data = mosys_malloc(entry->len + 1);
+		memcpy(*data, entry->data, entry->len);
+		ret = 0;
+		break;
+	}
+
+cache_lookup_exit:
+	pthread_rwlock_unlock(&cache_lock);
+	return ret;
+}
+
+static void cache_destroy(void)
+{
+	struct response_cache *entry, *next;
+
+	for (entry = cache; entry; entry = next) {
+		next = entry->next;
+		free(entry->key);
+		free(entry->data);
+		free(entry);
+	}
+	cache = NULL;
+}
+
+/*
+ * cache_store  -  keep output of command
+ *
+ * @generation:	result_cache_invalidations() before the command ran
+ *
+ * Output is dropped if a setter ran since, as it may be out of date.
+ */
+static void cache_store(const char *key, size_t key_len,
+                        int status, const char *data, size_t len,
+                        unsigned int generation)
+{
+	struct response_cache *entry;
+
+	entry = mosys_malloc(sizeof(*entry));
+	entry->key = mosys_malloc(key_len);
+	memcpy(entry->key, key, key_len);
+	entry->key_len = key_len;
+	entry->status = status;
+	entry->data = mosys_malloc(len + 1);
+	memcpy(entry->data, data, len);
+	entry->len = len;
+
+	pthread_rwlock_wrlock(&cache_lock);
+	if (generation != result_cache_invalidations()) {
+		free(entry->key);
+		free(entry->data);
+		free(entry);
+		goto cache_store_exit;
+	}
+	if (generation != cache_generation) {
+		cache_destroy();
+		cache_generation = generation;
+	}
+	entry->next = cache;
+	cache = entry;
+
+cache_store_exit:
+	pthread_rwlock_unlock(&cache_lock);
+}
+
+/* drop cached output once a setter may have changed it */
+static void cache_expire(void)
+{
+	pthread_rwlock_wrlock(&cache_lock);
+	if (cache_generation != result_cache_invalidations()) {
+		cache_destroy();
+		cache_generation = result_cache_invalidations();
+	}
+	pthread_rwlock_unlock(&cache_lock);
+}
+
+/*
+ * run_command  -  run command with its output captured
+ *
+ * @style:	output style
+ * @single_key:	key to print for KV_STYLE_SINGLE, may be NULL
+ * @argc:	number of arguments
+ * @argv:	command and its arguments
+ * @data:	OUTPUT allocated buffer with stdout and stderr of command
+ * @len:	OUTPUT length of output
+ * @generation:	OUTPUT result_cache_invalidations() before the command ran
+ *
+ * Commands share the platform interface and the process-wide output
+ * settings, so only one runs at a time.
+ *
+ * returns exit status of the command
+ */
+static int run_command(enum kv_pair_style style, const char *single_key,
+                       int argc, char **argv, char **data, size_t *len,
+                       unsigned int *generation)
+{
+	FILE *out;
+	int saved_stdout, saved_stderr;
+	int rc, errsv;
+	long size;
+
+	*data = NULL;
+	*len = 0;
+
+	out = tmpfile();
+	if (!out) {
+		lperror(LOG_ERR, "Unable to create output file");
+		return -1;
+	}
+
+	pthread_mutex_lock(&hw_lock);
+
+#if defined(CONFIG_USE_IPC_LOCK)
+	/* other mosys processes may be accessing the hardware */
+	if (mosys_acquire_big_lock(LOCK_TIMEOUT_SECS) < 0) {
+		pthread_mutex_unlock(&hw_lock);
+		fclose(out);
+		return -1;
+	}
+#endif
+
+	fflush(stdout);
+	fflush(stderr);
+	saved_stdout = dup(STDOUT_FILENO);
+	saved_stderr = dup(STDERR_FILENO);
+	dup2(fileno(out), STDOUT_FILENO);
+	dup2(fileno(out), STDERR_FILENO);
+
+	/*
+	 * Firmware and other processes change the event log, NVRAM and the
+	 * like while the daemon runs. Only data identifying the system is
+	 * kept from one request to the next.
+	 */
+	flashrom_cache_expire();
+
+	mosys_set_kv_pair_style(style);
+	kv_set_single_key(single_key);
+
+	*generation = result_cache_invalidations();
+	errno = 0;
+	rc = platform_dispatch(intf, argc, argv, NULL);
+	errsv = errno;
+	if (rc < 0 && errsv == ENOSYS)
+		lprintf(LOG_ERR, "Command not supported on this platform\n");
+
+	kv_set_single_key(NULL);
+
+	fflush(stdout);
+	fflush(stderr);
+	dup2(saved_stdout, STDOUT_FILENO);
+	dup2(saved_stderr, STDERR_FILENO);
+	close(saved_stdout);
+	close(saved_stderr);
+
+#if defined(CONFIG_USE_IPC_LOCK)
+	mosys_release_big_lock();
+#endif
+	pthread_mutex_unlock(&hw_lock);
+
+	/* setters invalidate cached values, see sub_run() */
+	cache_expire();
+
+	size = ftell(out);
+	if (size > 0 && size <= MOSYSD_MAX_LEN) {
+		*data = mosys_malloc(size);
+		rewind(out);
+		*len = fread(*data, 1, size, out);
+	}
+	fclose(out);
+
+	return (rc < 0 && errsv > 0) ? errsv : rc;
+}
+
+/*
+ * serve_client  -  handle one request from a connected client
+ *
+ * @arg:	connected socket
+ */
+static void *serve_client(void *arg)
+{
+	int fd = (long)arg;
+	struct mosysd_request req;
+	char *single_key, **argv;
+	char *key, *data = NULL;
+	size_t key_len, len = 0;
+	unsigned int generation;
+	int status, cacheable;
+
+	if (mosysd_set_timeout(fd, CLIENT_TIMEOUT_SECS) < 0 ||
+	    mosysd_recv_request(fd, &req, &single_key, &argv) < 0) {
+		close(fd);
+		sem_post(&client_slots);
+		return NULL;
+	}
+
+	cacheable = is_static_command(req.argc, argv);
+	key = cache_key(req.style, single_key, req.argc, argv, &key_len);
+
+	if (!cacheable ||
+	    cache_lookup(key, key_len, &status, &data, &len) < 0) {
+		status = run_command(req.style, single_key, req.argc, argv,
+		                     &data, &len, &generation);
+		if (cacheable && status == 0)
+			cache_store(key, key_len, status, data, len,
+			            generation);
+	}
+
+	if (mosysd_send_response(fd, status, data, len) < 0)
+		lprintf(LOG_DEBUG, "Unable to send response\n");
+
+	free(data);
+	free(key);
+	free(argv);
+	close(fd);
+	sem_post(&client_slots);
+	return NULL;
+}
+
+/*
+ * listen_socket  -  create listening socket
+ *
+ * @path:	path of socket
+ *
+ * returns listening socket
+ * returns <0 to indicate failure
+ */
+static int listen_socket(const char *path)
+{
+	struct sockaddr_un addr;
+	mode_t mask;
+	int fd, rc;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		lprintf(LOG_ERR, "Socket path %s is too long\n", path);
+		return -1;
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		lperror(LOG_ERR, "Unable to create socket");
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	/* remove socket left over from an earlier instance */
+	unlink(path);
+
+	/*
+	 * Hardware access is as privileged as running mosys itself. The
+	 * socket is created with these permissions so nobody can connect
+	 * before they are restricted.
+	 */
+	mask = umask(0177);
+	rc = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+	umask(mask);
+	if (rc < 0) {
+		lperror(LOG_ERR, "Unable to bind to %s", path);
+		close(fd);
+		return -1;
+	}
+
+	if (listen(fd, 16) < 0) {
+		lperror(LOG_ERR, "Unable to listen on %s", path);
+		close(fd);
+		unlink(path);
+		return -1;
+	}
+
+	return fd;
+}
+
+int main(int argc, char **argv)
+{
+	const char *socket_path = MOSYSD_SOCKET;
+	char *p_opt = NULL;
+	int verbose = 0;
+	int argflag, fd, client, rc = -1;
+	struct sigaction sa;
+	pthread_attr_t attr;
+	pthread_t thread;
+
+	mosys_globals_init();
+
+	while ((argflag = getopt(argc, argv, "s:p:rvVh")) > 0) {
+		switch (argflag) {
+		case 's':
+			socket_path = optarg;
+			break;
+		case 'p':
+			p_opt = optarg;
+			break;
+		case 'r':
+			mosys_set_force_probe(1);
+			break;
+		case 'v':
+			verbose++;
+			break;
+		case 'V':
+			printf("%s version %s\n", PROGRAM, VERSION);
+			exit(EXIT_SUCCESS);
+		case 'h':
+			usage();
+			exit(EXIT_SUCCESS);
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	mosys_log_init(PROGRAM, CONFIG_LOGLEVEL+verbose, NULL);
+	mosys_set_verbosity(CONFIG_LOGLEVEL+verbose);
+
+#if defined(CONFIG_USE_IPC_LOCK)
+	if (mosys_acquire_big_lock(LOCK_TIMEOUT_SECS) < 0)
+		goto do_exit_1;
+#endif
+	intf = mosys_platform_setup(p_opt);
+#if defined(CONFIG_USE_IPC_LOCK)
+	mosys_release_big_lock();
+#endif
+	if (!intf) {
+		lprintf(LOG_ERR, "Platform not supported\n");
+		goto do_exit_1;
+	}
+	lprintf(LOG_DEBUG, "Platform: %s\n", intf->name);
+
+	fd = listen_socket(socket_path);
+	if (fd < 0)
+		goto do_exit_2;
+
+	/* accept() is interrupted so the daemon can exit cleanly */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = handle_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	sem_init(&client_slots, 0, MAX_CLIENTS);
+
+	lprintf(LOG_NOTICE, "Listening on %s\n", socket_path);
+	while (!stop) {
+		/* interrupted by signals, like accept() */
+		if (sem_wait(&client_slots) < 0)
+			continue;
+
+		client = accept(fd, NULL, NULL);
+		if (client < 0) {
+			if (errno != EINTR)
+				lperror(LOG_ERR, "Unable to accept connection");
+			sem_post(&client_slots);
+			continue;
+		}
+
+		if (pthread_create(&thread, &attr, serve_client,
+		                   (void *)(long)client)) {
+			lprintf(LOG_ERR, "Unable to start thread\n");
+			close(client);
+			sem_post(&client_slots);
+		}
+	}
+	rc = 0;
+
+	pthread_attr_destroy(&attr);
+	close(fd);
+	unlink(socket_path);
+
+	/* wait for commands in progress before tearing down the platform */
+	pthread_mutex_lock(&hw_lock);
+do_exit_2:
+	mosys_platform_destroy(intf);
+do_exit_1:
+	cache_destroy();
+	mosys_log_halt();
+	return rc;
+}
@@ -170,9 +170,22 @@ struct platform_cb auron_cb = {
 	.eventlog	= &auron_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *auron_probe_ids[] = {
+	"Buddy",
+	"Cid",
+	"Gandof",
+	"Lulu",
+	"Paine",
+	"Yuna",
+	"Auron",
+	NULL
+};
+
 struct platform_intf platform_auron = {
 	.type		= PLATFORM_X86_64,
 	.name		= "Auron",
+	.probe_ids	= auron_probe_ids,
 	.sub		= auron_sub,
 	.cb		= &auron_cb,
 	.probe		= &auron_probe,
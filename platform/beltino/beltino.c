@@ -153,9 +153,25 @@ struct platform_cb beltino_cb = {
 	.eventlog	= &beltino_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *beltino_probe_ids[] = {
+	"Beltino",
+	"Guado",
+	"Jecht",
+	"Mccloud",
+	"Monroe",
+	"Panther",
+	"Rikku",
+	"Tidus",
+	"Tricky",
+	"Zako",
+	NULL
+};
+
 struct platform_intf platform_beltino = {
 	.type		= PLATFORM_X86_64,
 	.name		= "Beltino",
+	.probe_ids	= beltino_probe_ids,
 	.sub		= beltino_sub,
 	.cb		= &beltino_cb,
 	.probe		= &beltino_probe,
@@ -131,9 +131,16 @@ struct platform_cb cyan_cb = {
 	.eventlog	= &cyan_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *cyan_probe_ids[] = {
+	"Cyan",
+	NULL
+};
+
 struct platform_intf platform_cyan = {
 	.type		= PLATFORM_X86_64,
 	.name		= "cyan",
+	.probe_ids	= cyan_probe_ids,
 	.sub		= cyan_sub,
 	.cb		= &cyan_cb,
 	.probe		= &cyan_probe,
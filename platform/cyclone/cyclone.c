@@ -88,9 +88,11 @@ struct eventlog_cb cyclone_eventlog_cb = {
 	.verify		= &elog_verify,
 	.verify_header	= &elog_verify_header,
 	.add		= &elog_add_event_manually,
+	.add_many	= &elog_add_events_manually,
 	.clear		= &elog_clear_manually,
 	.fetch		= &elog_fetch_from_flash,
 	.write		= &elog_write_to_flash,
+	.write_range	= &elog_write_range_to_flash,
 };
 
 struct platform_cb cyclone_cb = {
@@ -104,6 +106,7 @@ struct platform_cb cyclone_cb = {
 struct platform_intf platform_cyclone = {
 	.type		= PLATFORM_ARMV7,
 	.name		= "Gale",
+	.probe_ids	= id_list,
 	.sub		= cyclone_sub,
 	.cb		= &cyclone_cb,
 	.probe		= &cyclone_probe,
@@ -153,7 +153,7 @@ static int snow_get_board_config(struct platform_intf *intf)
 
 static int daisy_setup_post(struct platform_intf *intf)
 {
-	if (daisy_ec_setup(intf) <= 0)
+	if (cros_ec_defer_setup(intf, intf->cb->ec, daisy_ec_setup) < 0)
 		return -1;
 
 	if (!strcmp(intf->name, "Snow"))
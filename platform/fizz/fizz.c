@@ -136,9 +136,16 @@ struct platform_cb fizz_cb = {
 	.eventlog	= &fizz_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *fizz_probe_ids[] = {
+	"Fizz",
+	NULL
+};
+
 struct platform_intf platform_fizz = {
 	.type		= PLATFORM_X86_64,
 	.name		= "Fizz",
+	.probe_ids	= fizz_probe_ids,
 	.sub		= fizz_sub,
 	.cb		= &fizz_cb,
 	.probe		= &fizz_probe,
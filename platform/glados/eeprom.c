@@ -50,34 +50,6 @@ static int glados_host_firmware_size(struct platform_intf *intf)
 	return GLADOS_HOST_FIRMWARE_ROM_SIZE;
 }
 
-static int host_firmware_read(struct platform_intf *intf,
-			      struct eeprom *eeprom,
-			      unsigned int offset,
-			      unsigned int len,
-			      void *data)
-{
-	uint8_t *buf;
-	size_t rom_size;
-
-	rom_size = eeprom->device->size(intf);
-	buf = mosys_malloc(rom_size);
-
-	if (flashrom_read(buf, rom_size, HOST_FIRMWARE, NULL) < 0)
-		return -1;
-
-	memcpy(data, &buf[offset], len);
-	free(buf);
-	return 0;
-}
-
-static int host_firmware_read_by_name(struct platform_intf *intf,
-				      struct eeprom *eeprom,
-				      const char *name,
-				      uint8_t **data)
-{
-	return flashrom_read_by_name(data, HOST_FIRMWARE, name);
-}
-
 static int host_firmware_write_by_name(struct platform_intf *intf,
 				       struct eeprom *eeprom,
 				       const char *name,
@@ -89,10 +61,10 @@ static int host_firmware_write_by_name(struct platform_intf *intf,
 
 static struct eeprom_dev host_firmware = {
 	.size		= glados_host_firmware_size,
-	.read		= host_firmware_read,
-	.read_by_name	= host_firmware_read_by_name,
+	.read		= eeprom_mapped_flash_read,
+	.read_by_name	= eeprom_mapped_flash_read_by_name,
 	.write_by_name	= host_firmware_write_by_name,
-	.get_map	= eeprom_get_fmap,
+	.get_map	= eeprom_mapped_flash_get_map,
 };
 
 static struct eeprom_region host_firmware_regions[] = {
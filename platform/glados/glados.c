@@ -168,9 +168,28 @@ struct platform_cb glados_cb = {
 	.eventlog	= &glados_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *glados_probe_ids[] = {
+	"Asuka",
+	"Caroline",
+	"Cave",
+	"Chell",
+	"Eve",
+	"Poppy",
+	"Glados",
+	"Kunimitsu",
+	"Lars",
+	"Pbody",
+	"Sentry",
+	"Skylake",
+	"Soraka",
+	NULL
+};
+
 struct platform_intf platform_glados = {
 	.type		= PLATFORM_X86_64,
 	.name		= "Glados",
+	.probe_ids	= glados_probe_ids,
 	.sub		= glados_sub,
 	.cb		= &glados_cb,
 	.probe		= &glados_probe,
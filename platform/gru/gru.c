@@ -128,9 +128,11 @@ struct eventlog_cb gru_eventlog_cb = {
 	.verify		= &elog_verify,
 	.verify_header	= &elog_verify_header,
 	.add		= &elog_add_event_manually,
+	.add_many	= &elog_add_events_manually,
 	.clear		= &elog_clear_manually,
 	.fetch		= &elog_fetch_from_flash,
 	.write		= &elog_write_to_flash,
+	.write_range	= &elog_write_range_to_flash,
 };
 
 struct platform_cb gru_cb = {
@@ -143,9 +145,19 @@ struct platform_cb gru_cb = {
 	.eventlog	= &gru_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *gru_probe_ids[] = {
+	"google,bob-rev",
+	"google,gru-rev",
+	"google,kevin-rev",
+	"google,scarlet-rev",
+	NULL
+};
+
 struct platform_intf platform_gru = {
 	.type		= PLATFORM_ARMV8,
 	.name		= "Gru",
+	.probe_ids	= gru_probe_ids,
 	.sub		= gru_sub,
 	.cb		= &gru_cb,
 	.probe		= &gru_probe,
@@ -97,7 +97,7 @@ static int link_setup_post(struct platform_intf *intf)
 {
 	int rc = 0;
 
-	rc |= link_ec_setup(intf);
+	rc |= cros_ec_defer_setup(intf, intf->cb->ec, link_ec_setup);
 	if (rc)
 		lprintf(LOG_DEBUG, "%s: failed\n", __func__);
 	return rc;
@@ -51,23 +51,6 @@ static int host_firmware_size(struct platform_intf *intf)
 	return OAK_HOST_FIRMWARE_ROM_SIZE;
 }
 
-static int host_firmware_read(struct platform_intf *intf, struct eeprom *eeprom,
-			unsigned int offset, unsigned int len, void *data)
-{
-	uint8_t *buf;
-	size_t rom_size;
-
-	rom_size = eeprom->device->size(intf);
-	buf = mosys_malloc(rom_size);
-
-	if (flashrom_read(buf, rom_size, HOST_FIRMWARE, NULL) < 0)
-		return -1;
-
-	memcpy(data, &buf[offset], len);
-	free(buf);
-	return 0;
-}
-
 static int host_firmware_read_by_name(struct platform_intf *intf,
 				struct eeprom *eeprom, const char *name,
 				uint8_t **data)
@@ -84,11 +67,24 @@ static int host_firmware_write_by_name(struct platform_intf *intf,
 	return flashrom_write_by_name(len, data, HOST_FIRMWARE, name);
 }
 
+static int host_firmware_write_range_by_name(struct platform_intf *intf,
+				             struct eeprom *eeprom,
+				             const char *name,
+				             unsigned int offset,
+				             unsigned int len,
+				             uint8_t *data)
+{
+	return flashrom_write_range_by_name(len, data, offset,
+	                                    HOST_FIRMWARE, name);
+}
+
 static struct eeprom_dev host_firmware = {
 	.size		= host_firmware_size,
-	.read		= host_firmware_read,
+	.read		= eeprom_host_firmware_read,
 	.write_by_name  = host_firmware_write_by_name,
+	.write_range_by_name = host_firmware_write_range_by_name,
 	.read_by_name	= host_firmware_read_by_name,
+	.prefetch	= eeprom_host_firmware_prefetch,
 	.get_map	= eeprom_get_fmap,
 };
 
@@ -131,9 +131,11 @@ struct eventlog_cb oak_eventlog_cb = {
 	.verify		= &elog_verify,
 	.verify_header	= &elog_verify_header,
 	.add		= &elog_add_event_manually,
+	.add_many	= &elog_add_events_manually,
 	.clear		= &elog_clear_manually,
 	.fetch		= &elog_fetch_from_flash,
 	.write		= &elog_write_to_flash,
+	.write_range	= &elog_write_range_to_flash,
 };
 
 struct platform_cb oak_cb = {
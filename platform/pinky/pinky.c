@@ -154,9 +154,11 @@ struct eventlog_cb pinky_eventlog_cb = {
 	.verify		= &elog_verify,
 	.verify_header	= &elog_verify_header,
 	.add		= &elog_add_event_manually,
+	.add_many	= &elog_add_events_manually,
 	.clear		= &elog_clear_manually,
 	.fetch		= &elog_fetch_from_flash,
 	.write		= &elog_write_to_flash,
+	.write_range	= &elog_write_range_to_flash,
 };
 
 struct platform_cb pinky_cb = {
@@ -169,9 +171,31 @@ struct platform_cb pinky_cb = {
 	.eventlog	= &pinky_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *pinky_probe_ids[] = {
+	"google,veyron-brain",
+	"google,veyron-danger",
+	"google,veyron-emile",
+	"google,veyron-fievel",
+	"google,veyron-gus",
+	"google,veyron-jaq",
+	"google,veyron-jerry",
+	"google,veyron-mickey",
+	"google,veyron-mighty",
+	"google,veyron-minnie",
+	"google,veyron-pinky",
+	"google,veyron-remy",
+	"google,veyron-rialto",
+	"google,veyron-speedy",
+	"google,veyron-thea",
+	"google,veyron-tiger",
+	NULL
+};
+
 struct platform_intf platform_pinky = {
 	.type		= PLATFORM_ARMV7,
 	.name		= "Pinky",
+	.probe_ids	= pinky_probe_ids,
 	.sub		= pinky_sub,
 	.cb		= &pinky_cb,
 	.probe		= &pinky_probe,
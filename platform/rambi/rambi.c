@@ -157,7 +157,7 @@ static int rambi_setup_post(struct platform_intf *intf)
 {
 	int rc = 0;
 
-	rc |= rambi_ec_setup(intf);
+	rc |= cros_ec_defer_setup(intf, intf->cb->ec, rambi_ec_setup);
 	if (rc)
 		lprintf(LOG_DEBUG, "%s: failed\n", __func__);
 	return rc;
@@ -189,9 +189,33 @@ struct platform_cb rambi_cb = {
 	.eventlog	= &rambi_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *rambi_probe_ids[] = {
+	"Banjo",
+	"Candy",
+	"Clapper",
+	"Cranky",
+	"Enguarde",
+	"Expresso",
+	"Glimmer",
+	"Gnawty",
+	"Heli",
+	"Kip",
+	"Ninja",
+	"Orco",
+	"Quawks",
+	"Rambi",
+	"Squawks",
+	"Sumo",
+	"Swanky",
+	"Winky",
+	NULL
+};
+
 struct platform_intf platform_rambi = {
 	.type		= PLATFORM_X86_64,
 	.name		= "Rambi",
+	.probe_ids	= rambi_probe_ids,
 	.sub		= rambi_sub,
 	.cb		= &rambi_cb,
 	.probe		= &rambi_probe,
@@ -210,9 +210,20 @@ struct platform_cb reef_cb = {
 	.eventlog	= &reef_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *reef_probe_ids[] = {
+	"Reef",
+	"Coral",
+	"Pyro",
+	"Sand",
+	"Snappy",
+	NULL
+};
+
 struct platform_intf platform_reef = {
 	.type		= PLATFORM_X86_64,
 	.name		= "Reef",
+	.probe_ids	= reef_probe_ids,
 	.sub		= reef_sub,
 	.cb		= &reef_cb,
 	.probe		= &reef_probe,
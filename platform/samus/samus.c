@@ -143,9 +143,16 @@ struct platform_cb samus_cb = {
 	.eventlog	= &samus_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *samus_probe_ids[] = {
+	"Samus",
+	NULL
+};
+
 struct platform_intf platform_samus = {
 	.type		= PLATFORM_X86_64,
 	.name		= "Samus",
+	.probe_ids	= samus_probe_ids,
 	.sub		= samus_sub,
 	.cb		= &samus_cb,
 	.probe		= &samus_probe,
@@ -91,10 +91,22 @@ static int skate_host_firmware_write_by_name(struct platform_intf *intf,
 	return flashrom_write_by_name(len, data, INTERNAL_BUS_SPI, name);
 }
 
+static int skate_host_firmware_write_range_by_name(struct platform_intf *intf,
+					           struct eeprom *eeprom,
+					           const char *name,
+					           unsigned int offset,
+					           unsigned int len,
+					           uint8_t *data)
+{
+	return flashrom_write_range_by_name(len, data, offset,
+	                                    INTERNAL_BUS_SPI, name);
+}
+
 static struct eeprom_dev skate_host_firmware = {
 	.size		= skate_host_firmware_size,
 	.read		= skate_host_firmware_read,
 	.write_by_name	= skate_host_firmware_write_by_name,
+	.write_range_by_name = skate_host_firmware_write_range_by_name,
 	.read_by_name	= skate_host_firmware_read_by_name,
 	.get_map	= eeprom_get_fmap,
 };
@@ -117,7 +117,7 @@ static int slippy_setup_post(struct platform_intf *intf)
 {
 	int rc = 0;
 
-	rc |= slippy_ec_setup(intf);
+	rc |= cros_ec_defer_setup(intf, intf->cb->ec, slippy_ec_setup);
 	if (rc)
 		lprintf(LOG_DEBUG, "%s: failed\n", __func__);
 	return rc;
@@ -148,9 +148,20 @@ struct platform_cb slippy_cb = {
 	.eventlog	= &slippy_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *slippy_probe_ids[] = {
+	"Falco",
+	"Leon",
+	"Peppy",
+	"Slippy",
+	"Wolf",
+	NULL
+};
+
 struct platform_intf platform_slippy = {
 	.type		= PLATFORM_X86_64,
 	.name		= "Slippy",
+	.probe_ids	= slippy_probe_ids,
 	.sub		= slippy_sub,
 	.cb		= &slippy_cb,
 	.probe		= &slippy_probe,
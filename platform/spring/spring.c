@@ -196,7 +196,7 @@ static int spring_setup_post(struct platform_intf *intf)
 	if (spring_board_config == SPRING_CONFIG_UNKNOWN)
 		return -1;
 
-	if (spring_ec_setup(intf) <= 0)
+	if (cros_ec_defer_setup(intf, intf->cb->ec, spring_ec_setup) < 0)
 		return -1;
 
 	return 0;
@@ -217,9 +217,11 @@ struct eventlog_cb spring_eventlog_cb = {
 	.verify		= &elog_verify,
 	.verify_header	= &elog_verify_header,
 	.add		= &elog_add_event_manually,
+	.add_many	= &elog_add_events_manually,
 	.clear		= &elog_clear_manually,
 	.fetch		= &elog_fetch_from_flash,
 	.write		= &elog_write_to_flash,
+	.write_range	= &elog_write_range_to_flash,
 };
 
 struct platform_cb spring_cb = {
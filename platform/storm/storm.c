@@ -98,9 +98,11 @@ struct eventlog_cb storm_eventlog_cb = {
 	.verify		= &elog_verify,
 	.verify_header	= &elog_verify_header,
 	.add		= &elog_add_event_manually,
+	.add_many	= &elog_add_events_manually,
 	.clear		= &elog_clear_manually,
 	.fetch		= &elog_fetch_from_flash,
 	.write		= &elog_write_to_flash,
+	.write_range	= &elog_write_range_to_flash,
 };
 
 struct platform_cb storm_cb = {
@@ -115,6 +117,7 @@ struct platform_cb storm_cb = {
 struct platform_intf platform_storm = {
 	.type		= PLATFORM_ARMV7,
 	.name		= "Storm",
+	.probe_ids	= id_list,
 	.sub		= storm_sub,
 	.cb		= &storm_cb,
 	.probe		= &storm_probe,
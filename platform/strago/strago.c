@@ -164,9 +164,27 @@ struct platform_cb strago_cb = {
 	.eventlog	= &strago_eventlog_cb,
 };
 
+/* ids the probe matches, for detection by identity */
+static const char *strago_probe_ids[] = {
+	"Banon",
+	"Celes",
+	"Edgar",
+	"Kefka",
+	"Reks",
+	"Relm",
+	"Setzer",
+	"Strago",
+	"Terra",
+	"Ultima",
+	"Umaro",
+	"Wizpig",
+	NULL
+};
+
 struct platform_intf platform_strago = {
 	.type		= PLATFORM_X86_64,
 	.name		= "Strago",
+	.probe_ids	= strago_probe_ids,
 	.sub		= strago_sub,
 	.cb		= &strago_cb,
 	.probe		= &strago_probe,
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * bench_util.c: fixtures shared by the benchmarks
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1	/* for mkdtemp() and nftw() */
+#endif
+
+#include <errno.h>
+#include <ftw.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "lib/smbios.h"
+#include "lib/smbios_tables.h"
+
+#include "bench_util.h"
+
+#define DMI_DIR		"/sys/firmware/dmi/tables"
+
+static char bench_root[PATH_MAX];
+
+double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+const char *bench_root_create(const char *name)
+{
+	snprintf(bench_root, sizeof(bench_root), "/tmp/%s.XXXXXX", name);
+	if (!mkdtemp(bench_root)) {
+		perror("mkdtemp");
+		bench_root[0] = '\0';
+		return NULL;
+	}
+
+	return bench_root;
+}
+
+static int remove_entry(const char *path, const struct stat *st,
+                        int flag, struct FTW *ftw)
+{
+	return remove(path);
+}
+
+void bench_root_remove(void)
+{
+	if (!bench_root[0])
+		return;
+
+	/* mosys may have added files of its own under the root */
+	nftw(bench_root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+	bench_root[0] = '\0';
+}
+
+int bench_root_mkdir(const char *dir)
+{
+	char path[PATH_MAX];
+	char *p;
+
+	if (snprintf(path, sizeof(path), "%s%s/",
+	             bench_root, dir) >= sizeof(path))
+		return -1;
+
+	for (p = path + strlen(bench_root) + 1; (p = strchr(p, '/')); p++) {
+		*p = '\0';
+		if (mkdir(path, 0700) < 0 && errno != EEXIST) {
+			perror(path);
+			return -1;
+		}
+		*p = '/';
+	}
+
+	return 0;
+}
+
+int bench_root_write(const char *name, const void *buf, size_t len,
+                     mode_t mode)
+{
+	char path[PATH_MAX];
+	char *dir;
+	FILE *fp;
+	int rc = 0;
+
+	snprintf(path, sizeof(path), "%s", name);
+	if ((dir = strrchr(path, '/')) != NULL) {
+		*dir = '\0';
+		if (bench_root_mkdir(path) < 0)
+			return -1;
+	}
+
+	snprintf(path, sizeof(path), "%s%s", bench_root, name);
+	if ((fp = fopen(path, "w")) == NULL) {
+		perror(path);
+		return -1;
+	}
+	if (fwrite(buf, 1, len, fp) != len)
+		rc = -1;
+	if (fclose(fp) || chmod(path, mode))
+		rc = -1;
+
+	return rc;
+}
+
+int bench_write_smbios(const uint8_t *table, size_t len)
+{
+	struct smbios3_entry ep;
+	uint8_t csum;
+	int i, rc = 0;
+
+	memset(&ep, 0, sizeof(ep));
+	memcpy(ep.anchor_string, SMBIOS3_ENTRY_MAGIC, sizeof(ep.anchor_string));
+	ep.entry_length = sizeof(ep);
+	ep.major_ver = 3;
+	ep.max_size = len;
+	for (csum = i = 0; i < sizeof(ep); i++)
+		csum += ((uint8_t *)&ep)[i];
+	ep.entry_cksum = -csum;
+
+	rc |= bench_root_write(DMI_DIR "/smbios_entry_point",
+	                       &ep, sizeof(ep), 0600);
+	rc |= bench_root_write(DMI_DIR "/DMI", table, len, 0600);
+
+	return rc;
+}
+
+int bench_write_link_smbios(void)
+{
+	uint8_t table[128];
+	struct smbios_header *header;
+	struct smbios_table_system *sys;
+	size_t off = 0;
+
+	memset(table, 0, sizeof(table));
+	header = (struct smbios_header *)table;
+	header->type = SMBIOS_TYPE_SYSTEM;
+	header->length = sizeof(*header) + sizeof(*sys);
+	sys = (struct smbios_table_system *)(header + 1);
+	sys->manufacturer = 1;
+	sys->name = 2;
+	off += header->length;
+	off += sprintf((char *)&table[off], "GOOGLE") + 1;
+	off += sprintf((char *)&table[off], "Link") + 1;
+	table[off++] = '\0';
+
+	header = (struct smbios_header *)&table[off];
+	header->type = SMBIOS_TYPE_END;
+	header->length = sizeof(*header);
+	header->handle = 1;
+	off += header->length + 2;
+
+	return bench_write_smbios(table, off);
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * bench_util.h: fixtures shared by the benchmarks
+ *
+ * Each benchmark writes the files it needs to a scratch root prefix, where
+ * mosys finds them like the files the kernel exports, and removes it when
+ * done. Paths given to the bench_root_* functions are relative to it.
+ */
+
+#ifndef MOSYS_TOOLS_BENCH_UTIL_H__
+#define MOSYS_TOOLS_BENCH_UTIL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* bench_now  -  return a monotonic time in seconds */
+extern double bench_now(void);
+
+/*
+ * bench_root_create  -  create the scratch root prefix
+ *
+ * @name:	name of the benchmark, used in the directory name
+ *
+ * returns path of the root prefix
+ * returns NULL to indicate failure
+ */
+extern const char *bench_root_create(const char *name);
+
+/*
+ * bench_root_remove  -  remove the scratch root prefix and everything in it
+ */
+extern void bench_root_remove(void);
+
+/*
+ * bench_root_mkdir  -  create a directory and its parents
+ *
+ * @dir:	directory to create
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int bench_root_mkdir(const char *dir);
+
+/*
+ * bench_root_write  -  create a file with the given contents
+ *
+ * @name:	file to create, its directory is created as needed
+ * @buf:	contents
+ * @len:	length of contents
+ * @mode:	permissions of the file
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int bench_root_write(const char *name, const void *buf, size_t len,
+                            mode_t mode);
+
+/*
+ * bench_write_smbios  -  write an SMBIOS 3.0 entry point and structure table
+ *
+ * @table:	structure table, ending with an end-of-table structure
+ * @len:	length of structure table
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int bench_write_smbios(const uint8_t *table, size_t len);
+
+/*
+ * bench_write_link_smbios  -  write SMBIOS tables naming a Link system
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+extern int bench_write_link_smbios(void);
+
+#endif	/* MOSYS_TOOLS_BENCH_UTIL_H__ */
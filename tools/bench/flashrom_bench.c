@@ -0,0 +1,195 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * flashrom_bench.c: benchmark for the flashrom backends
+ *
+ * Reads a synthetic ROM image through each backend in turn. The exec
+ * backend runs a stand-in flashrom script which copies the image, so it
+ * pays for finding the binary, fork/exec and the temporary file just as
+ * with the real utility. The libflashrom backend, when built, reads the
+ * same image from the dummy programmer's emulated chip. No hardware or
+ * root access is needed.
+ */
+
+#include <getopt.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mosys/alloc.h"
+#include "mosys/callbacks.h"
+#include "mosys/globals.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "lib/flashrom.h"
+
+#include "bench_util.h"
+
+/* the dummy programmer emulates this 16MB chip */
+#define BENCH_CHIP		"W25Q128FV"
+#define BENCH_CHIP_SIZE		(16 * 1024 * 1024)
+
+/*
+ * run_backend  -  read the ROM repeatedly and report the time per read
+ *
+ * @backend:	backend to read with
+ * @image:	expected contents
+ * @size:	size of ROM
+ * @iterations:	reads to do
+ *
+ * The backend is called directly, so the firmware cache is not involved.
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int run_backend(struct flashrom_backend *backend,
+                       const uint8_t *image, size_t size, int iterations)
+{
+	double start, elapsed;
+	uint8_t *buf;
+	int i, rc = 0;
+
+	if (backend->setup && backend->setup(HOST_FIRMWARE) < 0) {
+		printf("%-12s unavailable\n", backend->name);
+		return 0;
+	}
+
+	buf = mosys_malloc(size);
+	start = bench_now();
+	for (i = 0; i < iterations; i++) {
+		if (backend->read(buf, size, HOST_FIRMWARE, NULL) < 0 ||
+		    memcmp(buf, image, size)) {
+			fprintf(stderr, "%s: read %d failed\n",
+			        backend->name, i);
+			rc = -1;
+			break;
+		}
+	}
+	elapsed = bench_now() - start;
+	free(buf);
+
+	if (rc == 0)
+		printf("%-12s %4d reads of %5zu KB: %8.3f s, %8.3f ms/read\n",
+		       backend->name, iterations, size / 1024, elapsed,
+		       elapsed * 1000 / iterations);
+	return rc;
+}
+
+static void usage(void)
+{
+	printf("usage: flashrom_bench [-i iterations]\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *root;
+	char image_path[PATH_MAX];
+	char script[PATH_MAX * 2], env[PATH_MAX * 2];
+	size_t size = BENCH_CHIP_SIZE;
+	int iterations = 10;
+	uint8_t *image;
+	int opt, i, rc = 0;
+#if defined(CONFIG_USE_LIBFLASHROM)
+	char params[PATH_MAX * 2];
+#endif
+
+	while ((opt = getopt(argc, argv, "i:h")) != -1) {
+		switch (opt) {
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		default:
+			usage();
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (iterations < 1) {
+		usage();
+		return 1;
+	}
+
+	mosys_globals_init();
+	mosys_log_init("flashrom_bench", LOG_WARNING, NULL);
+
+	root = bench_root_create("flashrom_bench");
+	if (!root)
+		return 1;
+
+	image = mosys_malloc(size);
+	for (i = 0; i < size; i++)
+		image[i] = i * 7 + (i >> 12);
+	snprintf(image_path, sizeof(image_path), "%s/image.bin", root);
+	if (bench_root_write("/image.bin", image, size, 0600) < 0) {
+		rc = -1;
+		goto main_exit;
+	}
+
+	/* found through PATH by the exec backend, like the real utility */
+	snprintf(script, sizeof(script),
+	         "#!/bin/sh\n"
+	         "while [ $# -gt 0 ]; do\n"
+	         "\tcase \"$1\" in\n"
+	         "\t-r) exec cp \"%s\" \"$2\" ;;\n"
+	         "\t--get-size) echo %zu; exit 0 ;;\n"
+	         "\tesac\n"
+	         "\tshift\n"
+	         "done\n"
+	         "exit 1\n", image_path, size);
+	if (bench_root_write("/flashrom", script, strlen(script), 0700) < 0) {
+		rc = -1;
+		goto main_exit;
+	}
+	snprintf(env, sizeof(env), "%s:%s", root, getenv("PATH") ? : "");
+	setenv("PATH", env, 1);
+
+	rc |= run_backend(&flashrom_exec_backend, image, size, iterations);
+
+#if defined(CONFIG_USE_LIBFLASHROM)
+	snprintf(params, sizeof(params), "emulate=%s,image=%s",
+	         BENCH_CHIP, image_path);
+	libflashrom_set_programmer(HOST_FIRMWARE, "dummy", params);
+	rc |= run_backend(&libflashrom_backend, image, size, iterations);
+#else
+	printf("%-12s not built, see CONFIG_USE_LIBFLASHROM\n", "libflashrom");
+#endif
+
+	invoke_destroy_callbacks();
+
+main_exit:
+	free(image);
+	bench_root_remove();
+
+	return rc ? 1 : 0;
+}
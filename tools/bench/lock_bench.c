@@ -0,0 +1,195 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * lock_bench.c: contention benchmark for the big lock and resource locks
+ *
+ * Forks a number of clients which each run a number of short commands,
+ * first the way every command ran with only the big lock held
+ * exclusively, then the way commands which declare their resources run
+ * now. Lock files go to a scratch root prefix, so no hardware or root
+ * access is needed.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "mosys/big_lock.h"
+#include "mosys/globals.h"
+#include "mosys/locks.h"
+#include "mosys/log.h"
+#include "mosys/resource_lock.h"
+
+#include "bench_util.h"
+
+#define LOCK_TIMEOUT_SECS	180
+
+/* what a read-only command such as "eventlog list" claims */
+static const struct resource_claim read_claims[] = {
+	{ RESOURCE_HOST_FLASH, NULL, IPC_LOCK_SHARED },
+	{ RESOURCE_NONE },
+};
+
+/*
+ * run_client  -  run commands in a client process
+ *
+ * @mode:	mode to take the big lock in
+ * @claims:	resources to take, NULL for none
+ * @iterations:	commands to run
+ * @hold_usecs:	time each command holds its locks
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate a lock could not be taken
+ */
+static int run_client(enum ipc_lock_mode mode,
+                      const struct resource_claim *claims,
+                      int iterations, int hold_usecs)
+{
+	int i;
+
+	for (i = 0; i < iterations; i++) {
+		if (mosys_acquire_big_lock_mode(mode, LOCK_TIMEOUT_SECS) < 0)
+			return -1;
+		if (claims && mosys_acquire_resources(claims,
+		                                      LOCK_TIMEOUT_SECS) < 0) {
+			mosys_release_big_lock();
+			return -1;
+		}
+
+		usleep(hold_usecs);
+
+		if (claims)
+			mosys_release_resources(claims);
+		mosys_release_big_lock();
+	}
+
+	return 0;
+}
+
+/*
+ * run_scenario  -  run clients concurrently and report the elapsed time
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int run_scenario(const char *name, enum ipc_lock_mode mode,
+                        const struct resource_claim *claims,
+                        int clients, int iterations, int hold_usecs)
+{
+	double start, elapsed;
+	int i, status, rc = 0;
+
+	start = bench_now();
+	for (i = 0; i < clients; i++) {
+		pid_t pid = fork();
+
+		if (pid < 0) {
+			perror("fork");
+			rc = -1;
+			break;
+		}
+		if (pid == 0)
+			_exit(run_client(mode, claims,
+			                 iterations, hold_usecs) ? 1 : 0);
+	}
+
+	while (wait(&status) > 0) {
+		if (!WIFEXITED(status) || WEXITSTATUS(status))
+			rc = -1;
+	}
+	elapsed = bench_now() - start;
+
+	printf("%-10s %3d clients x %4d commands: %8.3f s, %8.3f ms/command\n",
+	       name, clients, iterations, elapsed,
+	       elapsed * 1000 / (clients * iterations));
+	return rc;
+}
+
+static void usage(void)
+{
+	printf("usage: lock_bench [-n clients] [-i iterations] "
+	       "[-u hold_usecs]\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *root;
+	int clients = 8, iterations = 50, hold_usecs = 2000;
+	int opt, rc = 0;
+
+	while ((opt = getopt(argc, argv, "n:i:u:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			clients = atoi(optarg);
+			break;
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		case 'u':
+			hold_usecs = atoi(optarg);
+			break;
+		default:
+			usage();
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (clients < 1 || iterations < 1 || hold_usecs < 0) {
+		usage();
+		return 1;
+	}
+
+	mosys_globals_init();
+	mosys_log_init("lock_bench", LOG_WARNING, NULL);
+
+	root = bench_root_create("lock_bench");
+	if (!root)
+		return 1;
+	if (bench_root_mkdir("/run/lock") < 0) {
+		bench_root_remove();
+		return 1;
+	}
+	mosys_set_root_prefix(root);
+
+	rc |= run_scenario("exclusive", IPC_LOCK_EXCLUSIVE, NULL,
+	                   clients, iterations, hold_usecs);
+	rc |= run_scenario("shared", IPC_LOCK_SHARED, read_claims,
+	                   clients, iterations, hold_usecs);
+
+	/* lock files are left in place by design, clean up after them */
+	bench_root_remove();
+
+	return rc ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * platform_bench.c: startup benchmark for the platform cache
+ *
+ * Writes the identifying data of a Link system (SMBIOS tables naming it,
+ * plus the CPU information of this host) and a boot ID to a scratch root
+ * prefix, where they are found like the files the kernel exports, and
+ * then times platform setup and teardown in fresh processes, first
+ * probing for the platform as every command did before the platform cache
+ * existed and then finding it in the cache. Each startup runs in its own
+ * process because probe results are kept for the life of a process; the
+ * fork is included in both timings. No hardware or root access is needed.
+ */
+
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "mosys/globals.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "bench_util.h"
+
+#define BOOT_ID		"3c1d2a0e-5b4f-4c6e-9d7a-8f2e1b0c4d5a\n"
+
+/* copy this host's CPU information so identity probing reads real data */
+static int copy_cpuinfo(const char *root)
+{
+	char path[PATH_MAX];
+	char buf[4096];
+	FILE *in, *out;
+	size_t len;
+	int rc = 0;
+
+	snprintf(path, sizeof(path), "%s/proc/cpuinfo", root);
+	if ((out = fopen(path, "w")) == NULL) {
+		perror(path);
+		return -1;
+	}
+	/* not every host has one; identity probing copes without it */
+	if ((in = fopen("/proc/cpuinfo", "r")) != NULL) {
+		while ((len = fread(buf, 1, sizeof(buf), in)) > 0) {
+			if (fwrite(buf, 1, len, out) != len)
+				rc = -1;
+		}
+		fclose(in);
+	}
+	if (fclose(out))
+		rc = -1;
+
+	return rc;
+}
+
+/*
+ * run_startup  -  set up and tear down the platform in a new process
+ *
+ * returns 0 to indicate the platform was found
+ * returns <0 to indicate failure
+ */
+static int run_startup(void)
+{
+	struct platform_intf *intf;
+	pid_t pid;
+	int status;
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return -1;
+	}
+	if (pid == 0) {
+		intf = mosys_platform_setup(NULL);
+		if (!intf)
+			_exit(1);
+		mosys_platform_destroy(intf);
+		_exit(0);
+	}
+
+	if (waitpid(pid, &status, 0) < 0 ||
+	    !WIFEXITED(status) || WEXITSTATUS(status))
+		return -1;
+
+	return 0;
+}
+
+/*
+ * run_scenario  -  time a number of startups and report the average
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int run_scenario(const char *name, int force_probe, int iterations)
+{
+	double start;
+	int i;
+
+	mosys_set_force_probe(force_probe);
+	start = bench_now();
+	for (i = 0; i < iterations; i++) {
+		if (run_startup() < 0) {
+			fprintf(stderr, "%s: platform not found\n", name);
+			return -1;
+		}
+	}
+	printf("%-8s %5d startups: %8.3f ms/startup\n", name, iterations,
+	       (bench_now() - start) * 1000 / iterations);
+
+	return 0;
+}
+
+static void usage(void)
+{
+	printf("usage: platform_bench [-i iterations]\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *root;
+	int iterations = 200;
+	int opt, rc = 0;
+
+	while ((opt = getopt(argc, argv, "i:h")) != -1) {
+		switch (opt) {
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		default:
+			usage();
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (iterations < 1) {
+		usage();
+		return 1;
+	}
+
+	mosys_globals_init();
+	mosys_log_init("platform_bench", LOG_WARNING, NULL);
+
+	root = bench_root_create("platform_bench");
+	if (!root)
+		return 1;
+
+	rc |= bench_root_write("/proc/sys/kernel/random/boot_id",
+	                       BOOT_ID, strlen(BOOT_ID), 0600);
+	rc |= bench_write_link_smbios();
+	rc |= copy_cpuinfo(root);
+	if (rc)
+		goto main_exit;
+	mosys_set_root_prefix(root);
+
+	/* probing also writes the cache which later startups find */
+	rc |= run_scenario("probe", 1, iterations);
+	if (!rc)
+		rc |= run_scenario("cached", 0, iterations);
+
+main_exit:
+	bench_root_remove();
+
+	return rc ? 1 : 0;
+}
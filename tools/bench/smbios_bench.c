@@ -0,0 +1,247 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * smbios_bench.c: benchmark for SMBIOS table lookups
+ *
+ * Writes a synthetic structure table with a large number of memory device
+ * tables to a scratch root prefix, where it is found like the tables the
+ * kernel exports. Lookups of the first, middle and last instance are timed
+ * through the index and, for comparison, by walking the table from the
+ * start as every lookup used to. No hardware or root access is needed.
+ */
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mosys/alloc.h"
+#include "mosys/callbacks.h"
+#include "mosys/globals.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "lib/smbios.h"
+#include "lib/smbios_tables.h"
+
+#include "bench_util.h"
+
+/*
+ * build_table  -  build a structure table of memory devices
+ *
+ * @count:	number of memory device tables
+ * @len:	OUTPUT length of the table
+ *
+ * returns allocated table
+ */
+static uint8_t *build_table(int count, size_t *len)
+{
+	struct smbios_header *header;
+	struct smbios_table_memory_device *mem;
+	size_t alloc = (count + 1) * 128, off = 0;
+	uint8_t *buf = mosys_zalloc(alloc);
+	int i;
+
+	for (i = 0; i < count; i++) {
+		header = (struct smbios_header *)&buf[off];
+		header->type = SMBIOS_TYPE_MEMORY;
+		header->length = sizeof(*header) + sizeof(*mem);
+		header->handle = i;
+		mem = (struct smbios_table_memory_device *)(header + 1);
+		mem->size = 4096;
+		mem->speed = 1600;
+		mem->locator = 1;
+		mem->manufacturer = 2;
+		mem->part_number = 3;
+		off += header->length;
+
+		off += sprintf((char *)&buf[off], "DIMM-%d", i) + 1;
+		off += sprintf((char *)&buf[off], "Vendor") + 1;
+		off += sprintf((char *)&buf[off], "PART-%08d", i) + 1;
+		buf[off++] = '\0';
+	}
+
+	header = (struct smbios_header *)&buf[off];
+	header->type = SMBIOS_TYPE_END;
+	header->length = sizeof(*header);
+	header->handle = count;
+	off += header->length + 2;
+
+	*len = off;
+	return buf;
+}
+
+/*
+ * linear_find  -  find a table by walking the structure table from the start
+ *
+ * returns offset of table if found
+ * returns <0 if not found
+ */
+static long linear_find(const uint8_t *buf, size_t len,
+                        int type, int instance)
+{
+	const struct smbios_header *header;
+	const uint8_t *ptr = buf, *end = buf + len;
+
+	while (ptr + sizeof(*header) <= end) {
+		header = (const struct smbios_header *)ptr;
+		if (header->type == type && instance-- == 0)
+			return ptr - buf;
+		if (header->type == SMBIOS_TYPE_END)
+			break;
+
+		for (ptr += header->length; ptr + 1 < end && (ptr[0] || ptr[1]);
+		     ptr++)
+			;
+		ptr += 2;
+	}
+
+	return -1;
+}
+
+/*
+ * run_lookups  -  time lookups of one instance
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int run_lookups(struct platform_intf *intf, const uint8_t *buf,
+                       size_t len, const char *name, int instance,
+                       int iterations)
+{
+	struct smbios_table_view view;
+	double start, indexed, linear;
+	char expect[32];
+	int i;
+
+	snprintf(expect, sizeof(expect), "PART-%08d", instance);
+
+	start = bench_now();
+	for (i = 0; i < iterations; i++) {
+		if (smbios_find_table_view(intf, SMBIOS_TYPE_MEMORY, instance,
+		                           &view, SMBIOS_LEGACY_ENTRY_BASE,
+		                           SMBIOS_LEGACY_ENTRY_LEN) < 0)
+			return -1;
+	}
+	indexed = bench_now() - start;
+
+	if (strcmp(smbios_view_string_field(&view,
+	           SMBIOS_FIELD(memory_device, part_number)) ? : "", expect)) {
+		fprintf(stderr, "wrong table for instance %d\n", instance);
+		return -1;
+	}
+
+	start = bench_now();
+	for (i = 0; i < iterations; i++) {
+		if (linear_find(buf, len, SMBIOS_TYPE_MEMORY, instance) < 0)
+			return -1;
+	}
+	linear = bench_now() - start;
+
+	printf("%-7s instance %6d: indexed %10.1f ns, linear %10.1f ns\n",
+	       name, instance, indexed * 1e9 / iterations,
+	       linear * 1e9 / iterations);
+	return 0;
+}
+
+static void usage(void)
+{
+	printf("usage: smbios_bench [-n tables] [-i iterations]\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *root;
+	struct platform_intf intf;
+	int count = 4096, iterations = 1000;
+	double start;
+	uint8_t *table;
+	size_t len;
+	int opt, rc = 0;
+
+	while ((opt = getopt(argc, argv, "n:i:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		default:
+			usage();
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (count < 1 || iterations < 1) {
+		usage();
+		return 1;
+	}
+
+	mosys_globals_init();
+	mosys_log_init("smbios_bench", LOG_WARNING, NULL);
+	memset(&intf, 0, sizeof(intf));
+	intf.name = "smbios_bench";
+
+	root = bench_root_create("smbios_bench");
+	if (!root)
+		return 1;
+
+	table = build_table(count, &len);
+	rc |= bench_write_smbios(table, len);
+	if (rc)
+		goto main_exit;
+	mosys_set_root_prefix(root);
+
+	/* the first lookup loads the table and builds the index */
+	start = bench_now();
+	if (smbios_count_tables(&intf, SMBIOS_TYPE_MEMORY,
+	                        SMBIOS_LEGACY_ENTRY_BASE,
+	                        SMBIOS_LEGACY_ENTRY_LEN) != count) {
+		fprintf(stderr, "wrong number of tables\n");
+		rc = -1;
+		goto main_exit;
+	}
+	printf("setup   %6d tables, %7zu bytes: %8.3f ms\n",
+	       count, len, (bench_now() - start) * 1000);
+
+	rc |= run_lookups(&intf, table, len, "first", 0, iterations);
+	rc |= run_lookups(&intf, table, len, "middle", count / 2, iterations);
+	rc |= run_lookups(&intf, table, len, "last", count - 1, iterations);
+
+	invoke_destroy_callbacks();
+
+main_exit:
+	free(table);
+	bench_root_remove();
+
+	return rc ? 1 : 0;
+}
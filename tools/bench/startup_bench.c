@@ -0,0 +1,252 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * startup_bench.c: per-command startup benchmark for deferred setup
+ *
+ * Writes SMBIOS tables naming Link to a scratch root prefix and times
+ * startup, a command and teardown in fresh processes, for a command that
+ * only reads SMBIOS and for one that talks to the EC. Each is run with
+ * every interface operation and the EC set up right after platform setup,
+ * as every command used to, and with both set up on first use.
+ *
+ * There is no EC to talk to, so the platform's EC is replaced by one which
+ * answers after a fixed latency. No hardware or root access is needed.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1	/* for usleep() */
+#endif
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "mosys/globals.h"
+#include "mosys/intf_list.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "drivers/google/cros_ec.h"
+#include "drivers/google/cros_ec_commands.h"
+
+#include "lib/smbios.h"
+
+#include "bench_util.h"
+
+/* time the stand-in EC takes to answer a command */
+static int ec_latency_usecs = 500;
+
+/* stand-in EC, which only knows how to say hello */
+static int bench_ec_command(struct platform_intf *intf, struct ec_cb *ec,
+                            int command, int command_version,
+                            const void *indata, int insize,
+                            const void *outdata, int outsize)
+{
+	const struct ec_params_hello *request = outdata;
+	struct ec_response_hello *response = (void *)indata;
+
+	usleep(ec_latency_usecs);
+
+	if (command != EC_CMD_HELLO ||
+	    insize < sizeof(*response) || outsize < sizeof(*request))
+		return -1;
+	response->out_data = request->in_data + 0x01020304;
+	return 0;
+}
+
+/* returns 1 if EC detected, 0 if not, <0 to indicate failure */
+static int bench_ec_setup(struct platform_intf *intf)
+{
+	static struct cros_ec_priv bench_ec_priv = {
+		.cmd	= &bench_ec_command,
+	};
+
+	intf->cb->ec->priv = &bench_ec_priv;
+	return cros_ec_detect(intf, intf->cb->ec);
+}
+
+/* a command which only reads SMBIOS, like "smbios info system" */
+static int run_smbios_command(struct platform_intf *intf)
+{
+	struct smbios_table_view view;
+
+	return smbios_find_table_view(intf, SMBIOS_TYPE_SYSTEM, 0, &view,
+	                              SMBIOS_LEGACY_ENTRY_BASE,
+	                              SMBIOS_LEGACY_ENTRY_LEN);
+}
+
+/* a command which talks to the EC, like "ec info" */
+static int run_ec_command(struct platform_intf *intf)
+{
+	return cros_ec_detect(intf, intf->cb->ec) == 1 ? 0 : -1;
+}
+
+/*
+ * run_startup  -  set up the platform and run a command in a new process
+ *
+ * @command:	command to run
+ * @eager:	set up interface operations and the EC before the command
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int run_startup(int (*command)(struct platform_intf *intf), int eager)
+{
+	struct platform_intf *intf;
+	enum intf_op_type type;
+	pid_t pid;
+	int status, rc;
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return -1;
+	}
+	if (pid == 0) {
+		intf = mosys_platform_setup(NULL);
+		if (!intf || !intf->cb || !intf->cb->ec)
+			_exit(1);
+
+		if (eager) {
+			/* failures only mattered to commands using them */
+			for (type = 0; type < INTF_OP_MAX; type++)
+				intf_op_ready(intf, type);
+			rc = bench_ec_setup(intf) == 1 ? 0 : -1;
+		} else {
+			rc = cros_ec_defer_setup(intf, intf->cb->ec,
+			                         bench_ec_setup);
+		}
+
+		if (rc == 0)
+			rc = command(intf);
+		mosys_platform_destroy(intf);
+		_exit(rc ? 1 : 0);
+	}
+
+	if (waitpid(pid, &status, 0) < 0 ||
+	    !WIFEXITED(status) || WEXITSTATUS(status))
+		return -1;
+
+	return 0;
+}
+
+/*
+ * run_scenario  -  time startups with a command and report the average
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int run_scenario(const char *name,
+                        int (*command)(struct platform_intf *intf),
+                        int iterations)
+{
+	double start, eager, lazy;
+	int i;
+
+	start = bench_now();
+	for (i = 0; i < iterations; i++) {
+		if (run_startup(command, 1) < 0)
+			goto run_scenario_fail;
+	}
+	eager = bench_now() - start;
+
+	start = bench_now();
+	for (i = 0; i < iterations; i++) {
+		if (run_startup(command, 0) < 0)
+			goto run_scenario_fail;
+	}
+	lazy = bench_now() - start;
+
+	printf("%-8s %5d startups: eager %8.3f ms, on first use %8.3f ms\n",
+	       name, iterations, eager * 1000 / iterations,
+	       lazy * 1000 / iterations);
+	return 0;
+
+run_scenario_fail:
+	fprintf(stderr, "%s: command failed\n", name);
+	return -1;
+}
+
+static void usage(void)
+{
+	printf("usage: startup_bench [-i iterations] [-l ec_latency_usecs]\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *root;
+	int iterations = 200;
+	int opt, rc = 0;
+
+	while ((opt = getopt(argc, argv, "i:l:h")) != -1) {
+		switch (opt) {
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		case 'l':
+			ec_latency_usecs = atoi(optarg);
+			break;
+		default:
+			usage();
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (iterations < 1 || ec_latency_usecs < 0) {
+		usage();
+		return 1;
+	}
+
+	mosys_globals_init();
+	/* without root access, eager port IO setup logs an error every time */
+	mosys_log_init("startup_bench", LOG_CRIT, NULL);
+
+	root = bench_root_create("startup_bench");
+	if (!root)
+		return 1;
+
+	rc |= bench_write_link_smbios();
+	if (rc)
+		goto main_exit;
+	mosys_set_root_prefix(root);
+
+	rc |= run_scenario("smbios", run_smbios_command, iterations);
+	rc |= run_scenario("ec", run_ec_command, iterations);
+
+main_exit:
+	bench_root_remove();
+
+	return rc ? 1 : 0;
+}
@@ -0,0 +1,362 @@
+/*
+ * Copyright 2018, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following disclaimer
+ *      in the documentation and/or other materials provided with the
+ *      distribution.
+ *    * Neither the name of Google Inc. nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * vpd_bench.c: benchmark for VPD table lookups
+ *
+ * Writes a synthetic VPD area with firmware and system tables and a large
+ * number of binary blob pointers to the /dev/mem of a scratch root prefix,
+ * where it is mapped like physical memory. Every blob pointer is looked
+ * up, as "vpd print blobs" does, through the index and, for comparison,
+ * by walking the table from the start as every lookup used to. No
+ * hardware or root access is needed.
+ */
+
+#include <getopt.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mosys/alloc.h"
+#include "mosys/callbacks.h"
+#include "mosys/globals.h"
+#include "mosys/intf_list.h"
+#include "mosys/log.h"
+#include "mosys/platform.h"
+
+#include "lib/vpd.h"
+#include "lib/vpd_tables.h"
+
+#include "bench_util.h"
+
+#define VPD_BASE	0x10000		/* address of the search region */
+#define VPD_LEN		0x1000		/* length of the search region */
+#define VPD_TABLE	VPD_LEN		/* table offset from VPD_BASE */
+#define VPD_TABLE_MAX	0xffff		/* table_length is 16 bits */
+
+/*
+ * add_table  -  append a table and its strings
+ *
+ * @buf:	structure table
+ * @off:	offset to append at, updated past the table
+ * @type:	table type
+ * @handle:	table handle
+ * @data:	formatted table, without header
+ * @len:	length of formatted table
+ * @strings:	strings, NULL-terminated
+ */
+static void add_table(uint8_t *buf, size_t *off, int type, int handle,
+                      const void *data, size_t len, const char **strings)
+{
+	struct vpd_header *header = (struct vpd_header *)&buf[*off];
+	const char **s;
+
+	header->type = type;
+	header->length = sizeof(*header) + len;
+	header->handle = handle;
+	memcpy(header + 1, data, len);
+	*off += header->length;
+
+	/* a table without strings still ends with two nul bytes */
+	for (s = strings; s && *s; s++)
+		*off += sprintf((char *)&buf[*off], "%s", *s) + 1;
+	if (s == strings)
+		buf[(*off)++] = '\0';
+	buf[(*off)++] = '\0';
+}
+
+/*
+ * build_table  -  build a structure table of binary blob pointers
+ *
+ * @count:	number of binary blob pointers
+ * @len:	OUTPUT length of the table
+ *
+ * returns allocated table
+ * returns NULL if the tables do not fit in a VPD area
+ */
+static uint8_t *build_table(int count, size_t *len)
+{
+	struct vpd_table_firmware firmware;
+	struct vpd_table_system system;
+	struct vpd_table_binary_blob_pointer blob;
+	const char *strings[3];
+	char description[32];
+	uint8_t *buf;
+	size_t off = 0;
+	int i;
+
+	/* each blob pointer takes at most 64 bytes, see below */
+	if ((size_t)count * 64 + 256 > VPD_TABLE_MAX)
+		return NULL;
+	buf = mosys_zalloc(VPD_TABLE_MAX + 1);
+
+	memset(&firmware, 0, sizeof(firmware));
+	firmware.vendor = 1;
+	firmware.version = 2;
+	strings[0] = "Google";
+	strings[1] = "Google_Bench.1.0.0";
+	strings[2] = NULL;
+	add_table(buf, &off, VPD_TYPE_FIRMWARE, 0,
+	          &firmware, sizeof(firmware), strings);
+
+	memset(&system, 0, sizeof(system));
+	system.manufacturer = 1;
+	system.name = 2;
+	strings[1] = "Bench";
+	add_table(buf, &off, VPD_TYPE_SYSTEM, 1,
+	          &system, sizeof(system), strings);
+
+	memset(&blob, 0, sizeof(blob));
+	blob.vendor = 1;
+	blob.description = 2;
+	strings[1] = description;
+	for (i = 0; i < count; i++) {
+		snprintf(description, sizeof(description), "BLOB-%06d", i);
+		blob.offset = 0x1000 * i;
+		blob.size = 0x1000;
+		add_table(buf, &off, VPD_TYPE_BINARY_BLOB_POINTER, i + 2,
+		          &blob, sizeof(blob), strings);
+	}
+
+	add_table(buf, &off, VPD_TYPE_END, count + 2, NULL, 0, NULL);
+
+	*len = off;
+	return buf;
+}
+
+/*
+ * write_mem  -  write the VPD area to the /dev/mem of the root prefix
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int write_mem(const char *path, const uint8_t *table, size_t len)
+{
+	struct vpd_entry entry;
+	uint8_t csum;
+	FILE *fp;
+	int i, rc = 0;
+
+	memset(&entry, 0, sizeof(entry));
+	memcpy(entry.anchor_string, VPD_ENTRY_MAGIC,
+	       sizeof(entry.anchor_string));
+	entry.entry_length = sizeof(entry);
+	entry.major_ver = 2;
+	entry.minor_ver = 6;
+	entry.table_length = len;
+	entry.table_address = VPD_TABLE;
+	for (csum = i = 0; i < sizeof(entry); i++)
+		csum += ((uint8_t *)&entry)[i];
+	entry.entry_cksum = -csum;
+
+	if ((fp = fopen(path, "w")) == NULL) {
+		perror(path);
+		return -1;
+	}
+	if (fseek(fp, VPD_BASE, SEEK_SET) ||
+	    fwrite(&entry, 1, sizeof(entry), fp) != sizeof(entry) ||
+	    fseek(fp, VPD_BASE + VPD_TABLE, SEEK_SET) ||
+	    fwrite(table, 1, len, fp) != len)
+		rc = -1;
+	if (fclose(fp))
+		rc = -1;
+
+	return rc;
+}
+
+/*
+ * linear_find  -  find a table by walking the structure table from the start
+ *
+ * returns offset of table if found
+ * returns <0 if not found
+ */
+static long linear_find(const uint8_t *buf, size_t len,
+                        int type, int instance)
+{
+	const struct vpd_header *header;
+	const uint8_t *ptr = buf, *end = buf + len;
+
+	while (ptr + sizeof(*header) <= end) {
+		header = (const struct vpd_header *)ptr;
+		if (header->type == type && instance-- == 0)
+			return ptr - buf;
+		if (header->type == VPD_TYPE_END)
+			break;
+
+		for (ptr += header->length; ptr + 1 < end && (ptr[0] || ptr[1]);
+		     ptr++)
+			;
+		ptr += 2;
+	}
+
+	return -1;
+}
+
+/*
+ * run_lookups  -  time looking up every blob pointer
+ *
+ * returns 0 to indicate success
+ * returns <0 to indicate failure
+ */
+static int run_lookups(struct platform_intf *intf, const uint8_t *buf,
+                       size_t len, int count, int iterations)
+{
+	struct vpd_table table;
+	double start, indexed, linear;
+	char expect[32];
+	int i, n;
+
+	start = bench_now();
+	for (i = 0; i < iterations; i++) {
+		n = vpd_count_tables(intf, VPD_TYPE_BINARY_BLOB_POINTER,
+		                     VPD_BASE, VPD_LEN);
+		if (n != count) {
+			fprintf(stderr, "wrong number of blob pointers\n");
+			return -1;
+		}
+		for (n = 0; n < count; n++) {
+			if (vpd_find_table(intf, VPD_TYPE_BINARY_BLOB_POINTER,
+			                   n, &table, VPD_BASE, VPD_LEN) < 0)
+				return -1;
+		}
+	}
+	indexed = bench_now() - start;
+
+	snprintf(expect, sizeof(expect), "BLOB-%06d", count - 1);
+	if (strcmp(table.string[table.data.blob.description], expect)) {
+		fprintf(stderr, "wrong table for instance %d\n", count - 1);
+		return -1;
+	}
+
+	start = bench_now();
+	for (i = 0; i < iterations; i++) {
+		/* the old iterator probed until a lookup failed */
+		for (n = 0; n <= count; n++) {
+			if (linear_find(buf, len, VPD_TYPE_BINARY_BLOB_POINTER,
+			                n) < 0)
+				break;
+		}
+		if (n != count)
+			return -1;
+	}
+	linear = bench_now() - start;
+
+	printf("%6d blob pointers: indexed %10.3f ms, linear %10.3f ms\n",
+	       count, indexed * 1000 / iterations, linear * 1000 / iterations);
+	return 0;
+}
+
+static void usage(void)
+{
+	printf("usage: vpd_bench [-n blobs] [-i iterations]\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *root;
+	char path[PATH_MAX];
+	struct platform_intf intf;
+	struct vpd_table table;
+	int count = 1000, iterations = 20;
+	double start;
+	uint8_t *buf;
+	size_t len;
+	int opt, rc = 0;
+
+	while ((opt = getopt(argc, argv, "n:i:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			count = atoi(optarg);
+			break;
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		default:
+			usage();
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (count < 1 || iterations < 1) {
+		usage();
+		return 1;
+	}
+
+	buf = build_table(count, &len);
+	if (!buf) {
+		fprintf(stderr, "%d blob pointers do not fit in a VPD area\n",
+		        count);
+		return 1;
+	}
+
+	mosys_globals_init();
+	mosys_log_init("vpd_bench", LOG_WARNING, NULL);
+	memset(&intf, 0, sizeof(intf));
+	intf.name = "vpd_bench";
+	intf.op = &platform_common_op;
+
+	root = bench_root_create("vpd_bench");
+	if (!root) {
+		free(buf);
+		return 1;
+	}
+	if (bench_root_mkdir("/dev") < 0) {
+		rc = -1;
+		goto main_exit;
+	}
+	snprintf(path, sizeof(path), "%s/dev/mem", root);
+	rc |= write_mem(path, buf, len);
+	if (rc)
+		goto main_exit;
+	mosys_set_root_prefix(root);
+
+	/* the first lookup maps the tables and builds the index */
+	start = bench_now();
+	if (vpd_find_table(&intf, VPD_TYPE_SYSTEM, 0, &table,
+	                   VPD_BASE, VPD_LEN) < 0) {
+		fprintf(stderr, "VPD tables not found\n");
+		rc = -1;
+		goto main_exit;
+	}
+	printf("setup  %6d tables, %7zu bytes: %8.3f ms\n",
+	       count + 3, len, (bench_now() - start) * 1000);
+
+	rc |= run_lookups(&intf, buf, len, count, iterations);
+
+	invoke_destroy_callbacks();
+
+main_exit:
+	free(buf);
+	bench_root_remove();
+
+	return rc ? 1 : 0;
+}